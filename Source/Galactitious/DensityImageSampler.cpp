@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DensityImageSampler.h"
+
+#include "GalactitiousStats.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	/** Largest float below 1, uniforms are clamped to it so the selected interval is never empty. */
+	const float MaxUniform = 0.99999994f;
+
+	/** Invert a CDF of Num intervals, returns the position in [0, 1] and the selected interval. */
+	float InvertCdf(const float* Cdf, int32 Num, float U, int32& OutIndex)
+	{
+		U = FMath::Clamp(U, 0.0f, MaxUniform);
+		// Last entry <= U, its interval ends above U and has non-zero width
+		const int32 Index = FMath::Clamp(Algo::UpperBound(TArrayView<const float>(Cdf, Num + 1), U) - 1, 0, Num - 1);
+		const float IntervalWidth = Cdf[Index + 1] - Cdf[Index];
+		const float T = IntervalWidth > 0.0f ? FMath::Clamp((U - Cdf[Index]) / IntervalWidth, 0.0f, 1.0f) : 0.5f;
+		OutIndex = Index;
+		return (Index + T) / Num;
+	}
+
+	/** Largest position of a table entry within its interval, far enough from the end to survive float rounding. */
+	const float MaxIntervalFraction = 0.99f;
+
+	/** Resample the inverse of a CDF of Num intervals at TableWidth uniform quantiles. */
+	void ResampleInverseCdf(const float* Cdf, int32 Num, int32 TableWidth, float* OutValues)
+	{
+		int32 Index = 0;
+		for (int32 i = 0; i < TableWidth; ++i)
+		{
+			const float Quantile = (float)i / (TableWidth - 1);
+			// Skip intervals that end below the quantile and empty intervals, so quantiles 0 and 1 map to the support
+			while (Index < Num - 1 && (Cdf[Index + 1] < Quantile || Cdf[Index + 1] <= Cdf[Index]))
+			{
+				++Index;
+			}
+
+			// Entries stay inside their interval, the end of the last one would select the following, possibly empty pixel
+			const float IntervalWidth = Cdf[Index + 1] - Cdf[Index];
+			const float T = IntervalWidth > 0.0f ? FMath::Clamp((Quantile - Cdf[Index]) / IntervalWidth, 0.0f, MaxIntervalFraction) : 0.5f;
+			OutValues[i] = (Index + T) / Num;
+		}
+	}
+
+	/** Entry of a table row nearest to the quantile, like a point sampled texture lookup offset by half a texel. */
+	float EvalTableRowNearest(const float* Row, int32 TableWidth, float Quantile)
+	{
+		return Row[FMath::RoundToInt(FMath::Clamp(Quantile, 0.0f, 1.0f) * (TableWidth - 1))];
+	}
+
+	/** Interpolate a table row resampled from a CDF of Num intervals, skipping intervals between those of the two entries. */
+	float EvalTableRow(const float* Row, int32 TableWidth, int32 Num, float Quantile)
+	{
+		const float X = FMath::Clamp(Quantile, 0.0f, 1.0f) * (TableWidth - 1);
+		const int32 Index = FMath::Min((int32)X, TableWidth - 2);
+		if (Index < 0)
+		{
+			return Row[0];
+		}
+
+		// Intervals strictly between the intervals of both entries hold less probability than one table step and may be
+		// empty, interpolation continues from the end of the first interval at the beginning of the last one
+		const float Value0 = Row[Index];
+		const float Value1 = Row[Index + 1];
+		const float End0 = FMath::FloorToFloat(Value0 * Num) + 1.0f;
+		const float Begin1 = FMath::CeilToFloat(Value1 * Num) - 1.0f;
+		const float Gap = FMath::Max(Begin1 - End0, 0.0f) / Num;
+		const float Value = FMath::Lerp(Value0, Value1 - Gap, X - Index);
+		return Value * Num >= End0 ? Value + Gap : Value;
+	}
+} // namespace
+
+bool FDensityImageSampler::Build(int32 InWidth, int32 InHeight, TArrayView<const float> Density)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousBuildDensitySampler);
+
+	Width = 0;
+	Height = 0;
+	if (!ensureMsgf(
+			InWidth >= 1 && InHeight >= 1 && Density.Num() == InWidth * InHeight, TEXT("Density image size does not match %dx%d"),
+			InWidth, InHeight))
+	{
+		return false;
+	}
+
+	MarginalCdf.SetNumUninitialized(InHeight + 1);
+	ConditionalCdf.SetNumUninitialized(InHeight * (InWidth + 1));
+
+	// Conditional CDFs of all rows in parallel, row totals are stored in the marginal CDF until it is accumulated.
+	// Sums are accumulated in double precision and normalized by division, so the final entry is exactly 1.
+	ParallelFor(InHeight, [&](int32 y) {
+		const float* Row = Density.GetData() + (int64)y * InWidth;
+		float* Cdf = ConditionalCdf.GetData() + (int64)y * (InWidth + 1);
+
+		double Sum = 0.0;
+		for (int32 x = 0; x < InWidth; ++x)
+		{
+			Sum += FMath::Max(Row[x], 0.0f);
+		}
+
+		Cdf[0] = 0.0f;
+		double Running = 0.0;
+		for (int32 x = 0; x < InWidth; ++x)
+		{
+			Running += FMath::Max(Row[x], 0.0f);
+			Cdf[x + 1] = Sum > 0.0 ? (float)(Running / Sum) : (float)(x + 1) / InWidth;
+		}
+		MarginalCdf[y + 1] = (float)Sum;
+	});
+
+	double Total = 0.0;
+	for (int32 y = 0; y < InHeight; ++y)
+	{
+		Total += MarginalCdf[y + 1];
+	}
+	if (Total <= 0.0)
+	{
+		return false;
+	}
+
+	MarginalCdf[0] = 0.0f;
+	double Running = 0.0;
+	for (int32 y = 0; y < InHeight; ++y)
+	{
+		Running += MarginalCdf[y + 1];
+		MarginalCdf[y + 1] = (float)(Running / Total);
+	}
+
+	Width = InWidth;
+	Height = InHeight;
+	return true;
+}
+
+FVector2D FDensityImageSampler::Sample(float U, float V) const
+{
+	check(IsValid());
+
+	int32 Row;
+	const float Y = InvertCdf(MarginalCdf.GetData(), Height, U, Row);
+	int32 Column;
+	const float X = InvertCdf(ConditionalCdf.GetData() + (int64)Row * (Width + 1), Width, V, Column);
+	return FVector2D(X, Y);
+}
+
+float FDensityImageSampler::Pdf(const FVector2D& Position) const
+{
+	if (!IsValid() || Position.X < 0.0f || Position.X > 1.0f || Position.Y < 0.0f || Position.Y > 1.0f)
+	{
+		return 0.0f;
+	}
+
+	const int32 x = FMath::Min((int32)(Position.X * Width), Width - 1);
+	const int32 y = FMath::Min((int32)(Position.Y * Height), Height - 1);
+	const float* Cdf = ConditionalCdf.GetData() + (int64)y * (Width + 1);
+	return (MarginalCdf[y + 1] - MarginalCdf[y]) * (Cdf[x + 1] - Cdf[x]) * Width * Height;
+}
+
+void FDensityImageSampler::BuildQuantileTable(int32 TableWidth, TArray<float>& OutTable) const
+{
+	check(IsValid() && TableWidth >= 2);
+
+	OutTable.SetNumUninitialized(TableWidth * (Height + 1));
+	ParallelFor(Height + 1, [&](int32 y) {
+		float* OutRow = OutTable.GetData() + (int64)y * TableWidth;
+		if (y < Height)
+		{
+			ResampleInverseCdf(ConditionalCdf.GetData() + (int64)y * (Width + 1), Width, TableWidth, OutRow);
+		}
+		else
+		{
+			ResampleInverseCdf(MarginalCdf.GetData(), Height, TableWidth, OutRow);
+		}
+	});
+}
+
+FVector2D FDensityImageSampler::SampleQuantileTable(
+	const TArray<float>& Table, int32 TableWidth, int32 ImageWidth, int32 ImageHeight, float U, float V)
+{
+	check(TableWidth >= 2 && ImageWidth >= 1 && Table.Num() == TableWidth * (ImageHeight + 1));
+
+	const float Y = EvalTableRow(Table.GetData() + (int64)ImageHeight * TableWidth, TableWidth, ImageHeight, U);
+	const int32 Row = FMath::Clamp((int32)(Y * ImageHeight), 0, ImageHeight - 1);
+	const float X = EvalTableRow(Table.GetData() + (int64)Row * TableWidth, TableWidth, ImageWidth, V);
+	return FVector2D(X, Y);
+}
+
+FVector2D FDensityImageSampler::SampleQuantileTableNearest(
+	const TArray<float>& Table, int32 TableWidth, int32 ImageWidth, int32 ImageHeight, float U, float V)
+{
+	check(TableWidth >= 2 && ImageWidth >= 1 && Table.Num() == TableWidth * (ImageHeight + 1));
+
+	const float Y = EvalTableRowNearest(Table.GetData() + (int64)ImageHeight * TableWidth, TableWidth, U);
+	const int32 Row = FMath::Clamp((int32)(Y * ImageHeight), 0, ImageHeight - 1);
+	const float X = EvalTableRowNearest(Table.GetData() + (int64)Row * TableWidth, TableWidth, V);
+	return FVector2D(X, Y);
+}
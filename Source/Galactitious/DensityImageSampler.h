@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Importance sampler of a 2D density image, with a marginal CDF over rows and a conditional CDF within each row.
+ * Densities are piecewise constant per pixel, samples are distributed uniformly within the selected pixel.
+ * Positions are in [0, 1]^2, pixel (x, y) covers [x, x + 1] / Width x [y, y + 1] / Height.
+ */
+struct GALACTITIOUS_API FDensityImageSampler
+{
+	/**
+	 * Build the CDFs from Width * Height non-negative densities in row-major order.
+	 * Reuses the storage of previous builds, returns false if the image has no positive density.
+	 */
+	bool Build(int32 InWidth, int32 InHeight, TArrayView<const float> Density);
+
+	bool IsValid() const { return Width > 0 && Height > 0; }
+	void Reset() { Width = Height = 0; }
+
+	/** Map two uniform numbers to a position by binary search of the CDFs, O(log Width + log Height). */
+	FVector2D Sample(float U, float V) const;
+
+	/** Probability density at a position relative to a uniform distribution on [0, 1]^2. */
+	float Pdf(const FVector2D& Position) const;
+
+	/**
+	 * Resample the inverse CDFs uniformly on the quantile axis for constant time lookups, e.g. in particle shaders.
+	 * The table has TableWidth columns and Height + 1 rows. Row y < Height maps V to X within image row y,
+	 * the last row maps U to Y. Entry i is located at quantile i / (TableWidth - 1), texture lookups have to offset by half a texel.
+	 */
+	void BuildQuantileTable(int32 TableWidth, TArray<float>& OutTable) const;
+
+	/**
+	 * Constant time sample from a quantile table, linearly interpolated like a texture lookup.
+	 * Rows and columns between those of two neighbouring entries are skipped, so pixels without density are never selected.
+	 */
+	static FVector2D SampleQuantileTable(
+		const TArray<float>& Table, int32 TableWidth, int32 ImageWidth, int32 ImageHeight, float U, float V);
+
+	/**
+	 * Sample from a quantile table the way the particle shaders do with the point sampled table texture.
+	 * Returns the nearest entries, so positions are quantized to TableWidth steps per row but never fall into pixels without density.
+	 * Bilinear filtering would blend entries of neighbouring rows and across gaps of empty pixels, which the shaders cannot skip.
+	 */
+	static FVector2D SampleQuantileTableNearest(
+		const TArray<float>& Table, int32 TableWidth, int32 ImageWidth, int32 ImageHeight, float U, float V);
+
+	int32 Width = 0;
+	int32 Height = 0;
+
+	/** Height + 1 values from 0 to 1, row y is selected for U in [MarginalCdf[y], MarginalCdf[y + 1]). */
+	TArray<float> MarginalCdf;
+
+	/** Height rows of Width + 1 values from 0 to 1. Rows without density are uniform. */
+	TArray<float> ConditionalCdf;
+};
@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FFT.h"
+
+#include "GalactitiousStats.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+	/** Width and height of the tiles transposed per task. */
+	const int32 TransposeTileSize = 32;
+
+	/** Transpose a Width x Height row-major matrix into Height x Width. */
+	void Transpose(const float* Source, float* Dest, int32 Width, int32 Height)
+	{
+		const int32 NumTilesX = FMath::DivideAndRoundUp(Width, TransposeTileSize);
+		const int32 NumTilesY = FMath::DivideAndRoundUp(Height, TransposeTileSize);
+		ParallelFor(NumTilesY, [&](int32 TileY) {
+			const int32 BeginY = TileY * TransposeTileSize;
+			const int32 EndY = FMath::Min(BeginY + TransposeTileSize, Height);
+			for (int32 TileX = 0; TileX < NumTilesX; ++TileX)
+			{
+				const int32 BeginX = TileX * TransposeTileSize;
+				const int32 EndX = FMath::Min(BeginX + TransposeTileSize, Width);
+				for (int32 y = BeginY; y < EndY; ++y)
+				{
+					for (int32 x = BeginX; x < EndX; ++x)
+					{
+						Dest[(int64)x * Height + y] = Source[(int64)y * Width + x];
+					}
+				}
+			}
+		});
+	}
+} // namespace
+
+FFastFourierTransform::FFastFourierTransform(int32 InSize) : Size(InSize)
+{
+	check(IsValidSize(Size));
+
+	int32 NumBits = 0;
+	while ((1 << NumBits) < Size)
+	{
+		++NumBits;
+	}
+	for (int32 i = 0; i < Size; ++i)
+	{
+		int32 Reversed = 0;
+		for (int32 Bit = 0; Bit < NumBits; ++Bit)
+		{
+			Reversed |= ((i >> Bit) & 1) << (NumBits - 1 - Bit);
+		}
+		if (i < Reversed)
+		{
+			BitReversalSwaps.Add(i);
+			BitReversalSwaps.Add(Reversed);
+		}
+	}
+
+	// Size - 1 entries in total, one contiguous block per stage for vector loads
+	TwiddleReal.SetNumUninitialized(FMath::Max(Size - 1, 1));
+	TwiddleImag.SetNumUninitialized(FMath::Max(Size - 1, 1));
+	for (int32 HalfSize = 1; HalfSize < Size; HalfSize *= 2)
+	{
+		for (int32 k = 0; k < HalfSize; ++k)
+		{
+			const double Angle = -PI * k / HalfSize;
+			TwiddleReal[HalfSize - 1 + k] = (float)FMath::Cos(Angle);
+			TwiddleImag[HalfSize - 1 + k] = (float)FMath::Sin(Angle);
+		}
+	}
+}
+
+void FFastFourierTransform::Transform(float* Real, float* Imag, bool bInverse) const
+{
+	// Inverse transform as conjugate of the forward transform of the conjugate
+	if (bInverse)
+	{
+		for (int32 i = 0; i < Size; ++i)
+		{
+			Imag[i] = -Imag[i];
+		}
+	}
+
+	for (int32 i = 0; i < BitReversalSwaps.Num(); i += 2)
+	{
+		const int32 A = BitReversalSwaps[i];
+		const int32 B = BitReversalSwaps[i + 1];
+		Swap(Real[A], Real[B]);
+		Swap(Imag[A], Imag[B]);
+	}
+
+	for (int32 HalfSize = 1; HalfSize < Size; HalfSize *= 2)
+	{
+		const float* WReal = TwiddleReal.GetData() + HalfSize - 1;
+		const float* WImag = TwiddleImag.GetData() + HalfSize - 1;
+		for (int32 Group = 0; Group < Size; Group += 2 * HalfSize)
+		{
+			float* AReal = Real + Group;
+			float* AImag = Imag + Group;
+			float* BReal = AReal + HalfSize;
+			float* BImag = AImag + HalfSize;
+
+			if (HalfSize >= 4)
+			{
+				// Four butterflies per iteration
+				for (int32 k = 0; k < HalfSize; k += 4)
+				{
+					const VectorRegister WR = VectorLoad(WReal + k);
+					const VectorRegister WI = VectorLoad(WImag + k);
+					const VectorRegister BR = VectorLoad(BReal + k);
+					const VectorRegister BI = VectorLoad(BImag + k);
+					const VectorRegister TR = VectorSubtract(VectorMultiply(BR, WR), VectorMultiply(BI, WI));
+					const VectorRegister TI = VectorMultiplyAdd(BR, WI, VectorMultiply(BI, WR));
+					const VectorRegister AR = VectorLoad(AReal + k);
+					const VectorRegister AI = VectorLoad(AImag + k);
+					VectorStore(VectorAdd(AR, TR), AReal + k);
+					VectorStore(VectorAdd(AI, TI), AImag + k);
+					VectorStore(VectorSubtract(AR, TR), BReal + k);
+					VectorStore(VectorSubtract(AI, TI), BImag + k);
+				}
+			}
+			else
+			{
+				for (int32 k = 0; k < HalfSize; ++k)
+				{
+					const float TR = BReal[k] * WReal[k] - BImag[k] * WImag[k];
+					const float TI = BReal[k] * WImag[k] + BImag[k] * WReal[k];
+					BReal[k] = AReal[k] - TR;
+					BImag[k] = AImag[k] - TI;
+					AReal[k] += TR;
+					AImag[k] += TI;
+				}
+			}
+		}
+	}
+
+	if (bInverse)
+	{
+		const float Scale = 1.0f / Size;
+		for (int32 i = 0; i < Size; ++i)
+		{
+			Real[i] *= Scale;
+			Imag[i] *= -Scale;
+		}
+	}
+}
+
+bool FFastFourierTransform::Transform2D(TArray<float>& Real, TArray<float>& Imag, int32 Width, int32 Height, bool bInverse)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousFFT);
+
+	const int64 NumValues = (int64)Width * Height;
+	if (!ensureMsgf(IsValidSize(Width) && IsValidSize(Height), TEXT("FFT size %dx%d is not a power of two"), Width, Height) ||
+		!ensureMsgf(Real.Num() == NumValues && Imag.Num() == NumValues, TEXT("FFT data does not match size %dx%d"), Width, Height))
+	{
+		return false;
+	}
+
+	const FFastFourierTransform RowTransform(Width);
+	ParallelFor(Height, [&](int32 Row) {
+		RowTransform.Transform(Real.GetData() + (int64)Row * Width, Imag.GetData() + (int64)Row * Width, bInverse);
+	});
+
+	if (Height > 1)
+	{
+		TArray<float> TransposedReal;
+		TArray<float> TransposedImag;
+		TransposedReal.SetNumUninitialized(NumValues);
+		TransposedImag.SetNumUninitialized(NumValues);
+		Transpose(Real.GetData(), TransposedReal.GetData(), Width, Height);
+		Transpose(Imag.GetData(), TransposedImag.GetData(), Width, Height);
+
+		const FFastFourierTransform ColumnTransform(Height);
+		ParallelFor(Width, [&](int32 Column) {
+			ColumnTransform.Transform(
+				TransposedReal.GetData() + (int64)Column * Height, TransposedImag.GetData() + (int64)Column * Height, bInverse);
+		});
+
+		Transpose(TransposedReal.GetData(), Real.GetData(), Height, Width);
+		Transpose(TransposedImag.GetData(), Imag.GetData(), Height, Width);
+	}
+	return true;
+}
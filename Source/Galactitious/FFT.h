@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Radix-2 complex FFT on split real and imaginary arrays.
+ * Sizes must be powers of two. Forward transforms are unnormalized, inverse transforms scale by 1 / N.
+ */
+class GALACTITIOUS_API FFastFourierTransform
+{
+public:
+	/** Precompute the permutation and twiddle factors for transforms of InSize values. */
+	explicit FFastFourierTransform(int32 InSize);
+
+	int32 GetSize() const { return Size; }
+
+	/** In-place transform of Size complex values. The plan is read-only, concurrent transforms are safe. */
+	void Transform(float* Real, float* Imag, bool bInverse = false) const;
+
+	/**
+	 * In-place 2D transform of Width x Height row-major values.
+	 * Rows are transformed in parallel, columns are transposed into contiguous rows and transformed in parallel.
+	 */
+	static bool Transform2D(TArray<float>& Real, TArray<float>& Imag, int32 Width, int32 Height, bool bInverse = false);
+
+	static bool IsValidSize(int32 InSize) { return InSize >= 1 && FMath::IsPowerOfTwo(InSize); }
+
+private:
+	int32 Size;
+
+	/** Index pairs swapped by the bit reversal permutation. */
+	TArray<int32> BitReversalSwaps;
+
+	/** Twiddle factors exp(-i pi k / H) of the stage with half size H, stored contiguously at offset H - 1. */
+	TArray<float> TwiddleReal;
+	TArray<float> TwiddleImag;
+};
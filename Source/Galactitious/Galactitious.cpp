@@ -1,6 +1,50 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Galactitious.h"
+
+#include "GalactitiousStats.h"
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Galactitious, "Galactitious" );
+
+DEFINE_STAT(STAT_GalactitiousConvertCurve);
+DEFINE_STAT(STAT_GalactitiousIntegrateCurve);
+DEFINE_STAT(STAT_GalactitiousTransformCurve);
+DEFINE_STAT(STAT_GalactitiousNormalizeCurve);
+DEFINE_STAT(STAT_GalactitiousInvertCurve);
+DEFINE_STAT(STAT_GalactitiousComputeQuantileCurve);
+
+DEFINE_STAT(STAT_GalactitiousBakeTexture);
+DEFINE_STAT(STAT_GalactitiousCreateTexture);
+DEFINE_STAT(STAT_GalactitiousUpdateTextureRegions);
+DEFINE_STAT(STAT_GalactitiousTickTextureBakeJob);
+DEFINE_STAT(STAT_GalactitiousComputePSFProfile);
+DEFINE_STAT(STAT_GalactitiousComputeAperturePSF);
+DEFINE_STAT(STAT_GalactitiousFFT);
+DEFINE_STAT(STAT_GalactitiousSplatImpostor);
+
+DEFINE_STAT(STAT_GalactitiousBuildDensitySampler);
+DEFINE_STAT(STAT_GalactitiousGenerateStars);
+DEFINE_STAT(STAT_GalactitiousBuildStarBuffer);
+DEFINE_STAT(STAT_GalactitiousBuildStarKDTree);
+DEFINE_STAT(STAT_GalactitiousQueryStarKDTree);
+DEFINE_STAT(STAT_GalactitiousUpdateStreaming);
+DEFINE_STAT(STAT_GalactitiousLoadStreamingChunk);
+
+DEFINE_STAT(STAT_GalactitiousBuildReferenceGrids);
+DEFINE_STAT(STAT_GalactitiousRenderReferencePass);
+
+DEFINE_STAT(STAT_GalactitiousUpdateGalaxyShapeParameters);
+DEFINE_STAT(STAT_GalactitiousUpdateStarParameters);
+DEFINE_STAT(STAT_GalactitiousUpdateGalaxyParameterBlock);
+DEFINE_STAT(STAT_GalactitiousSetCurveParameter);
+DEFINE_STAT(STAT_GalactitiousSetFloatParameter);
+DEFINE_STAT(STAT_GalactitiousSetTextureParameter);
+DEFINE_STAT(STAT_GalactitiousSetLookupTableParameter);
+
+DEFINE_STAT(STAT_GalactitiousRadialSamplingMemory);
+DEFINE_STAT(STAT_GalactitiousStellarSamplingMemory);
+DEFINE_STAT(STAT_GalactitiousTextureBakeMemory);
+DEFINE_STAT(STAT_GalactitiousStreamingMemory);
+
+CSV_DEFINE_CATEGORY_MODULE(GALACTITIOUS_API, Galactitious, true);
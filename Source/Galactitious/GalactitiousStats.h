@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("Galactitious"), STATGROUP_Galactitious, STATCAT_Advanced);
+
+// Probability curves
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Convert Curve"), STAT_GalactitiousConvertCurve, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Integrate Curve"), STAT_GalactitiousIntegrateCurve, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Transform Curve"), STAT_GalactitiousTransformCurve, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Normalize Curve"), STAT_GalactitiousNormalizeCurve, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Invert Curve"), STAT_GalactitiousInvertCurve, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Quantile Curve"), STAT_GalactitiousComputeQuantileCurve, STATGROUP_Galactitious, GALACTITIOUS_API);
+
+// Texture baking
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Bake Texture"), STAT_GalactitiousBakeTexture, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Create Texture"), STAT_GalactitiousCreateTexture, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(
+	TEXT("Update Texture Regions"), STAT_GalactitiousUpdateTextureRegions, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick Texture Bake Job"), STAT_GalactitiousTickTextureBakeJob, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute PSF Profile"), STAT_GalactitiousComputePSFProfile, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Compute Aperture PSF"), STAT_GalactitiousComputeAperturePSF, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("FFT 2D"), STAT_GalactitiousFFT, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Splat Impostor"), STAT_GalactitiousSplatImpostor, STATGROUP_Galactitious, GALACTITIOUS_API);
+
+// Star generation
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Density Sampler"), STAT_GalactitiousBuildDensitySampler, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Generate Stars"), STAT_GalactitiousGenerateStars, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Star Buffer"), STAT_GalactitiousBuildStarBuffer, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Star KD-Tree"), STAT_GalactitiousBuildStarKDTree, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Query Star KD-Tree"), STAT_GalactitiousQueryStarKDTree, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Streaming"), STAT_GalactitiousUpdateStreaming, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(
+	TEXT("Load Streaming Chunk"), STAT_GalactitiousLoadStreamingChunk, STATGROUP_Galactitious, GALACTITIOUS_API);
+
+// Reference rendering
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Reference Grids"), STAT_GalactitiousBuildReferenceGrids, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Render Reference Pass"), STAT_GalactitiousRenderReferencePass, STATGROUP_Galactitious, GALACTITIOUS_API);
+
+// Niagara parameter updates
+DECLARE_CYCLE_STAT_EXTERN(
+	TEXT("Update Galaxy Shape Parameters"), STAT_GalactitiousUpdateGalaxyShapeParameters, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Star Parameters"), STAT_GalactitiousUpdateStarParameters, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(
+	TEXT("Update Galaxy Parameter Block"), STAT_GalactitiousUpdateGalaxyParameterBlock, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Set Curve Parameter"), STAT_GalactitiousSetCurveParameter, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Set Float Parameter"), STAT_GalactitiousSetFloatParameter, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Set Texture Parameter"), STAT_GalactitiousSetTextureParameter, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_CYCLE_STAT_EXTERN(
+	TEXT("Set Lookup Table Parameter"), STAT_GalactitiousSetLookupTableParameter, STATGROUP_Galactitious, GALACTITIOUS_API);
+
+// Derived table sizes
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Radial Sampling Tables"), STAT_GalactitiousRadialSamplingMemory, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Stellar Sampling Tables"), STAT_GalactitiousStellarSamplingMemory, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Texture Bake Buffer"), STAT_GalactitiousTextureBakeMemory, STATGROUP_Galactitious, GALACTITIOUS_API);
+DECLARE_MEMORY_STAT_EXTERN(TEXT("Streaming Chunks"), STAT_GalactitiousStreamingMemory, STATGROUP_Galactitious, GALACTITIOUS_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(GALACTITIOUS_API, Galactitious);
+
+// Cycle counters already emit Insights CPU events when stats are enabled,
+// only add an explicit trace scope for configurations without stats (Test).
+#if STATS
+#define GALACTITIOUS_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat);                 \
+	CSV_SCOPED_TIMING_STAT(Galactitious, Stat)
+#else
+#define GALACTITIOUS_SCOPE_CYCLE_COUNTER(Stat) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat);       \
+	CSV_SCOPED_TIMING_STAT(Galactitious, Stat)
+#endif
@@ -1,3 +1,139 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "GalactitiousSubsystem.h"
+
+#include "GalactitiousStats.h"
+#include "GalaxyParameterComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "RenderCore.h"
+#include "RHI.h"
+
+static TAutoConsoleVariable<float> CVarTextureBakeFrameBudgetMs(
+	TEXT("Galactitious.TextureBake.FrameBudgetMs"), 2.0f,
+	TEXT("Game thread time per frame in milliseconds for incremental texture bakes. At least one tile is baked per job and frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarParticleBudgetTargetFrameTimeMs(
+	TEXT("Galactitious.ParticleBudget.TargetFrameTimeMs"), 16.7f,
+	TEXT("Frame time in milliseconds the particle budget of galaxies converges to, 0 disables the budget and draws all particles."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarParticleBudgetHysteresis(
+	TEXT("Galactitious.ParticleBudget.Hysteresis"), 0.1f,
+	TEXT("Relative band around the target frame time in which the particle budget does not change."), ECVF_Default);
+
+void UGalactitiousSubsystem::AddBakeJob(const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe>& Job)
+{
+	check(IsInGameThread());
+
+	if (!Job->Name.IsNone())
+	{
+		CancelBakeJobs(Job->Name);
+	}
+	BakeJobs.AddUnique(Job);
+}
+
+void UGalactitiousSubsystem::CancelBakeJobs(FName Name)
+{
+	for (const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe>& Job : BakeJobs)
+	{
+		if (Job->Name == Name)
+		{
+			Job->Cancel();
+		}
+	}
+}
+
+void UGalactitiousSubsystem::RegisterParticleBudget(UGalaxyParameterComponent* Galaxy)
+{
+	check(IsInGameThread());
+
+	BudgetedGalaxies.AddUnique(Galaxy);
+	Galaxy->SetParticleBudget(ParticleBudget.GetBudgetFraction());
+}
+
+void UGalactitiousSubsystem::UnregisterParticleBudget(UGalaxyParameterComponent* Galaxy)
+{
+	check(IsInGameThread());
+
+	BudgetedGalaxies.Remove(Galaxy);
+	if (BudgetedGalaxies.Num() == 0)
+	{
+		ParticleBudget.Reset();
+	}
+}
+
+void UGalactitiousSubsystem::Deinitialize()
+{
+	for (const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe>& Job : BakeJobs)
+	{
+		Job->Cancel();
+	}
+	BakeJobs.Empty();
+	BudgetedGalaxies.Empty();
+
+	Super::Deinitialize();
+}
+
+void UGalactitiousSubsystem::Tick(float DeltaTime)
+{
+	if (BudgetedGalaxies.Num() > 0)
+	{
+		TickParticleBudget(DeltaTime);
+	}
+
+	const double EndTime = FPlatformTime::Seconds() + CVarTextureBakeFrameBudgetMs.GetValueOnGameThread() * 0.001;
+
+	// Finish and remove jobs in order, later jobs get the remaining budget
+	for (int32 i = 0; i < BakeJobs.Num();)
+	{
+		const double BudgetSeconds = FMath::Max(EndTime - FPlatformTime::Seconds(), 0.0);
+		if (BakeJobs[i]->Tick(BudgetSeconds))
+		{
+			BakeJobs.RemoveAt(i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+void UGalactitiousSubsystem::TickParticleBudget(float DeltaTime)
+{
+	FParticleBudgetSettings& Settings = ParticleBudget.Settings;
+	Settings.TargetFrameTimeMs = CVarParticleBudgetTargetFrameTimeMs.GetValueOnGameThread();
+	Settings.Hysteresis = CVarParticleBudgetHysteresis.GetValueOnGameThread();
+
+	bool bChanged = false;
+	if (Settings.TargetFrameTimeMs <= 0.0f)
+	{
+		bChanged = ParticleBudget.GetBudgetFraction() != 1.0f;
+		ParticleBudget.Reset();
+	}
+	else
+	{
+		// Times of the previous frame, the slowest of game thread, render thread and GPU limits the frame rate
+		const uint32 FrameCycles = FMath::Max3(GGameThreadTime, GRenderThreadTime, RHIGetGPUFrameCycles());
+		bChanged = ParticleBudget.Update(DeltaTime, FPlatformTime::ToMilliseconds(FrameCycles));
+	}
+
+	if (bChanged)
+	{
+		BudgetedGalaxies.RemoveAll([](const TWeakObjectPtr<UGalaxyParameterComponent>& Galaxy) { return !Galaxy.IsValid(); });
+		for (const TWeakObjectPtr<UGalaxyParameterComponent>& Galaxy : BudgetedGalaxies)
+		{
+			Galaxy->SetParticleBudget(ParticleBudget.GetBudgetFraction());
+		}
+	}
+}
+
+TStatId UGalactitiousSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGalactitiousSubsystem, STATGROUP_Galactitious);
+}
+
+bool UGalactitiousSubsystem::IsTickable() const
+{
+	return (BakeJobs.Num() > 0 || BudgetedGalaxies.Num() > 0) && !HasAnyFlags(RF_ClassDefaultObject);
+}
@@ -4,6 +4,55 @@
 
 #include "CoreMinimal.h"
 #include "Subsystems/EngineSubsystem.h"
+#include "ParticleBudget.h"
+#include "Tickable.h"
+#include "TextureBakeJob.h"
 
-//#include "GalactitiousSubsystem.generated.h"
+#include "GalactitiousSubsystem.generated.h"
 
+class UGalaxyParameterComponent;
+
+/**
+ * Engine-wide services of the Galactitious module, ticks incremental texture bakes in game and editor
+ * and the particle budget shared by all registered galaxies.
+ */
+UCLASS()
+class GALACTITIOUS_API UGalactitiousSubsystem : public UEngineSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Tick the job until it is finished. Jobs baking on the game thread share the frame budget of Galactitious.TextureBake.FrameBudgetMs.
+	 * Running jobs with the same name are cancelled, so restarting a bake with changed parameters discards the outdated one.
+	 */
+	void AddBakeJob(const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe>& Job);
+
+	/** Cancel all running jobs with the given name. */
+	void CancelBakeJobs(FName Name);
+
+	int32 GetNumBakeJobs() const { return BakeJobs.Num(); }
+
+	/** Scale the active particles of the galaxy with the frame time, see Galactitious.ParticleBudget.TargetFrameTimeMs. */
+	void RegisterParticleBudget(UGalaxyParameterComponent* Galaxy);
+	void UnregisterParticleBudget(UGalaxyParameterComponent* Galaxy);
+
+	const FParticleBudgetController& GetParticleBudget() const { return ParticleBudget; }
+
+	virtual void Deinitialize() override;
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Conditional; }
+
+private:
+	void TickParticleBudget(float DeltaTime);
+
+	TArray<TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe>> BakeJobs;
+
+	FParticleBudgetController ParticleBudget;
+	TArray<TWeakObjectPtr<UGalaxyParameterComponent>> BudgetedGalaxies;
+};
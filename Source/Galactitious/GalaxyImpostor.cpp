@@ -0,0 +1,486 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalaxyImpostor.h"
+
+#include "GalactitiousStats.h"
+#include "NiagaraComponent.h"
+#include "SpectrumFunctionLibrary.h"
+#include "StarGenerator.h"
+#include "StellarSamplingData.h"
+#include "TelescopeData.h"
+#include "TextureBakerFunctionLibrary.h"
+#include "Async/ParallelFor.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+namespace
+{
+	/** Stars projected and binned per task. */
+	const int32 SplatChunkSize = 16 * 1024;
+
+	/** Subsamples per axis of kernel pixels. */
+	const int32 KernelSupersampling = 4;
+
+	float Luminance(const FLinearColor& Color)
+	{
+		return 0.2126f * Color.R + 0.7152f * Color.G + 0.0722f * Color.B;
+	}
+} // namespace
+
+void FImpostorSplatKernel::BuildGaussian(int32 InRadius)
+{
+	Radius = FMath::Max(InRadius, 0);
+	const int32 Size = GetSize();
+	const float Sigma = FMath::Max(0.5f * Radius, 0.5f);
+	Weights.SetNumUninitialized(Size * Size);
+	for (int32 y = 0; y < Size; ++y)
+	{
+		for (int32 x = 0; x < Size; ++x)
+		{
+			const float Weight = FMath::Exp(-0.5f * (FMath::Square(x - Radius) + FMath::Square(y - Radius)) / FMath::Square(Sigma));
+			Weights[y * Size + x] = FLinearColor(Weight, Weight, Weight, 1.0f);
+		}
+	}
+	Normalize();
+}
+
+void FImpostorSplatKernel::BuildTelescopePSF(const UTelescopeData& Telescope, int32 InRadius)
+{
+	// Same PSF evaluation as the baked telescope textures
+	FTelescopePSFProfile Profile;
+	FTelescopeAperturePSF AperturePSF;
+	TFunction<FLinearColor(float X, float Y)> EvalPSF = [&Telescope](float X, float Y) {
+		const float Intensity = Telescope.EvalAiryDiskIntensity(X, Y);
+		return FLinearColor(Intensity, Intensity, Intensity, 1.0f);
+	};
+	if (Telescope.PSFMode == ETelescopePSFMode::AnnularPolychromatic)
+	{
+		Telescope.ComputePSFProfile(Profile);
+		EvalPSF = [&Telescope, &Profile](float X, float Y) { return Telescope.EvalPSF(Profile, X, Y); };
+	}
+	else if (Telescope.PSFMode == ETelescopePSFMode::ApertureFFT && Telescope.ComputeAperturePSF(AperturePSF))
+	{
+		EvalPSF = [&Telescope, &AperturePSF](float X, float Y) { return Telescope.EvalAperturePSF(AperturePSF, X, Y); };
+	}
+
+	// The texture extent [0, 1] covers the kernel, each kernel pixel averages subsamples
+	Radius = FMath::Max(InRadius, 0);
+	const int32 Size = GetSize();
+	Weights.SetNumUninitialized(Size * Size);
+	for (int32 y = 0; y < Size; ++y)
+	{
+		for (int32 x = 0; x < Size; ++x)
+		{
+			FLinearColor Weight = FLinearColor::Transparent;
+			for (int32 SubY = 0; SubY < KernelSupersampling; ++SubY)
+			{
+				for (int32 SubX = 0; SubX < KernelSupersampling; ++SubX)
+				{
+					const float X = (x + (SubX + 0.5f) / KernelSupersampling) / Size;
+					const float Y = (y + (SubY + 0.5f) / KernelSupersampling) / Size;
+					Weight += EvalPSF(X, Y);
+				}
+			}
+			Weights[y * Size + x] = Weight;
+		}
+	}
+	Normalize();
+}
+
+void FImpostorSplatKernel::Normalize()
+{
+	double TotalLuminance = 0.0;
+	for (const FLinearColor& Weight : Weights)
+	{
+		TotalLuminance += Luminance(Weight);
+	}
+	if (!ensureMsgf(TotalLuminance > 0.0, TEXT("Splat kernel has no energy")))
+	{
+		return;
+	}
+
+	// Alpha holds the luminance of the weight, so splatted alpha is the luminosity density regardless of color
+	const float Scale = (float)(1.0 / TotalLuminance);
+	for (FLinearColor& Weight : Weights)
+	{
+		Weight *= Scale;
+		Weight.A = Luminance(Weight);
+	}
+}
+
+bool FGalaxyImpostorBaker::SplatStars(
+	const FStarBuffer& Stars, const FImpostorSplatKernel& Kernel, float Inclination, int32 Resolution, TArray<FLinearColor>& OutImage)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSplatImpostor);
+
+	const int32 TileSize = UTextureBakerFunctionLibrary::BakeTileSize;
+	const int32 Radius = Kernel.Radius;
+	const int32 KernelSize = Kernel.GetSize();
+	if (!ensureMsgf(
+			Resolution > 0 && Radius >= 0 && Radius <= TileSize && Kernel.Weights.Num() == KernelSize * KernelSize,
+			TEXT("Invalid impostor resolution %d or splat kernel radius %d"), Resolution, Radius))
+	{
+		return false;
+	}
+
+	OutImage.Reset();
+	OutImage.SetNumZeroed(Resolution * Resolution);
+
+	const int32 NumStars = Stars.Num();
+	float MinTemperature = MAX_flt;
+	float MaxTemperature = 0.0f;
+	double TotalLuminosity = 0.0;
+	for (int32 i = 0; i < NumStars; ++i)
+	{
+		MinTemperature = FMath::Min(MinTemperature, Stars.Temperature[i]);
+		MaxTemperature = FMath::Max(MaxTemperature, Stars.Temperature[i]);
+		TotalLuminosity += FMath::Exp(Stars.LogLuminosity[i]) * Stars.StarCount[i];
+	}
+	if (NumStars == 0 || TotalLuminosity <= 0.0)
+	{
+		return true;
+	}
+
+	// Blackbody colors have unit luminance
+	FBlackbodyColorTable ColorTable;
+	ColorTable.Build(MinTemperature, MaxTemperature);
+
+	// An image evenly covered by all stars has unit luminance per pixel
+	const float LuminosityScale = (float)((double)Resolution * Resolution / TotalLuminosity);
+
+	float Sin, Cos;
+	FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Inclination));
+	const float PixelScale = 0.5f * Resolution;
+	auto ProjectStar = [&](int32 Index, int32& OutX, int32& OutY) {
+		OutX = FMath::FloorToInt((Stars.PositionX[Index] + 1.0f) * PixelScale);
+		OutY = FMath::FloorToInt((Stars.PositionY[Index] * Cos + Stars.PositionZ[Index] * Sin + 1.0f) * PixelScale);
+		return OutX >= -Radius && OutX < Resolution + Radius && OutY >= -Radius && OutY < Resolution + Radius;
+	};
+
+	const int32 NumTilesX = FMath::DivideAndRoundUp(Resolution, TileSize);
+	const int32 NumTiles = NumTilesX * NumTilesX;
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumStars, SplatChunkSize);
+
+	// Count stars per chunk and tile, stars outside the image go to the nearest tile whose margin covers them
+	TArray<int32> StarTiles;
+	StarTiles.SetNumUninitialized(NumStars);
+	TArray<int32> ChunkTileOffsets;
+	ChunkTileOffsets.SetNumZeroed(NumChunks * NumTiles);
+	ParallelFor(NumChunks, [&](int32 Chunk) {
+		int32* Counts = &ChunkTileOffsets[Chunk * NumTiles];
+		const int32 End = FMath::Min((Chunk + 1) * SplatChunkSize, NumStars);
+		for (int32 i = Chunk * SplatChunkSize; i < End; ++i)
+		{
+			int32 X, Y;
+			if (!ProjectStar(i, X, Y))
+			{
+				StarTiles[i] = INDEX_NONE;
+				continue;
+			}
+			const int32 TileX = FMath::Clamp(X, 0, Resolution - 1) / TileSize;
+			const int32 TileY = FMath::Clamp(Y, 0, Resolution - 1) / TileSize;
+			StarTiles[i] = TileY * NumTilesX + TileX;
+			++Counts[StarTiles[i]];
+		}
+	});
+
+	// Offsets in (tile, chunk) order keep the stars of a tile in buffer order
+	TArray<int32> TileBegin;
+	TileBegin.SetNumUninitialized(NumTiles + 1);
+	int32 Offset = 0;
+	for (int32 Tile = 0; Tile < NumTiles; ++Tile)
+	{
+		TileBegin[Tile] = Offset;
+		for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+		{
+			int32& ChunkOffset = ChunkTileOffsets[Chunk * NumTiles + Tile];
+			const int32 Count = ChunkOffset;
+			ChunkOffset = Offset;
+			Offset += Count;
+		}
+	}
+	TileBegin[NumTiles] = Offset;
+
+	TArray<int32> SortedStars;
+	SortedStars.SetNumUninitialized(Offset);
+	ParallelFor(NumChunks, [&](int32 Chunk) {
+		int32* Offsets = &ChunkTileOffsets[Chunk * NumTiles];
+		const int32 End = FMath::Min((Chunk + 1) * SplatChunkSize, NumStars);
+		for (int32 i = Chunk * SplatChunkSize; i < End; ++i)
+		{
+			if (StarTiles[i] != INDEX_NONE)
+			{
+				SortedStars[Offsets[StarTiles[i]]++] = i;
+			}
+		}
+	});
+
+	// Each tile splats its stars into a private buffer with a margin of the kernel radius
+	const int32 PaddedSize = TileSize + 2 * Radius;
+	TArray<TArray<FLinearColor>> TileBuffers;
+	TileBuffers.SetNum(NumTiles);
+	ParallelFor(NumTiles, [&](int32 Tile) {
+		if (TileBegin[Tile] == TileBegin[Tile + 1])
+		{
+			return;
+		}
+
+		TArray<FLinearColor>& Buffer = TileBuffers[Tile];
+		Buffer.SetNumZeroed(PaddedSize * PaddedSize);
+		const int32 OriginX = (Tile % NumTilesX) * TileSize - Radius;
+		const int32 OriginY = (Tile / NumTilesX) * TileSize - Radius;
+		for (int32 Sorted = TileBegin[Tile]; Sorted < TileBegin[Tile + 1]; ++Sorted)
+		{
+			const int32 i = SortedStars[Sorted];
+			int32 X, Y;
+			ProjectStar(i, X, Y);
+
+			const FLinearColor Color =
+				ColorTable.Eval(Stars.Temperature[i]) * (FMath::Exp(Stars.LogLuminosity[i]) * Stars.StarCount[i] * LuminosityScale);
+
+			// Kernel origin in buffer coordinates, clipped to the buffer for stars clamped into edge tiles
+			const int32 KernelX = X - Radius - OriginX;
+			const int32 KernelY = Y - Radius - OriginY;
+			const int32 BeginKX = FMath::Max(0, -KernelX);
+			const int32 EndKX = FMath::Min(KernelSize, PaddedSize - KernelX);
+			const int32 BeginKY = FMath::Max(0, -KernelY);
+			const int32 EndKY = FMath::Min(KernelSize, PaddedSize - KernelY);
+			// Rows start at the first kernel column inside the buffer, KernelX may be negative
+			for (int32 ky = BeginKY; ky < EndKY; ++ky)
+			{
+				FLinearColor* Row = Buffer.GetData() + (KernelY + ky) * PaddedSize + KernelX + BeginKX;
+				const FLinearColor* Weights = Kernel.Weights.GetData() + ky * KernelSize + BeginKX;
+				for (int32 kx = 0; kx < EndKX - BeginKX; ++kx)
+				{
+					Row[kx] += Color * Weights[kx];
+				}
+			}
+		}
+	});
+
+	// Output tiles sum the overlapping buffers of their neighbors in a fixed order
+	ParallelFor(NumTiles, [&](int32 Tile) {
+		const int32 TileX = Tile % NumTilesX;
+		const int32 TileY = Tile / NumTilesX;
+		const int32 BeginX = TileX * TileSize;
+		const int32 BeginY = TileY * TileSize;
+		const int32 EndX = FMath::Min(BeginX + TileSize, Resolution);
+		const int32 EndY = FMath::Min(BeginY + TileSize, Resolution);
+		for (int32 NeighborY = FMath::Max(TileY - 1, 0); NeighborY <= FMath::Min(TileY + 1, NumTilesX - 1); ++NeighborY)
+		{
+			for (int32 NeighborX = FMath::Max(TileX - 1, 0); NeighborX <= FMath::Min(TileX + 1, NumTilesX - 1); ++NeighborX)
+			{
+				const TArray<FLinearColor>& Buffer = TileBuffers[NeighborY * NumTilesX + NeighborX];
+				if (Buffer.Num() == 0)
+				{
+					continue;
+				}
+
+				const int32 OriginX = NeighborX * TileSize - Radius;
+				const int32 OriginY = NeighborY * TileSize - Radius;
+				const int32 OverlapBeginX = FMath::Max(BeginX, OriginX);
+				const int32 OverlapEndX = FMath::Min(EndX, OriginX + PaddedSize);
+				const int32 OverlapEndY = FMath::Min(EndY, OriginY + PaddedSize);
+				for (int32 y = FMath::Max(BeginY, OriginY); y < OverlapEndY; ++y)
+				{
+					FLinearColor* Row = OutImage.GetData() + y * Resolution + OverlapBeginX;
+					const FLinearColor* BufferRow = Buffer.GetData() + (y - OriginY) * PaddedSize + OverlapBeginX - OriginX;
+					for (int32 x = 0; x < OverlapEndX - OverlapBeginX; ++x)
+					{
+						Row[x] += BufferRow[x];
+					}
+				}
+			}
+		}
+	});
+
+	return true;
+}
+
+int32 UGalaxyImpostorData::FindNearestInclination(float Inclination) const
+{
+	int32 NearestIndex = INDEX_NONE;
+	float NearestDistance = MAX_flt;
+	for (int32 i = 0; i < FMath::Min(Inclinations.Num(), ImpostorTextures.Num()); ++i)
+	{
+		const float Distance = FMath::Abs(Inclinations[i] - Inclination);
+		if (ImpostorTextures[i] != nullptr && Distance < NearestDistance)
+		{
+			NearestIndex = i;
+			NearestDistance = Distance;
+		}
+	}
+	return NearestIndex;
+}
+
+#if WITH_EDITOR
+void UGalaxyImpostorData::BakeTextures()
+{
+	if (!ensureMsgf(ShapeSettings != nullptr && StarSettings != nullptr, TEXT("Impostor shape or star settings not set")))
+	{
+		return;
+	}
+
+	FGalaxyShapeSamplingData ShapeData;
+	FStarSamplingData StarData;
+	if (!ShapeSettings->ComputeSamplingData(ShapeData) || !StarSettings->ComputeSamplingData(StarData))
+	{
+		return;
+	}
+
+	FStarGeneratorSettings GeneratorSettings;
+	GeneratorSettings.NumParticles = NumParticles;
+	GeneratorSettings.Seed = Seed;
+	GeneratorSettings.Sequence = Sequence;
+	FStarBuffer Stars;
+	if (!FGalaxyStarGenerator::Generate(*ShapeSettings, ShapeData, StarData, GeneratorSettings, Stars))
+	{
+		return;
+	}
+
+	FImpostorSplatKernel Kernel;
+	if (Telescope != nullptr)
+	{
+		Kernel.BuildTelescopePSF(*Telescope, KernelRadius);
+	}
+	else
+	{
+		Kernel.BuildGaussian(KernelRadius);
+	}
+
+	ImpostorTextures.SetNum(Inclinations.Num());
+	TArray<FLinearColor> Image;
+	for (int32 i = 0; i < Inclinations.Num(); ++i)
+	{
+		if (!FGalaxyImpostorBaker::SplatStars(Stars, Kernel, Inclinations[i], Resolution, Image))
+		{
+			return;
+		}
+
+		const FString TexturePath =
+			ImpostorTextures[i] ? ImpostorTextures[i]->GetPathName() : GetOutermost()->GetName() + FString::Printf(TEXT("_Impostor%d"), i);
+		ImpostorTextures[i] = UTextureBakerFunctionLibrary::BakeTextureAssetRGBA16FRows(
+			TexturePath, Resolution, Resolution, PF_FloatRGBA, TMGS_FromTextureGroup,
+			[this, &Image](float X0, float dX, float Y, int32 Count, FLinearColor* OutValues) {
+				const int32 Row = FMath::RoundToInt(Y * (Resolution - 1));
+				const int32 Column = FMath::RoundToInt(X0 * (Resolution - 1));
+				FMemory::Memcpy(OutValues, &Image[Row * Resolution + Column], Count * sizeof(FLinearColor));
+			});
+	}
+
+	MarkPackageDirty();
+}
+#endif
+
+UGalaxyImpostorComponent::UGalaxyImpostorComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickInterval = 0.1f;
+}
+
+void UGalaxyImpostorComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	GalaxySystem = GetOwner()->FindComponentByClass<UNiagaraComponent>();
+
+	Card = NewObject<UStaticMeshComponent>(GetOwner(), TEXT("ImpostorCard"));
+	Card->SetStaticMesh(CardMesh);
+	Card->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Card->SetCastShadow(false);
+	Card->SetupAttachment(this);
+	Card->SetUsingAbsoluteRotation(true);
+	Card->RegisterComponent();
+	Card->SetVisibility(false);
+
+	if (CardMaterial != nullptr)
+	{
+		CardMaterialInstance = UMaterialInstanceDynamic::Create(CardMaterial, this);
+		Card->SetMaterial(0, CardMaterialInstance);
+	}
+}
+
+void UGalaxyImpostorComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (Card != nullptr)
+	{
+		Card->DestroyComponent();
+		Card = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UGalaxyImpostorComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr || ImpostorData == nullptr)
+	{
+		return;
+	}
+
+	const FVector CameraLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	const float Distance = FVector::Dist(CameraLocation, GetComponentLocation());
+	const float Threshold = SwapDistance * (bShowingImpostor ? 1.0f - SwapHysteresis : 1.0f + SwapHysteresis);
+	SetShowImpostor(Distance > Threshold);
+
+	if (bShowingImpostor)
+	{
+		UpdateCard(CameraLocation);
+	}
+}
+
+void UGalaxyImpostorComponent::SetShowImpostor(bool bShow)
+{
+	if (bShow == bShowingImpostor)
+	{
+		return;
+	}
+	bShowingImpostor = bShow;
+
+	if (GalaxySystem != nullptr)
+	{
+		GalaxySystem->SetPaused(bShow);
+		GalaxySystem->SetVisibility(!bShow);
+	}
+	if (Card != nullptr)
+	{
+		Card->SetVisibility(bShow);
+	}
+}
+
+void UGalaxyImpostorComponent::UpdateCard(const FVector& CameraLocation)
+{
+	if (Card == nullptr)
+	{
+		return;
+	}
+
+	// Impostors are tilted around the galaxy X axis, the card keeps the line of nodes as its X axis
+	const FVector ToCamera = (CameraLocation - GetComponentLocation()).GetSafeNormal();
+	const FVector GalaxyUp = GetUpVector();
+	const float Inclination = FMath::RadiansToDegrees(FMath::Acos(FMath::Min(FMath::Abs(FVector::DotProduct(ToCamera, GalaxyUp)), 1.0f)));
+	FVector AxisX = FVector::CrossProduct(GalaxyUp, ToCamera);
+	if (!AxisX.Normalize())
+	{
+		AxisX = GetForwardVector();
+	}
+	Card->SetWorldRotation(FRotationMatrix::MakeFromZX(ToCamera, AxisX).Rotator());
+
+	// The card mesh is 100 units wide, impostors cover the galaxy radius on each side
+	const float Radius = ImpostorData->ShapeSettings != nullptr ? ImpostorData->ShapeSettings->Radius : 1.0f;
+	Card->SetWorldScale3D(FVector(2.0f * Radius * GetComponentScale().GetMax() / 100.0f));
+
+	const int32 InclinationIndex = ImpostorData->FindNearestInclination(Inclination);
+	if (InclinationIndex != CardInclinationIndex && InclinationIndex != INDEX_NONE && CardMaterialInstance != nullptr)
+	{
+		CardMaterialInstance->SetTextureParameterValue(TEXT("ImpostorTexture"), ImpostorData->ImpostorTextures[InclinationIndex]);
+		CardInclinationIndex = InclinationIndex;
+	}
+}
@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "Engine/DataAsset.h"
+#include "SampleSequence.h"
+
+#include "GalaxyImpostor.generated.h"
+
+class UGalaxyShapeSettings;
+class UMaterialInstanceDynamic;
+class UMaterialInterface;
+class UNiagaraComponent;
+class UStarSettings;
+class UStaticMesh;
+class UStaticMeshComponent;
+class UTelescopeData;
+class UTexture2D;
+struct FStarBuffer;
+
+/** Splat kernel of impostor bakes, (2 * Radius + 1)^2 row-major weights normalized to unit luminance. */
+struct GALACTITIOUS_API FImpostorSplatKernel
+{
+	int32 Radius = 0;
+	TArray<FLinearColor> Weights;
+
+	/** Gaussian with a standard deviation of half the radius. */
+	void BuildGaussian(int32 InRadius);
+
+	/** Point spread function of the telescope, its texture extent mapped to the kernel. */
+	void BuildTelescopePSF(const UTelescopeData& Telescope, int32 InRadius);
+
+	int32 GetSize() const { return 2 * Radius + 1; }
+
+private:
+	void Normalize();
+};
+
+class GALACTITIOUS_API FGalaxyImpostorBaker
+{
+public:
+	/**
+	 * Project stars onto a Resolution^2 image covering [-1, 1], viewed at an inclination in degrees from the galaxy normal,
+	 * tilted around the X axis. Each particle splats its luminosity exp(ln(L)) * star count, colored by its blackbody temperature.
+	 * Values are relative, an image evenly covered by all stars has unit luminance per pixel.
+	 *
+	 * Stars are binned into tiles of BakeTileSize by a counting sort. Each tile accumulates its stars into a private buffer with a
+	 * margin of the kernel radius, then output tiles sum the overlapping buffers of their neighbors. No atomics are used and the
+	 * result does not depend on the number of threads.
+	 */
+	static bool SplatStars(
+		const FStarBuffer& Stars, const FImpostorSplatKernel& Kernel, float Inclination, int32 Resolution, TArray<FLinearColor>& OutImage);
+};
+
+/** Settings and baked textures of distant galaxy impostors. */
+UCLASS(BlueprintType)
+class GALACTITIOUS_API UGalaxyImpostorData : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+#if WITH_EDITOR
+	/** Generate a star buffer and bake one impostor texture per inclination. */
+	UFUNCTION(BlueprintCallable, CallInEditor)
+	void BakeTextures();
+#endif
+
+	/** Index of the baked inclination closest to a view inclination in degrees, INDEX_NONE without textures. */
+	int32 FindNearestInclination(float Inclination) const;
+
+	UPROPERTY(EditAnywhere)
+	UGalaxyShapeSettings* ShapeSettings;
+
+	UPROPERTY(EditAnywhere)
+	UStarSettings* StarSettings;
+
+	/** Telescope whose point spread function is used as splat kernel, a Gaussian kernel if not set. */
+	UPROPERTY(EditAnywhere)
+	UTelescopeData* Telescope;
+
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "1"))
+	int32 NumParticles = 1000000;
+
+	UPROPERTY(EditAnywhere)
+	int32 Seed = 0;
+
+	UPROPERTY(EditAnywhere)
+	ESampleSequence Sequence = ESampleSequence::Sobol;
+
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "16", ClampMax = "4096"))
+	int32 Resolution = 1024;
+
+	/** Splat kernel radius in pixels. */
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0", ClampMax = "32"))
+	int32 KernelRadius = 4;
+
+	/** Inclinations from the galaxy normal in degrees, 0 is face-on. */
+	UPROPERTY(EditAnywhere)
+	TArray<float> Inclinations = {0.0f, 30.0f, 60.0f, 80.0f};
+
+	/** Baked impostors matching Inclinations, RGBA16F with relative luminance. */
+	UPROPERTY(EditAnywhere)
+	TArray<UTexture2D*> ImpostorTextures;
+};
+
+/**
+ * Swaps the Niagara galaxy system of its owner for a camera facing card with a baked impostor beyond a distance threshold.
+ * The galaxy system is paused and hidden rather than deactivated, so swapping back does not respawn particles.
+ */
+UCLASS(ClassGroup = (Galactitious), meta = (BlueprintSpawnableComponent))
+class GALACTITIOUS_API UGalaxyImpostorComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UGalaxyImpostorComponent();
+
+	UPROPERTY(EditAnywhere, Category = "Impostor")
+	UGalaxyImpostorData* ImpostorData;
+
+	/** Card mesh in the XY plane of 100 units, e.g. /Engine/BasicShapes/Plane. */
+	UPROPERTY(EditAnywhere, Category = "Impostor")
+	UStaticMesh* CardMesh;
+
+	/** Card material, the impostor is set as texture parameter ImpostorTexture. */
+	UPROPERTY(EditAnywhere, Category = "Impostor")
+	UMaterialInterface* CardMaterial;
+
+	/** Camera distance beyond which the impostor is shown. */
+	UPROPERTY(EditAnywhere, Category = "Impostor", meta = (ClampMin = "0"))
+	float SwapDistance = 1.0e6f;
+
+	/** Relative distance band around SwapDistance without swaps, avoids flickering at the threshold. */
+	UPROPERTY(EditAnywhere, Category = "Impostor", meta = (ClampMin = "0", ClampMax = "0.5"))
+	float SwapHysteresis = 0.1f;
+
+	bool IsShowingImpostor() const { return bShowingImpostor; }
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	void SetShowImpostor(bool bShow);
+	void UpdateCard(const FVector& CameraLocation);
+
+	UPROPERTY(Transient)
+	UNiagaraComponent* GalaxySystem;
+
+	UPROPERTY(Transient)
+	UStaticMeshComponent* Card;
+
+	UPROPERTY(Transient)
+	UMaterialInstanceDynamic* CardMaterialInstance;
+
+	int32 CardInclinationIndex = INDEX_NONE;
+	bool bShowingImpostor = false;
+};
@@ -2,18 +2,41 @@
 
 
 #include "GalaxyNiagaraFunctionLibrary.h"
+#include "GalactitiousStats.h"
 #include "ProbabilityCurveFunctionLibrary.h"
 
 #include "Curves/CurveFloat.h"
 #include "Curves/CurveLinearColor.h"
+#include "NiagaraComponent.h"
 #include "NiagaraDataInterfaceCurve.h"
+#include "NiagaraDataInterfaceLookupTable.h"
+#include "NiagaraDataInterfaceTexture.h"
 #include "NiagaraParameterCollection.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogGalaxyNiagara, Log, All);
 
+namespace
+{
+	/** Data interface of a user parameter in the override parameters of a component, nullptr if the system does not declare it. */
+	template <typename DataInterfaceType>
+	DataInterfaceType* FindUserDataInterface(UNiagaraComponent* Component, const FString& Name, FNiagaraVariable& OutVar)
+	{
+		static const FNiagaraTypeDefinition TypeDef(DataInterfaceType::StaticClass());
+		OutVar = FNiagaraVariable(TypeDef, *(TEXT("User.") + Name));
+		DataInterfaceType* DataInterface = Cast<DataInterfaceType>(Component->GetOverrideParameters().GetDataInterface(OutVar));
+		if (DataInterface == nullptr)
+		{
+			UE_LOG(LogGalaxyNiagara, Verbose, TEXT("User parameter %s not found in %s"), *Name, *Component->GetPathName());
+		}
+		return DataInterface;
+	}
+} // namespace
+
 void UGalaxyNiagaraFunctionLibrary::SetCurveParameter(
 	UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, const FRichCurve& Value, bool bOverride)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSetCurveParameter);
+
 	const FName ParameterName = *NiagaraParameters->Collection->ParameterNameFromFriendlyName(Name);
 
 	typedef UNiagaraDataInterfaceCurve CurveType;
@@ -43,6 +66,8 @@ void UGalaxyNiagaraFunctionLibrary::SetCurveParameter(
 void UGalaxyNiagaraFunctionLibrary::SetFloatParameter(
 	UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, float Value, bool bOverride)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSetFloatParameter);
+
 	const FName ParameterName = *NiagaraParameters->Collection->ParameterNameFromFriendlyName(Name);
 	const FNiagaraVariable Var(FNiagaraTypeDefinition::GetFloatDef(), ParameterName);
 
@@ -53,3 +78,137 @@ void UGalaxyNiagaraFunctionLibrary::SetFloatParameter(
 		NiagaraParameters->SetOverridesParameter(Var, true);
 	}
 }
+
+void UGalaxyNiagaraFunctionLibrary::SetTextureParameter(
+	UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, UTexture* Value, bool bOverride)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSetTextureParameter);
+
+	if (!ensure(NiagaraParameters != nullptr))
+	{
+		return;
+	}
+
+	const FName ParameterName = *NiagaraParameters->Collection->ParameterNameFromFriendlyName(Name);
+
+	typedef UNiagaraDataInterfaceTexture TextureType;
+	static const FNiagaraTypeDefinition TextureTypeDef(TextureType::StaticClass());
+	const FNiagaraVariable Var(TextureTypeDef, ParameterName);
+
+	TextureType* DataInterface = (TextureType*)NiagaraParameters->GetParameterStore().GetDataInterface(Var);
+	if (DataInterface == nullptr)
+	{
+		UE_LOG(
+			LogGalaxyNiagara, Warning, TEXT("Texture parameter %s not found in %s"), *Name, *NiagaraParameters->Collection->GetPathName());
+		return;
+	}
+
+	DataInterface->Texture = Value;
+	NiagaraParameters->GetParameterStore().SetDataInterface(DataInterface, Var);
+
+	if (bOverride)
+	{
+		NiagaraParameters->SetOverridesParameter(Var, true);
+	}
+}
+
+void UGalaxyNiagaraFunctionLibrary::SetLookupTableParameter(
+	UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, TArrayView<const float> Values, int32 NumChannels,
+	float DomainMin, float DomainMax, bool bOverride)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSetLookupTableParameter);
+
+	if (!ensure(NiagaraParameters != nullptr))
+	{
+		return;
+	}
+
+	const FName ParameterName = *NiagaraParameters->Collection->ParameterNameFromFriendlyName(Name);
+
+	typedef UNiagaraDataInterfaceLookupTable LookupTableType;
+	static const FNiagaraTypeDefinition LookupTableTypeDef(LookupTableType::StaticClass());
+	const FNiagaraVariable Var(LookupTableTypeDef, ParameterName);
+
+	LookupTableType* DataInterface = (LookupTableType*)NiagaraParameters->GetParameterStore().GetDataInterface(Var);
+	if (DataInterface == nullptr)
+	{
+		UE_LOG(
+			LogGalaxyNiagara, Warning, TEXT("Lookup table parameter %s not found in %s"), *Name,
+			*NiagaraParameters->Collection->GetPathName());
+		return;
+	}
+
+	DataInterface->SetTable(Values, NumChannels, DomainMin, DomainMax);
+	NiagaraParameters->GetParameterStore().SetDataInterface(DataInterface, Var);
+
+	if (bOverride)
+	{
+		NiagaraParameters->SetOverridesParameter(Var, true);
+	}
+}
+
+bool UGalaxyNiagaraFunctionLibrary::SetUserFloatParameter(UNiagaraComponent* Component, const FString& Name, float Value)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSetFloatParameter);
+
+	if (!ensure(Component != nullptr))
+	{
+		return false;
+	}
+
+	const FNiagaraVariable Var(FNiagaraTypeDefinition::GetFloatDef(), *(TEXT("User.") + Name));
+	FNiagaraUserRedirectionParameterStore& OverrideParameters = Component->GetOverrideParameters();
+	if (OverrideParameters.IndexOf(Var) == INDEX_NONE)
+	{
+		UE_LOG(LogGalaxyNiagara, Verbose, TEXT("User parameter %s not found in %s"), *Name, *Component->GetPathName());
+		return false;
+	}
+
+	OverrideParameters.SetParameterValue(Value, Var);
+	return true;
+}
+
+bool UGalaxyNiagaraFunctionLibrary::SetUserTextureParameter(UNiagaraComponent* Component, const FString& Name, UTexture* Value)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSetTextureParameter);
+
+	if (!ensure(Component != nullptr))
+	{
+		return false;
+	}
+
+	FNiagaraVariable Var;
+	UNiagaraDataInterfaceTexture* DataInterface = FindUserDataInterface<UNiagaraDataInterfaceTexture>(Component, Name, Var);
+	if (DataInterface == nullptr)
+	{
+		return false;
+	}
+
+	// Setting the data interface again marks the override parameters dirty, so running instances rebind the texture
+	DataInterface->Texture = Value;
+	Component->GetOverrideParameters().SetDataInterface(DataInterface, Var);
+	return true;
+}
+
+bool UGalaxyNiagaraFunctionLibrary::SetUserLookupTableParameter(
+	UNiagaraComponent* Component, const FString& Name, TArrayView<const float> Values, int32 NumChannels, float DomainMin,
+	float DomainMax)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousSetLookupTableParameter);
+
+	if (!ensure(Component != nullptr))
+	{
+		return false;
+	}
+
+	// Override parameters hold a copy of the data interface per component, updates only affect this component
+	FNiagaraVariable Var;
+	UNiagaraDataInterfaceLookupTable* DataInterface = FindUserDataInterface<UNiagaraDataInterfaceLookupTable>(Component, Name, Var);
+	if (DataInterface == nullptr)
+	{
+		return false;
+	}
+
+	DataInterface->SetTable(Values, NumChannels, DomainMin, DomainMax);
+	return true;
+}
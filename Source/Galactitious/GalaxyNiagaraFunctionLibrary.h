@@ -19,4 +19,22 @@ public:
 		class UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, const FRichCurve& Value, bool bOverride = true);
 	static void SetFloatParameter(
 		class UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, float Value, bool bOverride = true);
+	/** Set a texture data interface parameter. Missing parameters only log a warning, since texture parameters are optional. */
+	static void SetTextureParameter(
+		class UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, class UTexture* Value, bool bOverride = true);
+	/**
+	 * Set a lookup table data interface parameter, see UNiagaraDataInterfaceLookupTable::SetTable.
+	 * Only changed entries are uploaded. Missing parameters only log a warning, since lookup table parameters are optional.
+	 */
+	static void SetLookupTableParameter(
+		class UNiagaraParameterCollectionInstance* NiagaraParameters, const FString& Name, TArrayView<const float> Values,
+		int32 NumChannels, float DomainMin, float DomainMax, bool bOverride = true);
+
+	// User parameters of a single component, for per-instance parameters that do not touch the parameter collection.
+	// Names are given without the User namespace. Missing parameters are skipped, systems only declare the parameters they use.
+	static bool SetUserFloatParameter(class UNiagaraComponent* Component, const FString& Name, float Value);
+	static bool SetUserTextureParameter(class UNiagaraComponent* Component, const FString& Name, class UTexture* Value);
+	static bool SetUserLookupTableParameter(
+		class UNiagaraComponent* Component, const FString& Name, TArrayView<const float> Values, int32 NumChannels, float DomainMin,
+		float DomainMax);
 };
@@ -0,0 +1,274 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalaxyParameterComponent.h"
+
+#include "GalactitiousStats.h"
+#include "GalactitiousSubsystem.h"
+#include "GalaxyNiagaraFunctionLibrary.h"
+#include "NiagaraComponent.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/Engine.h"
+#include "GameFramework/Actor.h"
+
+namespace
+{
+	void SampleCurveTable(const FRichCurve& Curve, int32 TableSize, TArray<float>& OutTable, FVector2D& OutDomain)
+	{
+		Curve.GetTimeRange(OutDomain.X, OutDomain.Y);
+		OutTable.SetNumUninitialized(TableSize);
+		for (int32 i = 0; i < TableSize; ++i)
+		{
+			OutTable[i] = Curve.Eval(FMath::Lerp(OutDomain.X, OutDomain.Y, (float)i / (TableSize - 1)));
+		}
+	}
+} // namespace
+
+const TCHAR* FGalaxyParameterBlock::GetScalarName(int32 Scalar)
+{
+	static const TCHAR* Names[NumScalars] = {
+		TEXT("Radius"),
+		TEXT("Velocity"),
+		TEXT("Perturbation"),
+		TEXT("WindingFrequency"),
+		TEXT("ArmDensitySampling"),
+		TEXT("ArmSamplingTableHeight"),
+		TEXT("AverageLuminosity"),
+		TEXT("BlackbodyMinTemperature"),
+		TEXT("BlackbodyMaxTemperature"),
+	};
+	return Names[Scalar];
+}
+
+bool FGalaxyParameterBlock::IsSpawnScalar(int32 Scalar)
+{
+	return Scalar != Velocity && Scalar != BlackbodyMinTemperature && Scalar != BlackbodyMaxTemperature;
+}
+
+bool FGalaxyParameterBlock::Compute(const UGalaxyShapeSettings& Shape, const UStarSettings& Star)
+{
+	if (!ensureMsgf(Shape.ThicknessCurve != nullptr, TEXT("Thickness curve not set")))
+	{
+		return false;
+	}
+	if (!Shape.ComputeSamplingData(ShapeData) || !Star.ComputeSamplingData(StarData))
+	{
+		return false;
+	}
+
+	SampleCurveTable(Shape.ThicknessCurve->FloatCurve, CurveTableSize, ThicknessTable, ThicknessDomain);
+	SampleCurveTable(ShapeData.RadialDensityNormalizedCurve, CurveTableSize, RadialDensityTable, RadialDensityDomain);
+
+	const bool bArmSampling = ShapeData.ArmSamplingTable.Num() > 0;
+	Scalars[Radius] = Shape.Radius;
+	Scalars[Velocity] = Shape.Velocity;
+	Scalars[Perturbation] = Shape.Perturbation;
+	Scalars[WindingFrequency] = Shape.WindingFrequency;
+	Scalars[ArmDensitySampling] = bArmSampling ? 1.0f : 0.0f;
+	Scalars[ArmSamplingTableHeight] = bArmSampling ? ShapeData.ArmDensitySampler.Height : 0.0f;
+	Scalars[AverageLuminosity] = StarData.AverageLuminosity;
+	Scalars[BlackbodyMinTemperature] = Star.BlackbodyMinTemperature;
+	Scalars[BlackbodyMaxTemperature] = Star.BlackbodyMaxTemperature;
+	return true;
+}
+
+SIZE_T FGalaxyParameterBlock::GetAllocatedSize() const
+{
+	return ShapeData.RadialDensityNormalizedCurve.Keys.GetAllocatedSize() + ShapeData.RadialSamplingCurve.Keys.GetAllocatedSize() +
+		   ShapeData.RadialSamplingTable.GetAllocatedSize() + ShapeData.QuantizedRadialSamplingTable.GetAllocatedSize() +
+		   ShapeData.ArmDensitySampler.MarginalCdf.GetAllocatedSize() + ShapeData.ArmDensitySampler.ConditionalCdf.GetAllocatedSize() +
+		   ShapeData.ArmSamplingTable.GetAllocatedSize() + StarData.LogLuminositySamplingCurve.Keys.GetAllocatedSize() +
+		   StarData.TemperatureSamplingCurve.Keys.GetAllocatedSize() + StarData.SamplingTable.GetAllocatedSize() +
+		   StarData.QuantileSamplingTable.GetAllocatedSize() + StarData.SamplingTableQuantiles.GetAllocatedSize() +
+		   StarData.SamplingTableCoordinates.GetAllocatedSize() + StarData.QuantizedSamplingTable.GetAllocatedSize() +
+		   ThicknessTable.GetAllocatedSize() + RadialDensityTable.GetAllocatedSize();
+}
+
+void UGalaxyParameterComponent::UpdateParameters()
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousUpdateGalaxyParameterBlock);
+
+	if (ShapeSettings == nullptr || StarSettings == nullptr)
+	{
+		return;
+	}
+
+	// The block of the previous update stays for comparison, a failed update keeps it
+	Swap(Block, PreviousBlock);
+	if (!Block.Compute(*ShapeSettings, *StarSettings))
+	{
+		Swap(Block, PreviousBlock);
+		return;
+	}
+	PushParameters();
+}
+
+void UGalaxyParameterComponent::SetSettings(UGalaxyShapeSettings* InShapeSettings, UStarSettings* InStarSettings)
+{
+	ShapeSettings = InShapeSettings;
+	StarSettings = InStarSettings;
+	UpdateParameters();
+}
+
+void UGalaxyParameterComponent::SetGalaxySystem(UNiagaraComponent* InGalaxySystem)
+{
+	GalaxySystem = InGalaxySystem;
+
+	// The new component has not seen any of the previous values
+	PushedScalarMask = 0;
+	bPushedTables = false;
+	PushedBlackbodyColorTexture = nullptr;
+	Rescaling = FParticleBudgetRescaling();
+	UpdateParameters();
+}
+
+void UGalaxyParameterComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (GalaxySystem == nullptr)
+	{
+		SetGalaxySystem(GetOwner()->FindComponentByClass<UNiagaraComponent>());
+	}
+	else
+	{
+		UpdateParameters();
+	}
+
+	if (bParticleBudget)
+	{
+		GEngine->GetEngineSubsystem<UGalactitiousSubsystem>()->RegisterParticleBudget(this);
+	}
+}
+
+void UGalaxyParameterComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bParticleBudget && GEngine != nullptr)
+	{
+		GEngine->GetEngineSubsystem<UGalactitiousSubsystem>()->UnregisterParticleBudget(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+#if WITH_EDITOR
+void UGalaxyParameterComponent::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (GalaxySystem == nullptr && GetOwner() != nullptr)
+	{
+		GalaxySystem = GetOwner()->FindComponentByClass<UNiagaraComponent>();
+	}
+	UpdateParameters();
+}
+#endif
+
+void UGalaxyParameterComponent::PushParameters()
+{
+	if (GalaxySystem == nullptr)
+	{
+		return;
+	}
+
+	bool bRespawn = false;
+	for (int32 i = 0; i < FGalaxyParameterBlock::NumScalars; ++i)
+	{
+		const uint32 Bit = 1u << i;
+		if ((PushedScalarMask & Bit) != 0 && PushedScalars[i] == Block.Scalars[i])
+		{
+			continue;
+		}
+		if (UGalaxyNiagaraFunctionLibrary::SetUserFloatParameter(GalaxySystem, FGalaxyParameterBlock::GetScalarName(i), Block.Scalars[i]))
+		{
+			PushedScalars[i] = Block.Scalars[i];
+			PushedScalarMask |= Bit;
+			bRespawn |= FGalaxyParameterBlock::IsSpawnScalar(i);
+		}
+	}
+
+	// Tables are compared with the previous block, all of them are pushed to a new system. GPU lookups are directly at the quantile.
+	const TArray<FLinearColor>& StarSamplingTable = Block.StarData.QuantileSamplingTable;
+	if (!bPushedTables || StarSamplingTable != PreviousBlock.StarData.QuantileSamplingTable)
+	{
+		StarSamplingTableTexture = UTextureBakerFunctionLibrary::UpdateTransientTextureRegions(
+			StarSamplingTableTexture, StarSamplingTable.Num(), 1, PF_A32B32G32R32F, StarSamplingTable.GetData(), StarSamplingTableStaging);
+		UGalaxyNiagaraFunctionLibrary::SetUserTextureParameter(GalaxySystem, TEXT("StarSamplingTable"), StarSamplingTableTexture);
+		UGalaxyNiagaraFunctionLibrary::SetUserLookupTableParameter(
+			GalaxySystem, TEXT("StarSamplingLookupTable"),
+			TArrayView<const float>((const float*)StarSamplingTable.GetData(), StarSamplingTable.Num() * 4), 4, 0.0f, 1.0f);
+		bRespawn = true;
+	}
+	if (StarSettings->BlackbodyColorTexture != nullptr && StarSettings->BlackbodyColorTexture != PushedBlackbodyColorTexture)
+	{
+		UGalaxyNiagaraFunctionLibrary::SetUserTextureParameter(
+			GalaxySystem, TEXT("BlackbodyColorTexture"), StarSettings->BlackbodyColorTexture);
+		PushedBlackbodyColorTexture = StarSettings->BlackbodyColorTexture;
+	}
+
+	const FGalaxyShapeSamplingData& ShapeData = Block.ShapeData;
+	const FGalaxyShapeSamplingData& PreviousShapeData = PreviousBlock.ShapeData;
+	if (!bPushedTables || ShapeData.RadialSamplingTable != PreviousShapeData.RadialSamplingTable)
+	{
+		UGalaxyNiagaraFunctionLibrary::SetUserLookupTableParameter(
+			GalaxySystem, TEXT("RadialSamplingTable"), ShapeData.RadialSamplingTable, 1, 0.0f, 1.0f);
+		bRespawn = true;
+	}
+	if (!bPushedTables || Block.ThicknessTable != PreviousBlock.ThicknessTable || Block.ThicknessDomain != PreviousBlock.ThicknessDomain)
+	{
+		UGalaxyNiagaraFunctionLibrary::SetUserLookupTableParameter(
+			GalaxySystem, TEXT("ThicknessTable"), Block.ThicknessTable, 1, Block.ThicknessDomain.X, Block.ThicknessDomain.Y);
+		bRespawn = true;
+	}
+	if (!bPushedTables || Block.RadialDensityTable != PreviousBlock.RadialDensityTable ||
+		Block.RadialDensityDomain != PreviousBlock.RadialDensityDomain)
+	{
+		UGalaxyNiagaraFunctionLibrary::SetUserLookupTableParameter(
+			GalaxySystem, TEXT("RadialDensityTable"), Block.RadialDensityTable, 1, Block.RadialDensityDomain.X,
+			Block.RadialDensityDomain.Y);
+		bRespawn = true;
+	}
+	if (ShapeData.ArmSamplingTable.Num() > 0 && (!bPushedTables || ShapeData.ArmSamplingTable != PreviousShapeData.ArmSamplingTable))
+	{
+		ArmSamplingTableTexture = UTextureBakerFunctionLibrary::UpdateTransientTextureRegions(
+			ArmSamplingTableTexture, FGalaxyShapeSamplingData::ArmSamplingTableWidth, ShapeData.ArmDensitySampler.Height + 1,
+			PF_R32_FLOAT, ShapeData.ArmSamplingTable.GetData(), ArmSamplingTableStaging, TF_Nearest);
+		UGalaxyNiagaraFunctionLibrary::SetUserTextureParameter(GalaxySystem, TEXT("ArmSamplingTable"), ArmSamplingTableTexture);
+		bRespawn = true;
+	}
+	bPushedTables = true;
+
+	PushParticleBudget();
+
+	if (bRestartOnUpdate && bRespawn)
+	{
+		GalaxySystem->ReinitializeSystem();
+	}
+}
+
+void UGalaxyParameterComponent::SetParticleBudget(float BudgetFraction)
+{
+	ParticleBudgetFraction = BudgetFraction;
+	if (GalaxySystem != nullptr && Block.StarData.AverageLuminosity > 0.0f)
+	{
+		PushParticleBudget();
+	}
+}
+
+void UGalaxyParameterComponent::PushParticleBudget()
+{
+	const float Fraction = bParticleBudget ? FMath::Max(ParticleBudgetFraction, MinParticleFraction) : 1.0f;
+	const int32 NumActiveParticles = FMath::RoundToInt(NumParticles * FMath::Min(Fraction, 1.0f));
+	const FParticleBudgetRescaling NewRescaling =
+		FParticleBudgetRescaling::Compute(NumParticles, NumActiveParticles, NumGalaxyStars, Block.StarData.AverageLuminosity);
+	if (NewRescaling.NumActiveParticles == Rescaling.NumActiveParticles &&
+		NewRescaling.FractionalLuminosity == Rescaling.FractionalLuminosity)
+	{
+		return;
+	}
+	Rescaling = NewRescaling;
+
+	// Particles past the active count stay alive but hidden, so growing the budget again does not respawn them
+	UGalaxyNiagaraFunctionLibrary::SetUserFloatParameter(GalaxySystem, TEXT("ActiveParticleCount"), Rescaling.NumActiveParticles);
+	UGalaxyNiagaraFunctionLibrary::SetUserFloatParameter(GalaxySystem, TEXT("FractionalLuminosity"), Rescaling.FractionalLuminosity);
+	UGalaxyNiagaraFunctionLibrary::SetUserFloatParameter(GalaxySystem, TEXT("MinStarCount"), Rescaling.MinStarCount);
+}
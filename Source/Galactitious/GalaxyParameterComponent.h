@@ -0,0 +1,160 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "ParticleBudget.h"
+#include "StellarSamplingData.h"
+#include "TextureBakerFunctionLibrary.h"
+
+#include "GalaxyParameterComponent.generated.h"
+
+class UNiagaraComponent;
+class UTexture2D;
+
+/** Shape and star parameters of a single galaxy with the tables derived from them. */
+struct GALACTITIOUS_API FGalaxyParameterBlock
+{
+	enum EScalar
+	{
+		Radius,
+		Velocity,
+		Perturbation,
+		WindingFrequency,
+		ArmDensitySampling,
+		ArmSamplingTableHeight,
+		AverageLuminosity,
+		BlackbodyMinTemperature,
+		BlackbodyMaxTemperature,
+		NumScalars
+	};
+
+	/** User parameter name of a scalar, matching the parameter collection names. */
+	static const TCHAR* GetScalarName(int32 Scalar);
+
+	/** Whether a scalar is only read when particles spawn. Velocity and blackbody temperatures are read every frame. */
+	static bool IsSpawnScalar(int32 Scalar);
+
+	/** Entries of the curve tables which replace curve data interfaces. */
+	static constexpr int32 CurveTableSize = 256;
+
+	/** Derive the block from the settings. Assets are only read, safe to call from any thread. */
+	bool Compute(const UGalaxyShapeSettings& Shape, const UStarSettings& Star);
+
+	SIZE_T GetAllocatedSize() const;
+
+	float Scalars[NumScalars] = {};
+
+	FGalaxyShapeSamplingData ShapeData;
+	FStarSamplingData StarData;
+
+	/** Thickness and normalized radial density over the time ranges of their curves. */
+	TArray<float> ThicknessTable;
+	FVector2D ThicknessDomain = FVector2D(0.0f, 1.0f);
+	TArray<float> RadialDensityTable;
+	FVector2D RadialDensityDomain = FVector2D(0.0f, 1.0f);
+};
+
+/**
+ * Binds the parameters of its own settings to the user parameters of a Niagara galaxy system, instead of the default instance of
+ * the parameter collection which is shared by all galaxies. Curves are bound as lookup table data interfaces since those update
+ * in place, so the system needs user parameters RadialSamplingTable, ThicknessTable, RadialDensityTable and StarSamplingLookupTable
+ * next to the scalars and textures. Updates only change the bound component, parameters are only pushed when changed.
+ * Sampling tables and the scalars they depend on are read at particle spawn, only their changes restart the system.
+ */
+UCLASS(ClassGroup = (Galactitious), meta = (BlueprintSpawnableComponent))
+class GALACTITIOUS_API UGalaxyParameterComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Galaxy")
+	UGalaxyShapeSettings* ShapeSettings;
+
+	UPROPERTY(EditAnywhere, Category = "Galaxy")
+	UStarSettings* StarSettings;
+
+	/** Restart the galaxy system after updates of parameters which are only read at particle spawn. */
+	UPROPERTY(EditAnywhere, Category = "Galaxy")
+	bool bRestartOnUpdate = true;
+
+	/**
+	 * Let the particle budget of UGalactitiousSubsystem draw only a prefix of the particles when frame times are high.
+	 * Budget changes push ActiveParticleCount, FractionalLuminosity and MinStarCount without a restart, the system has to
+	 * hide particles past the active count and compute star counts as in FParticleBudgetRescaling.
+	 */
+	UPROPERTY(EditAnywhere, Category = "Particle Budget")
+	bool bParticleBudget = false;
+
+	/** Particles M spawned by the galaxy system, must match its star generation. */
+	UPROPERTY(EditAnywhere, Category = "Particle Budget", meta = (ClampMin = "1"))
+	int32 NumParticles = 100000;
+
+	/** Stars N in the galaxy, must match the star generation of the galaxy system. */
+	UPROPERTY(EditAnywhere, Category = "Particle Budget", meta = (ClampMin = "1"))
+	float NumGalaxyStars = 1.0e10f;
+
+	/** Lower bound of the active particles relative to NumParticles. */
+	UPROPERTY(EditAnywhere, Category = "Particle Budget", meta = (ClampMin = "0.01", ClampMax = "1"))
+	float MinParticleFraction = 0.1f;
+
+	/** Recompute the parameter block and push it to the galaxy system. */
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	void UpdateParameters();
+
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	void SetSettings(UGalaxyShapeSettings* InShapeSettings, UStarSettings* InStarSettings);
+
+	/** Niagara component receiving the parameters, the first Niagara component of the owner if not set. */
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	void SetGalaxySystem(UNiagaraComponent* InGalaxySystem);
+
+	/** Draw a fraction of NumParticles, called by the particle budget of UGalactitiousSubsystem. */
+	void SetParticleBudget(float BudgetFraction);
+
+	const FParticleBudgetRescaling& GetParticleBudgetRescaling() const { return Rescaling; }
+
+	const FGalaxyParameterBlock& GetParameterBlock() const { return Block; }
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+	void PushParameters();
+	void PushParticleBudget();
+
+	UPROPERTY(Transient)
+	UNiagaraComponent* GalaxySystem;
+
+	UPROPERTY(Transient)
+	UTexture2D* StarSamplingTableTexture = nullptr;
+
+	UPROPERTY(Transient)
+	UTexture2D* ArmSamplingTableTexture = nullptr;
+
+	FTextureUpdateStaging StarSamplingTableStaging;
+	FTextureUpdateStaging ArmSamplingTableStaging;
+
+	FGalaxyParameterBlock Block;
+
+	/** Block of the previous update, tables are only pushed where they differ. The next update reuses its storage. */
+	FGalaxyParameterBlock PreviousBlock;
+
+	/** Scalars last pushed to GalaxySystem, valid where the bit of PushedScalarMask is set. */
+	float PushedScalars[FGalaxyParameterBlock::NumScalars] = {};
+	uint32 PushedScalarMask = 0;
+
+	/** Whether GalaxySystem has the tables of the last pushed block, else all tables are pushed. */
+	bool bPushedTables = false;
+
+	UPROPERTY(Transient)
+	UTexture2D* PushedBlackbodyColorTexture = nullptr;
+
+	float ParticleBudgetFraction = 1.0f;
+	FParticleBudgetRescaling Rescaling;
+};
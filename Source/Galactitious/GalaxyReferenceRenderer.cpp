@@ -0,0 +1,309 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalaxyReferenceRenderer.h"
+
+#include "GalactitiousStats.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "SampleSequence.h"
+#include "SpectrumFunctionLibrary.h"
+#include "StarGenerator.h"
+#include "StellarSamplingData.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/FileHelper.h"
+#include "Modules/ModuleManager.h"
+
+namespace
+{
+	/** Rays stop once the transmittance drops below this. */
+	const float MinTransmittance = 1.0e-4f;
+
+	/** Tile range of a worker, the owner takes tiles from the front and other workers steal from the back. */
+	struct FTileQueue
+	{
+		FCriticalSection Lock;
+		int32 Begin = 0;
+		int32 End = 0;
+
+		bool Pop(int32& OutTile)
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (Begin == End)
+			{
+				return false;
+			}
+			OutTile = Begin++;
+			return true;
+		}
+
+		bool Steal(int32& OutTile)
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (Begin == End)
+			{
+				return false;
+			}
+			OutTile = --End;
+			return true;
+		}
+	};
+
+	/** Trilinear interpolation of a cell-centered grid, GridPosition in cells. */
+	template <typename ValueType>
+	ValueType SampleGrid(const TArray<ValueType>& Grid, const FIntVector& Resolution, const FVector& GridPosition)
+	{
+		const FVector Position = GridPosition - FVector(0.5f);
+		const int32 X0 = FMath::Clamp(FMath::FloorToInt(Position.X), 0, Resolution.X - 1);
+		const int32 Y0 = FMath::Clamp(FMath::FloorToInt(Position.Y), 0, Resolution.Y - 1);
+		const int32 Z0 = FMath::Clamp(FMath::FloorToInt(Position.Z), 0, Resolution.Z - 1);
+		const int32 X1 = FMath::Min(X0 + 1, Resolution.X - 1);
+		const int32 Y1 = FMath::Min(Y0 + 1, Resolution.Y - 1);
+		const int32 Z1 = FMath::Min(Z0 + 1, Resolution.Z - 1);
+		const float FracX = FMath::Clamp(Position.X - X0, 0.0f, 1.0f);
+		const float FracY = FMath::Clamp(Position.Y - Y0, 0.0f, 1.0f);
+		const float FracZ = FMath::Clamp(Position.Z - Z0, 0.0f, 1.0f);
+
+		auto Cell = [&](int32 X, int32 Y, int32 Z) { return Grid[(Z * Resolution.Y + Y) * Resolution.X + X]; };
+		const ValueType Y0Value = FMath::Lerp(
+			FMath::Lerp(Cell(X0, Y0, Z0), Cell(X1, Y0, Z0), FracX), FMath::Lerp(Cell(X0, Y0, Z1), Cell(X1, Y0, Z1), FracX), FracZ);
+		const ValueType Y1Value = FMath::Lerp(
+			FMath::Lerp(Cell(X0, Y1, Z0), Cell(X1, Y1, Z0), FracX), FMath::Lerp(Cell(X0, Y1, Z1), Cell(X1, Y1, Z1), FracX), FracZ);
+		return FMath::Lerp(Y0Value, Y1Value, FracY);
+	}
+} // namespace
+
+bool FGalaxyReferenceRenderer::Initialize(
+	const UGalaxyShapeSettings& Shape, const FStarBuffer& Stars, const FGalaxyRenderSettings& InSettings)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousBuildReferenceGrids);
+
+	const FIntVector& Resolution = InSettings.GridResolution;
+	if (!ensureMsgf(
+			InSettings.Width > 0 && InSettings.Height > 0 && InSettings.StepSize > 0.0f && Resolution.X > 0 && Resolution.Y > 0 &&
+				Resolution.Z > 0,
+			TEXT("Invalid reference render settings")))
+	{
+		return false;
+	}
+	const float MaxRadialDensity = Shape.GetMaxRadialDensity();
+	if (!ensureMsgf(MaxRadialDensity > 0.0f, TEXT("Radial density curve is not set or zero")))
+	{
+		return false;
+	}
+
+	Settings = InSettings;
+	GasVolumeHeight = Shape.GasVolumeHeight;
+	const int32 NumCells = Resolution.X * Resolution.Y * Resolution.Z;
+	const FVector CellSize(2.0f / Resolution.X, 2.0f / Resolution.Y, 2.0f * GasVolumeHeight / Resolution.Z);
+
+	// Gas density is evaluated once per cell, curve evaluation per ray-march step would dominate the render
+	const float InvMaxRadialDensity = 1.0f / MaxRadialDensity;
+	GasGrid.SetNumUninitialized(NumCells);
+	ParallelFor(Resolution.Z, [&](int32 z) {
+		for (int32 y = 0; y < Resolution.Y; ++y)
+		{
+			for (int32 x = 0; x < Resolution.X; ++x)
+			{
+				const FVector Position = FVector(x + 0.5f, y + 0.5f, z + 0.5f) * CellSize - FVector(1.0f, 1.0f, GasVolumeHeight);
+				GasGrid[(z * Resolution.Y + y) * Resolution.X + x] = Shape.EvalGasDensity(Position, InvMaxRadialDensity);
+			}
+		}
+	});
+
+	// Stars outside the gas volume height are clamped into the outermost cells, so no luminosity is lost
+	double TotalLuminosity = 0.0;
+	float MinTemperature = MAX_flt;
+	float MaxTemperature = 0.0f;
+	for (int32 i = 0; i < Stars.Num(); ++i)
+	{
+		TotalLuminosity += FMath::Exp(Stars.LogLuminosity[i]) * Stars.StarCount[i];
+		MinTemperature = FMath::Min(MinTemperature, Stars.Temperature[i]);
+		MaxTemperature = FMath::Max(MaxTemperature, Stars.Temperature[i]);
+	}
+	EmissionGrid.Reset();
+	EmissionGrid.SetNumZeroed(NumCells);
+	if (TotalLuminosity > 0.0)
+	{
+		FBlackbodyColorTable ColorTable;
+		ColorTable.Build(MinTemperature, MaxTemperature);
+		const float Scale = (float)(1.0 / (TotalLuminosity * CellSize.X * CellSize.Y * CellSize.Z));
+		for (int32 i = 0; i < Stars.Num(); ++i)
+		{
+			const int32 X = FMath::FloorToInt((Stars.PositionX[i] + 1.0f) / CellSize.X);
+			const int32 Y = FMath::FloorToInt((Stars.PositionY[i] + 1.0f) / CellSize.Y);
+			if (X < 0 || X >= Resolution.X || Y < 0 || Y >= Resolution.Y)
+			{
+				continue;
+			}
+			const int32 Z = FMath::Clamp(FMath::FloorToInt((Stars.PositionZ[i] + GasVolumeHeight) / CellSize.Z), 0, Resolution.Z - 1);
+			const FLinearColor& Color = ColorTable.Eval(Stars.Temperature[i]);
+			const float Luminosity = FMath::Exp(Stars.LogLuminosity[i]) * Stars.StarCount[i] * Scale;
+			EmissionGrid[(Z * Resolution.Y + Y) * Resolution.X + X] += FVector(Color.R, Color.G, Color.B) * Luminosity;
+		}
+	}
+
+	CameraForward = (Settings.CameraTarget - Settings.CameraPosition).GetSafeNormal();
+	CameraRight = FVector::CrossProduct(Settings.CameraUp, CameraForward);
+	if (!CameraRight.Normalize())
+	{
+		CameraRight = FVector::CrossProduct(FVector::ForwardVector, CameraForward).GetSafeNormal();
+	}
+	CameraUp = FVector::CrossProduct(CameraForward, CameraRight);
+
+	NumTilesX = FMath::DivideAndRoundUp(Settings.Width, TileSize);
+	NumPasses = 0;
+	NumStolenTiles.Reset();
+	Accumulation.Reset();
+	Accumulation.SetNumZeroed(Settings.Width * Settings.Height);
+	return true;
+}
+
+int32 FGalaxyReferenceRenderer::Render(int32 MaxPasses, double BudgetSeconds)
+{
+	if (!ensureMsgf(Accumulation.Num() > 0, TEXT("Reference renderer is not initialized")))
+	{
+		return 0;
+	}
+
+	const double EndTime = FPlatformTime::Seconds() + BudgetSeconds;
+	const int32 NumTiles = NumTilesX * FMath::DivideAndRoundUp(Settings.Height, TileSize);
+	const int32 NumWorkers =
+		FMath::Clamp(Settings.NumWorkers > 0 ? Settings.NumWorkers : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, NumTiles);
+	TUniquePtr<FTileQueue[]> Queues = MakeUnique<FTileQueue[]>(NumWorkers);
+
+	while (NumPasses < MaxPasses)
+	{
+		GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousRenderReferencePass);
+
+		for (int32 Worker = 0; Worker < NumWorkers; ++Worker)
+		{
+			Queues[Worker].Begin = (int64)NumTiles * Worker / NumWorkers;
+			Queues[Worker].End = (int64)NumTiles * (Worker + 1) / NumWorkers;
+		}
+
+		ParallelFor(NumWorkers, [&](int32 Worker) {
+			int32 Tile;
+			while (Queues[Worker].Pop(Tile))
+			{
+				RenderTile(Tile);
+			}
+			for (int32 Offset = 1; Offset < NumWorkers; ++Offset)
+			{
+				FTileQueue& Victim = Queues[(Worker + Offset) % NumWorkers];
+				while (Victim.Steal(Tile))
+				{
+					NumStolenTiles.Increment();
+					RenderTile(Tile);
+				}
+			}
+		});
+
+		++NumPasses;
+		if (FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+	}
+	return NumPasses;
+}
+
+void FGalaxyReferenceRenderer::RenderTile(int32 Tile)
+{
+	const int32 BeginX = (Tile % NumTilesX) * TileSize;
+	const int32 BeginY = (Tile / NumTilesX) * TileSize;
+	const int32 EndX = FMath::Min(BeginX + TileSize, Settings.Width);
+	const int32 EndY = FMath::Min(BeginY + TileSize, Settings.Height);
+	const float TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(0.5f * Settings.FieldOfView));
+	const float AspectRatio = (float)Settings.Height / Settings.Width;
+
+	// Per pixel scrambled Sobol samples stratify sub-pixel positions and step offsets over passes
+	for (int32 y = BeginY; y < EndY; ++y)
+	{
+		for (int32 x = BeginX; x < EndX; ++x)
+		{
+			const int32 PixelIndex = y * Settings.Width + x;
+			const uint32 PixelSeed = FSampleSequence::HashCombine((uint32)Settings.Seed, (uint32)PixelIndex);
+			const float JitterX = FSampleSequence::GetSample(ESampleSequence::Sobol, PixelSeed, NumPasses, 0);
+			const float JitterY = FSampleSequence::GetSample(ESampleSequence::Sobol, PixelSeed, NumPasses, 1);
+			const float StepJitter = FSampleSequence::GetSample(ESampleSequence::Sobol, PixelSeed, NumPasses, 2);
+
+			const float U = (2.0f * (x + JitterX) / Settings.Width - 1.0f) * TanHalfFOV;
+			const float V = (1.0f - 2.0f * (y + JitterY) / Settings.Height) * TanHalfFOV * AspectRatio;
+			const FVector Direction = (CameraForward + U * CameraRight + V * CameraUp).GetUnsafeNormal();
+			Accumulation[PixelIndex] += TraceRay(Settings.CameraPosition, Direction, StepJitter);
+		}
+	}
+}
+
+FLinearColor FGalaxyReferenceRenderer::TraceRay(const FVector& Origin, const FVector& Direction, float Jitter) const
+{
+	// Clip the ray to the grid bounds
+	const FVector BoxExtent(1.0f, 1.0f, GasVolumeHeight);
+	float Near = 0.0f;
+	float Far = MAX_flt;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		if (FMath::Abs(Direction[Axis]) < KINDA_SMALL_NUMBER)
+		{
+			if (FMath::Abs(Origin[Axis]) > BoxExtent[Axis])
+			{
+				return FLinearColor::Transparent;
+			}
+			continue;
+		}
+		const float T0 = (-BoxExtent[Axis] - Origin[Axis]) / Direction[Axis];
+		const float T1 = (BoxExtent[Axis] - Origin[Axis]) / Direction[Axis];
+		Near = FMath::Max(Near, FMath::Min(T0, T1));
+		Far = FMath::Min(Far, FMath::Max(T0, T1));
+	}
+	if (Near >= Far)
+	{
+		return FLinearColor::Transparent;
+	}
+
+	// Front to back, each step is a homogeneous segment with analytic transmittance
+	const FIntVector& Resolution = Settings.GridResolution;
+	const FVector GridScale(0.5f * Resolution.X, 0.5f * Resolution.Y, 0.5f * Resolution.Z / GasVolumeHeight);
+	const float StepSize = Settings.StepSize;
+	FVector Radiance = FVector::ZeroVector;
+	float Transmittance = 1.0f;
+	for (float T = Near + Jitter * StepSize; T < Far && Transmittance > MinTransmittance; T += StepSize)
+	{
+		const FVector GridPosition = (Origin + T * Direction + BoxExtent) * GridScale;
+		const float Extinction = SampleGrid(GasGrid, Resolution, GridPosition) * Settings.Extinction;
+		const FVector Emission = SampleGrid(EmissionGrid, Resolution, GridPosition);
+		const float StepTransmittance = FMath::Exp(-Extinction * StepSize);
+		const float EmissionLength = Extinction > KINDA_SMALL_NUMBER ? (1.0f - StepTransmittance) / Extinction : StepSize;
+		Radiance += Emission * (Transmittance * EmissionLength);
+		Transmittance *= StepTransmittance;
+	}
+
+	Radiance *= Settings.Exposure;
+	return FLinearColor(Radiance.X, Radiance.Y, Radiance.Z, 1.0f - Transmittance);
+}
+
+void FGalaxyReferenceRenderer::GetImage(TArray<FLinearColor>& OutImage) const
+{
+	OutImage.SetNumUninitialized(Accumulation.Num());
+	const float Scale = NumPasses > 0 ? 1.0f / NumPasses : 0.0f;
+	for (int32 i = 0; i < Accumulation.Num(); ++i)
+	{
+		OutImage[i] = Accumulation[i] * Scale;
+	}
+}
+
+bool FGalaxyReferenceRenderer::SaveImage(const FString& Filename) const
+{
+	TArray<FLinearColor> Image;
+	GetImage(Image);
+
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+	TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::EXR);
+	if (!ImageWrapper.IsValid() ||
+		!ImageWrapper->SetRaw(Image.GetData(), Image.Num() * Image.GetTypeSize(), Settings.Width, Settings.Height, ERGBFormat::RGBAF, 32))
+	{
+		return false;
+	}
+	return FFileHelper::SaveArrayToFile(ImageWrapper->GetCompressed(), *Filename);
+}
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+
+class UGalaxyShapeSettings;
+struct FStarBuffer;
+
+struct FGalaxyRenderSettings
+{
+	int32 Width = 1920;
+	int32 Height = 1080;
+
+	/** Camera position, target and up direction relative to the galaxy radius. */
+	FVector CameraPosition = FVector(0.0f, -2.5f, 1.0f);
+	FVector CameraTarget = FVector::ZeroVector;
+	FVector CameraUp = FVector::UpVector;
+
+	/** Horizontal field of view in degrees. */
+	float FieldOfView = 60.0f;
+
+	/** Ray-march step relative to the galaxy radius, the first step is jittered per pass. */
+	float StepSize = 0.005f;
+
+	/** Optical depth of unit gas density over one galaxy radius. */
+	float Extinction = 20.0f;
+
+	/** Scale of the emission, which integrates to unit luminance over the volume. */
+	float Exposure = 1.0f;
+
+	/** Cells of the emission and gas grids, covering [-1, 1] in X and Y and the gas volume height in Z. */
+	FIntVector GridResolution = FIntVector(256, 256, 64);
+
+	int32 Seed = 0;
+
+	/** Render threads, 0 uses the task graph workers and the calling thread. */
+	int32 NumWorkers = 0;
+};
+
+/**
+ * CPU ray-marcher for ground truth images and thumbnails without a GPU.
+ * Stars are binned into an emission grid colored by blackbody temperature, absorbed by the gas density of the shape settings.
+ * Passes jitter pixels and ray-march steps with scrambled Sobol samples and accumulate, so images refine progressively.
+ *
+ * Tiles of a pass are split evenly among the workers, idle workers steal tiles from the end of the other queues,
+ * since tiles through the galactic center take much longer than empty space. The image does not depend on scheduling.
+ */
+class GALACTITIOUS_API FGalaxyReferenceRenderer
+{
+public:
+	static constexpr int32 TileSize = 32;
+
+	/** Build the emission and gas grids. Curves are only read, safe to call from any thread. */
+	bool Initialize(const UGalaxyShapeSettings& Shape, const FStarBuffer& Stars, const FGalaxyRenderSettings& InSettings);
+
+	/**
+	 * Render passes until MaxPasses are accumulated or the budget is used up. Renders at least one pass unless MaxPasses are
+	 * already accumulated. Returns the total number of accumulated passes.
+	 */
+	int32 Render(int32 MaxPasses, double BudgetSeconds = TNumericLimits<double>::Max());
+
+	int32 GetNumPasses() const { return NumPasses; }
+
+	/** Tiles taken from the queue of another worker, for scheduling statistics. */
+	int32 GetNumStolenTiles() const { return NumStolenTiles.GetValue(); }
+
+	/** Average of the rendered passes, linear HDR radiance with alpha holding the opacity. */
+	void GetImage(TArray<FLinearColor>& OutImage) const;
+
+	/** Write the current image as 32-bit float OpenEXR. */
+	bool SaveImage(const FString& Filename) const;
+
+private:
+	void RenderTile(int32 Tile);
+	FLinearColor TraceRay(const FVector& Origin, const FVector& Direction, float Jitter) const;
+
+	FGalaxyRenderSettings Settings;
+	float GasVolumeHeight = 0.0f;
+
+	/** Luminance weighted blackbody color per unit volume. */
+	TArray<FVector> EmissionGrid;
+
+	/** Gas density in [0, 1]. */
+	TArray<float> GasGrid;
+
+	/** Sum of all passes. */
+	TArray<FLinearColor> Accumulation;
+
+	FVector CameraForward;
+	FVector CameraRight;
+	FVector CameraUp;
+	int32 NumTilesX = 0;
+	int32 NumPasses = 0;
+	FThreadSafeCounter NumStolenTiles;
+};
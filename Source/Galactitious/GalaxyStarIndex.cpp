@@ -0,0 +1,463 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalaxyStarIndex.h"
+
+#include "GalactitiousStats.h"
+#include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceStarBuffer.h"
+#include "Async/ParallelFor.h"
+#include "GameFramework/Actor.h"
+
+#include <algorithm>
+
+DEFINE_LOG_CATEGORY_STATIC(LogGalaxyStarIndex, Log, All);
+
+namespace
+{
+	/** Stars copied into nodes per task. */
+	const int32 BuildChunkSize = 64 * 1024;
+
+	/** Ranges split level by level before the subtrees are built by separate tasks. */
+	const int32 MinParallelSubtrees = 64;
+} // namespace
+
+struct FStarKDTree::FConeQuery
+{
+	FVector Origin;
+	FVector Direction;
+	float MaxDistance;
+
+	/** Cosine and sine of the half angle, narrowed to the angle of the best star found so far. */
+	float Cos;
+	float Sin;
+
+	int32 BestNode = INDEX_NONE;
+	float BestDistance = BIG_NUMBER;
+
+	/** Test a star and narrow the cone if it is closer to the axis than the best star. */
+	void Visit(const FVector& Position, int32 Node)
+	{
+		const FVector Offset = Position - Origin;
+		const float Distance = Offset.Size();
+		const float Along = FVector::DotProduct(Offset, Direction);
+		if (Distance > MaxDistance || Along <= 0.0f)
+		{
+			return;
+		}
+
+		// Nearer stars win ties, e.g. stars in line with the ray
+		const float StarCos = Along / Distance;
+		if (StarCos > Cos || (StarCos == Cos && Distance < BestDistance))
+		{
+			Cos = StarCos;
+			Sin = FMath::Sqrt(FMath::Max(1.0f - StarCos * StarCos, 0.0f));
+			BestNode = Node;
+			BestDistance = Distance;
+		}
+	}
+
+	/** Conservative test of the bounding sphere of a box against the cone, never rejects a box that intersects it. */
+	bool Overlaps(const FBox& Box) const
+	{
+		const FVector Center = Box.GetCenter();
+		const float Radius = Box.GetExtent().Size();
+		const FVector Offset = Center - Origin;
+		const float Along = FVector::DotProduct(Offset, Direction);
+		if (Along < -Radius || Offset.Size() - Radius > MaxDistance)
+		{
+			return false;
+		}
+
+		// Signed distance of the center to the cone surface, a lower bound for centers behind the apex
+		const float Perpendicular = FMath::Sqrt(FMath::Max(Offset.SizeSquared() - Along * Along, 0.0f));
+		return Perpendicular * Cos - Along * Sin <= Radius;
+	}
+};
+
+void FStarKDTree::Build(const FStarBuffer& Stars)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousBuildStarKDTree);
+
+	const int32 NumStars = Stars.Num();
+	if (!ensureMsgf(NumStars <= 0x3fffffff, TEXT("Too many stars for the KD-tree: %d"), NumStars))
+	{
+		Reset();
+		return;
+	}
+
+	Nodes.SetNumUninitialized(NumStars);
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumStars, BuildChunkSize);
+	ParallelFor(NumChunks, [&](int32 Chunk) {
+		const int32 Begin = Chunk * BuildChunkSize;
+		const int32 End = FMath::Min(Begin + BuildChunkSize, NumStars);
+		for (int32 i = Begin; i < End; ++i)
+		{
+			Nodes[i].Position = Stars.GetPosition(i);
+			Nodes[i].StarIndexAndAxis = (uint32)i;
+		}
+	});
+
+	Bounds = FBox(ForceInit);
+	for (const FNode& Node : Nodes)
+	{
+		Bounds += Node.Position;
+	}
+
+	// Top levels have few but large ranges, split them level by level with one task per range until there are enough subtrees
+	TArray<FIntPoint> Ranges;
+	TArray<FIntPoint> NextRanges;
+	if (NumStars > LeafSize)
+	{
+		Ranges.Add(FIntPoint(0, NumStars));
+	}
+	while (Ranges.Num() > 0 && Ranges.Num() < MinParallelSubtrees)
+	{
+		ParallelFor(Ranges.Num(), [&](int32 i) { SplitRange(Nodes.GetData(), Ranges[i].X, Ranges[i].Y); });
+
+		NextRanges.Reset();
+		for (const FIntPoint& Range : Ranges)
+		{
+			const int32 Mid = Range.X + (Range.Y - Range.X) / 2;
+			if (Mid - Range.X > LeafSize)
+			{
+				NextRanges.Add(FIntPoint(Range.X, Mid));
+			}
+			if (Range.Y - (Mid + 1) > LeafSize)
+			{
+				NextRanges.Add(FIntPoint(Mid + 1, Range.Y));
+			}
+		}
+		Swap(Ranges, NextRanges);
+	}
+	ParallelFor(Ranges.Num(), [&](int32 i) { BuildSubtree(Nodes.GetData(), Ranges[i].X, Ranges[i].Y); });
+}
+
+void FStarKDTree::Reset()
+{
+	Nodes.Empty();
+	Bounds = FBox(ForceInit);
+}
+
+void FStarKDTree::SplitRange(FNode* Nodes, int32 Begin, int32 End)
+{
+	FBox RangeBounds(ForceInit);
+	for (int32 i = Begin; i < End; ++i)
+	{
+		RangeBounds += Nodes[i].Position;
+	}
+	const FVector Extent = RangeBounds.GetExtent();
+	const int32 Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+
+	const int32 Mid = Begin + (End - Begin) / 2;
+	std::nth_element(
+		Nodes + Begin, Nodes + Mid, Nodes + End, [Axis](const FNode& A, const FNode& B) { return A.Position[Axis] < B.Position[Axis]; });
+	Nodes[Mid].StarIndexAndAxis = (Nodes[Mid].StarIndexAndAxis & 0x3fffffff) | ((uint32)Axis << 30);
+}
+
+void FStarKDTree::BuildSubtree(FNode* Nodes, int32 Begin, int32 End)
+{
+	if (End - Begin <= LeafSize)
+	{
+		return;
+	}
+
+	SplitRange(Nodes, Begin, End);
+	const int32 Mid = Begin + (End - Begin) / 2;
+	BuildSubtree(Nodes, Begin, Mid);
+	BuildSubtree(Nodes, Mid + 1, End);
+}
+
+int32 FStarKDTree::FindNearest(const FVector& Position, float MaxDistance, float* OutDistance) const
+{
+	int32 BestNode = INDEX_NONE;
+	float BestDistanceSquared = FMath::Square(FMath::Min(MaxDistance, 1.0e18f));
+	FindNearestRecursive(0, Nodes.Num(), Position, BestNode, BestDistanceSquared);
+
+	if (BestNode == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+	if (OutDistance != nullptr)
+	{
+		*OutDistance = FMath::Sqrt(BestDistanceSquared);
+	}
+	return Nodes[BestNode].GetStarIndex();
+}
+
+void FStarKDTree::FindNearestRecursive(int32 Begin, int32 End, const FVector& Position, int32& BestNode, float& BestDistanceSquared) const
+{
+	if (End - Begin <= LeafSize)
+	{
+		for (int32 i = Begin; i < End; ++i)
+		{
+			const float DistanceSquared = FVector::DistSquared(Nodes[i].Position, Position);
+			if (DistanceSquared < BestDistanceSquared)
+			{
+				BestNode = i;
+				BestDistanceSquared = DistanceSquared;
+			}
+		}
+		return;
+	}
+
+	const int32 Mid = Begin + (End - Begin) / 2;
+	const FNode& Node = Nodes[Mid];
+	const float DistanceSquared = FVector::DistSquared(Node.Position, Position);
+	if (DistanceSquared < BestDistanceSquared)
+	{
+		BestNode = Mid;
+		BestDistanceSquared = DistanceSquared;
+	}
+
+	// Near side first, the far side only if the split plane is closer than the best star
+	const int32 Axis = Node.GetAxis();
+	const float PlaneDistance = Position[Axis] - Node.Position[Axis];
+	if (PlaneDistance < 0.0f)
+	{
+		FindNearestRecursive(Begin, Mid, Position, BestNode, BestDistanceSquared);
+		if (PlaneDistance * PlaneDistance < BestDistanceSquared)
+		{
+			FindNearestRecursive(Mid + 1, End, Position, BestNode, BestDistanceSquared);
+		}
+	}
+	else
+	{
+		FindNearestRecursive(Mid + 1, End, Position, BestNode, BestDistanceSquared);
+		if (PlaneDistance * PlaneDistance < BestDistanceSquared)
+		{
+			FindNearestRecursive(Begin, Mid, Position, BestNode, BestDistanceSquared);
+		}
+	}
+}
+
+int32 FStarKDTree::FindInRadius(const FVector& Center, float Radius, TArray<int32>& OutStars, int32 MaxResults) const
+{
+	int32 Remaining = MaxResults;
+	FindInRadiusRecursive(0, Nodes.Num(), Center, Radius * Radius, OutStars, Remaining);
+	return MaxResults - Remaining;
+}
+
+void FStarKDTree::FindInRadiusRecursive(
+	int32 Begin, int32 End, const FVector& Center, float RadiusSquared, TArray<int32>& OutStars, int32& Remaining) const
+{
+	if (End - Begin <= LeafSize)
+	{
+		for (int32 i = Begin; i < End && Remaining > 0; ++i)
+		{
+			if (FVector::DistSquared(Nodes[i].Position, Center) <= RadiusSquared)
+			{
+				OutStars.Add(Nodes[i].GetStarIndex());
+				--Remaining;
+			}
+		}
+		return;
+	}
+
+	const int32 Mid = Begin + (End - Begin) / 2;
+	const FNode& Node = Nodes[Mid];
+	if (Remaining > 0 && FVector::DistSquared(Node.Position, Center) <= RadiusSquared)
+	{
+		OutStars.Add(Node.GetStarIndex());
+		--Remaining;
+	}
+
+	const int32 Axis = Node.GetAxis();
+	const float PlaneDistance = Center[Axis] - Node.Position[Axis];
+	if (Remaining > 0 && (PlaneDistance <= 0.0f || PlaneDistance * PlaneDistance <= RadiusSquared))
+	{
+		FindInRadiusRecursive(Begin, Mid, Center, RadiusSquared, OutStars, Remaining);
+	}
+	if (Remaining > 0 && (PlaneDistance >= 0.0f || PlaneDistance * PlaneDistance <= RadiusSquared))
+	{
+		FindInRadiusRecursive(Mid + 1, End, Center, RadiusSquared, OutStars, Remaining);
+	}
+}
+
+int32 FStarKDTree::FindInCone(const FVector& Origin, const FVector& Direction, float HalfAngle, float MaxDistance) const
+{
+	FConeQuery Query;
+	Query.Origin = Origin;
+	Query.Direction = Direction;
+	Query.MaxDistance = MaxDistance;
+	FMath::SinCos(&Query.Sin, &Query.Cos, FMath::Clamp(HalfAngle, 0.0f, HALF_PI));
+
+	if (Nodes.Num() > 0 && Query.Overlaps(Bounds))
+	{
+		FindInConeRecursive(0, Nodes.Num(), Bounds, Query);
+	}
+	return Query.BestNode != INDEX_NONE ? Nodes[Query.BestNode].GetStarIndex() : INDEX_NONE;
+}
+
+void FStarKDTree::FindInConeRecursive(int32 Begin, int32 End, const FBox& RangeBounds, FConeQuery& Query) const
+{
+	if (End - Begin <= LeafSize)
+	{
+		for (int32 i = Begin; i < End; ++i)
+		{
+			Query.Visit(Nodes[i].Position, i);
+		}
+		return;
+	}
+
+	const int32 Mid = Begin + (End - Begin) / 2;
+	const FNode& Node = Nodes[Mid];
+	Query.Visit(Node.Position, Mid);
+
+	// The cone narrows while stars are found, the child containing the apex goes first and the other one is tested after it
+	const int32 Axis = Node.GetAxis();
+	FBox LeftBounds = RangeBounds;
+	LeftBounds.Max[Axis] = Node.Position[Axis];
+	FBox RightBounds = RangeBounds;
+	RightBounds.Min[Axis] = Node.Position[Axis];
+
+	const bool bLeftFirst = Query.Origin[Axis] < Node.Position[Axis];
+	const FIntPoint First = bLeftFirst ? FIntPoint(Begin, Mid) : FIntPoint(Mid + 1, End);
+	const FIntPoint Second = bLeftFirst ? FIntPoint(Mid + 1, End) : FIntPoint(Begin, Mid);
+	const FBox& FirstBounds = bLeftFirst ? LeftBounds : RightBounds;
+	const FBox& SecondBounds = bLeftFirst ? RightBounds : LeftBounds;
+	if (Query.Overlaps(FirstBounds))
+	{
+		FindInConeRecursive(First.X, First.Y, FirstBounds, Query);
+	}
+	if (Query.Overlaps(SecondBounds))
+	{
+		FindInConeRecursive(Second.X, Second.Y, SecondBounds, Query);
+	}
+}
+
+bool UGalaxyStarQueryComponent::RebuildIndex()
+{
+	GalaxySystem = GetOwner() != nullptr ? GetOwner()->FindComponentByClass<UNiagaraComponent>() : nullptr;
+	if (GalaxySystem == nullptr)
+	{
+		UE_LOG(LogGalaxyStarIndex, Warning, TEXT("%s has no Niagara galaxy system"), *GetPathName());
+		SetStarBuffer(FStarBufferPtr());
+		return false;
+	}
+
+	static const FNiagaraTypeDefinition TypeDef(UNiagaraDataInterfaceStarBuffer::StaticClass());
+	const FNiagaraVariable Var(TypeDef, *(TEXT("User.") + StarBufferParameter));
+	const UNiagaraDataInterfaceStarBuffer* DataInterface =
+		Cast<UNiagaraDataInterfaceStarBuffer>(GalaxySystem->GetOverrideParameters().GetDataInterface(Var));
+	if (DataInterface == nullptr)
+	{
+		UE_LOG(LogGalaxyStarIndex, Warning, TEXT("Star buffer user parameter %s not found in %s"), *StarBufferParameter, *GetPathName());
+		SetStarBuffer(FStarBufferPtr());
+		return false;
+	}
+
+	SetStarBuffer(DataInterface->GetStarBuffer());
+	return StarBuffer.IsValid();
+}
+
+void UGalaxyStarQueryComponent::SetStarBuffer(FStarBufferPtr InStarBuffer)
+{
+	StarBuffer = MoveTemp(InStarBuffer);
+	if (StarBuffer.IsValid())
+	{
+		KDTree.Build(*StarBuffer);
+	}
+	else
+	{
+		KDTree.Reset();
+	}
+}
+
+bool UGalaxyStarQueryComponent::FindNearestStar(const FVector& Location, float MaxDistance, FGalaxyStarHit& OutHit) const
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousQueryStarKDTree);
+
+	const FTransform StarToWorld = GetStarToWorld();
+	const float Scale = StarToWorld.GetMaximumAxisScale();
+	const int32 StarIndex = KDTree.FindNearest(StarToWorld.InverseTransformPosition(Location), MaxDistance / Scale);
+	if (StarIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	MakeHit(StarIndex, Location, OutHit);
+	return true;
+}
+
+int32 UGalaxyStarQueryComponent::FindStarsInRadius(
+	const FVector& Location, float Radius, int32 MaxStars, TArray<FGalaxyStarHit>& OutHits) const
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousQueryStarKDTree);
+
+	const FTransform StarToWorld = GetStarToWorld();
+	const float Scale = StarToWorld.GetMaximumAxisScale();
+	TArray<int32> Found;
+	KDTree.FindInRadius(StarToWorld.InverseTransformPosition(Location), Radius / Scale, Found, MaxStars);
+
+	OutHits.SetNum(Found.Num());
+	for (int32 i = 0; i < Found.Num(); ++i)
+	{
+		MakeHit(Found[i], Location, OutHits[i]);
+	}
+	return Found.Num();
+}
+
+bool UGalaxyStarQueryComponent::PickStar(
+	const FVector& RayOrigin, const FVector& RayDirection, float ConeAngle, float MaxDistance, FGalaxyStarHit& OutHit) const
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousQueryStarKDTree);
+
+	const FTransform StarToWorld = GetStarToWorld();
+	const float Scale = StarToWorld.GetMaximumAxisScale();
+	const FVector Direction = StarToWorld.InverseTransformVectorNoScale(RayDirection).GetSafeNormal();
+	if (Direction.IsZero())
+	{
+		return false;
+	}
+
+	const int32 StarIndex = KDTree.FindInCone(
+		StarToWorld.InverseTransformPosition(RayOrigin), Direction, FMath::DegreesToRadians(ConeAngle), MaxDistance / Scale);
+	if (StarIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	MakeHit(StarIndex, RayOrigin, OutHit);
+	return true;
+}
+
+bool UGalaxyStarQueryComponent::GetStar(int32 StarIndex, FGalaxyStarHit& OutHit) const
+{
+	if (!StarBuffer.IsValid() || !StarBuffer->PositionX.IsValidIndex(StarIndex))
+	{
+		return false;
+	}
+
+	MakeHit(StarIndex, GetComponentLocation(), OutHit);
+	return true;
+}
+
+void UGalaxyStarQueryComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	RebuildIndex();
+}
+
+void UGalaxyStarQueryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetStarBuffer(FStarBufferPtr());
+
+	Super::EndPlay(EndPlayReason);
+}
+
+FTransform UGalaxyStarQueryComponent::GetStarToWorld() const
+{
+	return FTransform(FQuat::Identity, FVector::ZeroVector, FVector(GalaxyRadius)) * GetComponentTransform();
+}
+
+void UGalaxyStarQueryComponent::MakeHit(int32 StarIndex, const FVector& QueryLocation, FGalaxyStarHit& OutHit) const
+{
+	const FStarBuffer& Stars = *StarBuffer;
+	OutHit.StarIndex = StarIndex;
+	OutHit.Location = GetStarToWorld().TransformPosition(Stars.GetPosition(StarIndex));
+	OutHit.Distance = FVector::Dist(OutHit.Location, QueryLocation);
+	OutHit.Luminosity = FMath::Exp(Stars.LogLuminosity[StarIndex]);
+	OutHit.Temperature = Stars.Temperature[StarIndex];
+	OutHit.StarCount = Stars.StarCount[StarIndex];
+}
@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "StarGenerator.h"
+
+#include "GalaxyStarIndex.generated.h"
+
+class UNiagaraComponent;
+
+/**
+ * KD-tree over the positions of a star buffer with an implicit layout: the node of a range of the node array is its middle
+ * element, the left and right subtrees are the ranges before and after it. Nodes hold the position and star index in 16 bytes,
+ * no child pointers or bounds are stored. Ranges of up to LeafSize stars are leaves and scanned linearly.
+ *
+ * The top levels are split one level at a time with all ranges of a level in parallel, then the remaining subtrees are built
+ * in parallel. Splits use the axis of largest extent, so the flat disk is mostly split in the plane.
+ */
+class GALACTITIOUS_API FStarKDTree
+{
+public:
+	static constexpr int32 LeafSize = 8;
+
+	void Build(const FStarBuffer& Stars);
+
+	void Reset();
+
+	int32 Num() const { return Nodes.Num(); }
+
+	/** Star closest to Position within MaxDistance, INDEX_NONE if there is none. */
+	int32 FindNearest(const FVector& Position, float MaxDistance = BIG_NUMBER, float* OutDistance = nullptr) const;
+
+	/** Append the stars within Radius of Center to OutStars in no particular order, at most MaxResults. Returns the number appended. */
+	int32 FindInRadius(const FVector& Center, float Radius, TArray<int32>& OutStars, int32 MaxResults = MAX_int32) const;
+
+	/**
+	 * Star with the smallest angle to the axis of a cone with a half angle in radians, within MaxDistance of the apex.
+	 * Picks what a pointer ray hits best, INDEX_NONE if the cone contains no star. Direction has to be normalized.
+	 */
+	int32 FindInCone(const FVector& Origin, const FVector& Direction, float HalfAngle, float MaxDistance = BIG_NUMBER) const;
+
+	SIZE_T GetAllocatedSize() const { return Nodes.GetAllocatedSize(); }
+
+private:
+	struct FNode
+	{
+		FVector Position;
+
+		/** Star index in the low 30 bits, split axis of inner nodes in the high 2 bits. */
+		uint32 StarIndexAndAxis;
+
+		int32 GetStarIndex() const { return (int32)(StarIndexAndAxis & 0x3fffffff); }
+		int32 GetAxis() const { return (int32)(StarIndexAndAxis >> 30); }
+	};
+
+	struct FConeQuery;
+
+	static void SplitRange(FNode* Nodes, int32 Begin, int32 End);
+	static void BuildSubtree(FNode* Nodes, int32 Begin, int32 End);
+
+	void FindNearestRecursive(int32 Begin, int32 End, const FVector& Position, int32& BestNode, float& BestDistanceSquared) const;
+	void FindInRadiusRecursive(
+		int32 Begin, int32 End, const FVector& Center, float RadiusSquared, TArray<int32>& OutStars, int32& Remaining) const;
+	void FindInConeRecursive(int32 Begin, int32 End, const FBox& Bounds, FConeQuery& Query) const;
+
+	TArray<FNode> Nodes;
+	FBox Bounds = FBox(ForceInit);
+};
+
+/** Star found by a query of UGalaxyStarQueryComponent, in world space. */
+USTRUCT(BlueprintType)
+struct GALACTITIOUS_API FGalaxyStarHit
+{
+	GENERATED_BODY()
+
+	/** Index of the star in the star buffer, which is also the particle index. */
+	UPROPERTY(BlueprintReadOnly, Category = "Galaxy")
+	int32 StarIndex = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Galaxy")
+	FVector Location = FVector::ZeroVector;
+
+	/** Distance to the query location or ray origin. */
+	UPROPERTY(BlueprintReadOnly, Category = "Galaxy")
+	float Distance = 0.0f;
+
+	/** Luminosity of a single star of the particle in solar luminosities. */
+	UPROPERTY(BlueprintReadOnly, Category = "Galaxy")
+	float Luminosity = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Galaxy")
+	float Temperature = 0.0f;
+
+	/** Number of stars represented by the particle. */
+	UPROPERTY(BlueprintReadOnly, Category = "Galaxy")
+	float StarCount = 0.0f;
+};
+
+/**
+ * Star picking and neighborhood queries for a galaxy. The star buffer is taken from a star buffer user parameter of the
+ * Niagara galaxy system of the owner. The component transform has to match the galaxy system, star positions are
+ * scaled by GalaxyRadius.
+ */
+UCLASS(ClassGroup = (Galactitious), meta = (BlueprintSpawnableComponent))
+class GALACTITIOUS_API UGalaxyStarQueryComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	using FStarBufferPtr = TSharedPtr<const FStarBuffer, ESPMode::ThreadSafe>;
+
+	/** Galaxy radius in component space, matching the Radius of the galaxy shape settings. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Galaxy", meta = (ClampMin = "0.001"))
+	float GalaxyRadius = 100.0f;
+
+	/** Name of the star buffer user parameter of the galaxy system, without the User namespace. */
+	UPROPERTY(EditAnywhere, Category = "Galaxy")
+	FString StarBufferParameter = TEXT("StarBuffer");
+
+	/** Rebuild the index from the star buffer of the galaxy system, e.g. after the star buffer was regenerated. */
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	bool RebuildIndex();
+
+	/** Use a star buffer directly instead of the one of the galaxy system. */
+	void SetStarBuffer(FStarBufferPtr InStarBuffer);
+
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	bool FindNearestStar(const FVector& Location, float MaxDistance, FGalaxyStarHit& OutHit) const;
+
+	/** Stars within Radius of Location in no particular order, at most MaxStars. */
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	int32 FindStarsInRadius(const FVector& Location, float Radius, int32 MaxStars, TArray<FGalaxyStarHit>& OutHits) const;
+
+	/** Star closest to a pointer ray in angle, within a cone with a half angle of ConeAngle degrees around the ray and MaxDistance. */
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	bool PickStar(const FVector& RayOrigin, const FVector& RayDirection, float ConeAngle, float MaxDistance, FGalaxyStarHit& OutHit) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Galaxy")
+	bool GetStar(int32 StarIndex, FGalaxyStarHit& OutHit) const;
+
+	UFUNCTION(BlueprintPure, Category = "Galaxy")
+	int32 GetNumStars() const { return KDTree.Num(); }
+
+	const FStarKDTree& GetKDTree() const { return KDTree; }
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	/** Transform from the star buffer space relative to the galaxy radius to world space, assumed to be uniformly scaled. */
+	FTransform GetStarToWorld() const;
+
+	void MakeHit(int32 StarIndex, const FVector& QueryLocation, FGalaxyStarHit& OutHit) const;
+
+	UPROPERTY(Transient)
+	UNiagaraComponent* GalaxySystem;
+
+	FStarBufferPtr StarBuffer;
+	FStarKDTree KDTree;
+};
@@ -0,0 +1,404 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalaxyStreaming.h"
+
+#include "GalactitiousStats.h"
+#include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceStarBuffer.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGalaxyStreaming, Log, All);
+
+namespace
+{
+	/** Samples per axis of the chunk domain to estimate chunk bounds. */
+	const int32 ChunkBoundsSamples = 8;
+
+	/** Points along the predicted camera path to prioritize chunks by. */
+	const int32 PrefetchPathPoints = 4;
+} // namespace
+
+FGalaxyStreamer::~FGalaxyStreamer()
+{
+	Reset();
+}
+
+bool FGalaxyStreamer::Initialize(const UGalaxyShapeSettings& Shape, const UStarSettings& Star, const FGalaxyStreamingSettings& InSettings)
+{
+	Reset();
+
+	if (!ensureMsgf(Shape.ThicknessCurve != nullptr, TEXT("Thickness curve not set")))
+	{
+		return false;
+	}
+	if (!ensureMsgf(InSettings.ChunkResolution > 0 && InSettings.NumParticles > 0, TEXT("Invalid streaming settings")))
+	{
+		return false;
+	}
+
+	const int32 NumChunks = InSettings.ChunkResolution * InSettings.ChunkResolution;
+	const int64 NumChunkParticles = (InSettings.NumParticles + NumChunks - 1) / NumChunks;
+	if (!ensureMsgf(NumChunkParticles <= MAX_int32, TEXT("Too many particles per chunk, increase the chunk resolution")))
+	{
+		return false;
+	}
+
+	// Each slot holds a chunk in memory and in every mirror
+	const int64 ChunkBytes = NumChunkParticles * sizeof(float) * 6;
+	const int64 SlotBytes = ChunkBytes * (1 + FMath::Max(InSettings.NumMirrors, 0));
+	const int32 NumSlots = (int32)FMath::Clamp<int64>(InSettings.MemoryBudgetBytes / SlotBytes, 0, NumChunks);
+	if (!ensureMsgf(NumSlots > 0, TEXT("Memory budget below a single chunk, decrease the particles or increase the chunk resolution")))
+	{
+		return false;
+	}
+
+	TSharedRef<FGalaxyShapeSamplingData, ESPMode::ThreadSafe> NewShapeData = MakeShared<FGalaxyShapeSamplingData, ESPMode::ThreadSafe>();
+	TSharedRef<FStarSamplingData, ESPMode::ThreadSafe> NewStarData = MakeShared<FStarSamplingData, ESPMode::ThreadSafe>();
+	if (!Shape.ComputeSamplingData(*NewShapeData) || !Star.ComputeSamplingData(*NewStarData))
+	{
+		return false;
+	}
+
+	Settings = InSettings;
+	ShapeSettings = &Shape;
+	ShapeData = NewShapeData;
+	StarData = NewStarData;
+	ParticlesPerChunk = (int32)NumChunkParticles;
+	BytesPerChunk = ChunkBytes;
+	SlotChunks.Init(INDEX_NONE, NumSlots);
+	FreeSlots.Reset(NumSlots);
+	for (int32 Slot = NumSlots - 1; Slot >= 0; --Slot)
+	{
+		FreeSlots.Add(Slot);
+	}
+	UsedBytes = NumSlots * (SlotBytes - ChunkBytes);
+
+	// Bounds of the mapped sample grid, padded for the extremes between samples and a Gaussian height of three deviations
+	Chunks.SetNum(NumChunks);
+	const FRichCurve& ThicknessCurve = Shape.ThicknessCurve->FloatCurve;
+	ParallelFor(NumChunks, [&](int32 Chunk) {
+		const FBox2D Domain = GetChunkDomain(Chunk);
+		FBox Bounds(ForceInit);
+		for (int32 y = 0; y < ChunkBoundsSamples; ++y)
+		{
+			for (int32 x = 0; x < ChunkBoundsSamples; ++x)
+			{
+				const FVector2D Alpha = FVector2D(x, y) / (ChunkBoundsSamples - 1);
+				const float U = FMath::Min(FMath::Lerp(Domain.Min.X, Domain.Max.X, Alpha.X), 1.0f - KINDA_SMALL_NUMBER);
+				const float V = FMath::Min(FMath::Lerp(Domain.Min.Y, Domain.Max.Y, Alpha.Y), 1.0f - KINDA_SMALL_NUMBER);
+				const FVector2D PlanePosition = FGalaxyStarGenerator::SamplePlanePosition(*ShapeData, U, V, false);
+				const float Height = 3.0f * FMath::Max(ThicknessCurve.Eval(PlanePosition.Size()), 0.0f);
+				Bounds += FVector(PlanePosition, Height);
+				Bounds += FVector(PlanePosition, -Height);
+			}
+		}
+		Chunks[Chunk].Bounds = Bounds.ExpandBy(0.1f * Bounds.GetExtent().GetMax());
+	});
+
+	return true;
+}
+
+void FGalaxyStreamer::Reset()
+{
+	for (const int32 Chunk : LoadingChunks)
+	{
+		Chunks[Chunk].Load.Wait();
+	}
+	LoadingChunks.Empty();
+	Chunks.Empty();
+	SlotChunks.Empty();
+	FreeSlots.Empty();
+	UsedBytes = 0;
+	NumResidentChunks = 0;
+}
+
+bool FGalaxyStreamer::Update(const FVector& CameraPosition, const FVector& CameraVelocity)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousUpdateStreaming);
+
+	++UpdateCount;
+	bool bChanged = false;
+
+	for (int32 i = 0; i < LoadingChunks.Num();)
+	{
+		const int32 ChunkIndex = LoadingChunks[i];
+		FChunk& Chunk = Chunks[ChunkIndex];
+		if (!Chunk.Load.IsReady())
+		{
+			++i;
+			continue;
+		}
+
+		// Failed loads are retried when the chunk is wanted again, loads only start while a slot is free
+		Chunk.Stars = Chunk.Load.Get();
+		Chunk.Load.Reset();
+		if (Chunk.Stars.IsValid())
+		{
+			Chunk.State = EChunkState::Resident;
+			Chunk.Slot = FreeSlots.Pop(false);
+			SlotChunks[Chunk.Slot] = ChunkIndex;
+			++NumResidentChunks;
+			bChanged = true;
+		}
+		else
+		{
+			Chunk.State = EChunkState::Unloaded;
+			UsedBytes -= BytesPerChunk;
+		}
+		LoadingChunks.RemoveAtSwap(i);
+	}
+
+	// Distance of the chunks to the camera path predicted from the velocity
+	WantedChunks.Reset();
+	for (int32 Chunk = 0; Chunk < Chunks.Num(); ++Chunk)
+	{
+		const FBox& Bounds = Chunks[Chunk].Bounds;
+		float DistanceSquared = Bounds.ComputeSquaredDistanceToPoint(CameraPosition);
+		for (int32 Point = 1; Point <= PrefetchPathPoints; ++Point)
+		{
+			const FVector Predicted = CameraPosition + CameraVelocity * (Settings.PrefetchTime * Point / PrefetchPathPoints);
+			DistanceSquared = FMath::Min(DistanceSquared, Bounds.ComputeSquaredDistanceToPoint(Predicted));
+		}
+		if (DistanceSquared <= FMath::Square(Settings.LoadRadius))
+		{
+			WantedChunks.Add(TPair<float, int32>(DistanceSquared, Chunk));
+		}
+	}
+
+	// The nearest chunks that fit into the slots are wanted
+	WantedChunks.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+	WantedChunks.SetNum(FMath::Min(WantedChunks.Num(), SlotChunks.Num()), false);
+	for (const TPair<float, int32>& Wanted : WantedChunks)
+	{
+		Chunks[Wanted.Value].LastWanted = UpdateCount;
+	}
+
+	for (const TPair<float, int32>& Wanted : WantedChunks)
+	{
+		if (LoadingChunks.Num() >= Settings.MaxConcurrentLoads)
+		{
+			break;
+		}
+
+		const int32 ChunkIndex = Wanted.Value;
+		FChunk& Chunk = Chunks[ChunkIndex];
+		if (Chunk.State != EChunkState::Unloaded)
+		{
+			continue;
+		}
+
+		// The slots and their mirrors fit into the budget, so resident and loading chunks are bounded by the slots
+		bool bFits = true;
+		while (bFits && NumResidentChunks + LoadingChunks.Num() >= SlotChunks.Num())
+		{
+			bFits = EvictLeastRecentlyWanted(UpdateCount);
+			bChanged |= bFits;
+		}
+		if (!bFits)
+		{
+			break;
+		}
+
+		// Memory is reserved up front so loads in flight count towards the budget
+		Chunk.State = EChunkState::Loading;
+		UsedBytes += BytesPerChunk;
+		LoadingChunks.Add(ChunkIndex);
+		Chunk.Load = Async(EAsyncExecution::ThreadPool, [this, ChunkIndex]() {
+			TSharedRef<FStarBuffer, ESPMode::ThreadSafe> Stars = MakeShared<FStarBuffer, ESPMode::ThreadSafe>();
+			return LoadChunk(ChunkIndex, *Stars) ? FStarBufferPtr(Stars) : FStarBufferPtr();
+		});
+	}
+
+	SET_MEMORY_STAT(STAT_GalactitiousStreamingMemory, UsedBytes);
+	return bChanged;
+}
+
+bool FGalaxyStreamer::EvictLeastRecentlyWanted(uint32 WantedUpdate)
+{
+	int32 Evicted = INDEX_NONE;
+	for (int32 Chunk = 0; Chunk < Chunks.Num(); ++Chunk)
+	{
+		const FChunk& Candidate = Chunks[Chunk];
+		if (Candidate.State == EChunkState::Resident && Candidate.LastWanted != WantedUpdate &&
+			(Evicted == INDEX_NONE || Candidate.LastWanted < Chunks[Evicted].LastWanted))
+		{
+			Evicted = Chunk;
+		}
+	}
+	if (Evicted == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FChunk& Chunk = Chunks[Evicted];
+	Chunk.Stars.Reset();
+	Chunk.State = EChunkState::Unloaded;
+	SlotChunks[Chunk.Slot] = INDEX_NONE;
+	FreeSlots.Add(Chunk.Slot);
+	Chunk.Slot = INDEX_NONE;
+	UsedBytes -= BytesPerChunk;
+	--NumResidentChunks;
+	return true;
+}
+
+void FGalaxyStreamer::GetSlots(TArray<FStarBufferPtr>& OutStars) const
+{
+	OutStars.Reset(SlotChunks.Num());
+	for (const int32 Chunk : SlotChunks)
+	{
+		OutStars.Add(Chunk != INDEX_NONE ? Chunks[Chunk].Stars : FStarBufferPtr());
+	}
+}
+
+FBox2D FGalaxyStreamer::GetChunkDomain(int32 Chunk) const
+{
+	const int32 Resolution = Settings.ChunkResolution;
+	const FVector2D Min(Chunk % Resolution, Chunk / Resolution);
+	return FBox2D(Min / Resolution, (Min + FVector2D(1.0f, 1.0f)) / Resolution);
+}
+
+FStarGeneratorSettings FGalaxyStreamer::GetChunkGeneratorSettings(int32 Chunk) const
+{
+	// Each chunk covers an equal share of the probability mass and of the stars
+	FStarGeneratorSettings GeneratorSettings;
+	GeneratorSettings.NumParticles = ParticlesPerChunk;
+	GeneratorSettings.NumGalaxyStars = Settings.NumGalaxyStars / Chunks.Num();
+	GeneratorSettings.Seed = (int32)HashCombine(GetTypeHash(Settings.Seed), GetTypeHash(Chunk));
+	GeneratorSettings.Sequence = Settings.Sequence;
+	GeneratorSettings.SampleDomain = GetChunkDomain(Chunk);
+	GeneratorSettings.bSingleThreaded = true;
+	return GeneratorSettings;
+}
+
+bool FGalaxyStreamer::LoadChunk(int32 Chunk, FStarBuffer& OutStars) const
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousLoadStreamingChunk);
+
+	const FString Filename = GetChunkFilename(Chunk);
+	if (!Filename.IsEmpty() && IFileManager::Get().FileExists(*Filename))
+	{
+		if (OutStars.LoadSnapshot(Filename) && OutStars.Num() == ParticlesPerChunk)
+		{
+			return true;
+		}
+		UE_LOG(LogGalaxyStreaming, Warning, TEXT("Chunk file %s is invalid, regenerating"), *Filename);
+	}
+
+	if (!FGalaxyStarGenerator::Generate(*ShapeSettings, *ShapeData, *StarData, GetChunkGeneratorSettings(Chunk), OutStars))
+	{
+		return false;
+	}
+	if (!Filename.IsEmpty() && Settings.bWriteCache)
+	{
+		OutStars.SaveSnapshot(Filename);
+	}
+	return true;
+}
+
+FString FGalaxyStreamer::GetChunkFilename(int32 Chunk) const
+{
+	return Settings.CacheDirectory.IsEmpty() ? FString() : Settings.CacheDirectory / FString::Printf(TEXT("Chunk_%d.bin"), Chunk);
+}
+
+UGalaxyStreamingComponent::UGalaxyStreamingComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+void UGalaxyStreamingComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	GalaxySystem = GetOwner()->FindComponentByClass<UNiagaraComponent>();
+	if (!ensureMsgf(ShapeSettings != nullptr && StarSettings != nullptr, TEXT("Galaxy streaming settings not set")))
+	{
+		return;
+	}
+
+	FGalaxyStreamingSettings StreamingSettings;
+	StreamingSettings.ChunkResolution = ChunkResolution;
+	StreamingSettings.NumParticles = NumParticles;
+	StreamingSettings.NumGalaxyStars = NumGalaxyStars;
+	StreamingSettings.MemoryBudgetBytes = (int64)MemoryBudgetMB * 1024 * 1024;
+	StreamingSettings.LoadRadius = LoadRadius;
+	StreamingSettings.PrefetchTime = PrefetchTime;
+	// The star buffer data interface mirrors the slots on the GPU
+	StreamingSettings.NumMirrors = 1;
+	if (!CacheDirectory.IsEmpty())
+	{
+		StreamingSettings.CacheDirectory = FPaths::ProjectSavedDir() / CacheDirectory;
+		StreamingSettings.bWriteCache = true;
+	}
+	if (!Streamer.Initialize(*ShapeSettings, *StarSettings, StreamingSettings))
+	{
+		return;
+	}
+
+	// The number of stars only changes here, chunks arriving later replace their slots in the running system
+	if (PushSlots())
+	{
+		GalaxySystem->ReinitializeSystem();
+	}
+}
+
+void UGalaxyStreamingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Streamer.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UGalaxyStreamingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (PlayerController == nullptr || PlayerController->PlayerCameraManager == nullptr || Streamer.GetNumChunks() == 0)
+	{
+		return;
+	}
+
+	// Camera in the star buffer space relative to the galaxy radius
+	const FVector CameraLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	const FVector CameraPosition = GetComponentTransform().InverseTransformPosition(CameraLocation) / GalaxyRadius;
+	const FVector CameraVelocity =
+		bHasLastCameraPosition && DeltaTime > 0.0f ? (CameraPosition - LastCameraPosition) / DeltaTime : FVector::ZeroVector;
+	LastCameraPosition = CameraPosition;
+	bHasLastCameraPosition = true;
+
+	if (Streamer.Update(CameraPosition, CameraVelocity))
+	{
+		PushSlots();
+	}
+}
+
+bool UGalaxyStreamingComponent::PushSlots()
+{
+	if (GalaxySystem == nullptr)
+	{
+		return false;
+	}
+
+	static const FNiagaraTypeDefinition TypeDef(UNiagaraDataInterfaceStarBuffer::StaticClass());
+	const FNiagaraVariable Var(TypeDef, *(TEXT("User.") + StarBufferParameter));
+	UNiagaraDataInterfaceStarBuffer* DataInterface =
+		Cast<UNiagaraDataInterfaceStarBuffer>(GalaxySystem->GetOverrideParameters().GetDataInterface(Var));
+	if (DataInterface == nullptr)
+	{
+		UE_LOG(LogGalaxyStreaming, Warning, TEXT("Star buffer user parameter %s not found in %s"), *StarBufferParameter, *GetPathName());
+		return false;
+	}
+
+	// Slots share the chunk buffers, only slots whose chunk changed are uploaded
+	TArray<FGalaxyStreamer::FStarBufferPtr> Slots;
+	Streamer.GetSlots(Slots);
+	return DataInterface->SetStarSlots(MoveTemp(Slots), Streamer.GetParticlesPerChunk());
+}
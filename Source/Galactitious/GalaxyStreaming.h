@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Components/SceneComponent.h"
+#include "SampleSequence.h"
+#include "StarGenerator.h"
+#include "StellarSamplingData.h"
+
+#include "GalaxyStreaming.generated.h"
+
+class UNiagaraComponent;
+
+struct FGalaxyStreamingSettings
+{
+	/** Chunks per axis of the position sample domain, each chunk holds NumParticles / ChunkResolution^2 particles. */
+	int32 ChunkResolution = 64;
+
+	/** Particles M of the whole galaxy, only the resident chunks are held in memory. */
+	int64 NumParticles = 1000000000;
+
+	/** Stars N in the galaxy. */
+	double NumGalaxyStars = 1.0e11;
+
+	int32 Seed = 0;
+	ESampleSequence Sequence = ESampleSequence::Sobol;
+
+	/** Ceiling of the star data of resident and loading chunks, including their mirrors. */
+	int64 MemoryBudgetBytes = 512ll * 1024 * 1024;
+
+	/** Copies of the slots outside the streamer, such as the GPU buffer of the star buffer data interface. Reserved up front. */
+	int32 NumMirrors = 0;
+
+	/** Chunks closer to the camera than this, relative to the galaxy radius, are loaded. */
+	float LoadRadius = 0.3f;
+
+	/** Seconds of camera velocity to look ahead, chunks near the predicted position are loaded early. */
+	float PrefetchTime = 2.0f;
+
+	/** Chunk loads in flight on the thread pool. */
+	int32 MaxConcurrentLoads = 4;
+
+	/** Directory of chunk snapshot files, chunks are loaded from it when present and regenerated otherwise. Empty to always regenerate. */
+	FString CacheDirectory;
+
+	/** Write regenerated chunks to CacheDirectory. The directory has to be cleared when settings change. */
+	bool bWriteCache = false;
+};
+
+/**
+ * Pages spatial chunks of a galaxy too large for memory in and out around the camera.
+ *
+ * Chunks are rectangles of the position sample domain of FGalaxyStarGenerator. Both the radial and the arm density sampling
+ * map a rectangle to a compact region, rings and sectors or bands of rows, and every chunk holds the same probability mass.
+ * Generating the chunks separately therefore yields the same distribution as generating the whole galaxy at once, and all
+ * chunks have the same size.
+ *
+ * Update only does bookkeeping on the game thread. Loads read snapshot files or regenerate chunks on the thread pool.
+ * Chunks are prioritized by the distance of their bounds to the camera and to its position predicted from the velocity.
+ * Resident chunks outside the wanted set stay cached until their memory is needed and are evicted least recently wanted first.
+ * Each resident chunk keeps a slot until it is evicted, so mirrors of the slots only update the slots which changed.
+ */
+class GALACTITIOUS_API FGalaxyStreamer
+{
+public:
+	using FStarBufferPtr = TSharedPtr<const FStarBuffer, ESPMode::ThreadSafe>;
+
+	~FGalaxyStreamer();
+
+	/** Derive the sampling data and estimate chunk bounds. The settings assets must stay alive while the streamer is used. */
+	bool Initialize(const UGalaxyShapeSettings& Shape, const UStarSettings& Star, const FGalaxyStreamingSettings& InSettings);
+
+	/** Wait for loads in flight and release all chunks. */
+	void Reset();
+
+	/**
+	 * Finish completed loads, evict and start new loads. Positions and velocity are relative to the galaxy radius.
+	 * Returns true when the set of resident chunks changed.
+	 */
+	bool Update(const FVector& CameraPosition, const FVector& CameraVelocity);
+
+	int32 GetNumChunks() const { return Chunks.Num(); }
+	int32 GetNumResidentChunks() const { return NumResidentChunks; }
+	int32 GetNumLoadingChunks() const { return LoadingChunks.Num(); }
+
+	/** Bytes of resident chunks, reserved for chunks in flight and for the mirrors of all slots. */
+	int64 GetUsedBytes() const { return UsedBytes; }
+
+	/** Slots of resident chunks, the most chunks resident or loading at once within the budget. */
+	int32 GetNumSlots() const { return SlotChunks.Num(); }
+
+	int32 GetParticlesPerChunk() const { return ParticlesPerChunk; }
+
+	/** Stars of a chunk, null unless it is resident. */
+	FStarBufferPtr GetChunkStars(int32 Chunk) const { return Chunks[Chunk].Stars; }
+
+	/** Estimated bounds of a chunk relative to the galaxy radius. */
+	const FBox& GetChunkBounds(int32 Chunk) const { return Chunks[Chunk].Bounds; }
+
+	/** Stars of the chunks in all slots, null for free slots. */
+	void GetSlots(TArray<FStarBufferPtr>& OutStars) const;
+
+	/** Generator settings of a chunk, the stars of a single chunk as generated by FGalaxyStarGenerator. */
+	FStarGeneratorSettings GetChunkGeneratorSettings(int32 Chunk) const;
+
+	/** Generate or load a chunk synchronously. Safe to call from any thread. */
+	bool LoadChunk(int32 Chunk, FStarBuffer& OutStars) const;
+
+private:
+	enum class EChunkState : uint8
+	{
+		Unloaded,
+		Loading,
+		Resident,
+	};
+
+	struct FChunk
+	{
+		FBox Bounds;
+		EChunkState State = EChunkState::Unloaded;
+
+		/** Update when the chunk was last wanted, for LRU eviction. */
+		uint32 LastWanted = 0;
+
+		/** Slot of a resident chunk. */
+		int32 Slot = INDEX_NONE;
+
+		FStarBufferPtr Stars;
+		TFuture<FStarBufferPtr> Load;
+	};
+
+	bool EvictLeastRecentlyWanted(uint32 WantedUpdate);
+	FBox2D GetChunkDomain(int32 Chunk) const;
+	FString GetChunkFilename(int32 Chunk) const;
+
+	FGalaxyStreamingSettings Settings;
+	const UGalaxyShapeSettings* ShapeSettings = nullptr;
+
+	/** Only read after Initialize, loads in flight share them. */
+	TSharedPtr<const FGalaxyShapeSamplingData, ESPMode::ThreadSafe> ShapeData;
+	TSharedPtr<const FStarSamplingData, ESPMode::ThreadSafe> StarData;
+
+	TArray<FChunk> Chunks;
+	TArray<int32> LoadingChunks;
+
+	/** Chunk in each slot or INDEX_NONE, and the free slots. */
+	TArray<int32> SlotChunks;
+	TArray<int32> FreeSlots;
+	int32 ParticlesPerChunk = 0;
+	int64 BytesPerChunk = 0;
+	int64 UsedBytes = 0;
+	int32 NumResidentChunks = 0;
+	uint32 UpdateCount = 0;
+
+	/** Scratch of Update. */
+	TArray<TPair<float, int32>> WantedChunks;
+};
+
+/**
+ * Streams the stars around the camera into the star buffer user parameter of the Niagara galaxy system of the owner.
+ * The slots of the streamer are bound as star buffer slots, arriving chunks replace their slot in place without a restart,
+ * so particle update scripts have to read the star of their index to follow them. The GPU copy counts towards the budget.
+ * The component transform has to match the galaxy system, star positions are scaled by GalaxyRadius.
+ */
+UCLASS(ClassGroup = (Galactitious), meta = (BlueprintSpawnableComponent))
+class GALACTITIOUS_API UGalaxyStreamingComponent : public USceneComponent
+{
+	GENERATED_BODY()
+
+public:
+	UGalaxyStreamingComponent();
+
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	UGalaxyShapeSettings* ShapeSettings;
+
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	UStarSettings* StarSettings;
+
+	/** Galaxy radius in component space, matching the Radius of the galaxy shape settings. */
+	UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "0.001"))
+	float GalaxyRadius = 100.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "1"))
+	int64 NumParticles = 1000000000;
+
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	float NumGalaxyStars = 1.0e11f;
+
+	UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "1", ClampMax = "1024"))
+	int32 ChunkResolution = 64;
+
+	UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "1"))
+	int32 MemoryBudgetMB = 512;
+
+	/** Chunks closer to the camera than this, relative to the galaxy radius, are loaded. */
+	UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "0"))
+	float LoadRadius = 0.3f;
+
+	UPROPERTY(EditAnywhere, Category = "Streaming", meta = (ClampMin = "0"))
+	float PrefetchTime = 2.0f;
+
+	/** Chunk snapshot directory relative to the project saved directory, empty to always regenerate chunks. */
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	FString CacheDirectory;
+
+	/** Name of the star buffer user parameter of the galaxy system, without the User namespace. */
+	UPROPERTY(EditAnywhere, Category = "Streaming")
+	FString StarBufferParameter = TEXT("StarBuffer");
+
+	const FGalaxyStreamer& GetStreamer() const { return Streamer; }
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+private:
+	/** Bind the slots of the streamer to the star buffer user parameter. */
+	bool PushSlots();
+
+	UPROPERTY(Transient)
+	UNiagaraComponent* GalaxySystem;
+
+	FGalaxyStreamer Streamer;
+	FVector LastCameraPosition = FVector::ZeroVector;
+	bool bHasLastCameraPosition = false;
+};
@@ -0,0 +1,554 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NiagaraDataInterfaceLookupTable.h"
+
+#include "NiagaraRenderer.h"
+#include "NiagaraShader.h"
+#include "NiagaraTypes.h"
+#include "ShaderParameterUtils.h"
+#include "TextureBakerFunctionLibrary.h"
+#include "VectorVM.h"
+
+namespace
+{
+	const FName SampleName(TEXT("Sample"));
+	const FName SampleVectorName(TEXT("SampleVector"));
+
+	const FString TableBufferName(TEXT("TableBuffer_"));
+	const FString NumEntriesName(TEXT("TableNumEntries_"));
+	const FString NumChannelsName(TEXT("TableNumChannels_"));
+	const FString DomainScaleName(TEXT("TableDomainScale_"));
+	const FString DomainOffsetName(TEXT("TableDomainOffset_"));
+
+	/** Entry indices and interpolation weight of a fractional index already clamped to [0, NumEntries - 1]. */
+	FORCEINLINE void GetLerpEntries(float Index, int32 NumEntries, int32& OutIndex0, int32& OutIndex1, float& OutAlpha)
+	{
+		OutIndex0 = (int32)Index;
+		OutIndex1 = FMath::Min(OutIndex0 + 1, NumEntries - 1);
+		OutAlpha = Index - OutIndex0;
+	}
+
+	struct FNDILookupTableInstanceData
+	{
+		/** Snapshot read by the VM functions of the instance, only replaced on the game thread in PerInstanceTick. */
+		UNiagaraDataInterfaceLookupTable::FSnapshotPtr Snapshot;
+	};
+} // namespace
+
+struct FNiagaraDataInterfaceParametersCS_LookupTable : public FNiagaraDataInterfaceParametersCS
+{
+	DECLARE_TYPE_LAYOUT(FNiagaraDataInterfaceParametersCS_LookupTable, NonVirtual);
+
+public:
+	void Bind(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FShaderParameterMap& ParameterMap)
+	{
+		TableBuffer.Bind(ParameterMap, *(TableBufferName + ParamInfo.DataInterfaceHLSLSymbol));
+		NumEntries.Bind(ParameterMap, *(NumEntriesName + ParamInfo.DataInterfaceHLSLSymbol));
+		NumChannels.Bind(ParameterMap, *(NumChannelsName + ParamInfo.DataInterfaceHLSLSymbol));
+		DomainScale.Bind(ParameterMap, *(DomainScaleName + ParamInfo.DataInterfaceHLSLSymbol));
+		DomainOffset.Bind(ParameterMap, *(DomainOffsetName + ParamInfo.DataInterfaceHLSLSymbol));
+	}
+
+	void Set(FRHICommandList& RHICmdList, const FNiagaraDataInterfaceSetArgs& Context) const
+	{
+		check(IsInRenderingThread());
+
+		FRHIComputeShader* ComputeShaderRHI = Context.Shader.GetComputeShader();
+		const FNiagaraDataInterfaceProxyLookupTable* Proxy =
+			static_cast<const FNiagaraDataInterfaceProxyLookupTable*>(Context.DataInterface);
+
+		// Empty tables sample to zero, a buffer still has to be bound
+		FRHIShaderResourceView* TableSRV =
+			Proxy->NumEntries > 0 ? Proxy->TableBuffer.SRV.GetReference() : FNiagaraRenderer::GetDummyFloatBuffer().SRV.GetReference();
+		SetSRVParameter(RHICmdList, ComputeShaderRHI, TableBuffer, TableSRV);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, NumEntries, Proxy->NumEntries);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, NumChannels, Proxy->NumChannels);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, DomainScale, Proxy->DomainScale);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, DomainOffset, Proxy->DomainOffset);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, TableBuffer);
+	LAYOUT_FIELD(FShaderParameter, NumEntries);
+	LAYOUT_FIELD(FShaderParameter, NumChannels);
+	LAYOUT_FIELD(FShaderParameter, DomainScale);
+	LAYOUT_FIELD(FShaderParameter, DomainOffset);
+};
+
+IMPLEMENT_TYPE_LAYOUT(FNiagaraDataInterfaceParametersCS_LookupTable);
+
+IMPLEMENT_NIAGARA_DI_PARAMETER(UNiagaraDataInterfaceLookupTable, FNiagaraDataInterfaceParametersCS_LookupTable);
+
+UNiagaraDataInterfaceLookupTable::UNiagaraDataInterfaceLookupTable(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	Proxy.Reset(new FNiagaraDataInterfaceProxyLookupTable());
+	Snapshot = MakeShared<const FNiagaraLookupTableSnapshot, ESPMode::ThreadSafe>();
+}
+
+void UNiagaraDataInterfaceLookupTable::SetTable(
+	TArrayView<const float> InValues, int32 InNumChannels, float InDomainMin, float InDomainMax)
+{
+	if (!ensureMsgf(InNumChannels == 1 || InNumChannels == 4, TEXT("Lookup tables have 1 or 4 channels, got %d"), InNumChannels))
+	{
+		return;
+	}
+	if (!ensureMsgf(InValues.Num() % InNumChannels == 0, TEXT("Lookup table values are not a multiple of %d channels"), InNumChannels))
+	{
+		return;
+	}
+
+	const bool bSameLayout = InNumChannels == NumChannels && InValues.Num() == Values.Num();
+	const bool bSameDomain = InDomainMin == DomainMin && InDomainMax == DomainMax;
+	DomainMin = InDomainMin;
+	DomainMax = InDomainMax;
+
+	if (!bSameLayout)
+	{
+		NumChannels = InNumChannels;
+		Values.Reset(InValues.Num());
+		Values.Append(InValues.GetData(), InValues.Num());
+		PushToRenderThread(0, GetNumEntries());
+		return;
+	}
+
+	// Bitwise comparison, so NaN entries do not cause uploads on every push
+	const uint32* NewBits = reinterpret_cast<const uint32*>(InValues.GetData());
+	const uint32* OldBits = reinterpret_cast<const uint32*>(Values.GetData());
+	int32 FirstChanged = 0;
+	while (FirstChanged < Values.Num() && NewBits[FirstChanged] == OldBits[FirstChanged])
+	{
+		++FirstChanged;
+	}
+	if (FirstChanged == Values.Num())
+	{
+		if (!bSameDomain)
+		{
+			PushToRenderThread(0, 0);
+		}
+		return;
+	}
+	int32 LastChanged = Values.Num() - 1;
+	while (NewBits[LastChanged] == OldBits[LastChanged])
+	{
+		--LastChanged;
+	}
+
+	const int32 FirstEntry = FirstChanged / NumChannels;
+	const int32 EndEntry = LastChanged / NumChannels + 1;
+	const int32 FirstValue = FirstEntry * NumChannels;
+	FMemory::Memcpy(&Values[FirstValue], &InValues[FirstValue], (EndEntry - FirstEntry) * NumChannels * sizeof(float));
+	PushToRenderThread(FirstEntry, EndEntry - FirstEntry);
+}
+
+void UNiagaraDataInterfaceLookupTable::UpdateEntries(int32 FirstEntry, TArrayView<const float> InValues)
+{
+	const int32 NumUpdatedEntries = InValues.Num() / NumChannels;
+	if (!ensureMsgf(
+			InValues.Num() % NumChannels == 0 && FirstEntry >= 0 && FirstEntry + NumUpdatedEntries <= GetNumEntries(),
+			TEXT("Lookup table update [%d, %d) out of range"), FirstEntry, FirstEntry + NumUpdatedEntries))
+	{
+		return;
+	}
+
+	FMemory::Memcpy(&Values[FirstEntry * NumChannels], InValues.GetData(), InValues.Num() * sizeof(float));
+	PushToRenderThread(FirstEntry, NumUpdatedEntries);
+}
+
+void UNiagaraDataInterfaceLookupTable::GetDomainTransform(float& OutScale, float& OutOffset) const
+{
+	const int32 NumEntries = GetNumEntries();
+	const float DomainSize = DomainMax - DomainMin;
+	OutScale = NumEntries > 1 && DomainSize > 0.0f ? (NumEntries - 1) / DomainSize : 0.0f;
+	OutOffset = -DomainMin * OutScale;
+}
+
+float FNiagaraLookupTableSnapshot::Sample(float X) const
+{
+	const int32 NumEntries = GetNumEntries();
+	if (NumEntries == 0)
+	{
+		return 0.0f;
+	}
+
+	int32 Index0, Index1;
+	float Alpha;
+	GetLerpEntries(FMath::Clamp(X * DomainScale + DomainOffset, 0.0f, (float)(NumEntries - 1)), NumEntries, Index0, Index1, Alpha);
+	return FMath::Lerp(Values[Index0 * NumChannels], Values[Index1 * NumChannels], Alpha);
+}
+
+FVector4 FNiagaraLookupTableSnapshot::SampleVector(float X) const
+{
+	const int32 NumEntries = GetNumEntries();
+	if (NumEntries == 0)
+	{
+		return FVector4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+
+	int32 Index0, Index1;
+	float Alpha;
+	GetLerpEntries(FMath::Clamp(X * DomainScale + DomainOffset, 0.0f, (float)(NumEntries - 1)), NumEntries, Index0, Index1, Alpha);
+
+	FVector4 Result;
+	for (int32 Channel = 0; Channel < 4; ++Channel)
+	{
+		const int32 TableChannel = FMath::Min(Channel, NumChannels - 1);
+		Result[Channel] = FMath::Lerp(Values[Index0 * NumChannels + TableChannel], Values[Index1 * NumChannels + TableChannel], Alpha);
+	}
+	return Result;
+}
+
+void UNiagaraDataInterfaceLookupTable::PushToRenderThread(int32 FirstEntry, int32 NumUpdatedEntries)
+{
+	float Scale, Offset;
+	GetDomainTransform(Scale, Offset);
+
+	TSharedRef<FNiagaraLookupTableSnapshot, ESPMode::ThreadSafe> NewSnapshot =
+		MakeShared<FNiagaraLookupTableSnapshot, ESPMode::ThreadSafe>();
+	NewSnapshot->Values = Values;
+	NewSnapshot->NumChannels = NumChannels;
+	NewSnapshot->DomainScale = Scale;
+	NewSnapshot->DomainOffset = Offset;
+	Snapshot = NewSnapshot;
+
+	// A reallocated buffer has no previous contents, all entries are uploaded
+	const int32 NumEntries = GetNumEntries();
+	if (NumEntries * NumChannels != PushedNumValues || bHalfPrecision != bPushedHalfPrecision)
+	{
+		FirstEntry = 0;
+		NumUpdatedEntries = NumEntries;
+		PushedNumValues = NumEntries * NumChannels;
+		bPushedHalfPrecision = bHalfPrecision;
+	}
+	const int32 FirstValue = FirstEntry * NumChannels;
+	const int32 NumUpdatedValues = NumUpdatedEntries * NumChannels;
+	const uint32 BytesPerValue = bHalfPrecision ? sizeof(FFloat16) : sizeof(float);
+	TArray<uint8> UpdatedData;
+	UpdatedData.SetNumUninitialized(NumUpdatedValues * BytesPerValue);
+	if (bHalfPrecision)
+	{
+		UTextureBakerFunctionLibrary::ConvertFloatToHalf(
+			Values.GetData() + FirstValue, reinterpret_cast<FFloat16*>(UpdatedData.GetData()), NumUpdatedValues);
+	}
+	else if (NumUpdatedValues > 0)
+	{
+		FMemory::Memcpy(UpdatedData.GetData(), Values.GetData() + FirstValue, UpdatedData.Num());
+	}
+
+	FNiagaraDataInterfaceProxyLookupTable* RT_Proxy = GetProxyAs<FNiagaraDataInterfaceProxyLookupTable>();
+	ENQUEUE_RENDER_COMMAND(FUpdateLookupTable)
+	(
+		[RT_Proxy, RT_UpdatedData = MoveTemp(UpdatedData), FirstValue, NumEntries, RT_NumChannels = NumChannels,
+		 RT_bHalfPrecision = bHalfPrecision, BytesPerValue, Scale, Offset](FRHICommandListImmediate& RHICmdList) {
+			RT_Proxy->NumEntries = NumEntries;
+			RT_Proxy->NumChannels = RT_NumChannels;
+			RT_Proxy->DomainScale = Scale;
+			RT_Proxy->DomainOffset = Offset;
+
+			// Size and precision changes are always pushed with all entries, see PushedNumValues
+			const uint32 NumBytes = NumEntries * RT_NumChannels * BytesPerValue;
+			if (RT_Proxy->TableBuffer.NumBytes != NumBytes || RT_Proxy->bHalfPrecision != RT_bHalfPrecision)
+			{
+				RT_Proxy->TableBuffer.Release();
+				RT_Proxy->bHalfPrecision = RT_bHalfPrecision;
+				if (NumBytes > 0)
+				{
+					RT_Proxy->TableBuffer.Initialize(
+						TEXT("NiagaraLookupTable"), BytesPerValue, NumEntries * RT_NumChannels, RT_bHalfPrecision ? PF_R16F : PF_R32_FLOAT,
+						BUF_Static);
+				}
+			}
+
+			if (RT_UpdatedData.Num() > 0)
+			{
+				void* Data =
+					RHILockVertexBuffer(RT_Proxy->TableBuffer.Buffer, FirstValue * BytesPerValue, RT_UpdatedData.Num(), RLM_WriteOnly);
+				FMemory::Memcpy(Data, RT_UpdatedData.GetData(), RT_UpdatedData.Num());
+				RHIUnlockVertexBuffer(RT_Proxy->TableBuffer.Buffer);
+			}
+		});
+}
+
+void UNiagaraDataInterfaceLookupTable::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		ENiagaraTypeRegistryFlags Flags = ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter;
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), Flags);
+	}
+	else
+	{
+		PushToRenderThread(0, GetNumEntries());
+	}
+}
+
+void UNiagaraDataInterfaceLookupTable::PostLoad()
+{
+	Super::PostLoad();
+
+	PushToRenderThread(0, GetNumEntries());
+}
+
+#if WITH_EDITOR
+void UNiagaraDataInterfaceLookupTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Only 1 and 4 channels are supported, partial entries left by a channel count change are dropped
+	NumChannels = NumChannels >= 4 ? 4 : 1;
+	Values.SetNum(GetNumEntries() * NumChannels);
+
+	// Edits may change any entry, bHalfPrecision edits reallocate the GPU buffer in the push
+	PushToRenderThread(0, GetNumEntries());
+}
+#endif
+
+void UNiagaraDataInterfaceLookupTable::GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions)
+{
+	auto AddSignature = [&](const FName& Name, const FNiagaraTypeDefinition& ValueType) {
+		FNiagaraFunctionSignature& Signature = OutFunctions.AddDefaulted_GetRef();
+		Signature.Name = Name;
+		Signature.bMemberFunction = true;
+		Signature.bRequiresContext = false;
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition(GetClass()), TEXT("LookupTable")));
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("X")));
+		Signature.Outputs.Add(FNiagaraVariable(ValueType, TEXT("Value")));
+	};
+	AddSignature(SampleName, FNiagaraTypeDefinition::GetFloatDef());
+	AddSignature(SampleVectorName, FNiagaraTypeDefinition::GetVec4Def());
+}
+
+void UNiagaraDataInterfaceLookupTable::GetVMExternalFunction(
+	const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+{
+	// The instance data user pointer is the first input
+	if (BindingInfo.Name == SampleName && BindingInfo.GetNumInputs() == 2 && BindingInfo.GetNumOutputs() == 1)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceLookupTable::VMSample);
+	}
+	else if (BindingInfo.Name == SampleVectorName && BindingInfo.GetNumInputs() == 2 && BindingInfo.GetNumOutputs() == 4)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceLookupTable::VMSampleVector);
+	}
+}
+
+bool UNiagaraDataInterfaceLookupTable::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	new (PerInstanceData) FNDILookupTableInstanceData{Snapshot};
+	return true;
+}
+
+void UNiagaraDataInterfaceLookupTable::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	static_cast<FNDILookupTableInstanceData*>(PerInstanceData)->~FNDILookupTableInstanceData();
+}
+
+int32 UNiagaraDataInterfaceLookupTable::PerInstanceDataSize() const
+{
+	return sizeof(FNDILookupTableInstanceData);
+}
+
+bool UNiagaraDataInterfaceLookupTable::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+	// Game thread, the simulation of the instance is not running
+	static_cast<FNDILookupTableInstanceData*>(PerInstanceData)->Snapshot = Snapshot;
+	return false;
+}
+
+void UNiagaraDataInterfaceLookupTable::VMSample(FVectorVMContext& Context)
+{
+	VectorVM::FUserPtrHandler<FNDILookupTableInstanceData> InstanceData(Context);
+	VectorVM::FExternalFuncInputHandler<float> XParam(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutValue(Context);
+
+	const FNiagaraLookupTableSnapshot& TableSnapshot = *InstanceData->Snapshot;
+	const int32 NumEntries = TableSnapshot.GetNumEntries();
+	if (NumEntries == 0)
+	{
+		for (int32 i = 0; i < Context.NumInstances; ++i)
+		{
+			*OutValue.GetDestAndAdvance() = 0.0f;
+		}
+		return;
+	}
+
+	const int32 TableNumChannels = TableSnapshot.NumChannels;
+	const VectorRegister ScaleVector = VectorSetFloat1(TableSnapshot.DomainScale);
+	const VectorRegister OffsetVector = VectorSetFloat1(TableSnapshot.DomainOffset);
+	const VectorRegister MaxIndexVector = VectorSetFloat1((float)(NumEntries - 1));
+	const float* Table = TableSnapshot.Values.GetData();
+
+	// Domain transform and interpolation four instances at a time, the table reads are scalar gathers
+	int32 i = 0;
+	for (; i + 4 <= Context.NumInstances; i += 4)
+	{
+		MS_ALIGN(16) float Indices[4] GCC_ALIGN(16);
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			Indices[Lane] = XParam.GetAndAdvance();
+		}
+		VectorRegister Index = VectorMultiplyAdd(VectorLoadAligned(Indices), ScaleVector, OffsetVector);
+		Index = VectorMin(VectorMax(Index, VectorZero()), MaxIndexVector);
+		VectorStoreAligned(Index, Indices);
+
+		MS_ALIGN(16) float Values0[4] GCC_ALIGN(16);
+		MS_ALIGN(16) float Values1[4] GCC_ALIGN(16);
+		MS_ALIGN(16) float Alphas[4] GCC_ALIGN(16);
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			int32 Index0, Index1;
+			GetLerpEntries(Indices[Lane], NumEntries, Index0, Index1, Alphas[Lane]);
+			Values0[Lane] = Table[Index0 * TableNumChannels];
+			Values1[Lane] = Table[Index1 * TableNumChannels];
+		}
+		const VectorRegister Value0 = VectorLoadAligned(Values0);
+		const VectorRegister Value1 = VectorLoadAligned(Values1);
+		const VectorRegister Result = VectorMultiplyAdd(VectorSubtract(Value1, Value0), VectorLoadAligned(Alphas), Value0);
+		VectorStoreAligned(Result, Values0);
+
+		for (int32 Lane = 0; Lane < 4; ++Lane)
+		{
+			*OutValue.GetDestAndAdvance() = Values0[Lane];
+		}
+	}
+	for (; i < Context.NumInstances; ++i)
+	{
+		*OutValue.GetDestAndAdvance() = TableSnapshot.Sample(XParam.GetAndAdvance());
+	}
+}
+
+void UNiagaraDataInterfaceLookupTable::VMSampleVector(FVectorVMContext& Context)
+{
+	VectorVM::FUserPtrHandler<FNDILookupTableInstanceData> InstanceData(Context);
+	VectorVM::FExternalFuncInputHandler<float> XParam(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutX(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutY(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutZ(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutW(Context);
+
+	const FNiagaraLookupTableSnapshot& TableSnapshot = *InstanceData->Snapshot;
+	const int32 NumEntries = TableSnapshot.GetNumEntries();
+	const int32 TableNumChannels = TableSnapshot.NumChannels;
+	const float Scale = TableSnapshot.DomainScale;
+	const float Offset = TableSnapshot.DomainOffset;
+	const float* Table = TableSnapshot.Values.GetData();
+
+	for (int32 i = 0; i < Context.NumInstances; ++i)
+	{
+		MS_ALIGN(16) float Result[4] GCC_ALIGN(16) = {0.0f, 0.0f, 0.0f, 0.0f};
+		const float X = XParam.GetAndAdvance();
+		if (NumEntries > 0)
+		{
+			int32 Index0, Index1;
+			float Alpha;
+			GetLerpEntries(FMath::Clamp(X * Scale + Offset, 0.0f, (float)(NumEntries - 1)), NumEntries, Index0, Index1, Alpha);
+
+			// All channels of an entry are interpolated in one register, single channel tables are broadcast
+			const VectorRegister Value0 =
+				TableNumChannels == 4 ? VectorLoad(Table + Index0 * 4) : VectorLoadFloat1(Table + Index0);
+			const VectorRegister Value1 =
+				TableNumChannels == 4 ? VectorLoad(Table + Index1 * 4) : VectorLoadFloat1(Table + Index1);
+			VectorStoreAligned(VectorMultiplyAdd(VectorSubtract(Value1, Value0), VectorSetFloat1(Alpha), Value0), Result);
+		}
+		*OutX.GetDestAndAdvance() = Result[0];
+		*OutY.GetDestAndAdvance() = Result[1];
+		*OutZ.GetDestAndAdvance() = Result[2];
+		*OutW.GetDestAndAdvance() = Result[3];
+	}
+}
+
+bool UNiagaraDataInterfaceLookupTable::Equals(const UNiagaraDataInterface* Other) const
+{
+	if (!Super::Equals(Other))
+	{
+		return false;
+	}
+	const UNiagaraDataInterfaceLookupTable* OtherTable = CastChecked<const UNiagaraDataInterfaceLookupTable>(Other);
+	return OtherTable->NumChannels == NumChannels && OtherTable->DomainMin == DomainMin && OtherTable->DomainMax == DomainMax &&
+		   OtherTable->bHalfPrecision == bHalfPrecision && OtherTable->Values == Values;
+}
+
+bool UNiagaraDataInterfaceLookupTable::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+	if (!Super::CopyToInternal(Destination))
+	{
+		return false;
+	}
+	UNiagaraDataInterfaceLookupTable* DestinationTable = CastChecked<UNiagaraDataInterfaceLookupTable>(Destination);
+	DestinationTable->Values = Values;
+	DestinationTable->NumChannels = NumChannels;
+	DestinationTable->DomainMin = DomainMin;
+	DestinationTable->DomainMax = DomainMax;
+	DestinationTable->bHalfPrecision = bHalfPrecision;
+	DestinationTable->PushToRenderThread(0, GetNumEntries());
+	return true;
+}
+
+#if WITH_EDITORONLY_DATA
+void UNiagaraDataInterfaceLookupTable::GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL)
+{
+	const TCHAR* Symbol = *ParamInfo.DataInterfaceHLSLSymbol;
+	OutHLSL += FString::Printf(TEXT("Buffer<float> %s%s;\n"), *TableBufferName, Symbol);
+	OutHLSL += FString::Printf(TEXT("int %s%s;\n"), *NumEntriesName, Symbol);
+	OutHLSL += FString::Printf(TEXT("int %s%s;\n"), *NumChannelsName, Symbol);
+	OutHLSL += FString::Printf(TEXT("float %s%s;\n"), *DomainScaleName, Symbol);
+	OutHLSL += FString::Printf(TEXT("float %s%s;\n"), *DomainOffsetName, Symbol);
+}
+
+bool UNiagaraDataInterfaceLookupTable::GetFunctionHLSL(
+	const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+	int FunctionInstanceIndex, FString& OutHLSL)
+{
+	const FString& Symbol = ParamInfo.DataInterfaceHLSLSymbol;
+	const FString TableBufferParameter = TableBufferName + Symbol;
+	const FString NumEntriesParameter = NumEntriesName + Symbol;
+	const FString NumChannelsParameter = NumChannelsName + Symbol;
+
+	// Matches the CPU lookup: clamp the fractional index, then interpolate the two neighboring entries
+	const FString Lookup = FString::Printf(
+		TEXT("\tif (%s <= 0)\n")
+			TEXT("\t{\n")
+			TEXT("\t\treturn;\n")
+			TEXT("\t}\n")
+			TEXT("\tconst float Index = clamp(In_X * %s + %s, 0.0f, float(%s - 1));\n")
+			TEXT("\tconst int Index0 = int(Index);\n")
+			TEXT("\tconst int Index1 = min(Index0 + 1, %s - 1);\n")
+			TEXT("\tconst float Alpha = Index - Index0;\n"),
+		*NumEntriesParameter, *(DomainScaleName + Symbol), *(DomainOffsetName + Symbol), *NumEntriesParameter, *NumEntriesParameter);
+
+	const TCHAR* Table = *TableBufferParameter;
+	if (FunctionInfo.DefinitionName == SampleName)
+	{
+		OutHLSL += FString::Printf(
+			TEXT("void %s(float In_X, out float Out_Value)\n")
+				TEXT("{\n")
+				TEXT("\tOut_Value = 0.0f;\n")
+				TEXT("%s")
+				TEXT("\tOut_Value = lerp(%s[Index0 * %s], %s[Index1 * %s], Alpha);\n")
+				TEXT("}\n"),
+			*FunctionInfo.InstanceName, *Lookup, Table, *NumChannelsParameter, Table, *NumChannelsParameter);
+		return true;
+	}
+	if (FunctionInfo.DefinitionName == SampleVectorName)
+	{
+		OutHLSL += FString::Printf(
+			TEXT("void %s(float In_X, out float4 Out_Value)\n")
+				TEXT("{\n")
+				TEXT("\tOut_Value = 0.0f;\n")
+				TEXT("%s")
+				TEXT("\tconst int4 Channels = min(int4(0, 1, 2, 3), %s - 1);\n")
+				TEXT("\tconst int4 Offsets0 = Index0 * %s + Channels;\n")
+				TEXT("\tconst int4 Offsets1 = Index1 * %s + Channels;\n")
+				TEXT("\tconst float4 Value0 = float4(%s[Offsets0.x], %s[Offsets0.y], %s[Offsets0.z], %s[Offsets0.w]);\n")
+				TEXT("\tconst float4 Value1 = float4(%s[Offsets1.x], %s[Offsets1.y], %s[Offsets1.z], %s[Offsets1.w]);\n")
+				TEXT("\tOut_Value = lerp(Value0, Value1, Alpha);\n")
+				TEXT("}\n"),
+			*FunctionInfo.InstanceName, *Lookup, *NumChannelsParameter, *NumChannelsParameter, *NumChannelsParameter, Table, Table, Table,
+			Table, Table, Table, Table, Table);
+		return true;
+	}
+	return false;
+}
+#endif
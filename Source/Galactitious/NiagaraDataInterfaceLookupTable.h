@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataInterface.h"
+#include "RHIUtilities.h"
+
+#include "NiagaraDataInterfaceLookupTable.generated.h"
+
+/** Render thread copy of a lookup table. */
+struct FNiagaraDataInterfaceProxyLookupTable : public FNiagaraDataInterfaceProxy
+{
+	FReadBuffer TableBuffer;
+	int32 NumEntries = 0;
+	int32 NumChannels = 1;
+	bool bHalfPrecision = false;
+	float DomainScale = 0.0f;
+	float DomainOffset = 0.0f;
+
+	virtual int32 PerInstanceDataPassedToRenderThreadSize() const override { return 0; }
+};
+
+/** Immutable copy of a lookup table for CPU lookups, shared with the system instances sampling it. */
+struct FNiagaraLookupTableSnapshot
+{
+	TArray<float> Values;
+	int32 NumChannels = 1;
+	float DomainScale = 0.0f;
+	float DomainOffset = 0.0f;
+
+	int32 GetNumEntries() const { return Values.Num() / NumChannels; }
+
+	float Sample(float X) const;
+	FVector4 SampleVector(float X) const;
+};
+
+/**
+ * Uniformly sampled table of 1 or 4 channels over [DomainMin, DomainMax] with linear lookup, for quantile and color tables.
+ * Entry i is located at DomainMin + i / (NumEntries - 1) * (DomainMax - DomainMin), lookups clamp to the domain.
+ * Unlike curve data interfaces the table is used as is, updates only upload the entries that changed.
+ */
+UCLASS(EditInlineNew, Category = "Sampling", meta = (DisplayName = "Lookup Table"))
+class GALACTITIOUS_API UNiagaraDataInterfaceLookupTable : public UNiagaraDataInterface
+{
+	GENERATED_UCLASS_BODY()
+
+	DECLARE_NIAGARA_DI_PARAMETER();
+
+public:
+	using FSnapshotPtr = TSharedPtr<const FNiagaraLookupTableSnapshot, ESPMode::ThreadSafe>;
+
+	/** Entries with NumChannels interleaved channels. */
+	UPROPERTY(EditAnywhere, Category = "Lookup Table")
+	TArray<float> Values;
+
+	UPROPERTY(EditAnywhere, Category = "Lookup Table", meta = (ClampMin = "1", ClampMax = "4"))
+	int32 NumChannels = 1;
+
+	UPROPERTY(EditAnywhere, Category = "Lookup Table")
+	float DomainMin = 0.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Lookup Table")
+	float DomainMax = 1.0f;
+
+	/** Upload the table to the GPU as half floats, halving upload size and memory. CPU lookups keep full precision. */
+	UPROPERTY(EditAnywhere, Category = "Lookup Table")
+	bool bHalfPrecision = false;
+
+	int32 GetNumEntries() const { return NumChannels > 0 ? Values.Num() / NumChannels : 0; }
+
+	/**
+	 * Replace the table. If the number of entries and channels is unchanged only the range of changed entries is uploaded,
+	 * so pushing a mostly unchanged table is cheap. NumChannels has to be 1 or 4.
+	 */
+	void SetTable(TArrayView<const float> InValues, int32 InNumChannels, float InDomainMin, float InDomainMax);
+
+	/** Overwrite entries starting at FirstEntry with NumChannels interleaved channels each, and upload only those. */
+	void UpdateEntries(int32 FirstEntry, TArrayView<const float> InValues);
+
+	/** Linear lookup of the first channel. */
+	float Sample(float X) const { return Snapshot->Sample(X); }
+
+	/** Linear lookup of all channels, single channel tables are broadcast. */
+	FVector4 SampleVector(float X) const { return Snapshot->SampleVector(X); }
+
+	// UObject
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// UNiagaraDataInterface
+	virtual void GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions) override;
+	virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+		override;
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override { return true; }
+	virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+	virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual int32 PerInstanceDataSize() const override;
+	virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+#if WITH_EDITORONLY_DATA
+	virtual void GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL) override;
+	virtual bool GetFunctionHLSL(
+		const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+		int FunctionInstanceIndex, FString& OutHLSL) override;
+#endif
+
+	/** Sample(X) -> float, four instances at a time. Reads the snapshot of the system instance. */
+	void VMSample(FVectorVMContext& Context);
+
+	/** SampleVector(X) -> vector4. Reads the snapshot of the system instance. */
+	void VMSampleVector(FVectorVMContext& Context);
+
+protected:
+	virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+
+private:
+	/** Scale and offset mapping X to the fractional entry index. */
+	void GetDomainTransform(float& OutScale, float& OutOffset) const;
+
+	/**
+	 * Publish a new snapshot and copy NumUpdatedEntries entries from FirstEntry and the domain to the proxy. If the size or
+	 * precision changed the buffer is reallocated and all entries are copied.
+	 */
+	void PushToRenderThread(int32 FirstEntry, int32 NumUpdatedEntries);
+
+	/**
+	 * Current table for CPU lookups. Replaced, never modified, on every change on the game thread. System instances take it
+	 * over in PerInstanceTick, so VM threads never read a table that is being changed.
+	 */
+	FSnapshotPtr Snapshot;
+
+	/** Layout of the last push, a push with a different layout reallocates the GPU buffer and uploads all entries. */
+	int32 PushedNumValues = INDEX_NONE;
+	bool bPushedHalfPrecision = false;
+};
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NiagaraDataInterfaceSampleSequence.h"
+
+#include "NiagaraTypes.h"
+#include "VectorVM.h"
+
+namespace
+{
+	const FName SampleName(TEXT("Sample"));
+	const FName Sample2DName(TEXT("Sample2D"));
+} // namespace
+
+void UNiagaraDataInterfaceSampleSequence::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		ENiagaraTypeRegistryFlags Flags = ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter;
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), Flags);
+	}
+}
+
+void UNiagaraDataInterfaceSampleSequence::GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions)
+{
+	auto AddSignature = [&](const FName& Name, const FNiagaraTypeDefinition& ValueType) {
+		FNiagaraFunctionSignature& Signature = OutFunctions.AddDefaulted_GetRef();
+		Signature.Name = Name;
+		Signature.bMemberFunction = true;
+		Signature.bRequiresContext = false;
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition(GetClass()), TEXT("SampleSequence")));
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Index")));
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Dimension")));
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Seed")));
+		Signature.Outputs.Add(FNiagaraVariable(ValueType, TEXT("Value")));
+	};
+	AddSignature(SampleName, FNiagaraTypeDefinition::GetFloatDef());
+	AddSignature(Sample2DName, FNiagaraTypeDefinition::GetVec2Def());
+}
+
+void UNiagaraDataInterfaceSampleSequence::GetVMExternalFunction(
+	const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+{
+	if (BindingInfo.Name == SampleName && BindingInfo.GetNumInputs() == 3 && BindingInfo.GetNumOutputs() == 1)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceSampleSequence::GetSample);
+	}
+	else if (BindingInfo.Name == Sample2DName && BindingInfo.GetNumInputs() == 3 && BindingInfo.GetNumOutputs() == 2)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceSampleSequence::GetSample2D);
+	}
+}
+
+void UNiagaraDataInterfaceSampleSequence::GetSample(FVectorVMContext& Context)
+{
+	VectorVM::FExternalFuncInputHandler<int32> IndexParam(Context);
+	VectorVM::FExternalFuncInputHandler<int32> DimensionParam(Context);
+	VectorVM::FExternalFuncInputHandler<int32> SeedParam(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutValue(Context);
+
+	for (int32 i = 0; i < Context.NumInstances; ++i)
+	{
+		const uint32 Index = IndexParam.GetAndAdvance();
+		const uint32 Dimension = DimensionParam.GetAndAdvance();
+		const uint32 Seed = SeedParam.GetAndAdvance();
+		*OutValue.GetDestAndAdvance() = FSampleSequence::GetSample(Sequence, Seed, Index, Dimension);
+	}
+}
+
+void UNiagaraDataInterfaceSampleSequence::GetSample2D(FVectorVMContext& Context)
+{
+	VectorVM::FExternalFuncInputHandler<int32> IndexParam(Context);
+	VectorVM::FExternalFuncInputHandler<int32> DimensionParam(Context);
+	VectorVM::FExternalFuncInputHandler<int32> SeedParam(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutX(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutY(Context);
+
+	for (int32 i = 0; i < Context.NumInstances; ++i)
+	{
+		const uint32 Index = IndexParam.GetAndAdvance();
+		const uint32 Dimension = DimensionParam.GetAndAdvance();
+		const uint32 Seed = SeedParam.GetAndAdvance();
+		*OutX.GetDestAndAdvance() = FSampleSequence::GetSample(Sequence, Seed, Index, Dimension);
+		*OutY.GetDestAndAdvance() = FSampleSequence::GetSample(Sequence, Seed, Index, Dimension + 1);
+	}
+}
+
+bool UNiagaraDataInterfaceSampleSequence::Equals(const UNiagaraDataInterface* Other) const
+{
+	if (!Super::Equals(Other))
+	{
+		return false;
+	}
+	return CastChecked<const UNiagaraDataInterfaceSampleSequence>(Other)->Sequence == Sequence;
+}
+
+bool UNiagaraDataInterfaceSampleSequence::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+	if (!Super::CopyToInternal(Destination))
+	{
+		return false;
+	}
+	CastChecked<UNiagaraDataInterfaceSampleSequence>(Destination)->Sequence = Sequence;
+	return true;
+}
+
+#if WITH_EDITORONLY_DATA
+bool UNiagaraDataInterfaceSampleSequence::AppendCompileHash(FNiagaraCompileHashVisitor* InVisitor) const
+{
+	if (!Super::AppendCompileHash(InVisitor))
+	{
+		return false;
+	}
+	// The sequence is compiled into the generated HLSL
+	InVisitor->UpdatePOD(TEXT("NiagaraDataInterfaceSampleSequence_Sequence"), (int32)Sequence);
+	return true;
+}
+
+void UNiagaraDataInterfaceSampleSequence::GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL)
+{
+	OutHLSL += FSampleSequence::GetSampleHLSL(Sequence, TEXT("SampleSequence_") + ParamInfo.DataInterfaceHLSLSymbol);
+}
+
+bool UNiagaraDataInterfaceSampleSequence::GetFunctionHLSL(
+	const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+	int FunctionInstanceIndex, FString& OutHLSL)
+{
+	const FString SampleFunction = TEXT("SampleSequence_") + ParamInfo.DataInterfaceHLSLSymbol;
+	if (FunctionInfo.DefinitionName == SampleName)
+	{
+		OutHLSL += FString::Printf(
+			TEXT("void %s(int In_Index, int In_Dimension, int In_Seed, out float Out_Value)\n")
+				TEXT("{\n")
+				TEXT("\tOut_Value = %s(uint(In_Seed), uint(In_Index), uint(In_Dimension));\n")
+				TEXT("}\n"),
+			*FunctionInfo.InstanceName, *SampleFunction);
+		return true;
+	}
+	if (FunctionInfo.DefinitionName == Sample2DName)
+	{
+		OutHLSL += FString::Printf(
+			TEXT("void %s(int In_Index, int In_Dimension, int In_Seed, out float2 Out_Value)\n")
+				TEXT("{\n")
+				TEXT("\tOut_Value.x = %s(uint(In_Seed), uint(In_Index), uint(In_Dimension));\n")
+				TEXT("\tOut_Value.y = %s(uint(In_Seed), uint(In_Index), uint(In_Dimension) + 1);\n")
+				TEXT("}\n"),
+			*FunctionInfo.InstanceName, *SampleFunction, *SampleFunction);
+		return true;
+	}
+	return false;
+}
+#endif
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataInterface.h"
+#include "SampleSequence.h"
+
+#include "NiagaraDataInterfaceSampleSequence.generated.h"
+
+/**
+ * Stateless index-to-sample functions for particle spawn scripts, matching FSampleSequence on the CPU.
+ * Spawn scripts pass the particle index, so the first 2^m particles of a low-discrepancy sequence are stratified.
+ * The sequence is compiled into the GPU script, seeds are function inputs.
+ */
+UCLASS(EditInlineNew, Category = "Sampling", meta = (DisplayName = "Sample Sequence"))
+class GALACTITIOUS_API UNiagaraDataInterfaceSampleSequence : public UNiagaraDataInterface
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Sampling")
+	ESampleSequence Sequence = ESampleSequence::Sobol;
+
+	// UObject
+	virtual void PostInitProperties() override;
+
+	// UNiagaraDataInterface
+	virtual void GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions) override;
+	virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+		override;
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override { return true; }
+	virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+#if WITH_EDITORONLY_DATA
+	virtual bool AppendCompileHash(FNiagaraCompileHashVisitor* InVisitor) const override;
+	virtual void GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL) override;
+	virtual bool GetFunctionHLSL(
+		const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+		int FunctionInstanceIndex, FString& OutHLSL) override;
+#endif
+
+	/** Sample(Index, Dimension, Seed) -> float in [0, 1). */
+	void GetSample(FVectorVMContext& Context);
+
+	/** Sample2D(Index, Dimension, Seed) -> vector2 of dimensions Dimension and Dimension + 1. */
+	void GetSample2D(FVectorVMContext& Context);
+
+protected:
+	virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+};
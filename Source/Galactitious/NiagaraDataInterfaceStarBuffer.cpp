@@ -0,0 +1,532 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NiagaraDataInterfaceStarBuffer.h"
+
+#include "GalactitiousStats.h"
+#include "NiagaraRenderer.h"
+#include "NiagaraShader.h"
+#include "NiagaraTypes.h"
+#include "ShaderParameterUtils.h"
+#include "StellarSamplingData.h"
+#include "VectorVM.h"
+#include "Async/Async.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	const FName GetNumStarsName(TEXT("GetNumStars"));
+	const FName GetStarName(TEXT("GetStar"));
+
+	const FString StarBufferName(TEXT("StarBuffer_"));
+	const FString NumStarsName(TEXT("NumStars_"));
+	const FString SlotCapacityName(TEXT("SlotCapacity_"));
+
+	/** Attribute arrays of FStarBuffer in upload order. */
+	const int32 NumStarAttributes = 6;
+
+	struct FNDIStarBufferInstanceData
+	{
+		/** Slots read by the VM functions of the instance, only replaced on the game thread in PerInstanceTick. */
+		UNiagaraDataInterfaceStarBuffer::FStarSlotsPtr StarSlots;
+	};
+
+	/** Write the attribute arrays of a slot, zero beyond the stars of the buffer. */
+	void WriteStarSlot(uint8* Data, const FStarBuffer* Stars, int32 SlotCapacity)
+	{
+		const int32 NumStars = Stars != nullptr ? FMath::Min(Stars->Num(), SlotCapacity) : 0;
+		for (int32 Attribute = 0; Attribute < NumStarAttributes; ++Attribute)
+		{
+			float* Dest = (float*)Data + Attribute * SlotCapacity;
+			if (NumStars > 0)
+			{
+				const TArray<float>* Attributes[NumStarAttributes] = {&Stars->PositionX,	 &Stars->PositionY,	  &Stars->PositionZ,
+																	  &Stars->LogLuminosity, &Stars->Temperature, &Stars->StarCount};
+				FMemory::Memcpy(Dest, Attributes[Attribute]->GetData(), NumStars * sizeof(float));
+			}
+			FMemory::Memzero(Dest + NumStars, (SlotCapacity - NumStars) * sizeof(float));
+		}
+	}
+} // namespace
+
+struct FNiagaraDataInterfaceParametersCS_StarBuffer : public FNiagaraDataInterfaceParametersCS
+{
+	DECLARE_TYPE_LAYOUT(FNiagaraDataInterfaceParametersCS_StarBuffer, NonVirtual);
+
+public:
+	void Bind(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FShaderParameterMap& ParameterMap)
+	{
+		StarBuffer.Bind(ParameterMap, *(StarBufferName + ParamInfo.DataInterfaceHLSLSymbol));
+		NumStars.Bind(ParameterMap, *(NumStarsName + ParamInfo.DataInterfaceHLSLSymbol));
+		SlotCapacity.Bind(ParameterMap, *(SlotCapacityName + ParamInfo.DataInterfaceHLSLSymbol));
+	}
+
+	void Set(FRHICommandList& RHICmdList, const FNiagaraDataInterfaceSetArgs& Context) const
+	{
+		check(IsInRenderingThread());
+
+		FRHIComputeShader* ComputeShaderRHI = Context.Shader.GetComputeShader();
+		const FNiagaraDataInterfaceProxyStarBuffer* Proxy = static_cast<const FNiagaraDataInterfaceProxyStarBuffer*>(Context.DataInterface);
+
+		FRHIShaderResourceView* StarSRV =
+			Proxy->NumStars > 0 ? Proxy->StarBuffer.SRV.GetReference() : FNiagaraRenderer::GetDummyFloatBuffer().SRV.GetReference();
+		SetSRVParameter(RHICmdList, ComputeShaderRHI, StarBuffer, StarSRV);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, NumStars, Proxy->NumStars);
+		SetShaderValue(RHICmdList, ComputeShaderRHI, SlotCapacity, Proxy->SlotCapacity);
+	}
+
+private:
+	LAYOUT_FIELD(FShaderResourceParameter, StarBuffer);
+	LAYOUT_FIELD(FShaderParameter, NumStars);
+	LAYOUT_FIELD(FShaderParameter, SlotCapacity);
+};
+
+IMPLEMENT_TYPE_LAYOUT(FNiagaraDataInterfaceParametersCS_StarBuffer);
+
+IMPLEMENT_NIAGARA_DI_PARAMETER(UNiagaraDataInterfaceStarBuffer, FNiagaraDataInterfaceParametersCS_StarBuffer);
+
+UNiagaraDataInterfaceStarBuffer::UNiagaraDataInterfaceStarBuffer(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	Proxy.Reset(new FNiagaraDataInterfaceProxyStarBuffer());
+}
+
+TUniqueFunction<UNiagaraDataInterfaceStarBuffer::FStarBufferPtr()> UNiagaraDataInterfaceStarBuffer::MakeStarBufferBuild(
+	bool bSingleThreaded) const
+{
+	if (Source == EStarBufferSource::Snapshot)
+	{
+		const FString Filename = FPaths::IsRelative(SnapshotFile.FilePath) ? FPaths::ProjectDir() / SnapshotFile.FilePath
+																		   : SnapshotFile.FilePath;
+		return [Filename, bEmpty = SnapshotFile.FilePath.IsEmpty()]() {
+			GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousBuildStarBuffer);
+
+			TSharedRef<FStarBuffer, ESPMode::ThreadSafe> NewStarBuffer = MakeShared<FStarBuffer, ESPMode::ThreadSafe>();
+			return !bEmpty && NewStarBuffer->LoadSnapshot(Filename) ? FStarBufferPtr(NewStarBuffer) : FStarBufferPtr();
+		};
+	}
+
+	TSharedRef<FGalaxyShapeSamplingData, ESPMode::ThreadSafe> ShapeData = MakeShared<FGalaxyShapeSamplingData, ESPMode::ThreadSafe>();
+	TSharedRef<FStarSamplingData, ESPMode::ThreadSafe> StarData = MakeShared<FStarSamplingData, ESPMode::ThreadSafe>();
+	if (!ensureMsgf(ShapeSettings != nullptr && StarSettings != nullptr, TEXT("Star buffer generator settings not set")) ||
+		!ShapeSettings->ComputeSamplingData(*ShapeData) || !StarSettings->ComputeSamplingData(*StarData))
+	{
+		return []() { return FStarBufferPtr(); };
+	}
+
+	FStarGeneratorSettings GeneratorSettings;
+	GeneratorSettings.NumParticles = NumParticles;
+	GeneratorSettings.NumGalaxyStars = NumGalaxyStars;
+	GeneratorSettings.Seed = Seed;
+	GeneratorSettings.Sequence = Sequence;
+	GeneratorSettings.bSingleThreaded = bSingleThreaded;
+	return [Shape = ShapeSettings, ShapeData, StarData, GeneratorSettings]() {
+		GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousBuildStarBuffer);
+
+		TSharedRef<FStarBuffer, ESPMode::ThreadSafe> NewStarBuffer = MakeShared<FStarBuffer, ESPMode::ThreadSafe>();
+		const bool bGenerated = FGalaxyStarGenerator::Generate(*Shape, *ShapeData, *StarData, GeneratorSettings, *NewStarBuffer);
+		return bGenerated ? FStarBufferPtr(NewStarBuffer) : FStarBufferPtr();
+	};
+}
+
+bool UNiagaraDataInterfaceStarBuffer::RebuildStarBuffer()
+{
+	// Systems spawning from a failed rebuild spawn nothing rather than stale stars
+	FStarBufferPtr NewStarBuffer = MakeStarBufferBuild(false)();
+	const bool bSuccess = NewStarBuffer.IsValid();
+	SetStarBuffer(MoveTemp(NewStarBuffer));
+	return bSuccess;
+}
+
+void UNiagaraDataInterfaceStarBuffer::RebuildStarBufferAsync()
+{
+	// The build reads the settings assets, which are only released after it finished
+	if (PendingRebuild.IsValid())
+	{
+		PendingRebuild.Wait();
+	}
+
+	// Background builds do not take task graph workers from the frame
+	TWeakObjectPtr<UNiagaraDataInterfaceStarBuffer> WeakThis(this);
+	const uint32 BufferChange = NumBufferChanges;
+	PendingRebuild = Async(EAsyncExecution::ThreadPool, [Build = MakeStarBufferBuild(true), WeakThis, BufferChange]() {
+		FStarBufferPtr NewStarBuffer = Build();
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, BufferChange, NewStarBuffer]() {
+			UNiagaraDataInterfaceStarBuffer* This = WeakThis.Get();
+			if (This != nullptr && This->NumBufferChanges == BufferChange)
+			{
+				This->SetStarBuffer(NewStarBuffer);
+			}
+		});
+	});
+}
+
+void UNiagaraDataInterfaceStarBuffer::SetStarBuffer(FStarBufferPtr InStarBuffer)
+{
+	++NumBufferChanges;
+	StarBuffer = MoveTemp(InStarBuffer);
+	StarSlots.Reset();
+	if (StarBuffer.IsValid())
+	{
+		TSharedRef<FStarBufferSlots, ESPMode::ThreadSafe> NewSlots = MakeShared<FStarBufferSlots, ESPMode::ThreadSafe>();
+		NewSlots->Slots.Add(StarBuffer);
+		NewSlots->SlotCapacity = StarBuffer->Num();
+		StarSlots = NewSlots;
+	}
+	bDynamicSlots = false;
+	PushToRenderThread();
+}
+
+bool UNiagaraDataInterfaceStarBuffer::SetStarSlots(TArray<FStarBufferPtr> InSlots, int32 SlotCapacity)
+{
+	const int64 NumBytes = (int64)InSlots.Num() * SlotCapacity * NumStarAttributes * sizeof(float);
+	if (!ensureMsgf(SlotCapacity >= 0 && NumBytes <= MAX_uint32, TEXT("Too many stars in %d slots of %d"), InSlots.Num(), SlotCapacity))
+	{
+		return false;
+	}
+
+	// Only the slots which changed are uploaded into a buffer of the same layout
+	TArray<int32> ChangedSlots;
+	const bool bSameLayout =
+		bDynamicSlots && StarSlots.IsValid() && StarSlots->Slots.Num() == InSlots.Num() && StarSlots->SlotCapacity == SlotCapacity;
+	if (bSameLayout)
+	{
+		for (int32 Slot = 0; Slot < InSlots.Num(); ++Slot)
+		{
+			if (InSlots[Slot] != StarSlots->Slots[Slot])
+			{
+				ChangedSlots.Add(Slot);
+			}
+		}
+		if (ChangedSlots.Num() == 0)
+		{
+			return true;
+		}
+	}
+
+	++NumBufferChanges;
+	TSharedRef<FStarBufferSlots, ESPMode::ThreadSafe> NewSlots = MakeShared<FStarBufferSlots, ESPMode::ThreadSafe>();
+	NewSlots->Slots = MoveTemp(InSlots);
+	NewSlots->SlotCapacity = SlotCapacity;
+	StarSlots = NewSlots;
+	StarBuffer.Reset();
+	if (bSameLayout)
+	{
+		PushSlotsToRenderThread(MoveTemp(ChangedSlots));
+	}
+	else
+	{
+		bDynamicSlots = true;
+		PushToRenderThread();
+	}
+	return true;
+}
+
+void UNiagaraDataInterfaceStarBuffer::PushToRenderThread()
+{
+	FNiagaraDataInterfaceProxyStarBuffer* RT_Proxy = GetProxyAs<FNiagaraDataInterfaceProxyStarBuffer>();
+	ENQUEUE_RENDER_COMMAND(FUpdateStarBuffer)
+	([RT_Proxy, RT_StarSlots = StarSlots, bDynamic = bDynamicSlots](FRHICommandListImmediate& RHICmdList) {
+		RT_Proxy->StarBuffer.Release();
+		RT_Proxy->NumStars = RT_StarSlots.IsValid() ? RT_StarSlots->Num() : 0;
+		RT_Proxy->SlotCapacity = RT_StarSlots.IsValid() ? RT_StarSlots->SlotCapacity : 0;
+		if (RT_Proxy->NumStars == 0)
+		{
+			return;
+		}
+
+		// Slot buffers are updated in place while streaming
+		const int32 NumStars = RT_Proxy->NumStars;
+		RT_Proxy->StarBuffer.Initialize(
+			TEXT("NiagaraStarBuffer"), sizeof(float), NumStars * NumStarAttributes, PF_R32_FLOAT, bDynamic ? BUF_Dynamic : BUF_Static);
+
+		const uint32 SlotBytes = RT_Proxy->SlotCapacity * NumStarAttributes * sizeof(float);
+		uint8* Data = (uint8*)RHILockVertexBuffer(RT_Proxy->StarBuffer.Buffer, 0, SlotBytes * RT_StarSlots->Slots.Num(), RLM_WriteOnly);
+		for (int32 Slot = 0; Slot < RT_StarSlots->Slots.Num(); ++Slot)
+		{
+			WriteStarSlot(Data + Slot * SlotBytes, RT_StarSlots->Slots[Slot].Get(), RT_Proxy->SlotCapacity);
+		}
+		RHIUnlockVertexBuffer(RT_Proxy->StarBuffer.Buffer);
+	});
+}
+
+void UNiagaraDataInterfaceStarBuffer::PushSlotsToRenderThread(TArray<int32> ChangedSlots)
+{
+	FNiagaraDataInterfaceProxyStarBuffer* RT_Proxy = GetProxyAs<FNiagaraDataInterfaceProxyStarBuffer>();
+	ENQUEUE_RENDER_COMMAND(FUpdateStarBufferSlots)
+	([RT_Proxy, RT_StarSlots = StarSlots, RT_ChangedSlots = MoveTemp(ChangedSlots)](FRHICommandListImmediate& RHICmdList) {
+		if (RT_Proxy->NumStars == 0)
+		{
+			return;
+		}
+
+		const uint32 SlotBytes = RT_Proxy->SlotCapacity * NumStarAttributes * sizeof(float);
+		for (const int32 Slot : RT_ChangedSlots)
+		{
+			uint8* Data = (uint8*)RHILockVertexBuffer(RT_Proxy->StarBuffer.Buffer, Slot * SlotBytes, SlotBytes, RLM_WriteOnly);
+			WriteStarSlot(Data, RT_StarSlots->Slots[Slot].Get(), RT_Proxy->SlotCapacity);
+			RHIUnlockVertexBuffer(RT_Proxy->StarBuffer.Buffer);
+		}
+	});
+}
+
+void UNiagaraDataInterfaceStarBuffer::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		ENiagaraTypeRegistryFlags Flags = ENiagaraTypeRegistryFlags::AllowAnyVariable | ENiagaraTypeRegistryFlags::AllowParameter;
+		FNiagaraTypeRegistry::Register(FNiagaraTypeDefinition(GetClass()), Flags);
+	}
+}
+
+void UNiagaraDataInterfaceStarBuffer::PostLoad()
+{
+	Super::PostLoad();
+
+	if (ShapeSettings != nullptr)
+	{
+		ShapeSettings->ConditionalPostLoad();
+	}
+	if (StarSettings != nullptr)
+	{
+		StarSettings->ConditionalPostLoad();
+	}
+	if (Source == EStarBufferSource::Snapshot || (ShapeSettings != nullptr && StarSettings != nullptr))
+	{
+		RebuildStarBufferAsync();
+	}
+}
+
+void UNiagaraDataInterfaceStarBuffer::BeginDestroy()
+{
+	// The rebuild result is dropped, its game thread task finds the data interface gone
+	if (PendingRebuild.IsValid())
+	{
+		PendingRebuild.Wait();
+	}
+
+	Super::BeginDestroy();
+}
+
+#if WITH_EDITOR
+void UNiagaraDataInterfaceStarBuffer::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (Source == EStarBufferSource::Snapshot || (ShapeSettings != nullptr && StarSettings != nullptr))
+	{
+		RebuildStarBufferAsync();
+	}
+}
+#endif
+
+void UNiagaraDataInterfaceStarBuffer::GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions)
+{
+	const FNiagaraVariable StarBufferVariable(FNiagaraTypeDefinition(GetClass()), TEXT("StarBuffer"));
+	{
+		FNiagaraFunctionSignature& Signature = OutFunctions.AddDefaulted_GetRef();
+		Signature.Name = GetNumStarsName;
+		Signature.bMemberFunction = true;
+		Signature.bRequiresContext = false;
+		Signature.Inputs.Add(StarBufferVariable);
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("NumStars")));
+	}
+	{
+		FNiagaraFunctionSignature& Signature = OutFunctions.AddDefaulted_GetRef();
+		Signature.Name = GetStarName;
+		Signature.bMemberFunction = true;
+		Signature.bRequiresContext = false;
+		Signature.Inputs.Add(StarBufferVariable);
+		Signature.Inputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetIntDef(), TEXT("Index")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetVec3Def(), TEXT("Position")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("LogLuminosity")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("Temperature")));
+		Signature.Outputs.Add(FNiagaraVariable(FNiagaraTypeDefinition::GetFloatDef(), TEXT("StarCount")));
+	}
+}
+
+void UNiagaraDataInterfaceStarBuffer::GetVMExternalFunction(
+	const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+{
+	// The instance data user pointer is the first input
+	if (BindingInfo.Name == GetNumStarsName && BindingInfo.GetNumInputs() == 1 && BindingInfo.GetNumOutputs() == 1)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceStarBuffer::VMGetNumStars);
+	}
+	else if (BindingInfo.Name == GetStarName && BindingInfo.GetNumInputs() == 2 && BindingInfo.GetNumOutputs() == 6)
+	{
+		OutFunc = FVMExternalFunction::CreateUObject(this, &UNiagaraDataInterfaceStarBuffer::VMGetStar);
+	}
+}
+
+bool UNiagaraDataInterfaceStarBuffer::InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	new (PerInstanceData) FNDIStarBufferInstanceData{StarSlots};
+	return true;
+}
+
+void UNiagaraDataInterfaceStarBuffer::DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance)
+{
+	static_cast<FNDIStarBufferInstanceData*>(PerInstanceData)->~FNDIStarBufferInstanceData();
+}
+
+int32 UNiagaraDataInterfaceStarBuffer::PerInstanceDataSize() const
+{
+	return sizeof(FNDIStarBufferInstanceData);
+}
+
+bool UNiagaraDataInterfaceStarBuffer::PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds)
+{
+	// Game thread, the simulation of the instance is not running
+	static_cast<FNDIStarBufferInstanceData*>(PerInstanceData)->StarSlots = StarSlots;
+	return false;
+}
+
+void UNiagaraDataInterfaceStarBuffer::VMGetNumStars(FVectorVMContext& Context)
+{
+	VectorVM::FUserPtrHandler<FNDIStarBufferInstanceData> InstanceData(Context);
+	VectorVM::FExternalFuncRegisterHandler<int32> OutNumStars(Context);
+
+	const FStarBufferSlots* Slots = InstanceData->StarSlots.Get();
+	const int32 NumStars = Slots != nullptr ? Slots->Num() : 0;
+	for (int32 i = 0; i < Context.NumInstances; ++i)
+	{
+		*OutNumStars.GetDestAndAdvance() = NumStars;
+	}
+}
+
+void UNiagaraDataInterfaceStarBuffer::VMGetStar(FVectorVMContext& Context)
+{
+	VectorVM::FUserPtrHandler<FNDIStarBufferInstanceData> InstanceData(Context);
+	VectorVM::FExternalFuncInputHandler<int32> IndexParam(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutPositionX(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutPositionY(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutPositionZ(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutLogLuminosity(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutTemperature(Context);
+	VectorVM::FExternalFuncRegisterHandler<float> OutStarCount(Context);
+
+	// Count and attributes from the same slots
+	const FStarBufferSlots* Slots = InstanceData->StarSlots.Get();
+	const int32 NumStars = Slots != nullptr ? Slots->Num() : 0;
+	for (int32 i = 0; i < Context.NumInstances; ++i)
+	{
+		const int32 Index = FMath::Clamp(IndexParam.GetAndAdvance(), 0, NumStars - 1);
+		const FStarBuffer* Stars = nullptr;
+		int32 StarIndex = 0;
+		if (NumStars > 0)
+		{
+			const int32 Slot = Index / Slots->SlotCapacity;
+			Stars = Slots->Slots[Slot].Get();
+			StarIndex = Index - Slot * Slots->SlotCapacity;
+		}
+		if (Stars == nullptr || StarIndex >= Stars->Num())
+		{
+			*OutPositionX.GetDestAndAdvance() = 0.0f;
+			*OutPositionY.GetDestAndAdvance() = 0.0f;
+			*OutPositionZ.GetDestAndAdvance() = 0.0f;
+			*OutLogLuminosity.GetDestAndAdvance() = 0.0f;
+			*OutTemperature.GetDestAndAdvance() = 0.0f;
+			*OutStarCount.GetDestAndAdvance() = 0.0f;
+			continue;
+		}
+
+		*OutPositionX.GetDestAndAdvance() = Stars->PositionX[StarIndex];
+		*OutPositionY.GetDestAndAdvance() = Stars->PositionY[StarIndex];
+		*OutPositionZ.GetDestAndAdvance() = Stars->PositionZ[StarIndex];
+		*OutLogLuminosity.GetDestAndAdvance() = Stars->LogLuminosity[StarIndex];
+		*OutTemperature.GetDestAndAdvance() = Stars->Temperature[StarIndex];
+		*OutStarCount.GetDestAndAdvance() = Stars->StarCount[StarIndex];
+	}
+}
+
+bool UNiagaraDataInterfaceStarBuffer::Equals(const UNiagaraDataInterface* Other) const
+{
+	if (!Super::Equals(Other))
+	{
+		return false;
+	}
+	const UNiagaraDataInterfaceStarBuffer* OtherStarBuffer = CastChecked<const UNiagaraDataInterfaceStarBuffer>(Other);
+	return OtherStarBuffer->Source == Source && OtherStarBuffer->ShapeSettings == ShapeSettings &&
+		   OtherStarBuffer->StarSettings == StarSettings && OtherStarBuffer->NumParticles == NumParticles &&
+		   OtherStarBuffer->NumGalaxyStars == NumGalaxyStars && OtherStarBuffer->Seed == Seed && OtherStarBuffer->Sequence == Sequence &&
+		   OtherStarBuffer->SnapshotFile.FilePath == SnapshotFile.FilePath && OtherStarBuffer->StarSlots == StarSlots;
+}
+
+bool UNiagaraDataInterfaceStarBuffer::CopyToInternal(UNiagaraDataInterface* Destination) const
+{
+	if (!Super::CopyToInternal(Destination))
+	{
+		return false;
+	}
+	UNiagaraDataInterfaceStarBuffer* DestinationStarBuffer = CastChecked<UNiagaraDataInterfaceStarBuffer>(Destination);
+	DestinationStarBuffer->Source = Source;
+	DestinationStarBuffer->ShapeSettings = ShapeSettings;
+	DestinationStarBuffer->StarSettings = StarSettings;
+	DestinationStarBuffer->NumParticles = NumParticles;
+	DestinationStarBuffer->NumGalaxyStars = NumGalaxyStars;
+	DestinationStarBuffer->Seed = Seed;
+	DestinationStarBuffer->Sequence = Sequence;
+	DestinationStarBuffer->SnapshotFile = SnapshotFile;
+	// Copies share the immutable buffers instead of regenerating them, their first slot update reallocates
+	DestinationStarBuffer->StarBuffer = StarBuffer;
+	DestinationStarBuffer->StarSlots = StarSlots;
+	DestinationStarBuffer->bDynamicSlots = false;
+	DestinationStarBuffer->PushToRenderThread();
+	return true;
+}
+
+#if WITH_EDITORONLY_DATA
+void UNiagaraDataInterfaceStarBuffer::GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL)
+{
+	OutHLSL += FString::Printf(TEXT("Buffer<float> %s%s;\n"), *StarBufferName, *ParamInfo.DataInterfaceHLSLSymbol);
+	OutHLSL += FString::Printf(TEXT("int %s%s;\n"), *NumStarsName, *ParamInfo.DataInterfaceHLSLSymbol);
+	OutHLSL += FString::Printf(TEXT("int %s%s;\n"), *SlotCapacityName, *ParamInfo.DataInterfaceHLSLSymbol);
+}
+
+bool UNiagaraDataInterfaceStarBuffer::GetFunctionHLSL(
+	const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+	int FunctionInstanceIndex, FString& OutHLSL)
+{
+	const FString StarBufferParameter = StarBufferName + ParamInfo.DataInterfaceHLSLSymbol;
+	const FString NumStarsParameter = NumStarsName + ParamInfo.DataInterfaceHLSLSymbol;
+	const FString SlotCapacityParameter = SlotCapacityName + ParamInfo.DataInterfaceHLSLSymbol;
+
+	if (FunctionInfo.DefinitionName == GetNumStarsName)
+	{
+		OutHLSL += FString::Printf(
+			TEXT("void %s(out int Out_NumStars)\n")
+				TEXT("{\n")
+				TEXT("\tOut_NumStars = %s;\n")
+				TEXT("}\n"),
+			*FunctionInfo.InstanceName, *NumStarsParameter);
+		return true;
+	}
+	if (FunctionInfo.DefinitionName == GetStarName)
+	{
+		// Slots are concatenated, attribute k of star i of a slot is at k * SlotCapacity + i within the slot
+		OutHLSL += FString::Printf(
+			TEXT("void %s(int In_Index, out float3 Out_Position, out float Out_LogLuminosity, out float Out_Temperature, ")
+				TEXT("out float Out_StarCount)\n")
+				TEXT("{\n")
+				TEXT("\tconst int NumStars = %s;\n")
+				TEXT("\tconst int SlotCapacity = max(%s, 1);\n")
+				TEXT("\tconst int Index = clamp(In_Index, 0, max(NumStars - 1, 0));\n")
+				TEXT("\tconst int Slot = Index / SlotCapacity;\n")
+				TEXT("\tconst int Offset = Slot * %d * SlotCapacity + Index - Slot * SlotCapacity;\n")
+				TEXT("\tconst bool bValid = NumStars > 0;\n")
+				TEXT("\tOut_Position.x = bValid ? %s[Offset] : 0.0f;\n")
+				TEXT("\tOut_Position.y = bValid ? %s[SlotCapacity + Offset] : 0.0f;\n")
+				TEXT("\tOut_Position.z = bValid ? %s[2 * SlotCapacity + Offset] : 0.0f;\n")
+				TEXT("\tOut_LogLuminosity = bValid ? %s[3 * SlotCapacity + Offset] : 0.0f;\n")
+				TEXT("\tOut_Temperature = bValid ? %s[4 * SlotCapacity + Offset] : 0.0f;\n")
+				TEXT("\tOut_StarCount = bValid ? %s[5 * SlotCapacity + Offset] : 0.0f;\n")
+				TEXT("}\n"),
+			*FunctionInfo.InstanceName, *NumStarsParameter, *SlotCapacityParameter, NumStarAttributes, *StarBufferParameter,
+			*StarBufferParameter, *StarBufferParameter, *StarBufferParameter, *StarBufferParameter, *StarBufferParameter);
+		return true;
+	}
+	return false;
+}
+#endif
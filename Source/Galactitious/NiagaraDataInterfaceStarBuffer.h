@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDataInterface.h"
+#include "Async/Future.h"
+#include "RHIUtilities.h"
+#include "SampleSequence.h"
+#include "StarGenerator.h"
+
+#include "NiagaraDataInterfaceStarBuffer.generated.h"
+
+class UGalaxyShapeSettings;
+class UStarSettings;
+
+UENUM()
+enum class EStarBufferSource : uint8
+{
+	/** Generate stars from galaxy shape and star settings with FGalaxyStarGenerator. */
+	Generator,
+	/** Load stars from a snapshot file written by FStarBuffer::SaveSnapshot. */
+	Snapshot,
+};
+
+/**
+ * Star buffers in slots of equal capacity, star i of the data interface is star i % SlotCapacity of slot i / SlotCapacity.
+ * Stars of empty slots and beyond the buffer of a slot read as zero. A single buffer is one slot of its size.
+ */
+struct FStarBufferSlots
+{
+	TArray<TSharedPtr<const FStarBuffer, ESPMode::ThreadSafe>> Slots;
+	int32 SlotCapacity = 0;
+
+	int32 Num() const { return Slots.Num() * SlotCapacity; }
+};
+
+/** Render thread copy of the star buffer slots, the attribute arrays of each slot are concatenated in FStarBuffer order. */
+struct FNiagaraDataInterfaceProxyStarBuffer : public FNiagaraDataInterfaceProxy
+{
+	FReadBuffer StarBuffer;
+	int32 NumStars = 0;
+	int32 SlotCapacity = 0;
+
+	virtual int32 PerInstanceDataPassedToRenderThreadSize() const override { return 0; }
+};
+
+/**
+ * Exposes a precomputed star buffer to particle scripts. Spawn scripts read the attributes of particle i by index instead of
+ * sampling them, so spawning is deterministic and restarting systems after a parameter update only rebinds the buffer.
+ * Positions are relative to the galaxy radius, as generated.
+ */
+UCLASS(EditInlineNew, Category = "Galaxy", meta = (DisplayName = "Star Buffer"))
+class GALACTITIOUS_API UNiagaraDataInterfaceStarBuffer : public UNiagaraDataInterface
+{
+	GENERATED_UCLASS_BODY()
+
+	DECLARE_NIAGARA_DI_PARAMETER();
+
+public:
+	using FStarBufferPtr = TSharedPtr<const FStarBuffer, ESPMode::ThreadSafe>;
+	using FStarSlotsPtr = TSharedPtr<const FStarBufferSlots, ESPMode::ThreadSafe>;
+
+	UPROPERTY(EditAnywhere, Category = "Star Buffer")
+	EStarBufferSource Source = EStarBufferSource::Generator;
+
+	UPROPERTY(EditAnywhere, Category = "Generator", meta = (EditCondition = "Source == EStarBufferSource::Generator"))
+	UGalaxyShapeSettings* ShapeSettings = nullptr;
+
+	UPROPERTY(EditAnywhere, Category = "Generator", meta = (EditCondition = "Source == EStarBufferSource::Generator"))
+	UStarSettings* StarSettings = nullptr;
+
+	UPROPERTY(EditAnywhere, Category = "Generator", meta = (EditCondition = "Source == EStarBufferSource::Generator", ClampMin = "0"))
+	int32 NumParticles = 100000;
+
+	/** Number of stars in the galaxy, sets the number of stars each particle represents. */
+	UPROPERTY(EditAnywhere, Category = "Generator", meta = (EditCondition = "Source == EStarBufferSource::Generator"))
+	float NumGalaxyStars = 1.0e10f;
+
+	UPROPERTY(EditAnywhere, Category = "Generator", meta = (EditCondition = "Source == EStarBufferSource::Generator"))
+	int32 Seed = 0;
+
+	UPROPERTY(EditAnywhere, Category = "Generator", meta = (EditCondition = "Source == EStarBufferSource::Generator"))
+	ESampleSequence Sequence = ESampleSequence::Sobol;
+
+	/** Snapshot file, relative paths are relative to the project directory. */
+	UPROPERTY(EditAnywhere, Category = "Snapshot", meta = (EditCondition = "Source == EStarBufferSource::Snapshot"))
+	FFilePath SnapshotFile;
+
+	/** Generate or load the star buffer from Source. Game thread only. */
+	bool RebuildStarBuffer();
+
+	/**
+	 * Generate or load the star buffer from Source on the thread pool, systems keep the previous buffer until it is set on the
+	 * game thread. Used on load and edits. A rebuild in flight is waited for before the next one starts and on destroy.
+	 */
+	void RebuildStarBufferAsync();
+
+	/** Use an existing buffer, e.g. generated asynchronously. The buffer must not be modified afterwards. Discards rebuilds in flight. */
+	void SetStarBuffer(FStarBufferPtr InStarBuffer);
+
+	/**
+	 * Use buffers in fixed-capacity slots, e.g. streamed chunks. The buffers are shared, not copied. While the number of slots
+	 * and the capacity stay the same, only changed slots are uploaded and running systems read them without a restart.
+	 */
+	bool SetStarSlots(TArray<FStarBufferPtr> InSlots, int32 SlotCapacity);
+
+	/** Buffer of SetStarBuffer or RebuildStarBuffer, null while slots are used. */
+	const FStarBufferPtr& GetStarBuffer() const { return StarBuffer; }
+
+	int32 GetNumStars() const { return StarSlots.IsValid() ? StarSlots->Num() : 0; }
+
+	// UObject
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+	virtual void BeginDestroy() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// UNiagaraDataInterface
+	virtual void GetFunctions(TArray<FNiagaraFunctionSignature>& OutFunctions) override;
+	virtual void GetVMExternalFunction(const FVMExternalFunctionBindingInfo& BindingInfo, void* InstanceData, FVMExternalFunction& OutFunc)
+		override;
+	virtual bool CanExecuteOnTarget(ENiagaraSimTarget Target) const override { return true; }
+	virtual bool Equals(const UNiagaraDataInterface* Other) const override;
+	virtual bool InitPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual void DestroyPerInstanceData(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance) override;
+	virtual int32 PerInstanceDataSize() const override;
+	virtual bool PerInstanceTick(void* PerInstanceData, FNiagaraSystemInstance* SystemInstance, float DeltaSeconds) override;
+#if WITH_EDITORONLY_DATA
+	virtual void GetParameterDefinitionHLSL(const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, FString& OutHLSL) override;
+	virtual bool GetFunctionHLSL(
+		const FNiagaraDataInterfaceGPUParamInfo& ParamInfo, const FNiagaraDataInterfaceGeneratedFunction& FunctionInfo,
+		int FunctionInstanceIndex, FString& OutHLSL) override;
+#endif
+
+	/** GetNumStars() -> int. Reads the buffer of the system instance. */
+	void VMGetNumStars(FVectorVMContext& Context);
+
+	/** GetStar(Index) -> position, ln(L), temperature, star count. Indices are clamped to the buffer of the system instance. */
+	void VMGetStar(FVectorVMContext& Context);
+
+protected:
+	virtual bool CopyToInternal(UNiagaraDataInterface* Destination) const override;
+
+private:
+	/** Build of the star buffer from the current properties, the sampling data is derived on the calling thread. */
+	TUniqueFunction<FStarBufferPtr()> MakeStarBufferBuild(bool bSingleThreaded) const;
+
+	/** Reallocate the render thread buffer and upload all slots. */
+	void PushToRenderThread();
+
+	/** Upload slots into the render thread buffer in place, the layout has to be unchanged. */
+	void PushSlotsToRenderThread(TArray<int32> ChangedSlots);
+
+	FStarBufferPtr StarBuffer;
+
+	/**
+	 * Shared with copies of the data interface and the render thread upload. Replaced on the game thread, system instances
+	 * take it over in PerInstanceTick, so VM threads never read slots while they are replaced.
+	 */
+	FStarSlotsPtr StarSlots;
+
+	/** Whether the render thread buffer was allocated by SetStarSlots for updates in place. */
+	bool bDynamicSlots = false;
+
+	/** Asynchronous rebuild in flight, its buffer is only set if no other buffer was set since it started. */
+	TFuture<void> PendingRebuild;
+	uint32 NumBufferChanges = 0;
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ParticleBudget.h"
+
+bool FParticleBudgetController::Update(float DeltaTime, float FrameTimeMs)
+{
+	// Start from the first frame instead of ramping up from zero
+	const float Alpha =
+		SmoothedFrameTimeMs > 0.0f ? 1.0f - FMath::Exp(-DeltaTime / FMath::Max(Settings.SmoothingTime, SMALL_NUMBER)) : 1.0f;
+	SmoothedFrameTimeMs = FMath::Lerp(SmoothedFrameTimeMs, FrameTimeMs, Alpha);
+
+	CooldownRemaining -= DeltaTime;
+	if (CooldownRemaining > 0.0f)
+	{
+		return false;
+	}
+
+	float NewFraction = BudgetFraction;
+	if (SmoothedFrameTimeMs > Settings.TargetFrameTimeMs * (1.0f + Settings.Hysteresis))
+	{
+		NewFraction = BudgetFraction * (1.0f - Settings.Step);
+	}
+	else if (SmoothedFrameTimeMs < Settings.TargetFrameTimeMs * (1.0f - Settings.Hysteresis))
+	{
+		NewFraction = BudgetFraction * (1.0f + Settings.Step);
+	}
+	NewFraction = FMath::Clamp(NewFraction, Settings.MinFraction, 1.0f);
+
+	if (NewFraction == BudgetFraction)
+	{
+		return false;
+	}
+	BudgetFraction = NewFraction;
+	CooldownRemaining = Settings.Cooldown;
+	return true;
+}
+
+void FParticleBudgetController::Reset()
+{
+	BudgetFraction = 1.0f;
+	SmoothedFrameTimeMs = 0.0f;
+	CooldownRemaining = 0.0f;
+}
+
+FParticleBudgetRescaling FParticleBudgetRescaling::Compute(
+	int32 NumParticles, int32 NumActiveParticles, double NumGalaxyStars, float AverageLuminosity)
+{
+	FParticleBudgetRescaling Rescaling;
+	Rescaling.NumActiveParticles = FMath::Clamp(NumActiveParticles, 1, FMath::Max(NumParticles, 1));
+	Rescaling.FractionalLuminosity = (float)(AverageLuminosity * NumGalaxyStars / Rescaling.NumActiveParticles);
+	Rescaling.MinStarCount = (float)FMath::Max(NumParticles, 1) / Rescaling.NumActiveParticles;
+	return Rescaling;
+}
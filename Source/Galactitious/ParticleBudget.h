@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FParticleBudgetSettings
+{
+	/** Frame time the budget converges to, 16.7 ms for the 60 Hz of Hololens. */
+	float TargetFrameTimeMs = 16.7f;
+
+	/** Relative band around the target frame time without adjustments. */
+	float Hysteresis = 0.1f;
+
+	/** Time constant in seconds of the exponential moving average of the frame time. */
+	float SmoothingTime = 0.5f;
+
+	/** Relative change of the budget per adjustment. */
+	float Step = 0.1f;
+
+	/** Seconds after an adjustment before the next one, lets the frame time settle. */
+	float Cooldown = 1.0f;
+
+	float MinFraction = 0.05f;
+};
+
+/**
+ * Fraction of the generated particles to draw, driven by the frame time. Shrinks while the smoothed frame time is above the
+ * hysteresis band around the target and grows while it is below, so frame times inside the band never change the budget.
+ */
+class GALACTITIOUS_API FParticleBudgetController
+{
+public:
+	FParticleBudgetSettings Settings;
+
+	/** Feed the time of the last frame. Returns true when the budget fraction changed. */
+	bool Update(float DeltaTime, float FrameTimeMs);
+
+	void Reset();
+
+	/** Fraction of particles to draw in [MinFraction, 1]. */
+	float GetBudgetFraction() const { return BudgetFraction; }
+
+	float GetSmoothedFrameTimeMs() const { return SmoothedFrameTimeMs; }
+
+private:
+	float BudgetFraction = 1.0f;
+	float SmoothedFrameTimeMs = 0.0f;
+	float CooldownRemaining = 0.0f;
+};
+
+/**
+ * Luminosity preserving rescaling when only the first NumActiveParticles of NumParticles generated particles are drawn.
+ * Particles were generated with Np = max(Lf / Ls, 1) and Lf = E(L) * N / M. Dividing by the kept fraction M' / M gives
+ *   Np' = max(Lf' / Ls, M / M'), Lf' = E(L) * N / M'
+ * so the expected total luminosity sum(Np' * Ls) stays E(L) * N. Prefixes of low-discrepancy sequences stay stratified,
+ * which keeps the appearance close to a system generated with M' particles.
+ */
+struct GALACTITIOUS_API FParticleBudgetRescaling
+{
+	int32 NumActiveParticles = 0;
+
+	/** Fractional luminosity Lf' of the active particles. */
+	float FractionalLuminosity = 0.0f;
+
+	/** Lower bound M / M' of the star count of active particles. */
+	float MinStarCount = 1.0f;
+
+	static FParticleBudgetRescaling Compute(int32 NumParticles, int32 NumActiveParticles, double NumGalaxyStars, float AverageLuminosity);
+
+	/** Star count Np' of an active particle with star luminosity Ls. */
+	float GetStarCount(float Luminosity) const { return FMath::Max(FractionalLuminosity / Luminosity, MinStarCount); }
+};
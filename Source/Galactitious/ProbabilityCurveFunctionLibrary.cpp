@@ -3,6 +3,7 @@
 #include "ProbabilityCurveFunctionLibrary.h"
 
 #include "DrawDebugHelpers.h"
+#include "GalactitiousStats.h"
 
 #include "Curves/CurveFloat.h"
 #include "Curves/CurveLinearColor.h"
@@ -46,24 +47,31 @@ namespace
 		case CIM_Unknown:
 			OutInterpMode = RCIM_None;
 			OutTangentMode = RCTM_None;
+			break;
 		case CIM_Constant:
 			OutInterpMode = RCIM_Constant;
 			OutTangentMode = RCTM_None;
+			break;
 		case CIM_Linear:
 			OutInterpMode = RCIM_Linear;
 			OutTangentMode = RCTM_None;
+			break;
 		case CIM_CurveAuto:
 			OutInterpMode = RCIM_Cubic;
 			OutTangentMode = RCTM_Auto;
+			break;
 		case CIM_CurveAutoClamped:
 			OutInterpMode = RCIM_Cubic;
 			OutTangentMode = RCTM_Auto;
+			break;
 		case CIM_CurveBreak:
 			OutInterpMode = RCIM_Cubic;
 			OutTangentMode = RCTM_Break;
+			break;
 		case CIM_CurveUser:
 			OutInterpMode = RCIM_Cubic;
 			OutTangentMode = RCTM_User;
+			break;
 		}
 	}
 } // namespace
@@ -105,6 +113,8 @@ namespace
 
 void UProbabilityCurveFunctionLibrary::ConvertColorCurveAsset(UCurveLinearColor* CurveAsset, FInterpCurveLinearColor& Curve)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousConvertCurve);
+
 	Curve.bIsLooped = false;
 	Curve.LoopKeyOffset = 0.0f;
 
@@ -246,6 +256,8 @@ namespace
 
 void UProbabilityCurveFunctionLibrary::IntegrateCurve(const FInterpCurveFloat& Curve, float Offset, FInterpCurveFloat& IntegratedCurve)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousIntegrateCurve);
+
 	IntegratedCurve.bIsLooped = false;
 	IntegratedCurve.LoopKeyOffset = 0.0f;
 	IntegratedCurve.Points.Empty();
@@ -367,6 +379,8 @@ void UProbabilityCurveFunctionLibrary::IntegrateCurve(const FInterpCurveFloat& C
 
 void UProbabilityCurveFunctionLibrary::NormalizeCurve(const FInterpCurveFloat& Curve, FInterpCurveFloat& NormalizedCurve)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousNormalizeCurve);
+
 	NormalizedCurve.bIsLooped = Curve.bIsLooped;
 	NormalizedCurve.LoopKeyOffset = Curve.LoopKeyOffset;
 
@@ -424,6 +438,8 @@ namespace
 
 void UProbabilityCurveFunctionLibrary::InvertCurve(const FInterpCurveFloat& Curve, int32 Resolution, FInterpCurveFloat& InvertedCurve)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousInvertCurve);
+
 #if 1
 	if (!ensure(Resolution > 0))
 	{
@@ -676,6 +692,8 @@ void UProbabilityCurveFunctionLibrary::DrawDebugCurve(
 
 void UProbabilityCurveFunctionLibrary::ConvertFromRichCurve(const FRichCurve& RichCurve, FInterpCurveFloat& Curve)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousConvertCurve);
+
 	Curve.bIsLooped = false;
 	Curve.LoopKeyOffset = 0.0f;
 
@@ -702,6 +720,8 @@ void UProbabilityCurveFunctionLibrary::ConvertFromRichCurve(const FRichCurve& Ri
 
 void UProbabilityCurveFunctionLibrary::ConvertToRichCurve(const FInterpCurveFloat& Curve, FRichCurve& RichCurve)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousConvertCurve);
+
 	if (Curve.bIsLooped)
 	{
 		RichCurve.PreInfinityExtrap = ERichCurveExtrapolation::RCCE_Cycle;
@@ -739,29 +759,55 @@ namespace
 {
 	using RichCurveIterator = TIndexedContainerIterator<const TArray<FRichCurveKey>, FRichCurveKey, int32>;
 
+	/**
+	 * Remove all keys of a curve but keep the key array allocation.
+	 * FRichCurve::Reset frees the keys, so the emptied array is moved out and back around it.
+	 * Key handles are reset with the keys and created on demand when accessed by handle again.
+	 */
+	void ResetRichCurveKeys(FRichCurve& Curve)
+	{
+		TArray<FRichCurveKey> Keys = MoveTemp(Curve.Keys);
+		Keys.Reset();
+		Curve.Reset();
+		Curve.Keys = MoveTemp(Keys);
+	}
+
+	/**
+	 * Append a key to a curve that is built in increasing time order, after ResetRichCurveKeys.
+	 * Writes the key array directly, avoiding the sorted insert and key handle allocation of FRichCurve::AddKey.
+	 */
 	void AddRichCurveKey(
 		FRichCurve& Curve, float Time, float Value, float ArriveTangent, float LeaveTangent, ERichCurveInterpMode InterpMode = RCIM_None,
 		ERichCurveTangentMode TangentMode = RCTM_Auto)
 	{
-		FKeyHandle Handle = Curve.AddKey(Time, Value);
-		FRichCurveKey& Key = Curve.GetKey(Handle);
-		Key.InterpMode = InterpMode;
+		checkSlow(Curve.Keys.Num() == 0 || Curve.Keys.Last().Time <= Time);
+		FRichCurveKey& Key = Curve.Keys.Emplace_GetRef(Time, Value, ArriveTangent, LeaveTangent, InterpMode);
 		Key.TangentMode = TangentMode;
-		Key.ArriveTangent = ArriveTangent;
-		Key.LeaveTangent = LeaveTangent;
 	}
 } // namespace
 
 void UProbabilityCurveFunctionLibrary::IntegrateRichCurve(
 	const FRichCurve& Curve, float Offset, FRichCurve& IntegratedCurve, float& TotalArea)
 {
+	IntegratedCurve.Reset();
+	IntegrateRichCurveNoAlloc(Curve, Offset, IntegratedCurve, TotalArea);
+}
+
+void UProbabilityCurveFunctionLibrary::IntegrateRichCurveNoAlloc(
+	const FRichCurve& Curve, float Offset, FRichCurve& IntegratedCurve, float& TotalArea)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousIntegrateCurve);
+
 	IntegratedCurve.PreInfinityExtrap = RCCE_Constant;
 	IntegratedCurve.PostInfinityExtrap = RCCE_Constant;
-	IntegratedCurve.Reset();
+	ResetRichCurveKeys(IntegratedCurve);
+	TotalArea = Offset;
 	if (Curve.GetNumKeys() == 0)
 	{
 		return;
 	}
+	// Cubic segments are split at up to two extrema
+	IntegratedCurve.Keys.Reserve(1 + 3 * (Curve.GetNumKeys() - 1));
 
 	float Value = Offset;
 	// First point
@@ -880,14 +926,24 @@ void UProbabilityCurveFunctionLibrary::IntegrateRichCurve(
 
 void UProbabilityCurveFunctionLibrary::TransformRichCurve(const FRichCurve& Curve, float Scale, float Offset, FRichCurve& ScaledCurve)
 {
+	ScaledCurve.Reset();
+	TransformRichCurveNoAlloc(Curve, Scale, Offset, ScaledCurve);
+}
+
+void UProbabilityCurveFunctionLibrary::TransformRichCurveNoAlloc(
+	const FRichCurve& Curve, float Scale, float Offset, FRichCurve& ScaledCurve)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousTransformCurve);
+
 	ScaledCurve.PreInfinityExtrap = Curve.PreInfinityExtrap;
 	ScaledCurve.PostInfinityExtrap = Curve.PostInfinityExtrap;
-	ScaledCurve.Reset();
+	ResetRichCurveKeys(ScaledCurve);
 
 	if (Curve.GetNumKeys() == 0)
 	{
 		return;
 	}
+	ScaledCurve.Keys.Reserve(Curve.GetNumKeys());
 
 	for (auto KeyIter(Curve.GetKeyIterator()); KeyIter; ++KeyIter)
 	{
@@ -903,6 +959,8 @@ void UProbabilityCurveFunctionLibrary::TransformRichCurve(const FRichCurve& Curv
 
 void UProbabilityCurveFunctionLibrary::NormalizeRichCurve(const FRichCurve& Curve, FRichCurve& NormalizedCurve)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousNormalizeCurve);
+
 	float MinValue, MaxValue;
 	Curve.GetValueRange(MinValue, MaxValue);
 	const float Range = MaxValue - MinValue;
@@ -910,19 +968,51 @@ void UProbabilityCurveFunctionLibrary::NormalizeRichCurve(const FRichCurve& Curv
 	{
 		TransformRichCurve(Curve, 1.0f / Range, -MinValue / Range, NormalizedCurve);
 	}
+	else
+	{
+		// Flat curves cannot be scaled to the unit range, shift them to zero
+		TransformRichCurve(Curve, 1.0f, -MinValue, NormalizedCurve);
+	}
 }
 
-void UProbabilityCurveFunctionLibrary::InvertRichCurve(const FRichCurve& Curve, int32 Resolution, FRichCurve& InvertedCurve)
+void UProbabilityCurveFunctionLibrary::NormalizeRichCurveNoAlloc(const FRichCurve& Curve, FRichCurve& NormalizedCurve)
 {
-#if 1
-	if (!ensure(Resolution > 0))
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousNormalizeCurve);
+
+	float MinValue, MaxValue;
+	Curve.GetValueRange(MinValue, MaxValue);
+	const float Range = MaxValue - MinValue;
+	if (!FMath::IsNearlyZero(Range))
 	{
-		return;
+		TransformRichCurveNoAlloc(Curve, 1.0f / Range, -MinValue / Range, NormalizedCurve);
+	}
+	else
+	{
+		// Flat curves cannot be scaled to the unit range, shift them to zero
+		TransformRichCurveNoAlloc(Curve, 1.0f, -MinValue, NormalizedCurve);
 	}
+}
+
+void UProbabilityCurveFunctionLibrary::InvertRichCurve(const FRichCurve& Curve, int32 Resolution, FRichCurve& InvertedCurve)
+{
+	InvertedCurve.Reset();
+	InvertRichCurveNoAlloc(Curve, Resolution, InvertedCurve);
+}
 
+void UProbabilityCurveFunctionLibrary::InvertRichCurveNoAlloc(const FRichCurve& Curve, int32 Resolution, FRichCurve& InvertedCurve)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousInvertCurve);
+
+#if 1
 	InvertedCurve.PreInfinityExtrap = Curve.PreInfinityExtrap;
 	InvertedCurve.PostInfinityExtrap = Curve.PostInfinityExtrap;
-	InvertedCurve.Reset();
+	ResetRichCurveKeys(InvertedCurve);
+	if (!ensure(Resolution > 0) || Curve.GetNumKeys() == 0)
+	{
+		return;
+	}
+	// Cubic segments are sampled at Resolution points
+	InvertedCurve.Keys.Reserve(1 + Resolution * (Curve.GetNumKeys() - 1));
 
 	// First point
 	{
@@ -1031,18 +1121,26 @@ void UProbabilityCurveFunctionLibrary::InvertRichCurve(const FRichCurve& Curve,
 }
 
 void UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurve(
-	const FRichCurve& DensityCurve, FRichCurve& NormalizedDensityCurve, FRichCurve& QuantileCurve)
+	const FRichCurve& DensityCurve, FRichCurve& NormalizedDensityCurve, FRichCurve& QuantileCurve, int32 Resolution)
+{
+	FQuantileCurveScratch Scratch;
+	QuantileCurve.Reset();
+	ComputeQuantileRichCurveNoAlloc(DensityCurve, NormalizedDensityCurve, QuantileCurve, Scratch, Resolution);
+}
+
+void UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurveNoAlloc(
+	const FRichCurve& DensityCurve, FRichCurve& NormalizedDensityCurve, FRichCurve& QuantileCurve, FQuantileCurveScratch& Scratch,
+	int32 Resolution)
 {
-	FRichCurve IntegratedDensityCurve;
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousComputeQuantileCurve);
+
 	float IntegratedDensity;
-	UProbabilityCurveFunctionLibrary::IntegrateRichCurve(DensityCurve, 0.0f, IntegratedDensityCurve, IntegratedDensity);
+	IntegrateRichCurveNoAlloc(DensityCurve, 0.0f, Scratch.IntegratedDensityCurve, IntegratedDensity);
 
-	if (!FMath::IsNearlyZero(IntegratedDensity))
-	{
-		UProbabilityCurveFunctionLibrary::TransformRichCurve(DensityCurve, 1.0f / IntegratedDensity, 0.0f, NormalizedDensityCurve);
-	}
+	// A density without mass cannot be normalized and is copied unchanged
+	const float DensityScale = !FMath::IsNearlyZero(IntegratedDensity) ? 1.0f / IntegratedDensity : 1.0f;
+	TransformRichCurveNoAlloc(DensityCurve, DensityScale, 0.0f, NormalizedDensityCurve);
 
-	FRichCurve CumulativeDensityCurve;
-	UProbabilityCurveFunctionLibrary::NormalizeRichCurve(IntegratedDensityCurve, CumulativeDensityCurve);
-	UProbabilityCurveFunctionLibrary::InvertRichCurve(CumulativeDensityCurve, 10, QuantileCurve);
+	NormalizeRichCurveNoAlloc(Scratch.IntegratedDensityCurve, Scratch.CumulativeDensityCurve);
+	InvertRichCurveNoAlloc(Scratch.CumulativeDensityCurve, Resolution, QuantileCurve);
 }
@@ -9,6 +9,13 @@
 
 struct FRichCurve;
 
+/** Intermediate curves of the quantile computation, reused between calls to avoid allocations. */
+struct FQuantileCurveScratch
+{
+	FRichCurve IntegratedDensityCurve;
+	FRichCurve CumulativeDensityCurve;
+};
+
 USTRUCT(BlueprintType)
 struct FDrawDebugCurveSettings
 {
@@ -71,5 +78,19 @@ public:
 	static void NormalizeRichCurve(const FRichCurve& Curve, FRichCurve& NormalizedCurve);
 	static void InvertRichCurve(const FRichCurve& Curve, int32 Resolution, FRichCurve& InvertedCurve);
 
-	static void ComputeQuantileRichCurve(const FRichCurve& DensityCurve, FRichCurve& NormalizedDensityCurve, FRichCurve& QuantileCurve);
+	static void ComputeQuantileRichCurve(
+		const FRichCurve& DensityCurve, FRichCurve& NormalizedDensityCurve, FRichCurve& QuantileCurve, int32 Resolution = 10);
+
+	// Allocation-free variants for repeated derivation.
+	// Output keys are written directly and reuse the existing key array allocation, so these do not allocate once
+	// output curves have reached their steady state size. Key handles of output curves are reset and created again
+	// on demand when keys are accessed by handle.
+	static void IntegrateRichCurveNoAlloc(const FRichCurve& Curve, float Offset, FRichCurve& IntegratedCurve, float& TotalArea);
+	static void TransformRichCurveNoAlloc(const FRichCurve& Curve, float Scale, float Offset, FRichCurve& ScaledCurve);
+	static void NormalizeRichCurveNoAlloc(const FRichCurve& Curve, FRichCurve& NormalizedCurve);
+	static void InvertRichCurveNoAlloc(const FRichCurve& Curve, int32 Resolution, FRichCurve& InvertedCurve);
+
+	static void ComputeQuantileRichCurveNoAlloc(
+		const FRichCurve& DensityCurve, FRichCurve& NormalizedDensityCurve, FRichCurve& QuantileCurve, FQuantileCurveScratch& Scratch,
+		int32 Resolution = 10);
 };
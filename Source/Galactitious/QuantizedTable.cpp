@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "QuantizedTable.h"
+
+#include "TextureBakerFunctionLibrary.h"
+
+void FQuantizedTable::Encode(TArrayView<const float> Values, int32 InNumChannels, EQuantizedTableFormat InFormat, bool bInDeltaEncoding)
+{
+	Reset();
+	if (!ensureMsgf(
+			InNumChannels > 0 && Values.Num() % InNumChannels == 0 && Values.Num() >= 2 * InNumChannels,
+			TEXT("Quantized tables need at least two entries of %d channels"), InNumChannels))
+	{
+		return;
+	}
+
+	NumChannels = InNumChannels;
+	NumEntries = Values.Num() / InNumChannels;
+	Format = InFormat;
+	BlockShift = bInDeltaEncoding ? DeltaBlockShift : 30;
+	const int32 NumBlocks = ((NumEntries - 1) >> BlockShift) + 1;
+
+	Data.SetNumUninitialized(Values.Num());
+	Scales.SetNumUninitialized(NumBlocks * NumChannels);
+	Offsets.SetNumUninitialized(NumBlocks * NumChannels);
+	MaxErrors.SetNumZeroed(NumChannels);
+	for (int32 Block = 0; Block < NumBlocks; ++Block)
+	{
+		const int32 Begin = Block << BlockShift;
+		const int32 End = FMath::Min(NumEntries - Begin, 1 << BlockShift) + Begin;
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			float MinValue = MAX_flt;
+			float MaxValue = -MAX_flt;
+			for (int32 i = Begin; i < End; ++i)
+			{
+				MinValue = FMath::Min(MinValue, Values[i * NumChannels + Channel]);
+				MaxValue = FMath::Max(MaxValue, Values[i * NumChannels + Channel]);
+			}
+
+			const int32 BlockChannel = Block * NumChannels + Channel;
+			Offsets[BlockChannel] = MinValue;
+			Scales[BlockChannel] = MaxValue - MinValue;
+			const float InvScale = MaxValue > MinValue ? 1.0f / (MaxValue - MinValue) : 0.0f;
+			for (int32 i = Begin; i < End; ++i)
+			{
+				const float Value = Values[i * NumChannels + Channel];
+				const float Normalized = FMath::Clamp((Value - MinValue) * InvScale, 0.0f, 1.0f);
+				Data[i * NumChannels + Channel] = Format == EQuantizedTableFormat::UNorm16
+													  ? (uint16)FMath::RoundToInt(Normalized * 65535.0f)
+													  : UTextureBakerFunctionLibrary::FloatToHalf(Normalized);
+				MaxErrors[Channel] = FMath::Max(MaxErrors[Channel], FMath::Abs(GetValue(i, Channel) - Value));
+			}
+		}
+	}
+}
+
+void FQuantizedTable::Reset()
+{
+	Data.Reset();
+	Scales.Reset();
+	Offsets.Reset();
+	MaxErrors.Reset();
+	NumEntries = 0;
+	NumChannels = 0;
+}
+
+float FQuantizedTable::HalfToFloat(uint16 Bits)
+{
+	// Shift exponent and mantissa into place and rebias the exponent with a multiplication, which also handles denormals.
+	// Encoded values are finite, so infinities and NaNs need no special case.
+	union
+	{
+		uint32 UInt;
+		float Float;
+	} Magnitude;
+	Magnitude.UInt = (uint32)(Bits & 0x7fff) << 13;
+	const float Value = Magnitude.Float * 5.192296858534828e+33f; // 2^112
+	return (Bits & 0x8000) ? -Value : Value;
+}
+
+float FQuantizedTable::Eval(float X, int32 Channel) const
+{
+	if (NumEntries == 0)
+	{
+		return 0.0f;
+	}
+
+	int32 Index;
+	float Alpha;
+	GetLerpEntries(X, Index, Alpha);
+	return FMath::Lerp(GetValue(Index, Channel), GetValue(Index + 1, Channel), Alpha);
+}
+
+FLinearColor FQuantizedTable::Eval4(float X) const
+{
+	checkSlow(NumChannels == 4);
+	if (NumEntries == 0)
+	{
+		return FLinearColor::Transparent;
+	}
+
+	int32 Index;
+	float Alpha;
+	GetLerpEntries(X, Index, Alpha);
+	const FLinearColor Value0(GetValue(Index, 0), GetValue(Index, 1), GetValue(Index, 2), GetValue(Index, 3));
+	const FLinearColor Value1(GetValue(Index + 1, 0), GetValue(Index + 1, 1), GetValue(Index + 1, 2), GetValue(Index + 1, 3));
+	return FMath::Lerp(Value0, Value1, Alpha);
+}
+
+void FQuantizedTable::Decode(TArray<float>& OutValues) const
+{
+	OutValues.SetNumUninitialized(Data.Num());
+	for (int32 i = 0; i < NumEntries; ++i)
+	{
+		for (int32 Channel = 0; Channel < NumChannels; ++Channel)
+		{
+			OutValues[i * NumChannels + Channel] = GetValue(i, Channel);
+		}
+	}
+}
+
+SIZE_T FQuantizedTable::GetAllocatedSize() const
+{
+	return Data.GetAllocatedSize() + Scales.GetAllocatedSize() + Offsets.GetAllocatedSize() + MaxErrors.GetAllocatedSize();
+}
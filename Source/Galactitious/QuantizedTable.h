@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "QuantizedTable.generated.h"
+
+UENUM()
+enum class EQuantizedTableFormat : uint8
+{
+	/** 16-bit unsigned normalized, uniform absolute precision of 1 / 65535 of the channel range. */
+	UNorm16,
+	/** Half floats, relative precision of 11 bits which favors values near the channel offset. */
+	Half,
+};
+
+/**
+ * Compact table of samples uniform on [0, 1] with interleaved channels, 2 bytes per value instead of the 28 of an FRichCurveKey.
+ * Values are stored normalized with a scale and offset per channel. With delta encoding each block of DeltaBlockSize entries
+ * stores its values relative to the block minimum with its own scale, so tables with small steps but a large range, like quantile
+ * tables, keep most of the 16 bits. Decoding is a multiply-add either way and entries stay randomly accessible.
+ */
+USTRUCT()
+struct GALACTITIOUS_API FQuantizedTable
+{
+	GENERATED_BODY()
+
+	static constexpr int32 DeltaBlockShift = 5;
+	static constexpr int32 DeltaBlockSize = 1 << DeltaBlockShift;
+
+	/** Quantize Values with NumChannels interleaved channels. */
+	void Encode(TArrayView<const float> Values, int32 InNumChannels, EQuantizedTableFormat InFormat, bool bInDeltaEncoding);
+
+	void Reset();
+
+	int32 Num() const { return NumEntries; }
+	int32 GetNumChannels() const { return NumChannels; }
+	EQuantizedTableFormat GetFormat() const { return Format; }
+	bool IsDeltaEncoded() const { return BlockShift == DeltaBlockShift; }
+
+	/** Largest absolute error of the decoded values of a channel, measured by Encode. */
+	float GetMaxError(int32 Channel) const { return MaxErrors[Channel]; }
+
+	FORCEINLINE float GetValue(int32 Index, int32 Channel) const
+	{
+		const int32 Block = (Index >> BlockShift) * NumChannels + Channel;
+		const uint16 Bits = Data[Index * NumChannels + Channel];
+		const float Normalized = Format == EQuantizedTableFormat::UNorm16 ? Bits * (1.0f / 65535.0f) : HalfToFloat(Bits);
+		return Normalized * Scales[Block] + Offsets[Block];
+	}
+
+	/** Linear lookup of a channel at X in [0, 1], clamped. */
+	float Eval(float X, int32 Channel = 0) const;
+
+	/** Linear lookup of four channels at X in [0, 1], clamped. The table needs four channels. */
+	FLinearColor Eval4(float X) const;
+
+	/** Decoded values with interleaved channels, e.g. for uploads. */
+	void Decode(TArray<float>& OutValues) const;
+
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	static float HalfToFloat(uint16 Bits);
+
+	/** Entry index and interpolation weight of X. */
+	FORCEINLINE void GetLerpEntries(float X, int32& OutIndex, float& OutAlpha) const
+	{
+		const float Index = FMath::Clamp(X, 0.0f, 1.0f) * (NumEntries - 1);
+		OutIndex = FMath::Min((int32)Index, NumEntries - 2);
+		OutAlpha = Index - OutIndex;
+	}
+
+	UPROPERTY()
+	TArray<uint16> Data;
+
+	/** Scale and offset per block and channel, a single block without delta encoding. */
+	UPROPERTY()
+	TArray<float> Scales;
+
+	UPROPERTY()
+	TArray<float> Offsets;
+
+	UPROPERTY()
+	TArray<float> MaxErrors;
+
+	UPROPERTY()
+	int32 NumEntries = 0;
+
+	UPROPERTY()
+	int32 NumChannels = 0;
+
+	/** Entries per block as a shift, large enough for a single block without delta encoding. */
+	UPROPERTY()
+	int32 BlockShift = 30;
+
+	UPROPERTY()
+	EQuantizedTableFormat Format = EQuantizedTableFormat::UNorm16;
+};
@@ -0,0 +1,230 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SampleSequence.h"
+
+namespace
+{
+	/**
+	 * Sobol direction numbers as 0.32 fixed point, from primitive polynomials and initial numbers of Joe and Kuo.
+	 * The first dimension is the van der Corput sequence.
+	 */
+	struct FSobolDirections
+	{
+		uint32 Directions[FSampleSequence::NumSobolDimensions][32];
+
+		FSobolDirections()
+		{
+			struct FPolynomial
+			{
+				uint32 Degree;
+				uint32 Coefficients;
+				uint32 InitialNumbers[3];
+			};
+			const FPolynomial Polynomials[] = {{1, 0, {1}}, {2, 1, {1, 3}}, {3, 1, {1, 3, 1}}};
+
+			for (uint32 Bit = 0; Bit < 32; ++Bit)
+			{
+				Directions[0][Bit] = 1u << (31 - Bit);
+			}
+			for (uint32 Dimension = 1; Dimension < FSampleSequence::NumSobolDimensions; ++Dimension)
+			{
+				const FPolynomial& Polynomial = Polynomials[Dimension - 1];
+				const uint32 Degree = Polynomial.Degree;
+				uint32* V = Directions[Dimension];
+				for (uint32 Bit = 0; Bit < 32; ++Bit)
+				{
+					if (Bit < Degree)
+					{
+						V[Bit] = Polynomial.InitialNumbers[Bit] << (31 - Bit);
+						continue;
+					}
+
+					V[Bit] = V[Bit - Degree] ^ (V[Bit - Degree] >> Degree);
+					for (uint32 k = 1; k < Degree; ++k)
+					{
+						if ((Polynomial.Coefficients >> (Degree - 1 - k)) & 1)
+						{
+							V[Bit] ^= V[Bit - k];
+						}
+					}
+				}
+			}
+		}
+	};
+
+	const FSobolDirections SobolDirections;
+
+	/** Lattice generating vector component LatticeMultiplier^Dimension mod 2^32. */
+	uint32 LatticeGenerator(uint32 Dimension)
+	{
+		uint32 Result = 1;
+		uint32 Base = FSampleSequence::LatticeMultiplier;
+		for (; Dimension != 0; Dimension >>= 1)
+		{
+			Result *= (Dimension & 1) ? Base : 1u;
+			Base *= Base;
+		}
+		return Result;
+	}
+} // namespace
+
+uint32 FSampleSequence::HashUInt32(uint32 Value)
+{
+	// lowbias32 integer hash
+	Value ^= Value >> 16;
+	Value *= 0x7FEB352Du;
+	Value ^= Value >> 15;
+	Value *= 0x846CA68Bu;
+	Value ^= Value >> 16;
+	return Value;
+}
+
+uint32 FSampleSequence::HashCombine(uint32 Seed, uint32 Value)
+{
+	return Seed ^ (HashUInt32(Value) + 0x9E3779B9u + (Seed << 6) + (Seed >> 2));
+}
+
+uint32 FSampleSequence::OwenScramble(uint32 Value, uint32 Seed)
+{
+	// Hash-based permutation of reversed bits, each bit is only affected by higher order bits of the original value
+	Value = ReverseBits(Value);
+	Value += Seed;
+	Value ^= Value * 0x6C50B47Cu;
+	Value ^= Value * 0xB82F1E52u;
+	Value ^= Value * 0xC7AFE638u;
+	Value ^= Value * 0x8D22F6E6u;
+	return ReverseBits(Value);
+}
+
+uint32 FSampleSequence::SobolSample(uint32 Index, uint32 Dimension)
+{
+	check(Dimension < NumSobolDimensions);
+
+	const uint32* Directions = SobolDirections.Directions[Dimension];
+	uint32 Result = 0;
+	for (uint32 Bit = 0; Index != 0; ++Bit, Index >>= 1)
+	{
+		Result ^= (Index & 1) ? Directions[Bit] : 0u;
+	}
+	return Result;
+}
+
+uint32 FSampleSequence::GetSampleBits(ESampleSequence Sequence, uint32 Seed, uint32 Index, uint32 Dimension)
+{
+	switch (Sequence)
+	{
+	case ESampleSequence::Sobol:
+	{
+		// Dimensions beyond the Sobol dimensions are padded with independently shuffled indices
+		const uint32 GroupSeed = HashCombine(HashUInt32(Seed), Dimension / NumSobolDimensions);
+		const uint32 GroupDimension = Dimension % NumSobolDimensions;
+		const uint32 ShuffledIndex = OwenScramble(Index, GroupSeed);
+		return OwenScramble(SobolSample(ShuffledIndex, GroupDimension), HashCombine(GroupSeed, GroupDimension));
+	}
+	case ESampleSequence::Lattice:
+		// Radical inverse of the index times the generating vector, the fixed point product wraps to the fractional part
+		return ReverseBits(Index) * LatticeGenerator(Dimension) + HashCombine(HashUInt32(Seed), Dimension);
+	case ESampleSequence::Random:
+	default:
+		return HashUInt32(Index ^ HashCombine(HashUInt32(Seed), Dimension));
+	}
+}
+
+float FSampleSequence::GetSample(ESampleSequence Sequence, uint32 Seed, uint32 Index, uint32 Dimension)
+{
+	return BitsToFloat(GetSampleBits(Sequence, Seed, Index, Dimension));
+}
+
+FString FSampleSequence::GetSampleHLSL(ESampleSequence Sequence, const FString& FunctionName)
+{
+	const TCHAR* Prefix = *FunctionName;
+	FString HLSL;
+
+	// Helpers match the CPU implementation bit for bit
+	HLSL += FString::Printf(
+		TEXT("uint %s_Hash(uint Value)\n")
+			TEXT("{\n")
+			TEXT("\tValue ^= Value >> 16;\n")
+			TEXT("\tValue *= 0x7FEB352Du;\n")
+			TEXT("\tValue ^= Value >> 15;\n")
+			TEXT("\tValue *= 0x846CA68Bu;\n")
+			TEXT("\tValue ^= Value >> 16;\n")
+			TEXT("\treturn Value;\n")
+			TEXT("}\n")
+			TEXT("uint %s_HashCombine(uint Seed, uint Value)\n")
+			TEXT("{\n")
+			TEXT("\treturn Seed ^ (%s_Hash(Value) + 0x9E3779B9u + (Seed << 6) + (Seed >> 2));\n")
+			TEXT("}\n"),
+		Prefix, Prefix, Prefix);
+
+	switch (Sequence)
+	{
+	case ESampleSequence::Sobol:
+	{
+		FString Directions;
+		for (uint32 Dimension = 0; Dimension < NumSobolDimensions; ++Dimension)
+		{
+			for (uint32 Bit = 0; Bit < 32; ++Bit)
+			{
+				Directions += FString::Printf(TEXT("0x%08Xu,"), SobolDirections.Directions[Dimension][Bit]);
+			}
+			Directions += TEXT("\n");
+		}
+
+		HLSL += FString::Printf(
+			TEXT("static const uint %s_SobolDirections[%u] = {\n%s};\n")
+				TEXT("uint %s_OwenScramble(uint Value, uint Seed)\n")
+				TEXT("{\n")
+				TEXT("\tValue = reversebits(Value) + Seed;\n")
+				TEXT("\tValue ^= Value * 0x6C50B47Cu;\n")
+				TEXT("\tValue ^= Value * 0xB82F1E52u;\n")
+				TEXT("\tValue ^= Value * 0xC7AFE638u;\n")
+				TEXT("\tValue ^= Value * 0x8D22F6E6u;\n")
+				TEXT("\treturn reversebits(Value);\n")
+				TEXT("}\n")
+				TEXT("float %s(uint Seed, uint Index, uint Dimension)\n")
+				TEXT("{\n")
+				TEXT("\tconst uint GroupSeed = %s_HashCombine(%s_Hash(Seed), Dimension / %uu);\n")
+				TEXT("\tconst uint GroupDimension = Dimension %% %uu;\n")
+				TEXT("\tuint ShuffledIndex = %s_OwenScramble(Index, GroupSeed);\n")
+				TEXT("\tuint Bits = 0;\n")
+				TEXT("\t[loop] for (uint Bit = 0; ShuffledIndex != 0; ++Bit, ShuffledIndex >>= 1)\n")
+				TEXT("\t{\n")
+				TEXT("\t\tBits ^= (ShuffledIndex & 1) ? %s_SobolDirections[GroupDimension * 32 + Bit] : 0u;\n")
+				TEXT("\t}\n")
+				TEXT("\tBits = %s_OwenScramble(Bits, %s_HashCombine(GroupSeed, GroupDimension));\n")
+				TEXT("\treturn (Bits >> 8) * (1.0f / 16777216.0f);\n")
+				TEXT("}\n"),
+			Prefix, NumSobolDimensions * 32, *Directions, Prefix, Prefix, Prefix, Prefix, NumSobolDimensions, NumSobolDimensions, Prefix,
+			Prefix, Prefix, Prefix);
+		break;
+	}
+	case ESampleSequence::Lattice:
+		HLSL += FString::Printf(
+			TEXT("float %s(uint Seed, uint Index, uint Dimension)\n")
+				TEXT("{\n")
+				TEXT("\tuint Generator = 1;\n")
+				TEXT("\tuint Base = %uu;\n")
+				TEXT("\t[loop] for (uint Exponent = Dimension; Exponent != 0; Exponent >>= 1)\n")
+				TEXT("\t{\n")
+				TEXT("\t\tGenerator *= (Exponent & 1) ? Base : 1u;\n")
+				TEXT("\t\tBase *= Base;\n")
+				TEXT("\t}\n")
+				TEXT("\tconst uint Bits = reversebits(Index) * Generator + %s_HashCombine(%s_Hash(Seed), Dimension);\n")
+				TEXT("\treturn (Bits >> 8) * (1.0f / 16777216.0f);\n")
+				TEXT("}\n"),
+			Prefix, LatticeMultiplier, Prefix, Prefix);
+		break;
+	case ESampleSequence::Random:
+	default:
+		HLSL += FString::Printf(
+			TEXT("float %s(uint Seed, uint Index, uint Dimension)\n")
+				TEXT("{\n")
+				TEXT("\tconst uint Bits = %s_Hash(Index ^ %s_HashCombine(%s_Hash(Seed), Dimension));\n")
+				TEXT("\treturn (Bits >> 8) * (1.0f / 16777216.0f);\n")
+				TEXT("}\n"),
+			Prefix, Prefix, Prefix, Prefix);
+		break;
+	}
+	return HLSL;
+}
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "SampleSequence.generated.h"
+
+UENUM()
+enum class ESampleSequence : uint8
+{
+	/** Independent hashed random numbers. */
+	Random,
+	/** Sobol sequence with hash-based Owen scrambling, dimensions are grouped by four and each group shuffles the index. */
+	Sobol,
+	/** Extensible rank-1 lattice in base 2 with a random shift per dimension. */
+	Lattice,
+};
+
+/**
+ * Stateless sample sequences, a sample only depends on seed, index and dimension.
+ * The first 2^m indices of the low-discrepancy sequences are stratified in every dimension, so smooth results need fewer samples.
+ * Coordinates of one attribute should use consecutive dimensions starting at a multiple of two.
+ */
+struct GALACTITIOUS_API FSampleSequence
+{
+	/** Sample in [0, 1). */
+	static float GetSample(ESampleSequence Sequence, uint32 Seed, uint32 Index, uint32 Dimension);
+
+	/** Sample as 0.32 fixed point. */
+	static uint32 GetSampleBits(ESampleSequence Sequence, uint32 Seed, uint32 Index, uint32 Dimension);
+
+	/** Unscrambled Sobol sample as 0.32 fixed point, Dimension < NumSobolDimensions. */
+	static uint32 SobolSample(uint32 Index, uint32 Dimension);
+
+	/** Nested uniform scramble of the bits of Value in the style of Laine and Karras. */
+	static uint32 OwenScramble(uint32 Value, uint32 Seed);
+
+	static uint32 HashUInt32(uint32 Value);
+	static uint32 HashCombine(uint32 Seed, uint32 Value);
+
+	static float BitsToFloat(uint32 Bits) { return (Bits >> 8) * (1.0f / 16777216.0f); }
+
+	static constexpr uint32 NumSobolDimensions = 4;
+
+	/** Korobov multiplier of the lattice, chosen for good 2D projections of the first five dimensions for 2^6 to 2^22 points. */
+	static constexpr uint32 LatticeMultiplier = 3803483u;
+
+	/** HLSL of GetSample for particle shaders, defines float FunctionName(uint Seed, uint Index, uint Dimension) and helpers. */
+	static FString GetSampleHLSL(ESampleSequence Sequence, const FString& FunctionName);
+};
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SpectrumFunctionLibrary.h"
+
+namespace
+{
+	/** Piecewise Gaussian with different widths left and right of the center. */
+	float PiecewiseGaussian(float X, float Mu, float SigmaLeft, float SigmaRight)
+	{
+		const float T = (X - Mu) / (X < Mu ? SigmaLeft : SigmaRight);
+		return FMath::Exp(-0.5f * T * T);
+	}
+
+	/** Integration step of the visible spectrum. */
+	const float WavelengthStep = 1.0f;
+} // namespace
+
+double USpectrumFunctionLibrary::PlanckRadiance(double Wavelength, double Temperature)
+{
+	// Physical constants (SI)
+	const double PlanckConstant = 6.62607015e-34;
+	const double SpeedOfLight = 2.99792458e8;
+	const double BoltzmannConstant = 1.380649e-23;
+
+	const double Lambda = Wavelength * 1.0e-9;
+	const double Exponent = PlanckConstant * SpeedOfLight / (Lambda * BoltzmannConstant * Temperature);
+	const double Radiance = 2.0 * PlanckConstant * SpeedOfLight * SpeedOfLight / (FMath::Pow(Lambda, 5.0) * (FMath::Exp(Exponent) - 1.0));
+	// Per meter to per nanometer
+	return Radiance * 1.0e-9;
+}
+
+FVector USpectrumFunctionLibrary::ColorMatching(float Wavelength)
+{
+	const float X = 1.056f * PiecewiseGaussian(Wavelength, 599.8f, 37.9f, 31.0f) +
+					0.362f * PiecewiseGaussian(Wavelength, 442.0f, 16.0f, 26.7f) -
+					0.065f * PiecewiseGaussian(Wavelength, 501.1f, 20.4f, 26.2f);
+	const float Y = 0.821f * PiecewiseGaussian(Wavelength, 568.8f, 46.9f, 40.5f) +
+					0.286f * PiecewiseGaussian(Wavelength, 530.9f, 16.3f, 31.1f);
+	const float Z = 1.217f * PiecewiseGaussian(Wavelength, 437.0f, 11.8f, 36.0f) +
+					0.681f * PiecewiseGaussian(Wavelength, 459.0f, 26.0f, 13.8f);
+	return FVector(X, Y, Z);
+}
+
+FLinearColor USpectrumFunctionLibrary::XYZToLinearSRGB(const FVector& XYZ)
+{
+	return FLinearColor(
+		3.2406f * XYZ.X - 1.5372f * XYZ.Y - 0.4986f * XYZ.Z, -0.9689f * XYZ.X + 1.8758f * XYZ.Y + 0.0415f * XYZ.Z,
+		0.0557f * XYZ.X - 0.2040f * XYZ.Y + 1.0570f * XYZ.Z, 1.0f);
+}
+
+FLinearColor USpectrumFunctionLibrary::BlackbodyColor(float Temperature)
+{
+	if (!ensureMsgf(Temperature > 0.0f, TEXT("Blackbody temperature must be positive")))
+	{
+		return FLinearColor::Black;
+	}
+
+	// Integrate the spectrum against the color matching functions, trapezoidal rule
+	FVector XYZ = FVector::ZeroVector;
+	const int32 NumSteps = FMath::RoundToInt((MaxWavelength - MinWavelength) / WavelengthStep);
+	for (int32 i = 0; i <= NumSteps; ++i)
+	{
+		const float Wavelength = MinWavelength + i * WavelengthStep;
+		const float Weight = (i == 0 || i == NumSteps) ? 0.5f : 1.0f;
+		XYZ += ColorMatching(Wavelength) * (float)(PlanckRadiance(Wavelength, Temperature) * Weight);
+	}
+
+	if (XYZ.Y <= 0.0f)
+	{
+		return FLinearColor::Black;
+	}
+
+	FLinearColor Color = XYZToLinearSRGB(XYZ / XYZ.Y);
+	Color.R = FMath::Max(Color.R, 0.0f);
+	Color.G = FMath::Max(Color.G, 0.0f);
+	Color.B = FMath::Max(Color.B, 0.0f);
+	return Color;
+}
+
+void FBlackbodyColorTable::Build(float MinTemperature, float MaxTemperature, int32 NumEntries)
+{
+	check(NumEntries >= 2);
+	LogMinTemperature = FMath::Loge(FMath::Max(MinTemperature, 1.0f));
+	const float LogRange = FMath::Max(FMath::Loge(FMath::Max(MaxTemperature, 1.0f)) - LogMinTemperature, 0.0f);
+	IndexScale = LogRange > 0.0f ? (NumEntries - 1) / LogRange : 0.0f;
+
+	Colors.SetNumUninitialized(NumEntries);
+	for (int32 i = 0; i < NumEntries; ++i)
+	{
+		Colors[i] = USpectrumFunctionLibrary::BlackbodyColor(FMath::Exp(LogMinTemperature + LogRange * i / (NumEntries - 1)));
+	}
+}
+
+const FLinearColor& FBlackbodyColorTable::Eval(float Temperature) const
+{
+	const float Index = (FMath::Loge(FMath::Max(Temperature, 1.0f)) - LogMinTemperature) * IndexScale;
+	return Colors[FMath::Clamp(FMath::RoundToInt(Index), 0, Colors.Num() - 1)];
+}
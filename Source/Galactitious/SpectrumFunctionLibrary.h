@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+
+#include "SpectrumFunctionLibrary.generated.h"
+
+/** Blackbody colors tabulated over logarithmic temperature, for coloring many stars. */
+struct GALACTITIOUS_API FBlackbodyColorTable
+{
+	void Build(float MinTemperature, float MaxTemperature, int32 NumEntries = 256);
+
+	/** Nearest entry, temperatures are clamped to the table range. */
+	const FLinearColor& Eval(float Temperature) const;
+
+private:
+	TArray<FLinearColor> Colors;
+	float LogMinTemperature = 0.0f;
+	float IndexScale = 0.0f;
+};
+
+/**
+ * Spectral radiometry helpers for converting spectra to display colors.
+ * Wavelengths are in nanometers, temperatures in Kelvin.
+ */
+UCLASS()
+class GALACTITIOUS_API USpectrumFunctionLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	/** Visible range covered by the color matching functions. */
+	static constexpr float MinWavelength = 380.0f;
+	static constexpr float MaxWavelength = 780.0f;
+
+	/** Linear sRGB color of a blackbody, normalized to unit luminance (Y = 1). Out of gamut components are clamped to zero. */
+	UFUNCTION(BlueprintPure, Category = Spectrum)
+	static FLinearColor BlackbodyColor(float Temperature);
+
+	/** Spectral radiance of a blackbody (Planck's law), in W / (sr m^2 nm). */
+	static double PlanckRadiance(double Wavelength, double Temperature);
+
+	/** CIE 1931 2 degree color matching functions (x, y, z), multi-lobe Gaussian fit by Wyman, Sloan and Shirley (2013). */
+	static FVector ColorMatching(float Wavelength);
+
+	/** Convert CIE XYZ to linear sRGB (D65 white point). */
+	static FLinearColor XYZToLinearSRGB(const FVector& XYZ);
+};
@@ -0,0 +1,200 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "StarGenerator.h"
+
+#include "GalactitiousStats.h"
+#include "StellarSamplingData.h"
+#include "Async/ParallelFor.h"
+#include "Curves/CurveFloat.h"
+#include "HAL/FileManager.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogStarGenerator, Log, All);
+
+namespace
+{
+	/** Particles generated per task. */
+	const int32 GenerateChunkSize = 16 * 1024;
+
+	const uint32 SnapshotMagic = 0x52545347; // "GSTR"
+	const int32 SnapshotVersion = 1;
+} // namespace
+
+void FStarBuffer::SetNumUninitialized(int32 NumStars)
+{
+	PositionX.SetNumUninitialized(NumStars);
+	PositionY.SetNumUninitialized(NumStars);
+	PositionZ.SetNumUninitialized(NumStars);
+	LogLuminosity.SetNumUninitialized(NumStars);
+	Temperature.SetNumUninitialized(NumStars);
+	StarCount.SetNumUninitialized(NumStars);
+}
+
+void FStarBuffer::Empty()
+{
+	PositionX.Empty();
+	PositionY.Empty();
+	PositionZ.Empty();
+	LogLuminosity.Empty();
+	Temperature.Empty();
+	StarCount.Empty();
+}
+
+void FStarBuffer::Append(const FStarBuffer& Other)
+{
+	PositionX.Append(Other.PositionX);
+	PositionY.Append(Other.PositionY);
+	PositionZ.Append(Other.PositionZ);
+	LogLuminosity.Append(Other.LogLuminosity);
+	Temperature.Append(Other.Temperature);
+	StarCount.Append(Other.StarCount);
+}
+
+SIZE_T FStarBuffer::GetAllocatedSize() const
+{
+	return PositionX.GetAllocatedSize() + PositionY.GetAllocatedSize() + PositionZ.GetAllocatedSize() +
+		   LogLuminosity.GetAllocatedSize() + Temperature.GetAllocatedSize() + StarCount.GetAllocatedSize();
+}
+
+FArchive& operator<<(FArchive& Ar, FStarBuffer& Buffer)
+{
+	uint32 Magic = SnapshotMagic;
+	int32 Version = SnapshotVersion;
+	Ar << Magic << Version;
+	if (Magic != SnapshotMagic || Version != SnapshotVersion)
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Buffer.PositionX.BulkSerialize(Ar);
+	Buffer.PositionY.BulkSerialize(Ar);
+	Buffer.PositionZ.BulkSerialize(Ar);
+	Buffer.LogLuminosity.BulkSerialize(Ar);
+	Buffer.Temperature.BulkSerialize(Ar);
+	Buffer.StarCount.BulkSerialize(Ar);
+	return Ar;
+}
+
+bool FStarBuffer::SaveSnapshot(const FString& Filename) const
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogStarGenerator, Error, TEXT("Failed to create star snapshot %s"), *Filename);
+		return false;
+	}
+
+	*Writer << const_cast<FStarBuffer&>(*this);
+	return Writer->Close() && !Writer->IsError();
+}
+
+bool FStarBuffer::LoadSnapshot(const FString& Filename)
+{
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader)
+	{
+		UE_LOG(LogStarGenerator, Error, TEXT("Failed to open star snapshot %s"), *Filename);
+		Empty();
+		return false;
+	}
+
+	*Reader << *this;
+	const int32 NumStars = Num();
+	const bool bConsistent = PositionY.Num() == NumStars && PositionZ.Num() == NumStars && LogLuminosity.Num() == NumStars &&
+							 Temperature.Num() == NumStars && StarCount.Num() == NumStars;
+	if (Reader->IsError() || !bConsistent)
+	{
+		UE_LOG(LogStarGenerator, Error, TEXT("Star snapshot %s is invalid or has an unsupported version"), *Filename);
+		Empty();
+		return false;
+	}
+	return true;
+}
+
+bool FGalaxyStarGenerator::Generate(
+	const UGalaxyShapeSettings& ShapeSettings, const FGalaxyShapeSamplingData& ShapeData, const FStarSamplingData& StarData,
+	const FStarGeneratorSettings& Settings, FStarBuffer& OutBuffer)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousGenerateStars);
+
+	if (!ensureMsgf(ShapeSettings.ThicknessCurve != nullptr, TEXT("Thickness curve not set")))
+	{
+		return false;
+	}
+	if (!ensureMsgf(StarData.SamplingTable.Num() > 0 && StarData.AverageLuminosity > 0.0f, TEXT("Star sampling data not derived")))
+	{
+		return false;
+	}
+	if (!ensureMsgf(
+			!Settings.bQuantizedTables || (StarData.QuantizedSamplingTable.Num() > 0 && ShapeData.QuantizedRadialSamplingTable.Num() > 0),
+			TEXT("Quantized sampling tables not derived")))
+	{
+		return false;
+	}
+	if (!ensureMsgf(Settings.NumParticles >= 0, TEXT("Negative particle count")))
+	{
+		return false;
+	}
+
+	OutBuffer.SetNumUninitialized(Settings.NumParticles);
+
+	const FRichCurve& ThicknessCurve = ShapeSettings.ThicknessCurve->FloatCurve;
+	const bool bQuantizedTables = Settings.bQuantizedTables;
+	const FBox2D& SampleDomain = Settings.SampleDomain;
+	const FVector2D SampleDomainSize = SampleDomain.GetSize();
+	const uint32 Seed = (uint32)Settings.Seed;
+	const ESampleSequence Sequence = Settings.Sequence;
+	auto GetSample = [Sequence, Seed](int32 Index, EDimension Dimension) {
+		return FSampleSequence::GetSample(Sequence, Seed, (uint32)Index, Dimension);
+	};
+	// Fractional luminosity Lf = E(L) * N / M a single particle represents
+	const float FractionalLuminosity =
+		(float)(StarData.AverageLuminosity * Settings.NumGalaxyStars / FMath::Max(Settings.NumParticles, 1));
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(Settings.NumParticles, GenerateChunkSize);
+	auto GenerateChunk = [&](int32 Chunk) {
+		const int32 Begin = Chunk * GenerateChunkSize;
+		const int32 End = FMath::Min(Begin + GenerateChunkSize, Settings.NumParticles);
+		for (int32 i = Begin; i < End; ++i)
+		{
+			const float U = SampleDomain.Min.X + SampleDomainSize.X * GetSample(i, DimensionPositionU);
+			const float V = SampleDomain.Min.Y + SampleDomainSize.Y * GetSample(i, DimensionPositionV);
+			const FVector2D PlanePosition = SamplePlanePosition(ShapeData, U, V, bQuantizedTables);
+
+			// Gaussian vertical profile with the local thickness as standard deviation, Box-Muller transform
+			const float Thickness = FMath::Max(ThicknessCurve.Eval(PlanePosition.Size()), 0.0f);
+			const float Gaussian = FMath::Sqrt(-2.0f * FMath::Loge(1.0f - GetSample(i, DimensionHeight0))) *
+								   FMath::Cos(2.0f * PI * GetSample(i, DimensionHeight1));
+
+			const float ClassSample = GetSample(i, DimensionStarClass);
+			const FLinearColor StarClass = bQuantizedTables
+											   ? StarData.QuantizedSamplingTable.Eval4(StarData.GetSamplingTableCoordinate(ClassSample))
+											   : StarData.EvalSamplingTable(ClassSample);
+			const float Luminosity = FMath::Exp(StarClass.R);
+
+			OutBuffer.PositionX[i] = PlanePosition.X;
+			OutBuffer.PositionY[i] = PlanePosition.Y;
+			OutBuffer.PositionZ[i] = Thickness * Gaussian;
+			OutBuffer.LogLuminosity[i] = StarClass.R;
+			OutBuffer.Temperature[i] = StarClass.G;
+			OutBuffer.StarCount[i] = FMath::Max(FractionalLuminosity / Luminosity, 1.0f);
+		}
+	};
+	ParallelFor(NumChunks, GenerateChunk, Settings.bSingleThreaded);
+
+	return true;
+}
+
+FVector2D FGalaxyStarGenerator::SamplePlanePosition(const FGalaxyShapeSamplingData& ShapeData, float U, float V, bool bQuantizedTables)
+{
+	if (ShapeData.ArmDensitySampler.IsValid())
+	{
+		// Arm density map covers [-1, 1] in X and Y
+		return ShapeData.ArmDensitySampler.Sample(U, V) * 2.0f - FVector2D(1.0f, 1.0f);
+	}
+
+	const float Radius = bQuantizedTables ? ShapeData.QuantizedRadialSamplingTable.Eval(U) : ShapeData.RadialSamplingCurve.Eval(U);
+	float Sin, Cos;
+	FMath::SinCos(&Sin, &Cos, 2.0f * PI * V);
+	return FVector2D(Cos, Sin) * Radius;
+}
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SampleSequence.h"
+
+class UGalaxyShapeSettings;
+struct FGalaxyShapeSamplingData;
+struct FStarSamplingData;
+
+/** Generated stars as a structure of arrays, positions are relative to the galaxy radius. */
+struct GALACTITIOUS_API FStarBuffer
+{
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+
+	/** ln(L) of the star class represented by the particle. */
+	TArray<float> LogLuminosity;
+
+	TArray<float> Temperature;
+
+	/** Number of stars represented by the particle, Np = max(Lf / L, 1) for the fractional luminosity Lf = E(L) * N / M. */
+	TArray<float> StarCount;
+
+	int32 Num() const { return PositionX.Num(); }
+	void SetNumUninitialized(int32 NumStars);
+	void Empty();
+
+	/** Append the stars of another buffer. */
+	void Append(const FStarBuffer& Other);
+	SIZE_T GetAllocatedSize() const;
+
+	FVector GetPosition(int32 Index) const { return FVector(PositionX[Index], PositionY[Index], PositionZ[Index]); }
+
+	/** Write all attributes to a binary snapshot file, so generated stars can be reused without sampling. */
+	bool SaveSnapshot(const FString& Filename) const;
+
+	/** Replace the buffer with a snapshot file written by SaveSnapshot. Leaves the buffer empty on failure. */
+	bool LoadSnapshot(const FString& Filename);
+
+	friend FArchive& operator<<(FArchive& Ar, FStarBuffer& Buffer);
+};
+
+struct FStarGeneratorSettings
+{
+	/** Number of generated particles M. */
+	int32 NumParticles = 100000;
+
+	/** Number of stars N in the galaxy, sets the fractional luminosity of particles. */
+	double NumGalaxyStars = 1.0e10;
+
+	int32 Seed = 0;
+
+	/** Sequence of the uniform numbers that drive the quantile lookups. */
+	ESampleSequence Sequence = ESampleSequence::Random;
+
+	/** Sample the 16-bit quantized tables of the sampling data instead of the float tables and the radial curve. */
+	bool bQuantizedTables = false;
+
+	/**
+	 * Range of the two position samples. A sub-range generates the stars of a region with the probability mass of its area,
+	 * NumParticles and NumGalaxyStars then refer to the region, see FGalaxyStreamer.
+	 */
+	FBox2D SampleDomain = FBox2D(FVector2D(0.0f, 0.0f), FVector2D(1.0f, 1.0f));
+
+	/** Generate on the calling thread only, so background loads do not take task graph workers from the frame. */
+	bool bSingleThreaded = false;
+};
+
+/**
+ * CPU star generator using the same derived sampling data as the particle system.
+ * Particles are generated independently from stateless per-index sample sequences, so the result does not depend on
+ * the number of threads and any index range can be regenerated.
+ */
+class GALACTITIOUS_API FGalaxyStarGenerator
+{
+public:
+	/** Sample sequence dimensions per particle attribute, 2D attributes start at even dimensions. */
+	enum EDimension : uint32
+	{
+		DimensionPositionU,
+		DimensionPositionV,
+		DimensionHeight0,
+		DimensionHeight1,
+		DimensionStarClass,
+		NumDimensions,
+	};
+
+	/**
+	 * Generate particles in parallel. Uses the arm density sampler of the shape sampling data when it is valid,
+	 * otherwise the radial sampling curve. Settings curves are only read, safe to call from any thread.
+	 */
+	static bool Generate(
+		const UGalaxyShapeSettings& ShapeSettings, const FGalaxyShapeSamplingData& ShapeData, const FStarSamplingData& StarData,
+		const FStarGeneratorSettings& Settings, FStarBuffer& OutBuffer);
+
+	/** Position in the galactic plane of the two position samples. */
+	static FVector2D SamplePlanePosition(const FGalaxyShapeSamplingData& ShapeData, float U, float V, bool bQuantizedTables);
+};
@@ -2,9 +2,18 @@
 
 #include "StellarSamplingData.h"
 
+#include "GalactitiousStats.h"
+#include "GalactitiousSubsystem.h"
 #include "GalaxyNiagaraFunctionLibrary.h"
 #include "NiagaraParameterCollection.h"
 #include "ProbabilityCurveFunctionLibrary.h"
+#include "SpectrumFunctionLibrary.h"
+#include "TextureBakerFunctionLibrary.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
+#include "Engine/Texture2D.h"
+#include "Engine/VolumeTexture.h"
 
 namespace
 {
@@ -29,6 +38,37 @@ namespace
 		return true;
 	}
 
+#if WITH_EDITOR
+	/** Star density in the galactic plane from the source texture, or from the gas density field if not set. */
+	bool ReadArmDensity(const UGalaxyShapeSettings& Shape, float InvMaxRadialDensity, FIntPoint& OutSize, TArray<float>& OutDensity)
+	{
+		if (Shape.ArmDensitySourceTexture != nullptr)
+		{
+			return UTextureBakerFunctionLibrary::ReadTextureSourceIntensity(Shape.ArmDensitySourceTexture, OutSize, OutDensity);
+		}
+
+		float MinRadius, MaxRadius;
+		Shape.RadialDensityCurve->FloatCurve.GetTimeRange(MinRadius, MaxRadius);
+
+		// The radial density curve is the distribution of the radius, the surface density is divided by the circumference.
+		// Pixel centers are sampled, the radius is clamped to half a pixel at the center.
+		const int32 Resolution = Shape.ArmDensityMapResolution;
+		const float PixelSize = 2.0f / Resolution;
+		OutSize = FIntPoint(Resolution, Resolution);
+		OutDensity.SetNumUninitialized(Resolution * Resolution);
+		ParallelFor(Resolution, [&](int32 y) {
+			for (int32 x = 0; x < Resolution; ++x)
+			{
+				const FVector Position((x + 0.5f) * PixelSize - 1.0f, (y + 0.5f) * PixelSize - 1.0f, 0.0f);
+				const float RadialDistance = FVector2D(Position.X, Position.Y).Size();
+				const float Density = RadialDistance <= MaxRadius ? Shape.EvalGasDensity(Position, InvMaxRadialDensity) : 0.0f;
+				OutDensity[y * Resolution + x] = Density / FMath::Max(RadialDistance, 0.5f * PixelSize);
+			}
+		});
+		return true;
+	}
+#endif
+
 // Utility macros to perform additional update hacks made necessary due to Niagara bugs
 #define NIAGARA_UPDATE_HACK_BEGIN(_Collection, _UpdatedParameters)                                   \
 	{                                                                                                \
@@ -47,26 +87,33 @@ namespace
 	_Collection->OnChangedDelegate.Broadcast();                          \
 	}
 #else
-#define NIAGARA_UPDATE_HACK_END()                   \
-	/** Push the change to anyone already bound. */ \
-	_Collection->GetDefaultInstance()->GetParameterStore().Tick();  \
+#define NIAGARA_UPDATE_HACK_END(_Collection)                       \
+	/** Push the change to anyone already bound. */                \
+	_Collection->GetDefaultInstance()->GetParameterStore().Tick(); \
 	}
 #endif
 } // namespace
 
 void UStarSettings::UpdateNiagaraParameters()
 {
-	if (!ensureMsgf(NiagaraParameters != nullptr, TEXT("Niagara parameter collection not set")))
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousUpdateStarParameters);
+
+	FStarSamplingData SamplingData;
+	if (ComputeSamplingData(SamplingData))
 	{
-		return;
+		PushNiagaraParameters(SamplingData);
 	}
+}
+
+bool UStarSettings::ComputeSamplingData(FStarSamplingData& OutData) const
+{
 	if (!ensureMsgf(StellarClassesTable != nullptr, TEXT("Stellar classes table is not set")))
 	{
-		return;
+		return false;
 	}
 	if (!ensureMsgf(StellarClassesTable->GetRowMap().Num() > 0, TEXT("Stellar classes table is empty")))
 	{
-		return;
+		return false;
 	}
 
 	// Compute average star luminosity (expectation value): E(L) = sum(Ls_k * P_k)
@@ -93,11 +140,20 @@ void UStarSettings::UpdateNiagaraParameters()
 	// Compute final particle luminosity Lp = Np * Ls
 	// Assign particle luminosity value Lp, star count Np
 
-	// Local mutable copy of stellar classes
-	TArray<FStellarClass> StellarClasses;
-	StellarClasses.Reserve(StellarClassesTable->GetRowMap().Num());
-	StellarClassesTable->ForeachRow<FStellarClass>(
-		"CreateLuminositySampling", [&StellarClasses](const FName& Key, const FStellarClass& Value) { StellarClasses.Add(Value); });
+	if (!ensureMsgf(
+			StellarClassesTable->GetRowStruct() && StellarClassesTable->GetRowStruct()->IsChildOf(FStellarClass::StaticStruct()),
+			TEXT("Stellar classes table has the wrong row type")))
+	{
+		return false;
+	}
+
+	// Mutable copy of stellar classes, rows are read directly to avoid the allocating ForeachRow context string
+	TArray<FStellarClass>& StellarClasses = OutData.SortedStellarClasses;
+	StellarClasses.Reset(StellarClassesTable->GetRowMap().Num());
+	for (const TPair<FName, uint8*>& Row : StellarClassesTable->GetRowMap())
+	{
+		StellarClasses.Add(*reinterpret_cast<const FStellarClass*>(Row.Value));
+	}
 
 	// Sort by luminosity in increasing order
 	StellarClasses.Sort(
@@ -106,7 +162,7 @@ void UStarSettings::UpdateNiagaraParameters()
 	// Normalize to ensure fractions add up to 1
 	if (!NormalizeFractions(StellarClasses))
 	{
-		return;
+		return false;
 	}
 
 	// XXX Arbitrary: double min. luminosity of the last class as max. luminosity
@@ -115,7 +171,7 @@ void UStarSettings::UpdateNiagaraParameters()
 	const float MaxTemperature = StellarClasses.Last().MinTemperature;
 
 	// Average luminosity of i-th class
-	auto AverageClassLuminosity = [StellarClasses, MaxLuminosity](int32 i) -> float {
+	auto AverageClassLuminosity = [&StellarClasses, MaxLuminosity](int32 i) -> float {
 		const float MinClassLuminosity = StellarClasses[i].MinLuminosity;
 		const float MaxClassLuminosity = i < StellarClasses.Num() - 1 ? StellarClasses[i + 1].MinLuminosity : MaxLuminosity;
 		return 0.5f * (MinClassLuminosity + MaxClassLuminosity) * StellarClasses[i].Fraction;
@@ -127,11 +183,11 @@ void UStarSettings::UpdateNiagaraParameters()
 		AverageLuminosity += AverageClassLuminosity(i);
 	}
 
-	// Stores logarithmic Luminosity ln(L) for more sensible values.
-	// Luminosity varies by many orders of magnitude.
-	FRichCurve LogLuminositySamplingCurve;
-	// Temperature of stars
-	FRichCurve TemperatureSamplingCurve;
+	FRichCurve& LogLuminositySamplingCurve = OutData.LogLuminositySamplingCurve;
+	FRichCurve& TemperatureSamplingCurve = OutData.TemperatureSamplingCurve;
+	// Keys are appended in increasing time order, written directly to avoid per-key allocations of FRichCurve::AddKey
+	LogLuminositySamplingCurve.Keys.Reset(StellarClasses.Num() + 1);
+	TemperatureSamplingCurve.Keys.Reset(StellarClasses.Num() + 1);
 	float TotalProbability = 0.0f;
 	for (int32 i = 0; i < StellarClasses.Num(); ++i)
 	{
@@ -142,11 +198,8 @@ void UStarSettings::UpdateNiagaraParameters()
 		const float Luminosity = StellarClass.MinLuminosity;
 		const float Probability = StellarClass.Fraction * Luminosity / AverageLuminosity;
 
-		FKeyHandle Handle;
-		Handle = LogLuminositySamplingCurve.AddKey(TotalProbability, FMath::Loge(Luminosity));
-		LogLuminositySamplingCurve.SetKeyInterpMode(Handle, RCIM_Linear);
-		Handle = TemperatureSamplingCurve.AddKey(TotalProbability, StellarClass.MinTemperature);
-		TemperatureSamplingCurve.SetKeyInterpMode(Handle, RCIM_Linear);
+		LogLuminositySamplingCurve.Keys.Emplace(TotalProbability, FMath::Loge(Luminosity), 0.0f, 0.0f, RCIM_Linear);
+		TemperatureSamplingCurve.Keys.Emplace(TotalProbability, StellarClass.MinTemperature, 0.0f, 0.0f, RCIM_Linear);
 
 		TotalProbability += Probability;
 	}
@@ -154,11 +207,8 @@ void UStarSettings::UpdateNiagaraParameters()
 	{
 		const float Luminosity = MaxLuminosity;
 
-		FKeyHandle Handle;
-		Handle = LogLuminositySamplingCurve.AddKey(TotalProbability, FMath::Loge(Luminosity));
-		LogLuminositySamplingCurve.SetKeyInterpMode(Handle, RCIM_Linear);
-		Handle = TemperatureSamplingCurve.AddKey(TotalProbability, MaxTemperature);
-		TemperatureSamplingCurve.SetKeyInterpMode(Handle, RCIM_Linear);
+		LogLuminositySamplingCurve.Keys.Emplace(TotalProbability, FMath::Loge(Luminosity), 0.0f, 0.0f, RCIM_Linear);
+		TemperatureSamplingCurve.Keys.Emplace(TotalProbability, MaxTemperature, 0.0f, 0.0f, RCIM_Linear);
 	}
 	// Normalize probability
 	if (!FMath::IsNearlyZero(TotalProbability))
@@ -177,22 +227,400 @@ void UStarSettings::UpdateNiagaraParameters()
 		}
 	}
 
+	// Fused table of all class attributes, linear between class keys like the separate curves.
+	// Mass and radius of the most luminous class are constant, like its temperature.
+	const TArray<FRichCurveKey>& ClassKeys = LogLuminositySamplingCurve.Keys;
+	auto ClassAttributes = [&](int32 KeyIndex) -> FLinearColor {
+		const FStellarClass& StellarClass = StellarClasses[FMath::Min(KeyIndex, StellarClasses.Num() - 1)];
+		return FLinearColor(
+			ClassKeys[KeyIndex].Value, TemperatureSamplingCurve.Keys[KeyIndex].Value, StellarClass.MinMass, StellarClass.MinRadius);
+	};
+
+	// Every class spans a whole number of entries, at least one, so class boundaries lie exactly on entries and no class is lost
+	// however small its probability. Entries are distributed by probability, the largest class absorbs the rounding.
+	const int32 NumClasses = StellarClasses.Num();
+	const int32 NumIntervals = FStarSamplingData::SamplingTableSize - 1;
+	if (!ensureMsgf(NumClasses <= NumIntervals / 2, TEXT("Too many stellar classes for the sampling table")))
+	{
+		return false;
+	}
+	TArray<float>& ClassQuantiles = OutData.SamplingTableQuantiles;
+	TArray<float>& ClassCoordinates = OutData.SamplingTableCoordinates;
+	ClassQuantiles.SetNumUninitialized(NumClasses + 1);
+	ClassCoordinates.SetNumUninitialized(NumClasses + 1);
+	int32 NumEntries = 0;
+	int32 LargestClass = 0;
+	for (int32 i = 0; i < NumClasses; ++i)
+	{
+		// Interval counts are stored in the coordinates until they are accumulated
+		const float Probability = ClassKeys[i + 1].Time - ClassKeys[i].Time;
+		ClassCoordinates[i] = (float)FMath::Max(FMath::RoundToInt(Probability * NumIntervals), 1);
+		NumEntries += (int32)ClassCoordinates[i];
+		LargestClass = ClassCoordinates[i] > ClassCoordinates[LargestClass] ? i : LargestClass;
+	}
+	ClassCoordinates[LargestClass] -= (float)(NumEntries - NumIntervals);
+	if (!ensureMsgf(ClassCoordinates[LargestClass] >= 1.0f, TEXT("Too many improbable stellar classes for the sampling table")))
+	{
+		return false;
+	}
+
+	TArray<FLinearColor>& SamplingTable = OutData.SamplingTable;
+	SamplingTable.SetNumUninitialized(FStarSamplingData::SamplingTableSize);
+	int32 FirstEntry = 0;
+	for (int32 i = 0; i < NumClasses; ++i)
+	{
+		const int32 NumClassEntries = (int32)ClassCoordinates[i];
+		for (int32 j = 0; j < NumClassEntries; ++j)
+		{
+			SamplingTable[FirstEntry + j] = FMath::Lerp(ClassAttributes(i), ClassAttributes(i + 1), (float)j / NumClassEntries);
+		}
+		ClassQuantiles[i] = ClassKeys[i].Time;
+		ClassCoordinates[i] = (float)FirstEntry / NumIntervals;
+		FirstEntry += NumClassEntries;
+	}
+	SamplingTable[NumIntervals] = ClassAttributes(NumClasses);
+	ClassQuantiles[NumClasses] = ClassKeys[NumClasses].Time;
+	ClassCoordinates[NumClasses] = 1.0f;
+
+	OutData.QuantileSamplingTable.SetNumUninitialized(FStarSamplingData::SamplingTableSize);
+	for (int32 i = 0; i <= NumIntervals; ++i)
+	{
+		OutData.QuantileSamplingTable[i] = OutData.EvalSamplingTable((float)i / NumIntervals);
+	}
+
+	OutData.QuantizedSamplingTable.Encode(
+		TArrayView<const float>((const float*)SamplingTable.GetData(), SamplingTable.Num() * 4), 4, EQuantizedTableFormat::UNorm16, true);
+
+	OutData.AverageLuminosity = AverageLuminosity;
+	return true;
+}
+
+void UStarSettings::PushNiagaraParameters(const FStarSamplingData& SamplingData)
+{
+	if (!ensureMsgf(NiagaraParameters != nullptr, TEXT("Niagara parameter collection not set")))
+	{
+		return;
+	}
+
+	SET_MEMORY_STAT(
+		STAT_GalactitiousStellarSamplingMemory, SamplingData.LogLuminositySamplingCurve.Keys.GetAllocatedSize() +
+													SamplingData.TemperatureSamplingCurve.Keys.GetAllocatedSize() +
+													SamplingData.SamplingTable.GetAllocatedSize() +
+													SamplingData.QuantileSamplingTable.GetAllocatedSize() +
+													SamplingData.SamplingTableQuantiles.GetAllocatedSize() +
+													SamplingData.SamplingTableCoordinates.GetAllocatedSize() +
+													SamplingData.QuantizedSamplingTable.GetAllocatedSize());
+
+	// GPU lookups are directly at the quantile
+	const TArray<FLinearColor>& GpuSamplingTable = SamplingData.QuantileSamplingTable;
+	if (GpuSamplingTable.Num() > 0)
+	{
+		SamplingTableTexture = UTextureBakerFunctionLibrary::UpdateTransientTextureRegions(
+			SamplingTableTexture, GpuSamplingTable.Num(), 1, PF_A32B32G32R32F, GpuSamplingTable.GetData(), SamplingTableStaging);
+	}
+
 	NIAGARA_UPDATE_HACK_BEGIN(NiagaraParameters->Collection, UpdatedParameters)
 	const bool bOverride = false;
 	UGalaxyNiagaraFunctionLibrary::SetCurveParameter(
-		UpdatedParameters, TEXT("LuminositySamplingCurve"), LogLuminositySamplingCurve, bOverride);
-	UGalaxyNiagaraFunctionLibrary::SetFloatParameter(UpdatedParameters, TEXT("AverageLuminosity"), AverageLuminosity, bOverride);
+		UpdatedParameters, TEXT("LuminositySamplingCurve"), SamplingData.LogLuminositySamplingCurve, bOverride);
+	UGalaxyNiagaraFunctionLibrary::SetFloatParameter(
+		UpdatedParameters, TEXT("AverageLuminosity"), SamplingData.AverageLuminosity, bOverride);
 	UGalaxyNiagaraFunctionLibrary::SetCurveParameter(
-		UpdatedParameters, TEXT("TemperatureSamplingCurve"), TemperatureSamplingCurve, bOverride);
+		UpdatedParameters, TEXT("TemperatureSamplingCurve"), SamplingData.TemperatureSamplingCurve, bOverride);
+	UGalaxyNiagaraFunctionLibrary::SetTextureParameter(UpdatedParameters, TEXT("StarSamplingTable"), SamplingTableTexture, bOverride);
+	UGalaxyNiagaraFunctionLibrary::SetLookupTableParameter(
+		UpdatedParameters, TEXT("StarSamplingLookupTable"),
+		TArrayView<const float>((const float*)GpuSamplingTable.GetData(), GpuSamplingTable.Num() * 4), 4, 0.0f, 1.0f, bOverride);
+	if (BlackbodyColorTexture != nullptr)
+	{
+		UGalaxyNiagaraFunctionLibrary::SetTextureParameter(
+			UpdatedParameters, TEXT("BlackbodyColorTexture"), BlackbodyColorTexture, bOverride);
+		UGalaxyNiagaraFunctionLibrary::SetFloatParameter(
+			UpdatedParameters, TEXT("BlackbodyMinTemperature"), BlackbodyMinTemperature, bOverride);
+		UGalaxyNiagaraFunctionLibrary::SetFloatParameter(
+			UpdatedParameters, TEXT("BlackbodyMaxTemperature"), BlackbodyMaxTemperature, bOverride);
+	}
 	NIAGARA_UPDATE_HACK_END(NiagaraParameters->Collection)
 }
 
+bool UStarSettings::GetTemperatureRange(float& OutMinTemperature, float& OutMaxTemperature) const
+{
+	if (StellarClassesTable == nullptr || StellarClassesTable->GetRowMap().Num() == 0)
+	{
+		return false;
+	}
+
+	if (!ensureMsgf(
+			StellarClassesTable->GetRowStruct() && StellarClassesTable->GetRowStruct()->IsChildOf(FStellarClass::StaticStruct()),
+			TEXT("Stellar classes table has the wrong row type")))
+	{
+		return false;
+	}
+
+	OutMinTemperature = MAX_flt;
+	OutMaxTemperature = 0.0f;
+	for (const TPair<FName, uint8*>& Row : StellarClassesTable->GetRowMap())
+	{
+		const FStellarClass& StellarClass = *reinterpret_cast<const FStellarClass*>(Row.Value);
+		OutMinTemperature = FMath::Min(OutMinTemperature, StellarClass.MinTemperature);
+		OutMaxTemperature = FMath::Max(OutMaxTemperature, StellarClass.MinTemperature);
+	}
+	return OutMinTemperature > 0.0f;
+}
+
+#if WITH_EDITOR
+TSharedPtr<FTextureBakeJob, ESPMode::ThreadSafe> UStarSettings::CreateBakeJob()
+{
+	float MinTemperature, MaxTemperature;
+	if (!ensureMsgf(
+			GetTemperatureRange(MinTemperature, MaxTemperature), TEXT("Stellar classes table is not set or has invalid temperatures")))
+	{
+		return nullptr;
+	}
+	// Keep a valid range for tables with a single temperature
+	MaxTemperature = FMath::Max(MaxTemperature, MinTemperature * 1.01f);
+
+	const FString TexturePath =
+		BlackbodyColorTexture ? BlackbodyColorTexture->GetPathName() : GetOutermost()->GetName() + TEXT("_BlackbodyColor");
+	const float LogMinTemperature = FMath::Loge(MinTemperature);
+	const float LogTemperatureRange = FMath::Loge(MaxTemperature) - LogMinTemperature;
+
+	// Each texel integrates a full spectrum, tiles are baked on workers
+	TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Job = UTextureBakerFunctionLibrary::CreateTextureAssetBakeJobRGBA16F(
+		TexturePath, 1024, 1, PF_FloatRGBA, TMGS_NoMipmaps, [LogMinTemperature, LogTemperatureRange](float X, float Y) {
+			const float Temperature = FMath::Exp(LogMinTemperature + X * LogTemperatureRange);
+			return USpectrumFunctionLibrary::BlackbodyColor(Temperature);
+		});
+	Job->Name = FName(*TexturePath);
+
+	// The temperature range is only updated together with the texture it describes
+	Job->OnCompleted.BindWeakLambda(this, [this, MinTemperature, MaxTemperature](UTexture2D* Texture) {
+		BlackbodyColorTexture = Texture;
+		BlackbodyMinTemperature = MinTemperature;
+		BlackbodyMaxTemperature = MaxTemperature;
+		MarkPackageDirty();
+	});
+	return Job;
+}
+
+void UStarSettings::BakeTextures()
+{
+	if (TSharedPtr<FTextureBakeJob, ESPMode::ThreadSafe> Job = CreateBakeJob())
+	{
+		Job->StartWorkers();
+		GEngine->GetEngineSubsystem<UGalactitiousSubsystem>()->AddBakeJob(Job.ToSharedRef());
+	}
+}
+#endif
+
+float FStarSamplingData::GetSamplingTableCoordinate(float Quantile) const
+{
+	const int32 NumClasses = SamplingTableQuantiles.Num() - 1;
+	if (NumClasses < 1)
+	{
+		return FMath::Clamp(Quantile, 0.0f, 1.0f);
+	}
+
+	// Classes without probability have equal bounds and are skipped by the search
+	const int32 ClassIndex = FMath::Clamp(Algo::UpperBound(SamplingTableQuantiles, Quantile) - 1, 0, NumClasses - 1);
+	const float Quantile0 = SamplingTableQuantiles[ClassIndex];
+	const float Quantile1 = SamplingTableQuantiles[ClassIndex + 1];
+	const float Alpha = Quantile1 > Quantile0 ? FMath::Clamp((Quantile - Quantile0) / (Quantile1 - Quantile0), 0.0f, 1.0f) : 0.0f;
+	return FMath::Lerp(SamplingTableCoordinates[ClassIndex], SamplingTableCoordinates[ClassIndex + 1], Alpha);
+}
+
+FLinearColor FStarSamplingData::EvalSamplingTable(float Quantile) const
+{
+	if (SamplingTable.Num() == 0)
+	{
+		return FLinearColor::Transparent;
+	}
+
+	const float X = GetSamplingTableCoordinate(Quantile) * (SamplingTable.Num() - 1);
+	const int32 Index = FMath::Min((int32)X, SamplingTable.Num() - 2);
+	if (Index < 0)
+	{
+		return SamplingTable[0];
+	}
+	return FMath::Lerp(SamplingTable[Index], SamplingTable[Index + 1], X - Index);
+}
+
 void UGalaxyShapeSettings::UpdateNiagaraParameters()
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousUpdateGalaxyShapeParameters);
+
+	FGalaxyShapeSamplingData SamplingData;
+	if (ComputeSamplingData(SamplingData))
+	{
+		PushNiagaraParameters(SamplingData);
+	}
+}
+
+bool UGalaxyShapeSettings::ComputeSamplingData(FGalaxyShapeSamplingData& OutData) const
+{
+	if (!ensureMsgf(RadialDensityCurve != nullptr, TEXT("Radial density curve not set")))
+	{
+		return false;
+	}
+
+	UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurveNoAlloc(
+		RadialDensityCurve->FloatCurve, OutData.RadialDensityNormalizedCurve, OutData.RadialSamplingCurve, OutData.QuantileScratch);
+
+	const int32 TableSize = FGalaxyShapeSamplingData::RadialSamplingTableSize;
+	OutData.RadialSamplingTable.SetNumUninitialized(TableSize);
+	for (int32 i = 0; i < TableSize; ++i)
+	{
+		OutData.RadialSamplingTable[i] = OutData.RadialSamplingCurve.Eval((float)i / (TableSize - 1));
+	}
+	OutData.QuantizedRadialSamplingTable.Encode(OutData.RadialSamplingTable, 1, EQuantizedTableFormat::UNorm16, true);
+
+	// Arm density sampling tables are only derived when used
+	OutData.ArmDensitySampler.Reset();
+	OutData.ArmSamplingTable.Reset();
+	if (PositionSampling == EStarPositionSampling::ArmDensityMap)
+	{
+		const int32 NumPixels = ArmDensityMapSize.X * ArmDensityMapSize.Y;
+		if (!ensureMsgf(NumPixels > 0 && ArmDensityMap.Num() == NumPixels, TEXT("Arm density map is not baked")))
+		{
+			return false;
+		}
+
+		TArray<float>& Density = OutData.ArmDensityScratch;
+		Density.SetNumUninitialized(NumPixels);
+		for (int32 i = 0; i < NumPixels; ++i)
+		{
+			Density[i] = ArmDensityMap[i];
+		}
+		if (!ensureMsgf(
+				OutData.ArmDensitySampler.Build(ArmDensityMapSize.X, ArmDensityMapSize.Y, Density), TEXT("Arm density map is empty")))
+		{
+			return false;
+		}
+		OutData.ArmDensitySampler.BuildQuantileTable(FGalaxyShapeSamplingData::ArmSamplingTableWidth, OutData.ArmSamplingTable);
+	}
+	return true;
+}
+
+float UGalaxyShapeSettings::GetMaxRadialDensity() const
+{
+	if (RadialDensityCurve == nullptr)
+	{
+		return 0.0f;
+	}
+
+	float MinTime, MaxTime;
+	RadialDensityCurve->FloatCurve.GetTimeRange(MinTime, MaxTime);
+	float MaxDensity = 0.0f;
+	const int32 NumSamples = 256;
+	for (int32 i = 0; i < NumSamples; ++i)
+	{
+		const float Time = FMath::Lerp(MinTime, MaxTime, (float)i / (NumSamples - 1));
+		MaxDensity = FMath::Max(MaxDensity, RadialDensityCurve->FloatCurve.Eval(Time));
+	}
+	return MaxDensity;
+}
+
+float UGalaxyShapeSettings::EvalGasDensity(const FVector& Position, float InvMaxRadialDensity) const
+{
+	if (RadialDensityCurve == nullptr || ThicknessCurve == nullptr)
+	{
+		return 0.0f;
+	}
+
+	const float RadialDistance = FVector2D(Position.X, Position.Y).Size();
+	const float RadialDensity = FMath::Max(RadialDensityCurve->FloatCurve.Eval(RadialDistance), 0.0f) * InvMaxRadialDensity;
+
+	const float Thickness = ThicknessCurve->FloatCurve.Eval(RadialDistance);
+	const float VerticalDensity = Thickness > 0.0f ? FMath::Exp(-0.5f * FMath::Square(Position.Z / Thickness)) : 0.0f;
+
+	// Two arms along Archimedean spirals, density contrast from the orbit perturbation
+	const float Angle = FMath::Atan2(Position.Y, Position.X);
+	const float ArmPhase = 2.0f * (Angle - 2.0f * PI * WindingFrequency * RadialDistance);
+	const float ArmDensity = (1.0f + Perturbation * FMath::Cos(ArmPhase)) / (1.0f + FMath::Abs(Perturbation));
+
+	return FMath::Clamp(RadialDensity * VerticalDensity * ArmDensity, 0.0f, 1.0f);
+}
+
+#if WITH_EDITOR
+void UGalaxyShapeSettings::BakeTextures()
+{
+	if (!ensureMsgf(RadialDensityCurve != nullptr && ThicknessCurve != nullptr, TEXT("Radial density or thickness curve not set")))
+	{
+		return;
+	}
+	const float MaxRadialDensity = GetMaxRadialDensity();
+	if (!ensureMsgf(MaxRadialDensity > 0.0f, TEXT("Radial density curve is zero")))
+	{
+		return;
+	}
+
+	// Property clamps do not apply to vector components
+	const FIntVector Resolution(
+		FMath::Clamp(GasVolumeResolution.X, 1, 1024), FMath::Clamp(GasVolumeResolution.Y, 1, 1024),
+		FMath::Clamp(GasVolumeResolution.Z, 1, 1024));
+	ensureMsgf(
+		Resolution == GasVolumeResolution, TEXT("Gas volume resolution %s out of range [1, 1024], clamped"),
+		*GasVolumeResolution.ToString());
+
+	const FString TexturePath = GasVolumeTexture ? GasVolumeTexture->GetPathName() : GetOutermost()->GetName() + TEXT("_GasVolume");
+	const float InvMaxRadialDensity = 1.0f / MaxRadialDensity;
+
+	GasVolumeTexture = UTextureBakerFunctionLibrary::BakeVolumeTextureAsset<uint8>(
+		TexturePath, Resolution.X, Resolution.Y, Resolution.Z, TSF_G8, TMGS_FromTextureGroup,
+		[this, InvMaxRadialDensity](float X, float Y, float Z) -> uint8 {
+			const FVector Position(2.0f * X - 1.0f, 2.0f * Y - 1.0f, (2.0f * Z - 1.0f) * GasVolumeHeight);
+			return (uint8)FMath::RoundToInt(EvalGasDensity(Position, InvMaxRadialDensity) * 255.0f);
+		});
+
+	// Arm density map for importance sampling of star positions, stored in the asset for runtime derivation
+	FIntPoint Size;
+	TArray<float> Density;
+	if (ReadArmDensity(*this, InvMaxRadialDensity, Size, Density))
+	{
+		float MaxDensity = 0.0f;
+		for (const float Value : Density)
+		{
+			MaxDensity = FMath::Max(MaxDensity, Value);
+		}
+		const float Scale = MaxDensity > 0.0f ? 65535.0f / MaxDensity : 0.0f;
+
+		ArmDensityMap.SetNumUninitialized(Density.Num());
+		for (int32 i = 0; i < Density.Num(); ++i)
+		{
+			ArmDensityMap[i] = (uint16)FMath::Clamp(FMath::RoundToInt(Density[i] * Scale), 0, 65535);
+		}
+		ArmDensityMapSize = Size;
+	}
+
+	MarkPackageDirty();
+}
+#endif
+
+void UGalaxyShapeSettings::PushNiagaraParameters(const FGalaxyShapeSamplingData& SamplingData)
 {
 	if (!ensureMsgf(NiagaraParameters != nullptr, TEXT("Niagara parameter collection not set")))
 	{
 		return;
 	}
+	if (!ensureMsgf(ThicknessCurve != nullptr, TEXT("Thickness curve not set")))
+	{
+		return;
+	}
+
+	SET_MEMORY_STAT(
+		STAT_GalactitiousRadialSamplingMemory,
+		SamplingData.RadialDensityNormalizedCurve.Keys.GetAllocatedSize() + SamplingData.RadialSamplingCurve.Keys.GetAllocatedSize() +
+			SamplingData.RadialSamplingTable.GetAllocatedSize() + SamplingData.QuantizedRadialSamplingTable.GetAllocatedSize() +
+			SamplingData.ArmDensitySampler.MarginalCdf.GetAllocatedSize() +
+			SamplingData.ArmDensitySampler.ConditionalCdf.GetAllocatedSize() + SamplingData.ArmSamplingTable.GetAllocatedSize());
+
+	const bool bArmSampling = SamplingData.ArmSamplingTable.Num() > 0;
+	if (bArmSampling)
+	{
+		ArmSamplingTableTexture = UTextureBakerFunctionLibrary::UpdateTransientTextureRegions(
+			ArmSamplingTableTexture, FGalaxyShapeSamplingData::ArmSamplingTableWidth, SamplingData.ArmDensitySampler.Height + 1,
+			PF_R32_FLOAT, SamplingData.ArmSamplingTable.GetData(), ArmSamplingTableStaging, TF_Nearest);
+	}
 
 	NIAGARA_UPDATE_HACK_BEGIN(NiagaraParameters->Collection, UpdatedParameters)
 	const bool bOverride = false;
@@ -201,12 +629,19 @@ void UGalaxyShapeSettings::UpdateNiagaraParameters()
 	UGalaxyNiagaraFunctionLibrary::SetFloatParameter(UpdatedParameters, TEXT("Perturbation"), Perturbation, bOverride);
 	UGalaxyNiagaraFunctionLibrary::SetFloatParameter(UpdatedParameters, TEXT("WindingFrequency"), WindingFrequency, bOverride);
 	UGalaxyNiagaraFunctionLibrary::SetCurveParameter(UpdatedParameters, TEXT("ThicknessCurve"), ThicknessCurve->FloatCurve, bOverride);
-
-	FRichCurve RadialDensityNormalizedCurve, RadialSamplingCurve;
-	UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurve(
-		RadialDensityCurve->FloatCurve, RadialDensityNormalizedCurve, RadialSamplingCurve);
 	UGalaxyNiagaraFunctionLibrary::SetCurveParameter(
-		UpdatedParameters, TEXT("RadialDensityCurve"), RadialDensityNormalizedCurve, bOverride);
-	UGalaxyNiagaraFunctionLibrary::SetCurveParameter(UpdatedParameters, TEXT("RadialSamplingCurve"), RadialSamplingCurve, bOverride);
+		UpdatedParameters, TEXT("RadialDensityCurve"), SamplingData.RadialDensityNormalizedCurve, bOverride);
+	UGalaxyNiagaraFunctionLibrary::SetCurveParameter(
+		UpdatedParameters, TEXT("RadialSamplingCurve"), SamplingData.RadialSamplingCurve, bOverride);
+	UGalaxyNiagaraFunctionLibrary::SetLookupTableParameter(
+		UpdatedParameters, TEXT("RadialSamplingTable"), SamplingData.RadialSamplingTable, 1, 0.0f, 1.0f, bOverride);
+	UGalaxyNiagaraFunctionLibrary::SetFloatParameter(
+		UpdatedParameters, TEXT("ArmDensitySampling"), bArmSampling ? 1.0f : 0.0f, bOverride);
+	if (bArmSampling)
+	{
+		UGalaxyNiagaraFunctionLibrary::SetTextureParameter(UpdatedParameters, TEXT("ArmSamplingTable"), ArmSamplingTableTexture, bOverride);
+		UGalaxyNiagaraFunctionLibrary::SetFloatParameter(
+			UpdatedParameters, TEXT("ArmSamplingTableHeight"), SamplingData.ArmDensitySampler.Height, bOverride);
+	}
 	NIAGARA_UPDATE_HACK_END(NiagaraParameters->Collection)
 }
@@ -5,6 +5,11 @@
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h"
 #include "Engine/DataTable.h"
+#include "Curves/RichCurve.h"
+#include "DensityImageSampler.h"
+#include "ProbabilityCurveFunctionLibrary.h"
+#include "QuantizedTable.h"
+#include "TextureBakerFunctionLibrary.h"
 
 #include "StellarSamplingData.generated.h"
 
@@ -29,14 +34,145 @@ struct GALACTITIOUS_API FStellarClass : public FTableRowBase
 	float Fraction = 0.0f;
 };
 
+UENUM()
+enum class EStarPositionSampling : uint8
+{
+	/** Radius from the radial sampling curve and a uniform angle, arms only come from the orbit perturbation. */
+	Radial,
+	/** Position in the galactic plane importance sampled from the arm density map. */
+	ArmDensityMap,
+};
+
+/** Sampling curves derived from galaxy shape settings. */
+USTRUCT()
+struct GALACTITIOUS_API FGalaxyShapeSamplingData
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FRichCurve RadialDensityNormalizedCurve;
+
+	UPROPERTY()
+	FRichCurve RadialSamplingCurve;
+
+	static constexpr int32 RadialSamplingTableSize = 256;
+
+	/** Radial sampling curve resampled uniformly on the quantile axis [0, 1], pushed as a lookup table. */
+	UPROPERTY()
+	TArray<float> RadialSamplingTable;
+
+	/** Radial sampling table quantized to 16 bits with delta encoding, for CPU sampling. */
+	UPROPERTY()
+	FQuantizedTable QuantizedRadialSamplingTable;
+
+	/** Intermediate curves, kept to avoid allocations when deriving repeatedly. */
+	FQuantileCurveScratch QuantileScratch;
+
+	static constexpr int32 ArmSamplingTableWidth = 1024;
+
+	/** Importance sampler of the arm density map, only valid for EStarPositionSampling::ArmDensityMap. */
+	FDensityImageSampler ArmDensitySampler;
+
+	/** Quantile table of the arm density sampler with ArmSamplingTableWidth columns, see FDensityImageSampler::BuildQuantileTable. */
+	UPROPERTY()
+	TArray<float> ArmSamplingTable;
+
+	/** Arm density map converted to float, kept to avoid allocations when deriving repeatedly. */
+	TArray<float> ArmDensityScratch;
+};
+
+/** Sampling curves derived from the stellar classes table. */
+USTRUCT()
+struct GALACTITIOUS_API FStarSamplingData
+{
+	GENERATED_BODY()
+
+	// Stores logarithmic Luminosity ln(L) for more sensible values.
+	// Luminosity varies by many orders of magnitude.
+	UPROPERTY()
+	FRichCurve LogLuminositySamplingCurve;
+
+	// Temperature of stars
+	UPROPERTY()
+	FRichCurve TemperatureSamplingCurve;
+
+	UPROPERTY()
+	float AverageLuminosity = 0.0f;
+
+	static constexpr int32 SamplingTableSize = 1024;
+
+	/**
+	 * Fused sampling table, each entry holds (ln(L), temperature, mass, radius) in (R, G, B, A), so one lookup yields all
+	 * class attributes. Every class spans a whole number of entries, at least one, with class boundaries exactly on entries.
+	 * Only valid for lookups at GetSamplingTableCoordinate, GPU lookups directly at the quantile use QuantileSamplingTable.
+	 */
+	UPROPERTY()
+	TArray<FLinearColor> SamplingTable;
+
+	/**
+	 * Fused sampling table resampled uniformly on the quantile axis, entry i holds EvalSamplingTable(i / (SamplingTableSize - 1)).
+	 * Pushed as the StarSamplingTable texture and lookup table, which are sampled directly at the quantile. Class boundaries
+	 * are blended over one entry and classes less probable than one entry are attenuated.
+	 */
+	UPROPERTY()
+	TArray<FLinearColor> QuantileSamplingTable;
+
+	/** Exact cumulative class probabilities, the quantiles of the class boundaries. */
+	UPROPERTY()
+	TArray<float> SamplingTableQuantiles;
+
+	/** Table coordinates in [0, 1] of the class boundaries, entry i is located at i / (SamplingTableSize - 1). */
+	UPROPERTY()
+	TArray<float> SamplingTableCoordinates;
+
+	/** Fused sampling table quantized to 16 bits with delta encoding, for CPU sampling at GetSamplingTableCoordinate. */
+	UPROPERTY()
+	FQuantizedTable QuantizedSamplingTable;
+
+	/** Map a quantile to the sampling table coordinate through the exact class probabilities. */
+	float GetSamplingTableCoordinate(float Quantile) const;
+
+	/** Linearly interpolated lookup of the fused sampling table at the coordinate of a quantile. */
+	FLinearColor EvalSamplingTable(float Quantile) const;
+
+	/** Stellar classes sorted by luminosity, kept to avoid allocations when deriving repeatedly. */
+	TArray<FStellarClass> SortedStellarClasses;
+};
+
 UCLASS(BlueprintType)
 class GALACTITIOUS_API UGalaxyShapeSettings : public UDataAsset
 {
 	GENERATED_BODY()
 
+public:
 	UFUNCTION(BlueprintCallable, CallInEditor)
 	void UpdateNiagaraParameters();
 
+	/**
+	 * Derive sampling curves. Does not modify the asset and may run on any thread.
+	 * Reuses the storage of OutData, repeated derivation into the same data does not allocate.
+	 */
+	bool ComputeSamplingData(FGalaxyShapeSamplingData& OutData) const;
+
+	/** Push settings and previously derived sampling curves to the Niagara parameter collection. Game thread only. */
+	void PushNiagaraParameters(const FGalaxyShapeSamplingData& SamplingData);
+
+	/** Maximum of the radial density curve, normalizes gas densities. */
+	float GetMaxRadialDensity() const;
+
+	/**
+	 * Gas and dust density at a position relative to the galaxy radius, in [0, 1] for InvMaxRadialDensity = 1 / GetMaxRadialDensity().
+	 * Radial density and a Gaussian vertical profile of the local thickness are modulated by two spiral arms
+	 * winding with WindingFrequency, with arm contrast Perturbation. Curves are only read, safe to call from any thread.
+	 */
+	float EvalGasDensity(const FVector& Position, float InvMaxRadialDensity) const;
+
+#if WITH_EDITOR
+	/** Bake the gas volume texture from the density field and the arm density map. */
+	UFUNCTION(BlueprintCallable, CallInEditor)
+	void BakeTextures();
+#endif
+
 	UPROPERTY(EditAnywhere)
 	class UNiagaraParameterCollectionInstance* NiagaraParameters;
 
@@ -57,6 +193,52 @@ class GALACTITIOUS_API UGalaxyShapeSettings : public UDataAsset
 
 	UPROPERTY(EditAnywhere)
 	UCurveFloat* ThicknessCurve;
+
+	UPROPERTY(EditAnywhere)
+	EStarPositionSampling PositionSampling = EStarPositionSampling::Radial;
+
+	/**
+	 * Source of the arm density map, e.g. a cloud texture or a painted arm map covering [-Radius, Radius] in X and Y.
+	 * If not set, BakeTextures bakes the arm density of the gas density field in the galactic plane.
+	 */
+	UPROPERTY(EditAnywhere)
+	UTexture2D* ArmDensitySourceTexture;
+
+	/** Resolution of the arm density map baked from the gas density field. */
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "16", ClampMax = "4096"))
+	int32 ArmDensityMapResolution = 256;
+
+	/** Star density in the galactic plane baked by BakeTextures, row-major and normalized to the maximum. */
+	UPROPERTY()
+	TArray<uint16> ArmDensityMap;
+
+	UPROPERTY(VisibleAnywhere)
+	FIntPoint ArmDensityMapSize = FIntPoint::ZeroValue;
+
+	/**
+	 * Gas and dust density baked by BakeTextures.
+	 * Covers [-Radius, Radius] in X and Y and [-GasVolumeHeight, GasVolumeHeight] * Radius in Z.
+	 */
+	UPROPERTY(EditAnywhere)
+	UVolumeTexture* GasVolumeTexture;
+
+	/** Texels of the gas volume, each component in [1, 1024]. */
+	UPROPERTY(EditAnywhere)
+	FIntVector GasVolumeResolution = FIntVector(256, 256, 64);
+
+	/** Half height of the gas volume relative to the radius. */
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0.01"))
+	float GasVolumeHeight = 0.25f;
+
+	/**
+	 * Arm sampling table pushed as the ArmSamplingTable texture parameter, recreated at runtime.
+	 * Point sampled, see FDensityImageSampler::SampleQuantileTableNearest.
+	 */
+	UPROPERTY(Transient)
+	UTexture2D* ArmSamplingTableTexture = nullptr;
+
+	/** Region updates of the arm sampling table texture. */
+	FTextureUpdateStaging ArmSamplingTableStaging;
 };
 
 UCLASS(BlueprintType)
@@ -64,12 +246,55 @@ class GALACTITIOUS_API UStarSettings : public UDataAsset
 {
 	GENERATED_BODY()
 
+public:
 	UFUNCTION(BlueprintCallable, CallInEditor)
 	void UpdateNiagaraParameters();
 
+	/**
+	 * Derive sampling curves. Does not modify the asset and may run on any thread.
+	 * Reuses the storage of OutData, repeated derivation into the same data does not allocate.
+	 */
+	bool ComputeSamplingData(FStarSamplingData& OutData) const;
+
+	/** Push previously derived sampling curves to the Niagara parameter collection. Game thread only. */
+	void PushNiagaraParameters(const FStarSamplingData& SamplingData);
+
+	/** Temperature range of the stellar classes table. */
+	bool GetTemperatureRange(float& OutMinTemperature, float& OutMaxTemperature) const;
+
+#if WITH_EDITOR
+	/** Bake the blackbody color lookup texture for the temperature range of the stellar classes in the background. */
+	UFUNCTION(BlueprintCallable, CallInEditor)
+	void BakeTextures();
+
+	/** Job that bakes the blackbody texture and updates texture and temperature range when completed, null on failure. */
+	TSharedPtr<FTextureBakeJob, ESPMode::ThreadSafe> CreateBakeJob();
+#endif
+
 	UPROPERTY(EditAnywhere)
 	class UNiagaraParameterCollectionInstance* NiagaraParameters;
 
 	UPROPERTY(EditAnywhere, meta = (RequiredAssetDataTags = "RowStructure=StellarClass"))
 	UDataTable* StellarClassesTable;
+
+	/**
+	 * Linear sRGB blackbody color with unit luminance, indexed by logarithmic temperature:
+	 * U = (ln(T) - ln(BlackbodyMinTemperature)) / (ln(BlackbodyMaxTemperature) - ln(BlackbodyMinTemperature))
+	 */
+	UPROPERTY(EditAnywhere)
+	UTexture2D* BlackbodyColorTexture;
+
+	/** Temperature range of the baked blackbody texture. */
+	UPROPERTY(VisibleAnywhere)
+	float BlackbodyMinTemperature = 1000.0f;
+
+	UPROPERTY(VisibleAnywhere)
+	float BlackbodyMaxTemperature = 40000.0f;
+
+	/** Fused sampling table pushed as the StarSamplingTable texture parameter, recreated at runtime. */
+	UPROPERTY(Transient)
+	UTexture2D* SamplingTableTexture = nullptr;
+
+	/** Region updates of the sampling table texture, live edits only upload changed entries. */
+	FTextureUpdateStaging SamplingTableStaging;
 };
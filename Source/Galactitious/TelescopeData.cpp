@@ -2,7 +2,13 @@
 
 #include "TelescopeData.h"
 
+#include "FFT.h"
+#include "GalactitiousStats.h"
+#include "GalactitiousSubsystem.h"
+#include "SpectrumFunctionLibrary.h"
 #include "TextureBakerFunctionLibrary.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
 
 namespace
 {
@@ -24,33 +30,380 @@ namespace
 		FVector2D J = BesselRe(1, X);
 		return 2.0f * (J.X * J.X - J.Y * J.Y) / X;
 	}
+
+	/** Bessel function of the first kind J1, rational approximation (Numerical Recipes), absolute error below 1e-8. */
+	double BesselJ1(double X)
+	{
+		const double AbsX = FMath::Abs(X);
+		if (AbsX < 8.0)
+		{
+			const double Y = X * X;
+			const double Num = X * (72362614232.0 +
+									Y * (-7895059235.0 + Y * (242396853.1 + Y * (-2972611.439 + Y * (15704.48260 + Y * -30.16036606)))));
+			const double Den = 144725228442.0 + Y * (2300535178.0 + Y * (18583304.74 + Y * (99447.43394 + Y * (376.9991397 + Y))));
+			return Num / Den;
+		}
+
+		const double Z = 8.0 / AbsX;
+		const double Y = Z * Z;
+		const double XX = AbsX - 2.356194491;
+		const double P = 1.0 + Y * (0.183105e-2 + Y * (-0.3516396496e-4 + Y * (0.2457520174e-5 + Y * -0.240337019e-6)));
+		const double Q = 0.04687499995 + Y * (-0.2002690873e-3 + Y * (0.8449199096e-5 + Y * (-0.88228987e-6 + Y * 0.105787412e-6)));
+		const double Result = FMath::Sqrt(0.636619772 / AbsX) * (FMath::Cos(XX) * P - Z * FMath::Sin(XX) * Q);
+		return X < 0.0 ? -Result : Result;
+	}
+
+	/** 2 J1(x) / x, the amplitude of a circular aperture. */
+	double Jinc(double X)
+	{
+		return FMath::Abs(X) < 1.0e-6 ? 1.0 : 2.0 * BesselJ1(X) / X;
+	}
+
+	/** Intensity of an aperture with a central obstruction of relative radius Epsilon, normalized to 1 at the center. */
+	double AnnularApertureIntensity(double X, double Epsilon)
+	{
+		const double EpsilonSq = Epsilon * Epsilon;
+		const double Amplitude = (Jinc(X) - EpsilonSq * Jinc(Epsilon * X)) / (1.0 - EpsilonSq);
+		return Amplitude * Amplitude;
+	}
+
+	/** Integration step of the spectral PSF. */
+	const float PSFWavelengthStep = 5.0f;
+
+	struct FSpectralSample
+	{
+		/** Scale of the optical radius relative to the reference wavelength. */
+		float Scale;
+		/** Weight of the monochromatic PSF per RGB channel. */
+		FVector Weight;
+	};
+
+	/**
+	 * Spectral samples of a flat spectrum over the visible range, weighted by the sRGB response per channel (trapezoidal rule).
+	 * Channels are energy preserving, the PSF peak intensity scales with the inverse square of the wavelength for constant power.
+	 * Weights are normalized to unit luminance at the center, where the monochromatic PSFs are 1, preserving the channel ratio.
+	 */
+	template <typename AllocatorType>
+	bool BuildSpectralSamples(float ReferenceWavelength, TArray<FSpectralSample, AllocatorType>& OutSamples)
+	{
+		OutSamples.Reset();
+		FVector WeightSum = FVector::ZeroVector;
+		const int32 NumSteps =
+			FMath::RoundToInt((USpectrumFunctionLibrary::MaxWavelength - USpectrumFunctionLibrary::MinWavelength) / PSFWavelengthStep);
+		for (int32 i = 0; i <= NumSteps; ++i)
+		{
+			const float Wavelength = USpectrumFunctionLibrary::MinWavelength + i * PSFWavelengthStep;
+			const FLinearColor Response =
+				USpectrumFunctionLibrary::XYZToLinearSRGB(USpectrumFunctionLibrary::ColorMatching(Wavelength));
+			const float TrapezoidWeight = (i == 0 || i == NumSteps) ? 0.5f : 1.0f;
+			const FVector Weight =
+				FVector(FMath::Max(Response.R, 0.0f), FMath::Max(Response.G, 0.0f), FMath::Max(Response.B, 0.0f)) * TrapezoidWeight;
+			// The PSF scales with wavelength
+			const float Scale = ReferenceWavelength / Wavelength;
+			OutSamples.Add({Scale, Weight * (Scale * Scale)});
+			WeightSum += Weight;
+		}
+		if (!ensure(WeightSum.GetMin() > 0.0f))
+		{
+			return false;
+		}
+
+		FVector CenterValue = FVector::ZeroVector;
+		for (FSpectralSample& Sample : OutSamples)
+		{
+			Sample.Weight /= WeightSum;
+			CenterValue += Sample.Weight;
+		}
+		const float CenterLuminance = FLinearColor(CenterValue.X, CenterValue.Y, CenterValue.Z).GetLuminance();
+		if (!ensure(CenterLuminance > 0.0f))
+		{
+			return false;
+		}
+		for (FSpectralSample& Sample : OutSamples)
+		{
+			Sample.Weight /= CenterLuminance;
+		}
+		return true;
+	}
+} // namespace
+
+FLinearColor FTelescopePSFProfile::Eval(float Radius) const
+{
+	if (Samples.Num() == 0)
+	{
+		return FLinearColor::Black;
+	}
+	if (Samples.Num() == 1 || MaxRadius <= 0.0f)
+	{
+		return Samples[0];
+	}
+
+	const float Position = FMath::Clamp(Radius / MaxRadius, 0.0f, 1.0f) * (Samples.Num() - 1);
+	const int32 Index = FMath::Min((int32)Position, Samples.Num() - 2);
+	return FMath::Lerp(Samples[Index], Samples[Index + 1], Position - Index);
+}
+
+float UTelescopeData::EvalAiryDiskIntensity(float X, float Y) const
+{
+	const FVector2D p = FVector2D(X - 0.5f, Y - 0.5f) * 2.0f * AiryDiskScale;
+	const float q = p.Size();
+
+	//const float sigma = 0.42f;
+	//const float I = FMath::Exp(-q * q / (2.0f * sigma * sigma));
+
+	return AiryDiskIntensity(q);
+}
+
+void UTelescopeData::ComputePSFProfile(FTelescopePSFProfile& OutProfile) const
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousComputePSFProfile);
+
+	const double Epsilon = FMath::Clamp(ApertureObscuration, 0.0f, 0.95f);
+
+	TArray<FSpectralSample, TInlineAllocator<128>> SpectralSamples;
+	if (!BuildSpectralSamples(ReferenceWavelength, SpectralSamples))
+	{
+		return;
+	}
+
+	// Distance from the center to the texture corner
+	OutProfile.MaxRadius = AiryDiskScale * FMath::Sqrt(2.0f);
+	OutProfile.Samples.SetNumUninitialized(PSFProfileResolution);
+	const float dRadius = OutProfile.MaxRadius / (PSFProfileResolution - 1);
+	ParallelFor(PSFProfileResolution, [&](int32 Index) {
+		const double Radius = Index * dRadius;
+		FVector Value = FVector::ZeroVector;
+		for (const FSpectralSample& Sample : SpectralSamples)
+		{
+			Value += Sample.Weight * (float)AnnularApertureIntensity(Radius * Sample.Scale, Epsilon);
+		}
+		OutProfile.Samples[Index] = FLinearColor(Value.X, Value.Y, Value.Z, 1.0f);
+	});
+}
+
+FLinearColor UTelescopeData::EvalPSF(const FTelescopePSFProfile& Profile, float X, float Y) const
+{
+	const FVector2D p = FVector2D(X - 0.5f, Y - 0.5f) * 2.0f * AiryDiskScale;
+	return Profile.Eval(p.Size());
+}
+
+float FTelescopeAperturePSF::Eval(float RadiusX, float RadiusY) const
+{
+	if (Resolution == 0)
+	{
+		return 0.0f;
+	}
+
+	// Zero frequency is at index 0, negative frequencies wrap around
+	const float BinX = RadiusX * BinsPerRadius;
+	const float BinY = RadiusY * BinsPerRadius;
+	const int32 X0 = FMath::FloorToInt(BinX);
+	const int32 Y0 = FMath::FloorToInt(BinY);
+	const float FracX = BinX - X0;
+	const float FracY = BinY - Y0;
+	const int32 Mask = Resolution - 1;
+	const int32 Row0 = (Y0 & Mask) * Resolution;
+	const int32 Row1 = ((Y0 + 1) & Mask) * Resolution;
+	const int32 Column0 = X0 & Mask;
+	const int32 Column1 = (X0 + 1) & Mask;
+	const float I0 = FMath::Lerp(Intensity[Row0 + Column0], Intensity[Row0 + Column1], FracX);
+	const float I1 = FMath::Lerp(Intensity[Row1 + Column0], Intensity[Row1 + Column1], FracX);
+	return FMath::Lerp(I0, I1, FracY);
+}
+
+FVector FTelescopeAperturePSF::EvalSpectrum(float RadiusX, float RadiusY) const
+{
+	FVector Value = FVector::ZeroVector;
+	for (int32 i = 0; i < SpectralScales.Num(); ++i)
+	{
+		const float Scale = SpectralScales[i];
+		Value += SpectralWeights[i] * Eval(RadiusX * Scale, RadiusY * Scale);
+	}
+	return Value;
+}
+
+bool UTelescopeData::IsInsideAperture(float X, float Y) const
+{
+	const float RadiusSq = X * X + Y * Y;
+	const float Epsilon = FMath::Clamp(ApertureObscuration, 0.0f, 0.95f);
+	if (RadiusSq > 1.0f || RadiusSq < Epsilon * Epsilon)
+	{
+		return false;
+	}
+
+	// Vanes extend radially from the center at uniform angles
+	const float HalfVaneWidth = 0.5f * SpiderVaneWidth;
+	for (int32 i = 0; i < NumSpiderVanes; ++i)
+	{
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(SpiderRotation) + 2.0f * PI * i / NumSpiderVanes);
+		if (X * Cos + Y * Sin > 0.0f && FMath::Abs(Y * Cos - X * Sin) < HalfVaneWidth)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool UTelescopeData::ComputeAperturePSF(FTelescopeAperturePSF& OutPSF) const
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousComputeAperturePSF);
+
+	const int32 Resolution = ApertureFFTResolution;
+	if (!ensureMsgf(FFastFourierTransform::IsValidSize(Resolution), TEXT("Aperture FFT resolution %d is not a power of two"), Resolution))
+	{
+		return false;
+	}
+
+	TArray<FSpectralSample, TInlineAllocator<128>> SpectralSamples;
+	if (!BuildSpectralSamples(ReferenceWavelength, SpectralSamples))
+	{
+		return false;
+	}
+	OutPSF.SpectralScales.Reset(SpectralSamples.Num());
+	OutPSF.SpectralWeights.Reset(SpectralSamples.Num());
+	for (const FSpectralSample& Sample : SpectralSamples)
+	{
+		OutPSF.SpectralScales.Add(Sample.Scale);
+		OutPSF.SpectralWeights.Add(Sample.Weight);
+	}
+
+	// The optical radius v at frequency bin k is 2 pi R k / N for a pupil radius of R samples. The texture corner at the shortest
+	// wavelength must be within the FFT field, choose R such that it is at bin R, balancing pupil and PSF sampling.
+	const float FieldRadius = AiryDiskScale * FMath::Sqrt(2.0f) * ReferenceWavelength / USpectrumFunctionLibrary::MinWavelength;
+	const float PupilRadius = FMath::Min(FMath::Sqrt(Resolution * FieldRadius / (2.0f * PI)), Resolution / 4.0f);
+	OutPSF.Resolution = Resolution;
+	OutPSF.BinsPerRadius = Resolution / (2.0f * PI * PupilRadius);
+
+	// Rasterize the aperture mask with supersampled coverage, centered in the grid
+	const int64 NumValues = (int64)Resolution * Resolution;
+	TArray<float> Real;
+	TArray<float> Imag;
+	Real.SetNumZeroed(NumValues);
+	Imag.SetNumZeroed(NumValues);
+
+	const float Center = Resolution / 2;
+	const int32 MinIndex = FMath::Max(FMath::FloorToInt(Center - PupilRadius) - 1, 0);
+	const int32 MaxIndex = FMath::Min(FMath::CeilToInt(Center + PupilRadius) + 1, Resolution - 1);
+	const float SubsampleWeight = 1.0f / (ApertureSupersampling * ApertureSupersampling);
+	ParallelFor(MaxIndex - MinIndex + 1, [&](int32 RowOffset) {
+		const int32 Row = MinIndex + RowOffset;
+		for (int32 Column = MinIndex; Column <= MaxIndex; ++Column)
+		{
+			float Coverage = 0.0f;
+			for (int32 j = 0; j < ApertureSupersampling; ++j)
+			{
+				const float Y = (Row + (j + 0.5f) / ApertureSupersampling - Center) / PupilRadius;
+				for (int32 i = 0; i < ApertureSupersampling; ++i)
+				{
+					const float X = (Column + (i + 0.5f) / ApertureSupersampling - Center) / PupilRadius;
+					Coverage += IsInsideAperture(X, Y) ? SubsampleWeight : 0.0f;
+				}
+			}
+			Real[(int64)Row * Resolution + Column] = Coverage;
+		}
+	});
+
+	double Area = 0.0;
+	for (int32 Row = MinIndex; Row <= MaxIndex; ++Row)
+	{
+		for (int32 Column = MinIndex; Column <= MaxIndex; ++Column)
+		{
+			Area += Real[(int64)Row * Resolution + Column];
+		}
+	}
+	if (!ensureMsgf(Area > 0.0, TEXT("Aperture mask is empty")))
+	{
+		return false;
+	}
+
+	if (!FFastFourierTransform::Transform2D(Real, Imag, Resolution, Resolution))
+	{
+		return false;
+	}
+
+	// |FFT|^2, normalized to 1 at zero frequency
+	const float Normalization = (float)(1.0 / (Area * Area));
+	ParallelFor(Resolution, [&](int32 Row) {
+		float* RowReal = Real.GetData() + (int64)Row * Resolution;
+		const float* RowImag = Imag.GetData() + (int64)Row * Resolution;
+		for (int32 Column = 0; Column < Resolution; ++Column)
+		{
+			RowReal[Column] = (RowReal[Column] * RowReal[Column] + RowImag[Column] * RowImag[Column]) * Normalization;
+		}
+	});
+	OutPSF.Intensity = MoveTemp(Real);
+	return true;
+}
+
+FLinearColor UTelescopeData::EvalAperturePSF(const FTelescopeAperturePSF& PSF, float X, float Y) const
+{
+	const FVector2D p = FVector2D(X - 0.5f, Y - 0.5f) * 2.0f * AiryDiskScale;
+	const FVector Value = PSF.EvalSpectrum(p.X, p.Y);
+	return FLinearColor(Value.X, Value.Y, Value.Z, 1.0f);
 }
 
 #if WITH_EDITOR
-void UTelescopeData::BakeTextures()
+TSharedPtr<FTextureBakeJob, ESPMode::ThreadSafe> UTelescopeData::CreateBakeJob()
 {
 	if (!ensureMsgf(AiryDiskTexture != nullptr, TEXT("Airy disk texture not set")))
 	{
-		return;
+		return nullptr;
 	}
 
-	AiryDiskTexture = UTextureBakerFunctionLibrary::BakeTextureAsset<FVector4_16>(
-		AiryDiskTexture->GetPathName(), 1024, 1024, PF_A32B32G32R32F, TSF_RGBA16F, TMGS_SimpleAverage, [this](float X, float Y) -> FVector4_16 {
-			FVector4_16 Result;
+	// Pixels are baked on workers after this returns, so value functions own copies of everything they read
+	const float Scale = 2.0f * AiryDiskScale;
+	TFunction<FLinearColor(float X, float Y)> ValueFn;
+	if (PSFMode == ETelescopePSFMode::ApertureFFT)
+	{
+		FTelescopeAperturePSF PSF;
+		if (!ComputeAperturePSF(PSF))
+		{
+			return nullptr;
+		}
 
-			const FVector2D p = FVector2D(X - 0.5f, Y - 0.5f) * 2.0f * AiryDiskScale;
-			const float q = p.Size();
+		ValueFn = [Scale, PSF = MoveTemp(PSF)](float X, float Y) {
+			const FVector Value = PSF.EvalSpectrum((X - 0.5f) * Scale, (Y - 0.5f) * Scale);
+			return FLinearColor(Value.X, Value.Y, Value.Z, 1.0f);
+		};
+	}
+	else if (PSFMode == ETelescopePSFMode::AnnularPolychromatic)
+	{
+		// Spectral integration happens once per radial sample, pixels only interpolate the profile
+		FTelescopePSFProfile Profile;
+		ComputePSFProfile(Profile);
 
-			//const float sigma = 0.42f;
-			//const float I = FMath::Exp(-q * q / (2.0f * sigma * sigma));
+		ValueFn = [Scale, Profile = MoveTemp(Profile)](float X, float Y) {
+			FLinearColor Color = Profile.Eval((FVector2D(X - 0.5f, Y - 0.5f) * Scale).Size());
+			Color.A = 1.0f;
+			return Color;
+		};
+	}
+	else
+	{
+		ValueFn = [Scale](float X, float Y) {
+			const float I = AiryDiskIntensity((FVector2D(X - 0.5f, Y - 0.5f) * Scale).Size());
+			return FLinearColor(I, I, I, 1.0f);
+		};
+	}
 
-			const float I = AiryDiskIntensity(q);
+	const FString TexturePath = AiryDiskTexture->GetPathName();
+	TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Job = UTextureBakerFunctionLibrary::CreateTextureAssetBakeJobRGBA16F(
+		TexturePath, 1024, 1024, PF_A32B32G32R32F, TMGS_SimpleAverage, MoveTemp(ValueFn));
+	Job->Name = FName(*TexturePath);
+	Job->OnCompleted.BindWeakLambda(this, [this](UTexture2D* Texture) {
+		AiryDiskTexture = Texture;
+		MarkPackageDirty();
+	});
+	return Job;
+}
 
-			Result.X = I;
-			Result.Y = I;
-			Result.Z = I;
-			Result.W = 1.0f;
-			return Result;
-		});
+void UTelescopeData::BakeTextures()
+{
+	if (TSharedPtr<FTextureBakeJob, ESPMode::ThreadSafe> Job = CreateBakeJob())
+	{
+		Job->StartWorkers();
+		GEngine->GetEngineSubsystem<UGalactitiousSubsystem>()->AddBakeJob(Job.ToSharedRef());
+	}
 }
 #endif
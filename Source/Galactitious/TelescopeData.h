@@ -8,23 +8,122 @@
 
 #include "TelescopeData.generated.h"
 
+class FTextureBakeJob;
+
+UENUM()
+enum class ETelescopePSFMode : uint8
+{
+	/** Monochromatic Airy disk of an unobstructed aperture, same intensity in all channels. */
+	AiryDisk,
+	/** Centrally obscured aperture, integrated over the visible spectrum per RGB channel. */
+	AnnularPolychromatic,
+	/** Rasterized aperture mask with obscuration and spider vanes, PSF computed with a 2D FFT and integrated over the spectrum. */
+	ApertureFFT,
+};
+
+/** Radial point spread function profile, sampled uniformly in [0, MaxRadius]. */
+struct GALACTITIOUS_API FTelescopePSFProfile
+{
+	TArray<FLinearColor> Samples;
+	float MaxRadius = 0.0f;
+
+	/** Linearly interpolated lookup, clamped to the sampled range. */
+	FLinearColor Eval(float Radius) const;
+};
+
+/** Monochromatic PSF of a rasterized aperture mask at the reference wavelength, |FFT|^2 of the mask. */
+struct GALACTITIOUS_API FTelescopeAperturePSF
+{
+	/** Intensity normalized to 1 at the center, zero frequency at index 0. */
+	TArray<float> Intensity;
+	int32 Resolution = 0;
+
+	/** Frequency bins per unit of optical radius. */
+	float BinsPerRadius = 0.0f;
+
+	/** Wavelength scale of the optical radius and RGB weight per spectral sample. */
+	TArray<float> SpectralScales;
+	TArray<FVector> SpectralWeights;
+
+	/** Bilinear lookup at an optical radius relative to the center. */
+	float Eval(float RadiusX, float RadiusY) const;
+
+	/** RGB sum of the lookups scaled to the wavelengths of the spectral samples. */
+	FVector EvalSpectrum(float RadiusX, float RadiusY) const;
+};
+
 UCLASS(BlueprintType)
 class GALACTITIOUS_API UTelescopeData : public UDataAsset
 {
 public:
 	GENERATED_BODY()
 
-	UPROPERTY(EditAnywhere)
+	/** Radius of the central obstruction relative to the aperture radius. */
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "0.95"))
 	float ApertureObscuration = 0.15f;
 
+	/** Optical radius (first Airy zero at 3.83) at the texture border, for the reference wavelength. */
 	UPROPERTY(EditAnywhere)
 	float AiryDiskScale = 8.0f;
 
 	UPROPERTY(EditAnywhere)
 	UTexture2D* AiryDiskTexture;
 
+	UPROPERTY(EditAnywhere)
+	ETelescopePSFMode PSFMode = ETelescopePSFMode::AiryDisk;
+
+	/** Number of secondary mirror spider vanes, extending radially from the center. Each vane adds a pair of diffraction spikes. */
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0", ClampMax = "16"))
+	int32 NumSpiderVanes = 4;
+
+	/** Width of spider vanes relative to the aperture radius. */
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "0.0", ClampMax = "0.2"))
+	float SpiderVaneWidth = 0.02f;
+
+	/** Angle of the first spider vane in degrees. */
+	UPROPERTY(EditAnywhere)
+	float SpiderRotation = 45.0f;
+
+	/** FFT grid size of the aperture PSF, must be a power of two. */
+	UPROPERTY(EditAnywhere, meta = (ClampMin = "256", ClampMax = "8192"))
+	int32 ApertureFFTResolution = 4096;
+
+	/** Subsamples per axis for the coverage of aperture mask pixels. */
+	static constexpr int32 ApertureSupersampling = 4;
+
+	/** Wavelength at which AiryDiskScale applies, other wavelengths scale proportionally. */
+	static constexpr float ReferenceWavelength = 550.0f;
+
+	/** Number of radial samples of the polychromatic PSF profile. */
+	static constexpr int32 PSFProfileResolution = 2048;
+
+	/** Airy disk intensity at normalized texture coordinates, centered at (0.5, 0.5). */
+	float EvalAiryDiskIntensity(float X, float Y) const;
+
+	/**
+	 * Compute the radial profile of the annular aperture PSF, integrated over the visible spectrum for each RGB channel.
+	 * Channels are energy preserving for a flat spectrum and scaled to unit luminance at the center. Samples are computed in parallel.
+	 */
+	void ComputePSFProfile(FTelescopePSFProfile& OutProfile) const;
+
+	/** Polychromatic PSF at normalized texture coordinates, centered at (0.5, 0.5). */
+	FLinearColor EvalPSF(const FTelescopePSFProfile& Profile, float X, float Y) const;
+
+	/** Aperture mask at coordinates relative to the aperture radius. */
+	bool IsInsideAperture(float X, float Y) const;
+
+	/** Rasterize the aperture mask and compute its PSF with a 2D FFT. Rows and columns are transformed in parallel. */
+	bool ComputeAperturePSF(FTelescopeAperturePSF& OutPSF) const;
+
+	/** Polychromatic aperture PSF at normalized texture coordinates, centered at (0.5, 0.5). */
+	FLinearColor EvalAperturePSF(const FTelescopeAperturePSF& PSF, float X, float Y) const;
+
 #if WITH_EDITOR
+	/** Bake the PSF into the Airy disk texture asset in the background, ticked by UGalactitiousSubsystem. */
 	UFUNCTION(BlueprintCallable, CallInEditor)
 	void BakeTextures();
+
+	/** Job that bakes the PSF of the current settings and replaces the Airy disk texture when completed, null on failure. */
+	TSharedPtr<FTextureBakeJob, ESPMode::ThreadSafe> CreateBakeJob();
 #endif
 };
@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TextureBakeJob.h"
+
+#include "GalactitiousStats.h"
+#include "TextureBakerFunctionLibrary.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/Texture2D.h"
+
+FTextureBakeJob::FTextureBakeJob(
+	int32 InWidth, int32 InHeight, EPixelFormat InPixelFormat, FBakeTileFunction InBakeTileFn, UTexture2D* InTargetTexture)
+	: Width(InWidth)
+	, Height(InHeight)
+	, PixelFormat(InPixelFormat)
+	, BytesPerPixel(GPixelFormats[InPixelFormat].BlockBytes)
+	, NumTiles(UTextureBakerFunctionLibrary::GetNumTiles(InWidth, InHeight))
+	, BakeTileFn(MoveTemp(InBakeTileFn))
+	, Texture(InTargetTexture)
+{
+	check(Width >= 1 && Height >= 1);
+	checkf(GPixelFormats[PixelFormat].BlockSizeX == 1 && GPixelFormats[PixelFormat].BlockSizeY == 1,
+		TEXT("Texture bake jobs require an uncompressed pixel format"));
+
+	PixelData.AddUninitialized(Width * Height * BytesPerPixel);
+}
+
+TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> FTextureBakeJob::CreatePixels(
+	int32 Width, int32 Height, EPixelFormat PixelFormat, TFunction<void(float X, float Y, uint8* OutData)> ValueFn,
+	UTexture2D* TargetTexture)
+{
+	const int32 BytesPerPixel = GPixelFormats[PixelFormat].BlockBytes;
+	return MakeShared<FTextureBakeJob, ESPMode::ThreadSafe>(
+		Width, Height, PixelFormat,
+		[Width, Height, BytesPerPixel, ValueFn = MoveTemp(ValueFn)](int32 TileIndex, uint8* OutData) {
+			UTextureBakerFunctionLibrary::BakePixelTile(Width, Height, BytesPerPixel, TileIndex, ValueFn, OutData);
+		},
+		TargetTexture);
+}
+
+TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> FTextureBakeJob::CreateRGBA16F(
+	int32 Width, int32 Height, TFunction<void(float X0, float dX, float Y, int32 Count, FLinearColor* OutValues)> RowValueFn,
+	UTexture2D* TargetTexture)
+{
+	return MakeShared<FTextureBakeJob, ESPMode::ThreadSafe>(
+		Width, Height, PF_FloatRGBA,
+		[Width, Height, RowValueFn = MoveTemp(RowValueFn)](int32 TileIndex, uint8* OutData) {
+			UTextureBakerFunctionLibrary::BakePixelTileRGBA16F(Width, Height, TileIndex, RowValueFn, reinterpret_cast<FFloat16*>(OutData));
+		},
+		TargetTexture);
+}
+
+bool FTextureBakeJob::Tick(double BudgetSeconds)
+{
+	check(IsInGameThread());
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousTickTextureBakeJob);
+
+	if (IsFinished())
+	{
+		return true;
+	}
+
+	if (!bWorkersStarted)
+	{
+		BakeTiles(FPlatformTime::Seconds() + BudgetSeconds);
+	}
+
+	if (NumBakedTiles.GetValue() == NumTiles)
+	{
+		Finish();
+	}
+	return IsFinished();
+}
+
+void FTextureBakeJob::StartWorkers(int32 NumWorkers)
+{
+	check(IsInGameThread());
+
+	if (IsFinished())
+	{
+		return;
+	}
+
+	if (NumWorkers <= 0)
+	{
+		NumWorkers = FTaskGraphInterface::Get().GetNumWorkerThreads();
+	}
+	NumWorkers = FMath::Clamp(NumWorkers, 1, NumTiles);
+	bWorkersStarted = true;
+
+	// Workers keep the job alive until they return
+	for (int32 i = 0; i < NumWorkers; ++i)
+	{
+		Async(EAsyncExecution::ThreadPool, [Job = AsShared()]() { Job->BakeTiles(TNumericLimits<double>::Max()); });
+	}
+}
+
+void FTextureBakeJob::Cancel()
+{
+	check(IsInGameThread());
+
+	if (!IsFinished())
+	{
+		bCancelled = true;
+		State = EState::Cancelled;
+	}
+}
+
+float FTextureBakeJob::GetProgress() const
+{
+	return State == EState::Completed ? 1.0f : (float)NumBakedTiles.GetValue() / NumTiles;
+}
+
+void FTextureBakeJob::BakeTiles(double EndTime)
+{
+	do
+	{
+		const int32 TileIndex = NextTile.Increment() - 1;
+		if (TileIndex >= NumTiles)
+		{
+			return;
+		}
+
+		BakeTileFn(TileIndex, PixelData.GetData());
+		NumBakedTiles.Increment();
+	} while (!bCancelled && FPlatformTime::Seconds() < EndTime);
+}
+
+void FTextureBakeJob::Finish()
+{
+	Texture = Upload ? Upload(PixelData.GetData())
+					 : UTextureBakerFunctionLibrary::UpdateTransientTexture(Texture, Width, Height, PixelFormat, PixelData.GetData());
+	PixelData.Empty();
+
+	if (!ensureMsgf(Texture != nullptr, TEXT("Failed to create baked texture")))
+	{
+		State = EState::Cancelled;
+		return;
+	}
+
+	State = EState::Completed;
+	OnCompleted.ExecuteIfBound(Texture);
+}
+
+void FTextureBakeJob::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	Collector.AddReferencedObject(Texture);
+}
+
+FString FTextureBakeJob::GetReferencerName() const
+{
+	return FString::Printf(TEXT("FTextureBakeJob %s"), *Name.ToString());
+}
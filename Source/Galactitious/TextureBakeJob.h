@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "RHI.h"
+#include "UObject/GCObject.h"
+
+class UTexture2D;
+
+/**
+ * Incremental bake of a transient texture, for bakes during gameplay.
+ * Tiles are baked on the game thread within a time budget per tick, or on background workers after StartWorkers.
+ * The finished image is uploaded to the texture in a single update, consumers never see a partially baked texture.
+ * Jobs are usually ticked by UGalactitiousSubsystem::AddBakeJob, editor bakes of texture assets use the same path.
+ */
+class GALACTITIOUS_API FTextureBakeJob : public TSharedFromThis<FTextureBakeJob, ESPMode::ThreadSafe>, public FGCObject
+{
+public:
+	enum class EState : uint8
+	{
+		Running,
+		Completed,
+		Cancelled,
+	};
+
+	DECLARE_DELEGATE_OneParam(FOnCompleted, UTexture2D* /*Texture*/);
+
+	/** Bakes the pixels of the tile of TileIndex into OutData, which holds the whole image. */
+	using FBakeTileFunction = TFunction<void(int32 TileIndex, uint8* OutData)>;
+
+	/**
+	 * The tile function writes pixels of the uncompressed pixel format and must be thread-safe when baking on workers.
+	 * TargetTexture is updated in place if it matches size and format, otherwise a new transient texture is created.
+	 */
+	FTextureBakeJob(
+		int32 InWidth, int32 InHeight, EPixelFormat InPixelFormat, FBakeTileFunction InBakeTileFn, UTexture2D* InTargetTexture = nullptr);
+
+	/** The value function writes one pixel of the pixel format, see UTextureBakerFunctionLibrary::BakePixelTile. */
+	static TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> CreatePixels(
+		int32 Width, int32 Height, EPixelFormat PixelFormat, TFunction<void(float X, float Y, uint8* OutData)> ValueFn,
+		UTexture2D* TargetTexture = nullptr);
+
+	template <typename ValueType>
+	static TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Create(
+		int32 Width, int32 Height, EPixelFormat PixelFormat, TFunction<ValueType(float X, float Y)> ValueFn,
+		UTexture2D* TargetTexture = nullptr)
+	{
+		check(sizeof(ValueType) == GPixelFormats[PixelFormat].BlockBytes);
+		return CreatePixels(
+			Width, Height, PixelFormat,
+			[ValueFn = MoveTemp(ValueFn)](float X, float Y, uint8* OutData) {
+				const ValueType Value = ValueFn(X, Y);
+				FMemory::Memcpy(OutData, &Value, sizeof(ValueType));
+			},
+			TargetTexture);
+	}
+
+	/**
+	 * PF_FloatRGBA bake from float colors, rows of a tile are converted to half precision in one batch.
+	 * The row function fills Count colors for pixels at X0 + i * dX, see UTextureBakerFunctionLibrary::BakePixelTileRGBA16F.
+	 */
+	static TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> CreateRGBA16F(
+		int32 Width, int32 Height, TFunction<void(float X0, float dX, float Y, int32 Count, FLinearColor* OutValues)> RowValueFn,
+		UTexture2D* TargetTexture = nullptr);
+
+	/**
+	 * Bake tiles on the calling thread until the budget is used up, at least one tile is baked per call.
+	 * Uploads the texture once all tiles are baked. Game thread only, returns true when the job is finished.
+	 */
+	bool Tick(double BudgetSeconds);
+
+	/**
+	 * Bake the remaining tiles on background workers, 0 uses one worker per task graph thread.
+	 * Tick no longer bakes tiles itself but still has to be called to finish the job. Game thread only.
+	 */
+	void StartWorkers(int32 NumWorkers = 0);
+
+	/** Stop baking, the texture is left unchanged. Workers finish their current tile. */
+	void Cancel();
+
+	EState GetState() const { return State; }
+	bool IsFinished() const { return State != EState::Running; }
+
+	/** Fraction of baked tiles in [0, 1]. */
+	float GetProgress() const;
+
+	/** Baked texture, valid once completed. */
+	UTexture2D* GetTexture() const { return State == EState::Completed ? Texture : nullptr; }
+
+	/** Name of the job, a job added to the subsystem cancels running jobs with the same name. */
+	FName Name;
+
+	/** Called on the game thread when the texture has been updated. */
+	FOnCompleted OnCompleted;
+
+	/**
+	 * Replaces the update of the transient texture, e.g. to store the image as the source of a texture asset.
+	 * Called on the game thread with the baked pixels, returns the texture or null on failure.
+	 */
+	TFunction<UTexture2D*(const uint8* PixelData)> Upload;
+
+	// FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+
+private:
+	/** Claim and bake tiles until all are claimed, the job is cancelled or EndTime is reached. Any thread. */
+	void BakeTiles(double EndTime);
+
+	void Finish();
+
+	int32 Width;
+	int32 Height;
+	EPixelFormat PixelFormat;
+	int32 BytesPerPixel;
+	int32 NumTiles;
+	FBakeTileFunction BakeTileFn;
+
+	TArray<uint8> PixelData;
+
+	/** Target texture while baking, the result once completed. */
+	UTexture2D* Texture;
+
+	FThreadSafeCounter NextTile;
+	FThreadSafeCounter NumBakedTiles;
+	FThreadSafeBool bCancelled;
+	bool bWorkersStarted = false;
+
+	EState State = EState::Running;
+};
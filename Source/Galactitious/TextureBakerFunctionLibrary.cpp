@@ -3,14 +3,151 @@
 
 #include "TextureBakerFunctionLibrary.h"
 
+#include "GalactitiousStats.h"
+#include "TextureBakeJob.h"
 #include "ObjectTools.h"
 #include "PackageTools.h"
+#include "Async/ParallelFor.h"
 #include "AssetRegistry/AssetRegistryModule.h"
 
+// F16C is not part of the x64 baseline, the vector conversion is compiled for it and selected at runtime
+#if PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY
+#define GALACTITIOUS_HAS_F16C 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define GALACTITIOUS_F16C_TARGET
+#else
+#include <cpuid.h>
+#define GALACTITIOUS_F16C_TARGET __attribute__((target("avx,f16c")))
+#endif
+#else
+#define GALACTITIOUS_HAS_F16C 0
+#endif
+
+// Half conversions are part of the AArch64 baseline
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+#define GALACTITIOUS_HAS_NEON_FP16 1
+#else
+#define GALACTITIOUS_HAS_NEON_FP16 0
+#endif
+
+#if GALACTITIOUS_HAS_F16C
+namespace
+{
+	/** F16C and AVX support of the CPU, and AVX state saved by the OS. */
+	bool DetectF16C()
+	{
+		uint32 Info[4] = {};
+#if defined(_MSC_VER) && !defined(__clang__)
+		__cpuid(reinterpret_cast<int*>(Info), 1);
+#else
+		__cpuid(1, Info[0], Info[1], Info[2], Info[3]);
+#endif
+		const uint32 OSXSaveAVXF16C = (1u << 27) | (1u << 28) | (1u << 29);
+		if ((Info[2] & OSXSaveAVXF16C) != OSXSaveAVXF16C)
+		{
+			return false;
+		}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+		const uint64 EnabledState = _xgetbv(0);
+#else
+		uint32 EnabledStateLow, EnabledStateHigh;
+		__asm__("xgetbv" : "=a"(EnabledStateLow), "=d"(EnabledStateHigh) : "c"(0));
+		const uint64 EnabledState = EnabledStateLow;
+#endif
+		// SSE and AVX registers
+		return (EnabledState & 0x6) == 0x6;
+	}
+
+	const bool bHasF16C = DetectF16C();
+
+	/** Convert full vectors, returns the number of converted values. */
+	GALACTITIOUS_F16C_TARGET int32 ConvertFloatToHalfF16C(const float* Source, FFloat16* Dest, int32 Count)
+	{
+		int32 i = 0;
+		for (; i + 8 <= Count; i += 8)
+		{
+			const __m128i Half = _mm256_cvtps_ph(_mm256_loadu_ps(Source + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + i), Half);
+		}
+		for (; i + 4 <= Count; i += 4)
+		{
+			const __m128i Half = _mm_cvtps_ph(_mm_loadu_ps(Source + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(Dest + i), Half);
+		}
+		return i;
+	}
+} // namespace
+#endif
+
+void UTextureBakerFunctionLibrary::ConvertFloatToHalf(const float* Source, FFloat16* Dest, int32 Count)
+{
+	int32 i = 0;
+#if GALACTITIOUS_HAS_F16C
+	if (bHasF16C)
+	{
+		i = ConvertFloatToHalfF16C(Source, Dest, Count);
+	}
+#elif GALACTITIOUS_HAS_NEON_FP16
+	for (; i + 4 <= Count; i += 4)
+	{
+		const float16x4_t Half = vcvt_f16_f32(vld1q_f32(Source + i));
+		vst1_u16(reinterpret_cast<uint16_t*>(Dest + i), vreinterpret_u16_f16(Half));
+	}
+#endif
+	for (; i < Count; ++i)
+	{
+		Dest[i].Encoded = FloatToHalf(Source[i]);
+	}
+}
+
+uint16 UTextureBakerFunctionLibrary::FloatToHalf(float Value)
+{
+	// Branch-light conversion with round to nearest even (F. Giesen, float_to_half_fast3_rtne)
+	const uint32 Float32Infinity = 255u << 23;
+	const uint32 Float16Max = (127u + 16u) << 23;
+	const uint32 DenormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+	uint32 Bits;
+	FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+	const uint32 Sign = Bits & 0x80000000u;
+	Bits ^= Sign;
+
+	uint16 Result;
+	if (Bits >= Float16Max)
+	{
+		// Overflow to infinity, NaN to quiet NaN
+		Result = Bits > Float32Infinity ? 0x7e00 : 0x7c00;
+	}
+	else if (Bits < (113u << 23))
+	{
+		// Denormals and zero, the float addition rounds the mantissa
+		float Magic, Sum;
+		FMemory::Memcpy(&Magic, &DenormMagic, sizeof(Magic));
+		FMemory::Memcpy(&Sum, &Bits, sizeof(Sum));
+		Sum += Magic;
+		uint32 SumBits;
+		FMemory::Memcpy(&SumBits, &Sum, sizeof(SumBits));
+		Result = (uint16)(SumBits - DenormMagic);
+	}
+	else
+	{
+		const uint32 MantissaOdd = (Bits >> 13) & 1;
+		Bits += ((uint32)(15 - 127) << 23) + 0xfff;
+		Bits += MantissaOdd;
+		Result = (uint16)(Bits >> 13);
+	}
+	return Result | (uint16)(Sign >> 16);
+}
+
 void UTextureBakerFunctionLibrary::BakeTextureInternal(
-	UTexture2D* Texture, int32 Width, int32 Height, EPixelFormat PixelFormat, ETextureSourceFormat SourceFormat,
-	TextureMipGenSettings MipGenSettings, TFunctionRef<void(float X, float Y, uint8* OutData)> ValueFn)
+	UTexture2D* Texture, int32 Width, int32 Height, ETextureSourceFormat SourceFormat, TextureMipGenSettings MipGenSettings,
+	TFunctionRef<void(uint8* OutData)> BakeFn)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousBakeTexture);
+
 	const int32 BytesPerPixel = FTextureSource::GetBytesPerPixel(SourceFormat);
 
 	check(Width >= 1 && Height >= 1);
@@ -23,26 +160,13 @@ void UTextureBakerFunctionLibrary::BakeTextureInternal(
 	{
 		TArray<uint8> TextureData;
 		TextureData.AddUninitialized(Width * Height * BytesPerPixel);
+		SET_MEMORY_STAT(STAT_GalactitiousTextureBakeMemory, TextureData.GetAllocatedSize());
 
-		uint8* Data = TextureData.GetData();
-		const float dX = 1.0f / FMath::Max(Width - 1, 1);
-		const float dY = 1.0f / FMath::Max(Height - 1, 1);
-
-		float Y = 0.0f;
-		for (int32 j = 0; j < Height; j++)
-		{
-			float X = 0.0f;
-			for (int32 i = 0; i < Width; i++)
-			{
-				ValueFn(X, Y, Data);
-				X += dX;
-				Data += BytesPerPixel;
-			}
-			Y += dY;
-		}
+		BakeFn(TextureData.GetData());
 
 		Texture->Source.Init(Width, Height, /*NumSlices=*/1, 1, SourceFormat, TextureData.GetData());
 	}
+	SET_MEMORY_STAT(STAT_GalactitiousTextureBakeMemory, 0);
 
 	Texture->MipGenSettings = MipGenSettings;
 	Texture->CompressionNoAlpha = true;
@@ -63,16 +187,247 @@ void UTextureBakerFunctionLibrary::BakeTextureInternal(
 	FAssetRegistryModule::AssetCreated(Texture);
 }
 
+void UTextureBakerFunctionLibrary::BakePixelData(
+	int32 Width, int32 Height, int32 BytesPerPixel, TFunctionRef<void(float X, float Y, uint8* OutData)> ValueFn, uint8* OutData,
+	int32 MaxThreads)
+{
+	check(Width >= 1 && Height >= 1);
+
+	// Bake tiles in parallel, the value function is called concurrently from worker threads
+	const int32 NumTiles = GetNumTiles(Width, Height);
+	// Each task bakes a contiguous range of tiles, a single task runs on the calling thread
+	const int32 NumTasks = MaxThreads > 0 ? FMath::Min(MaxThreads, NumTiles) : NumTiles;
+	ParallelFor(NumTasks, [&](int32 TaskIndex) {
+		const int32 BeginTile = (int32)((int64)NumTiles * TaskIndex / NumTasks);
+		const int32 EndTile = (int32)((int64)NumTiles * (TaskIndex + 1) / NumTasks);
+		for (int32 TileIndex = BeginTile; TileIndex < EndTile; ++TileIndex)
+		{
+			BakePixelTile(Width, Height, BytesPerPixel, TileIndex, ValueFn, OutData);
+		}
+	});
+}
+
+void UTextureBakerFunctionLibrary::BakeVolumePixelData(
+	int32 Width, int32 Height, int32 Depth, int32 BytesPerPixel, TFunctionRef<void(float X, float Y, float Z, uint8* OutData)> ValueFn,
+	uint8* OutData, int32 MaxThreads)
+{
+	check(Width >= 1 && Height >= 1 && Depth >= 1);
+
+	const float dZ = 1.0f / FMath::Max(Depth - 1, 1);
+	const int64 SliceSize = (int64)Width * Height * BytesPerPixel;
+
+	// Tiles of all slices are baked in parallel
+	const int32 NumSliceTiles = GetNumTiles(Width, Height);
+	const int32 NumTiles = NumSliceTiles * Depth;
+	const int32 NumTasks = MaxThreads > 0 ? FMath::Min(MaxThreads, NumTiles) : NumTiles;
+	ParallelFor(NumTasks, [&](int32 TaskIndex) {
+		const int32 BeginTile = (int32)((int64)NumTiles * TaskIndex / NumTasks);
+		const int32 EndTile = (int32)((int64)NumTiles * (TaskIndex + 1) / NumTasks);
+		for (int32 TileIndex = BeginTile; TileIndex < EndTile; ++TileIndex)
+		{
+			const int32 Slice = TileIndex / NumSliceTiles;
+			const float Z = Slice * dZ;
+			BakePixelTile(
+				Width, Height, BytesPerPixel, TileIndex % NumSliceTiles,
+				[&ValueFn, Z](float X, float Y, uint8* PixelData) { ValueFn(X, Y, Z, PixelData); }, OutData + Slice * SliceSize);
+		}
+	});
+}
+
+void UTextureBakerFunctionLibrary::BakePixelDataRGBA16F(
+	int32 Width, int32 Height, FRowValueFunction RowValueFn, FFloat16* OutData, int32 MaxThreads)
+{
+	check(Width >= 1 && Height >= 1);
+
+	const int32 NumTiles = GetNumTiles(Width, Height);
+	const int32 NumTasks = MaxThreads > 0 ? FMath::Min(MaxThreads, NumTiles) : NumTiles;
+	ParallelFor(NumTasks, [&](int32 TaskIndex) {
+		const int32 BeginTile = (int32)((int64)NumTiles * TaskIndex / NumTasks);
+		const int32 EndTile = (int32)((int64)NumTiles * (TaskIndex + 1) / NumTasks);
+		for (int32 TileIndex = BeginTile; TileIndex < EndTile; ++TileIndex)
+		{
+			BakePixelTileRGBA16F(Width, Height, TileIndex, RowValueFn, OutData);
+		}
+	});
+}
+
+int32 UTextureBakerFunctionLibrary::GetNumTiles(int32 Width, int32 Height)
+{
+	return FMath::DivideAndRoundUp(Width, BakeTileSize) * FMath::DivideAndRoundUp(Height, BakeTileSize);
+}
+
+void UTextureBakerFunctionLibrary::BakePixelTile(
+	int32 Width, int32 Height, int32 BytesPerPixel, int32 TileIndex, TFunctionRef<void(float X, float Y, uint8* OutData)> ValueFn,
+	uint8* OutData)
+{
+	const float dX = 1.0f / FMath::Max(Width - 1, 1);
+	const float dY = 1.0f / FMath::Max(Height - 1, 1);
+
+	const int32 NumTilesX = FMath::DivideAndRoundUp(Width, BakeTileSize);
+	const int32 BeginX = (TileIndex % NumTilesX) * BakeTileSize;
+	const int32 BeginY = (TileIndex / NumTilesX) * BakeTileSize;
+	const int32 EndX = FMath::Min(BeginX + BakeTileSize, Width);
+	const int32 EndY = FMath::Min(BeginY + BakeTileSize, Height);
+
+	for (int32 j = BeginY; j < EndY; j++)
+	{
+		const float Y = j * dY;
+		uint8* PixelData = OutData + ((int64)j * Width + BeginX) * BytesPerPixel;
+		for (int32 i = BeginX; i < EndX; i++)
+		{
+			ValueFn(i * dX, Y, PixelData);
+			PixelData += BytesPerPixel;
+		}
+	}
+}
+
+void UTextureBakerFunctionLibrary::BakePixelTileRGBA16F(
+	int32 Width, int32 Height, int32 TileIndex, FRowValueFunction RowValueFn, FFloat16* OutData)
+{
+	const float dX = 1.0f / FMath::Max(Width - 1, 1);
+	const float dY = 1.0f / FMath::Max(Height - 1, 1);
+
+	const int32 NumTilesX = FMath::DivideAndRoundUp(Width, BakeTileSize);
+	const int32 BeginX = (TileIndex % NumTilesX) * BakeTileSize;
+	const int32 BeginY = (TileIndex / NumTilesX) * BakeTileSize;
+	const int32 Count = FMath::Min(BeginX + BakeTileSize, Width) - BeginX;
+	const int32 EndY = FMath::Min(BeginY + BakeTileSize, Height);
+
+	// Float colors of one tile row, converted to half precision in one batch
+	FLinearColor RowValues[BakeTileSize];
+	for (int32 j = BeginY; j < EndY; j++)
+	{
+		RowValueFn(BeginX * dX, dX, j * dY, Count, RowValues);
+		ConvertFloatToHalf(&RowValues[0].R, OutData + ((int64)j * Width + BeginX) * 4, Count * 4);
+	}
+}
+
 UTexture2D* UTextureBakerFunctionLibrary::CreateTransientTextureInternal(int32 Width, int32 Height, EPixelFormat PixelFormat)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousCreateTexture);
+
 	check(Width >= 1 && Height >= 1);
 	return UTexture2D::CreateTransient(Width, Height, PixelFormat);
 }
 
+UTexture2D* UTextureBakerFunctionLibrary::UpdateTransientTexture(
+	UTexture2D* Texture, int32 Width, int32 Height, EPixelFormat PixelFormat, const void* PixelData, TextureFilter Filter)
+{
+	check(IsInGameThread());
+	check(PixelData != nullptr);
+
+	const bool bReuseTexture = Texture != nullptr && Texture->PlatformData != nullptr && Texture->GetSizeX() == Width &&
+							   Texture->GetSizeY() == Height && Texture->GetPixelFormat() == PixelFormat;
+	if (!bReuseTexture)
+	{
+		Texture = CreateTransientTextureInternal(Width, Height, PixelFormat);
+		if (!Texture)
+		{
+			return nullptr;
+		}
+
+		Texture->AddressX = TA_Clamp;
+		Texture->AddressY = TA_Clamp;
+		Texture->LODGroup = TEXTUREGROUP_Effects;
+		Texture->SRGB = false;
+	}
+	// The sampler state is created with the resource below
+	Texture->Filter = Filter;
+
+	FTexture2DMipMap& Mip = Texture->PlatformData->Mips[0];
+	void* MipData = Mip.BulkData.Lock(LOCK_READ_WRITE);
+	FMemory::Memcpy(MipData, PixelData, Mip.BulkData.GetBulkDataSize());
+	Mip.BulkData.Unlock();
+
+	Texture->UpdateResource();
+	return Texture;
+}
+
+UTexture2D* UTextureBakerFunctionLibrary::UpdateTransientTextureRegions(
+	UTexture2D* Texture, int32 Width, int32 Height, EPixelFormat PixelFormat, const void* PixelData, FTextureUpdateStaging& Staging,
+	TextureFilter Filter)
+{
+	check(IsInGameThread());
+	check(PixelData != nullptr);
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousUpdateTextureRegions);
+
+	const int32 BytesPerPixel = GPixelFormats[PixelFormat].BlockBytes;
+	const int32 Pitch = Width * BytesPerPixel;
+	const bool bReuseTexture = Texture != nullptr && Texture->Resource != nullptr && Texture->GetSizeX() == Width &&
+							   Texture->GetSizeY() == Height && Texture->GetPixelFormat() == PixelFormat && Texture->Filter == Filter &&
+							   Staging.PixelData.Num() == Pitch * Height;
+	if (!bReuseTexture)
+	{
+		Staging.Fence.Wait();
+		Staging.PixelData.SetNumUninitialized(Pitch * Height);
+		FMemory::Memcpy(Staging.PixelData.GetData(), PixelData, Staging.PixelData.Num());
+		return UpdateTransientTexture(Texture, Width, Height, PixelFormat, PixelData, Filter);
+	}
+
+	// Bounding rectangle of changed pixels
+	const uint8* NewData = static_cast<const uint8*>(PixelData);
+	int32 MinX = Width, MaxX = -1, MinY = Height, MaxY = -1;
+	for (int32 y = 0; y < Height; ++y)
+	{
+		const uint8* NewRow = NewData + y * Pitch;
+		const uint8* OldRow = Staging.PixelData.GetData() + y * Pitch;
+		if (FMemory::Memcmp(NewRow, OldRow, Pitch) == 0)
+		{
+			continue;
+		}
+
+		int32 First = 0;
+		while (FMemory::Memcmp(NewRow + First * BytesPerPixel, OldRow + First * BytesPerPixel, BytesPerPixel) == 0)
+		{
+			++First;
+		}
+		int32 Last = Width - 1;
+		while (FMemory::Memcmp(NewRow + Last * BytesPerPixel, OldRow + Last * BytesPerPixel, BytesPerPixel) == 0)
+		{
+			--Last;
+		}
+		MinX = FMath::Min(MinX, First);
+		MaxX = FMath::Max(MaxX, Last);
+		MinY = FMath::Min(MinY, y);
+		MaxY = y;
+	}
+	if (MaxY < 0)
+	{
+		return Texture;
+	}
+
+	// The render thread reads the staging data of the previous update until the fence has passed
+	Staging.Fence.Wait();
+	for (int32 y = MinY; y <= MaxY; ++y)
+	{
+		const int32 Offset = y * Pitch + MinX * BytesPerPixel;
+		FMemory::Memcpy(Staging.PixelData.GetData() + Offset, NewData + Offset, (MaxX - MinX + 1) * BytesPerPixel);
+	}
+
+	// Keep the CPU copy in sync in case the resource is recreated
+	FTexture2DMipMap& Mip = Texture->PlatformData->Mips[0];
+	if (Mip.BulkData.IsBulkDataLoaded() && Mip.BulkData.GetBulkDataSize() == Staging.PixelData.Num())
+	{
+		void* MipData = Mip.BulkData.Lock(LOCK_READ_WRITE);
+		FMemory::Memcpy(MipData, Staging.PixelData.GetData(), Staging.PixelData.Num());
+		Mip.BulkData.Unlock();
+	}
+
+	Staging.Region = FUpdateTextureRegion2D(MinX, MinY, MinX, MinY, MaxX - MinX + 1, MaxY - MinY + 1);
+	// Staging data is owned by the caller, nothing to clean up after the upload
+	Texture->UpdateTextureRegions(
+		0, 1, &Staging.Region, Pitch, BytesPerPixel, Staging.PixelData.GetData(),
+		[](uint8* SrcData, const FUpdateTextureRegion2D* Regions) {});
+	Staging.Fence.BeginFence();
+	return Texture;
+}
+
 #if WITH_EDITOR
 UTexture2D* UTextureBakerFunctionLibrary::CreateTextureAssetInternal(
 	const FString& TexturePath, int32 Width, int32 Height, EPixelFormat PixelFormat, ETextureSourceFormat SourceFormat)
 {
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousCreateTexture);
+
 	const int32 BytesPerPixel = FTextureSource::GetBytesPerPixel(SourceFormat);
 
 	check(Width >= 1 && Height >= 1);
@@ -99,6 +454,163 @@ UTexture2D* UTextureBakerFunctionLibrary::CreateTextureAssetInternal(
 
 	return Texture;
 }
+
+UTexture2D* UTextureBakerFunctionLibrary::BakeTextureAssetRGBA16FRows(
+	const FString& TexturePath, int32 Width, int32 Height, EPixelFormat PixelFormat, TextureMipGenSettings MipGenSettings,
+	FRowValueFunction RowValueFn)
+{
+	UTexture2D* Texture = CreateTextureAssetInternal(TexturePath, Width, Height, PixelFormat, TSF_RGBA16F);
+	BakeTextureInternal(Texture, Width, Height, TSF_RGBA16F, MipGenSettings, [&](uint8* OutData) {
+		BakePixelDataRGBA16F(Width, Height, RowValueFn, reinterpret_cast<FFloat16*>(OutData));
+	});
+	return Texture;
+}
+
+TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> UTextureBakerFunctionLibrary::CreateTextureAssetBakeJobRGBA16F(
+	const FString& TexturePath, int32 Width, int32 Height, EPixelFormat PixelFormat, TextureMipGenSettings MipGenSettings,
+	TFunction<FLinearColor(float X, float Y)> ValueFn)
+{
+	TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Job = FTextureBakeJob::CreateRGBA16F(
+		Width, Height, [ValueFn = MoveTemp(ValueFn)](float X0, float dX, float Y, int32 Count, FLinearColor* OutValues) {
+			for (int32 i = 0; i < Count; ++i)
+			{
+				OutValues[i] = ValueFn(X0 + i * dX, Y);
+			}
+		});
+
+	// PF_FloatRGBA job pixels have the layout of TSF_RGBA16F source data
+	Job->Upload = [TexturePath, Width, Height, PixelFormat, MipGenSettings](const uint8* PixelData) {
+		UTexture2D* Texture = CreateTextureAssetInternal(TexturePath, Width, Height, PixelFormat, TSF_RGBA16F);
+		BakeTextureInternal(Texture, Width, Height, TSF_RGBA16F, MipGenSettings, [&](uint8* OutData) {
+			FMemory::Memcpy(OutData, PixelData, Width * Height * FTextureSource::GetBytesPerPixel(TSF_RGBA16F));
+		});
+		return Texture;
+	};
+	return Job;
+}
+
+UVolumeTexture* UTextureBakerFunctionLibrary::CreateVolumeTextureAssetInternal(const FString& TexturePath)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousCreateTexture);
+
+	const FString TextureName = ObjectTools::SanitizeObjectName(FPaths::GetBaseFilename(TexturePath));
+	if (TextureName.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	const FString PackageName = UPackageTools::SanitizePackageName(TexturePath);
+	UPackage* AssetPackage = CreatePackage(*PackageName);
+
+	return NewObject<UVolumeTexture>(AssetPackage, FName(TextureName), RF_Public | RF_Standalone);
+}
+
+void UTextureBakerFunctionLibrary::BakeVolumeTextureInternal(
+	UVolumeTexture* Texture, int32 Width, int32 Height, int32 Depth, ETextureSourceFormat SourceFormat,
+	TextureMipGenSettings MipGenSettings, TFunctionRef<void(float X, float Y, float Z, uint8* OutData)> ValueFn)
+{
+	GALACTITIOUS_SCOPE_CYCLE_COUNTER(STAT_GalactitiousBakeTexture);
+
+	check(Width >= 1 && Height >= 1 && Depth >= 1);
+
+	if (!Texture)
+	{
+		return;
+	}
+
+	// Slices are stored consecutively in the source, bake straight into its storage
+	Texture->Source.Init(Width, Height, Depth, 1, SourceFormat);
+	uint8* SourceData = Texture->Source.LockMip(0);
+	if (!ensureMsgf(SourceData != nullptr, TEXT("Failed to lock volume texture source")))
+	{
+		return;
+	}
+	BakeVolumePixelData(Width, Height, Depth, FTextureSource::GetBytesPerPixel(SourceFormat), ValueFn, SourceData);
+	Texture->Source.UnlockMip(0);
+
+	Texture->MipGenSettings = MipGenSettings;
+	Texture->CompressionNoAlpha = true;
+	Texture->CompressionSettings =
+		SourceFormat == TSF_G8 ? TextureCompressionSettings::TC_Grayscale : TextureCompressionSettings::TC_Default;
+	Texture->Filter = TF_Bilinear;
+	Texture->AddressMode = TA_Clamp;
+	Texture->LODGroup = TEXTUREGROUP_Effects;
+	Texture->SRGB = false;
+
+	// Platform data is built from the source
+	Texture->UpdateResource();
+	Texture->PostEditChange();
+	Texture->MarkPackageDirty();
+	FAssetRegistryModule::AssetCreated(Texture);
+}
+
+bool UTextureBakerFunctionLibrary::ReadTextureSourceIntensity(UTexture2D* Texture, FIntPoint& OutSize, TArray<float>& OutValues)
+{
+	if (!ensureMsgf(Texture != nullptr && Texture->Source.IsValid(), TEXT("Texture has no source data")))
+	{
+		return false;
+	}
+
+	const ETextureSourceFormat SourceFormat = Texture->Source.GetFormat();
+	if (!ensureMsgf(
+			SourceFormat == TSF_G8 || SourceFormat == TSF_G16 || SourceFormat == TSF_BGRA8 || SourceFormat == TSF_RGBA16 ||
+				SourceFormat == TSF_RGBA16F,
+			TEXT("Unsupported source format of %s"), *Texture->GetPathName()))
+	{
+		return false;
+	}
+
+	const int32 Width = Texture->Source.GetSizeX();
+	const int32 Height = Texture->Source.GetSizeY();
+	const uint8* SourceData = Texture->Source.LockMipReadOnly(0);
+	if (!ensureMsgf(SourceData != nullptr, TEXT("Failed to lock texture source of %s"), *Texture->GetPathName()))
+	{
+		return false;
+	}
+
+	// Raw source values, sRGB sources are not linearized
+	OutValues.SetNumUninitialized(Width * Height);
+	ParallelFor(Height, [&](int32 y) {
+		for (int64 Index = (int64)y * Width; Index < (int64)(y + 1) * Width; ++Index)
+		{
+			float Value = 0.0f;
+			switch (SourceFormat)
+			{
+			case TSF_G8:
+				Value = SourceData[Index] / 255.0f;
+				break;
+			case TSF_G16:
+				Value = reinterpret_cast<const uint16*>(SourceData)[Index] / 65535.0f;
+				break;
+			case TSF_BGRA8:
+			{
+				const uint8* Pixel = SourceData + Index * 4;
+				Value = (Pixel[0] + Pixel[1] + Pixel[2]) / (3.0f * 255.0f);
+				break;
+			}
+			case TSF_RGBA16:
+			{
+				const uint16* Pixel = reinterpret_cast<const uint16*>(SourceData) + Index * 4;
+				Value = (Pixel[0] + Pixel[1] + Pixel[2]) / (3.0f * 65535.0f);
+				break;
+			}
+			case TSF_RGBA16F:
+			{
+				const FFloat16* Pixel = reinterpret_cast<const FFloat16*>(SourceData) + Index * 4;
+				Value = (Pixel[0].GetFloat() + Pixel[1].GetFloat() + Pixel[2].GetFloat()) / 3.0f;
+				break;
+			}
+			default:
+				break;
+			}
+			OutValues[Index] = Value;
+		}
+	});
+	Texture->Source.UnlockMip(0);
+
+	OutSize = FIntPoint(Width, Height);
+	return true;
+}
 #endif
 
 TFunction<float(float X, float Y)> UTextureBakerFunctionLibrary::FloatCurveEvalFunction(const FInterpCurveFloat& Curve)
@@ -5,10 +5,15 @@
 #include "CoreMinimal.h"
 
 #include "Engine/Texture.h"
+#include "Engine/Texture2D.h"
+#include "Engine/VolumeTexture.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "RenderCommandFence.h"
 
 #include "TextureBakerFunctionLibrary.generated.h"
 
+class FTextureBakeJob;
+
 struct FVector4_16
 {
 	FFloat16 X;
@@ -17,12 +22,34 @@ struct FVector4_16
 	FFloat16 W;
 };
 
+/**
+ * Staging data of region updates, reused across updates of one transient texture.
+ * Holds a copy of the uploaded image that is read by the render thread until the fence has passed.
+ */
+struct GALACTITIOUS_API FTextureUpdateStaging
+{
+	~FTextureUpdateStaging() { Fence.Wait(); }
+
+	TArray<uint8> PixelData;
+	FUpdateTextureRegion2D Region;
+	FRenderCommandFence Fence;
+};
+
+/** Fills Count colors of a row for pixels at X0 + i * dX. */
+using FRowValueFunction = TFunctionRef<void(float X0, float dX, float Y, int32 Count, FLinearColor* OutValues)>;
+
 UCLASS()
 class GALACTITIOUS_API UTextureBakerFunctionLibrary : public UBlueprintFunctionLibrary
 {
 	GENERATED_BODY()
 
 public:
+	/** Width and height of the pixel tiles that are baked in parallel. */
+	static constexpr int32 BakeTileSize = 64;
+
+	// Value functions are evaluated concurrently on worker threads and must be thread-safe.
+	// These bake the whole image synchronously, use FTextureBakeJob for bakes during gameplay.
+
 	template <typename ValueType>
 	static UTexture2D* BakeTransientTexture(
 		const FString& TexturePath, int32 Width, int32 Height, EPixelFormat PixelFormat, ETextureSourceFormat SourceFormat,
@@ -32,12 +59,15 @@ public:
 		check(sizeof(ValueType) == BytesPerPixel);
 		if (UTexture2D* Texture = CreateTransientTextureInternal(Width, Height, PixelFormat))
 		{
-			BakeTextureInternal(
-				Texture, Width, Height, PixelFormat, SourceFormat, MipGenSettings,
-				[ValueFn, BytesPerPixel](float X, float Y, uint8* OutData) {
-					ValueType Value = ValueFn(X, Y);
-					memcpy(OutData, &Value, BytesPerPixel);
-				});
+			BakeTextureInternal(Texture, Width, Height, SourceFormat, MipGenSettings, [&](uint8* OutData) {
+				BakePixelData(
+					Width, Height, BytesPerPixel,
+					[ValueFn, BytesPerPixel](float X, float Y, uint8* PixelData) {
+						ValueType Value = ValueFn(X, Y);
+						memcpy(PixelData, &Value, BytesPerPixel);
+					},
+					OutData);
+			});
 			return Texture;
 		}
 		return nullptr;
@@ -53,30 +83,140 @@ public:
 		check(sizeof(ValueType) == BytesPerPixel);
 		if (UTexture2D* Texture = CreateTextureAssetInternal(TexturePath, Width, Height, PixelFormat, SourceFormat))
 		{
-			BakeTextureInternal(
-				Texture, Width, Height, PixelFormat, SourceFormat, MipGenSettings,
-				[ValueFn, BytesPerPixel](float X, float Y, uint8* OutData) {
-					ValueType Value = ValueFn(X, Y);
+			BakeTextureInternal(Texture, Width, Height, SourceFormat, MipGenSettings, [&](uint8* OutData) {
+				BakePixelData(
+					Width, Height, BytesPerPixel,
+					[ValueFn, BytesPerPixel](float X, float Y, uint8* PixelData) {
+						ValueType Value = ValueFn(X, Y);
+						memcpy(PixelData, &Value, BytesPerPixel);
+					},
+					OutData);
+			});
+			return Texture;
+		}
+		return nullptr;
+	}
+
+	static UTexture2D* BakeTextureAssetRGBA16FRows(
+		const FString& TexturePath, int32 Width, int32 Height, EPixelFormat PixelFormat, TextureMipGenSettings MipGenSettings,
+		FRowValueFunction RowValueFn);
+
+	/**
+	 * Incremental bake of a texture asset with RGBA16F source data, the asset is created or replaced when the job finishes.
+	 * Add the job to UGalactitiousSubsystem, or tick it to completion where no engine loop runs.
+	 */
+	static TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> CreateTextureAssetBakeJobRGBA16F(
+		const FString& TexturePath, int32 Width, int32 Height, EPixelFormat PixelFormat, TextureMipGenSettings MipGenSettings,
+		TFunction<FLinearColor(float X, float Y)> ValueFn);
+
+	/**
+	 * Bake a volume texture asset. Z slices are baked in parallel tiles straight into the texture source storage,
+	 * so no intermediate copy of the volume is allocated.
+	 */
+	template <typename ValueType>
+	static UVolumeTexture* BakeVolumeTextureAsset(
+		const FString& TexturePath, int32 Width, int32 Height, int32 Depth, ETextureSourceFormat SourceFormat,
+		TextureMipGenSettings MipGenSettings, TFunctionRef<ValueType(float X, float Y, float Z)> ValueFn)
+	{
+		const int32 BytesPerPixel = FTextureSource::GetBytesPerPixel(SourceFormat);
+		check(sizeof(ValueType) == BytesPerPixel);
+		if (UVolumeTexture* Texture = CreateVolumeTextureAssetInternal(TexturePath))
+		{
+			BakeVolumeTextureInternal(
+				Texture, Width, Height, Depth, SourceFormat, MipGenSettings,
+				[ValueFn, BytesPerPixel](float X, float Y, float Z, uint8* OutData) {
+					ValueType Value = ValueFn(X, Y, Z);
 					memcpy(OutData, &Value, BytesPerPixel);
 				});
 			return Texture;
 		}
 		return nullptr;
 	}
+
+	/**
+	 * Read the first mip of the texture source as intensities, the mean of the color channels.
+	 * Supports G8, G16, BGRA8, RGBA16 and RGBA16F sources. Normalized formats yield values in [0, 1].
+	 */
+	static bool ReadTextureSourceIntensity(UTexture2D* Texture, FIntPoint& OutSize, TArray<float>& OutValues);
 #endif
 
-	TFunction<float(float X, float Y)> FloatCurveEvalFunction(const struct FInterpCurveFloat& Curve);
-	TFunction<FLinearColor(float X, float Y)> LinearColorCurveEvalFunction(const struct FInterpCurveLinearColor& Curve);
+	static TFunction<float(float X, float Y)> FloatCurveEvalFunction(const struct FInterpCurveFloat& Curve);
+	static TFunction<FLinearColor(float X, float Y)> LinearColorCurveEvalFunction(const struct FInterpCurveLinearColor& Curve);
+
+	/**
+	 * Evaluate the value function for all pixels into OutData, which must hold Width * Height * BytesPerPixel bytes.
+	 * Tiles are distributed over at most MaxThreads tasks, 0 uses all worker threads.
+	 */
+	static void BakePixelData(
+		int32 Width, int32 Height, int32 BytesPerPixel, TFunctionRef<void(float X, float Y, uint8* OutData)> ValueFn, uint8* OutData,
+		int32 MaxThreads = 0);
+
+	/**
+	 * Evaluate the row function for all pixels and write RGBA16F data into OutData, which must hold Width * Height * 4 halfs.
+	 * Rows of tiles are evaluated into a float buffer and converted with ConvertFloatToHalf.
+	 */
+	static void BakePixelDataRGBA16F(int32 Width, int32 Height, FRowValueFunction RowValueFn, FFloat16* OutData, int32 MaxThreads = 0);
+
+	/** Convert floats to half precision with round to nearest even. Uses F16C when the CPU supports it, or NEON. */
+	static void ConvertFloatToHalf(const float* Source, FFloat16* Dest, int32 Count);
+
+	/** Portable scalar conversion with round to nearest even, matching the vector conversions. NaN becomes a quiet NaN. */
+	static uint16 FloatToHalf(float Value);
+
+	/** Number of tiles of BakeTileSize covering the image, in row-major order. */
+	static int32 GetNumTiles(int32 Width, int32 Height);
+
+	/** Evaluate the value function for the pixels of a single tile into OutData, which holds the whole image. */
+	static void BakePixelTile(
+		int32 Width, int32 Height, int32 BytesPerPixel, int32 TileIndex, TFunctionRef<void(float X, float Y, uint8* OutData)> ValueFn,
+		uint8* OutData);
+
+	/** Evaluate the row function for the rows of a single tile and convert them to RGBA16F in OutData, which holds the whole image. */
+	static void BakePixelTileRGBA16F(int32 Width, int32 Height, int32 TileIndex, FRowValueFunction RowValueFn, FFloat16* OutData);
+
+	/**
+	 * Evaluate the value function for all voxels of a Width x Height x Depth volume into OutData, slice by slice.
+	 * Tiles of all slices are distributed over at most MaxThreads tasks, 0 uses all worker threads.
+	 */
+	static void BakeVolumePixelData(
+		int32 Width, int32 Height, int32 Depth, int32 BytesPerPixel, TFunctionRef<void(float X, float Y, float Z, uint8* OutData)> ValueFn,
+		uint8* OutData, int32 MaxThreads = 0);
+
+	/**
+	 * Copy pixel data into the first mip of a transient texture and update its resource.
+	 * A new texture is created if Texture is null or does not match size and format, otherwise Texture is reused.
+	 * Writes platform data directly and works in builds without editor-only texture source data. Game thread only.
+	 * Use TF_Nearest for tables whose neighbouring texels must not be blended.
+	 */
+	static UTexture2D* UpdateTransientTexture(
+		UTexture2D* Texture, int32 Width, int32 Height, EPixelFormat PixelFormat, const void* PixelData,
+		TextureFilter Filter = TF_Bilinear);
+
+	/**
+	 * Like UpdateTransientTexture, but reuses the texture resource of previous updates with the same staging data.
+	 * Only the bounding rectangle of pixels that differ from the previous update is uploaded with UpdateTextureRegions,
+	 * unchanged data uploads nothing. Falls back to UpdateTransientTexture for the first update or size and format changes.
+	 */
+	static UTexture2D* UpdateTransientTextureRegions(
+		UTexture2D* Texture, int32 Width, int32 Height, EPixelFormat PixelFormat, const void* PixelData, FTextureUpdateStaging& Staging,
+		TextureFilter Filter = TF_Bilinear);
 
 private:
+	/** Allocate the source data, let BakeFn fill it and apply texture settings. */
 	static void BakeTextureInternal(
-		UTexture2D* Texture, int32 Width, int32 Height, EPixelFormat PixelFormat, ETextureSourceFormat SourceFormat,
-		TextureMipGenSettings MipGenSettings, TFunctionRef<void(float X, float Y, uint8* OutData)> ValueFn);
+		UTexture2D* Texture, int32 Width, int32 Height, ETextureSourceFormat SourceFormat, TextureMipGenSettings MipGenSettings,
+		TFunctionRef<void(uint8* OutData)> BakeFn);
 
 	static UTexture2D* CreateTransientTextureInternal(int32 Width, int32 Height, EPixelFormat PixelFormat);
 
 #if WITH_EDITOR
 	static UTexture2D* CreateTextureAssetInternal(
 		const FString& TexturePath, int32 Width, int32 Height, EPixelFormat PixelFormat, ETextureSourceFormat SourceFormat);
+
+	static UVolumeTexture* CreateVolumeTextureAssetInternal(const FString& TexturePath);
+
+	static void BakeVolumeTextureInternal(
+		UVolumeTexture* Texture, int32 Width, int32 Height, int32 Depth, ETextureSourceFormat SourceFormat,
+		TextureMipGenSettings MipGenSettings, TFunctionRef<void(float X, float Y, float Z, uint8* OutData)> ValueFn);
 #endif
 };
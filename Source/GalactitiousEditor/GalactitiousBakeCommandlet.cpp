@@ -0,0 +1,335 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBakeCommandlet.h"
+
+#include "GalaxyImpostor.h"
+#include "GalaxyReferenceRenderer.h"
+#include "NiagaraParameterCollection.h"
+#include "StarGenerator.h"
+#include "StellarSamplingData.h"
+#include "TelescopeData.h"
+#include "TextureBakeJob.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGalactitiousBake, Log, All);
+
+namespace
+{
+	template <typename AssetType>
+	TArray<AssetType*> LoadAssetsOfClass(IAssetRegistry& AssetRegistry, const FName& PackagePath)
+	{
+		FARFilter Filter;
+		Filter.ClassNames.Add(AssetType::StaticClass()->GetFName());
+		Filter.bRecursiveClasses = true;
+		Filter.PackagePaths.Add(PackagePath);
+		Filter.bRecursivePaths = true;
+
+		TArray<FAssetData> AssetDataList;
+		AssetRegistry.GetAssets(Filter, AssetDataList);
+
+		TArray<AssetType*> Assets;
+		Assets.Reserve(AssetDataList.Num());
+		for (const FAssetData& AssetData : AssetDataList)
+		{
+			if (AssetType* Asset = Cast<AssetType>(AssetData.GetAsset()))
+			{
+				Assets.Add(Asset);
+			}
+			else
+			{
+				UE_LOG(LogGalactitiousBake, Error, TEXT("Failed to load %s"), *AssetData.ObjectPath.ToString());
+			}
+		}
+		return Assets;
+	}
+
+	/** Sampling data derivation for a settings asset, executed on worker threads. */
+	template <typename SettingsType, typename SamplingDataType>
+	struct TDerivationJob
+	{
+		SettingsType* Settings = nullptr;
+		SamplingDataType SamplingData;
+		bool bSuccess = false;
+		double Seconds = 0.0;
+
+		void Run()
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			bSuccess = Settings->ComputeSamplingData(SamplingData);
+			Seconds = FPlatformTime::Seconds() - StartTime;
+		}
+	};
+
+	using FShapeDerivationJob = TDerivationJob<UGalaxyShapeSettings, FGalaxyShapeSamplingData>;
+	using FStarDerivationJob = TDerivationJob<UStarSettings, FStarSamplingData>;
+
+	template <typename AssetType, typename JobType>
+	TArray<JobType> MakeDerivationJobs(const TArray<AssetType*>& Assets)
+	{
+		TArray<JobType> Jobs;
+		Jobs.SetNum(Assets.Num());
+		for (int32 i = 0; i < Assets.Num(); ++i)
+		{
+			Jobs[i].Settings = Assets[i];
+		}
+		return Jobs;
+	}
+
+	/** Push derived data to the Niagara parameter collection and return the package that needs saving. */
+	template <typename JobType>
+	UPackage* FinishDerivationJob(JobType& Job)
+	{
+		if (!Job.bSuccess)
+		{
+			UE_LOG(LogGalactitiousBake, Error, TEXT("Failed to derive sampling data for %s"), *Job.Settings->GetPathName());
+			return nullptr;
+		}
+		if (Job.Settings->NiagaraParameters == nullptr || Job.Settings->NiagaraParameters->Collection == nullptr)
+		{
+			UE_LOG(LogGalactitiousBake, Error, TEXT("%s has no Niagara parameter collection"), *Job.Settings->GetPathName());
+			return nullptr;
+		}
+
+		Job.Settings->PushNiagaraParameters(Job.SamplingData);
+
+		UE_LOG(LogGalactitiousBake, Display, TEXT("Derived %s in %.2f ms"), *Job.Settings->GetPathName(), Job.Seconds * 1000.0);
+		UNiagaraParameterCollection* Collection = Job.Settings->NiagaraParameters->Collection;
+		Collection->MarkPackageDirty();
+		return Collection->GetOutermost();
+	}
+
+	/** Camera distance of reference images relative to the galaxy radius. */
+	const float ReferenceCameraDistance = 3.0f;
+
+	/** Render reference images of an impostor asset at its inclinations, as thumbnails and ground truth for the real-time look. */
+	bool RenderReferenceImages(const UGalaxyImpostorData& Impostor, int32 NumPasses)
+	{
+		FGalaxyShapeSamplingData ShapeData;
+		FStarSamplingData StarData;
+		FStarBuffer Stars;
+		FStarGeneratorSettings GeneratorSettings;
+		GeneratorSettings.NumParticles = Impostor.NumParticles;
+		GeneratorSettings.Seed = Impostor.Seed;
+		GeneratorSettings.Sequence = Impostor.Sequence;
+		if (Impostor.ShapeSettings == nullptr || Impostor.StarSettings == nullptr ||
+			!Impostor.ShapeSettings->ComputeSamplingData(ShapeData) || !Impostor.StarSettings->ComputeSamplingData(StarData) ||
+			!FGalaxyStarGenerator::Generate(*Impostor.ShapeSettings, ShapeData, StarData, GeneratorSettings, Stars))
+		{
+			UE_LOG(LogGalactitiousBake, Error, TEXT("Failed to generate stars for %s"), *Impostor.GetPathName());
+			return false;
+		}
+
+		for (const float Inclination : Impostor.Inclinations)
+		{
+			// Same view as the impostor bake, tilted around the galaxy X axis
+			float Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Inclination));
+			FGalaxyRenderSettings RenderSettings;
+			RenderSettings.CameraPosition = FVector(0.0f, -Sin, Cos) * ReferenceCameraDistance;
+			RenderSettings.CameraUp = FVector(0.0f, Cos, Sin);
+			RenderSettings.Seed = Impostor.Seed;
+
+			FGalaxyReferenceRenderer Renderer;
+			if (!Renderer.Initialize(*Impostor.ShapeSettings, Stars, RenderSettings))
+			{
+				return false;
+			}
+			const double StartTime = FPlatformTime::Seconds();
+			Renderer.Render(NumPasses);
+			const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+			const FString Filename = FPaths::ProjectSavedDir() / TEXT("Galactitious") / TEXT("Reference") /
+									 FString::Printf(TEXT("%s_%d.exr"), *Impostor.GetName(), FMath::RoundToInt(Inclination));
+			if (!Renderer.SaveImage(Filename))
+			{
+				UE_LOG(LogGalactitiousBake, Error, TEXT("Failed to write %s"), *Filename);
+				return false;
+			}
+			UE_LOG(
+				LogGalactitiousBake, Display, TEXT("Rendered %s in %.2f s (%d passes, %d stolen tiles)"), *Filename, Seconds,
+				Renderer.GetNumPasses(), Renderer.GetNumStolenTiles());
+		}
+		return true;
+	}
+
+	/** Tick a bake job that runs on workers until it is finished, returns true if it completed. */
+	bool WaitForBakeJob(FTextureBakeJob& Job)
+	{
+		while (!Job.Tick(0.0))
+		{
+			FPlatformProcess::Sleep(0.001f);
+		}
+		return Job.GetState() == FTextureBakeJob::EState::Completed;
+	}
+
+	bool SavePackage(UPackage* Package)
+	{
+		const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+		if (!UPackage::SavePackage(Package, nullptr, RF_Standalone, *Filename, GError, nullptr, false, true, SAVE_NoError))
+		{
+			UE_LOG(LogGalactitiousBake, Error, TEXT("Failed to save %s"), *Filename);
+			return false;
+		}
+
+		UE_LOG(LogGalactitiousBake, Display, TEXT("Saved %s"), *Filename);
+		return true;
+	}
+} // namespace
+
+UGalactitiousBakeCommandlet::UGalactitiousBakeCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UGalactitiousBakeCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens, Switches;
+	TMap<FString, FString> ParamsMap;
+	ParseCommandLine(*Params, Tokens, Switches, ParamsMap);
+
+	const bool bSave = !Switches.Contains(TEXT("nosave"));
+	const bool bReference = Switches.Contains(TEXT("reference"));
+	const FString* ReferencePassesParam = ParamsMap.Find(TEXT("referencepasses"));
+	const int32 ReferencePasses = ReferencePassesParam ? FMath::Max(FCString::Atoi(**ReferencePassesParam), 1) : 16;
+	const FString* PathParam = ParamsMap.Find(TEXT("path"));
+	const FName PackagePath = PathParam ? FName(**PathParam) : FName(TEXT("/Game"));
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	const TArray<UTelescopeData*> TelescopeAssets = LoadAssetsOfClass<UTelescopeData>(AssetRegistry, PackagePath);
+	const TArray<UGalaxyShapeSettings*> ShapeAssets = LoadAssetsOfClass<UGalaxyShapeSettings>(AssetRegistry, PackagePath);
+	const TArray<UStarSettings*> StarAssets = LoadAssetsOfClass<UStarSettings>(AssetRegistry, PackagePath);
+	UE_LOG(
+		LogGalactitiousBake, Display, TEXT("Found %d telescope, %d galaxy shape and %d star settings assets in %s"), TelescopeAssets.Num(),
+		ShapeAssets.Num(), StarAssets.Num(), *PackagePath.ToString());
+
+	const double StartTime = FPlatformTime::Seconds();
+	bool bFailed = false;
+	TSet<UPackage*> PackagesToSave;
+
+	// Sampling data derivation does not touch UObjects and runs on worker threads,
+	// while texture bakes have to create assets on the game thread.
+	TArray<FShapeDerivationJob> ShapeJobs = MakeDerivationJobs<UGalaxyShapeSettings, FShapeDerivationJob>(ShapeAssets);
+	TArray<FStarDerivationJob> StarJobs = MakeDerivationJobs<UStarSettings, FStarDerivationJob>(StarAssets);
+	TFuture<void> DerivationResult = Async(EAsyncExecution::ThreadPool, [&ShapeJobs, &StarJobs]() {
+		ParallelFor(ShapeJobs.Num() + StarJobs.Num(), [&ShapeJobs, &StarJobs](int32 Index) {
+			if (Index < ShapeJobs.Num())
+			{
+				ShapeJobs[Index].Run();
+			}
+			else
+			{
+				StarJobs[Index - ShapeJobs.Num()].Run();
+			}
+		});
+	});
+
+	const double TelescopeStartTime = FPlatformTime::Seconds();
+	TArray<TPair<UTelescopeData*, TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe>>> TelescopeJobs;
+	for (UTelescopeData* Telescope : TelescopeAssets)
+	{
+		if (Telescope->AiryDiskTexture == nullptr)
+		{
+			UE_LOG(LogGalactitiousBake, Error, TEXT("%s has no Airy disk texture"), *Telescope->GetPathName());
+			bFailed = true;
+			continue;
+		}
+
+		// The subsystem is not ticked in commandlets, jobs bake on workers and are finished below
+		if (TSharedPtr<FTextureBakeJob, ESPMode::ThreadSafe> Job = Telescope->CreateBakeJob())
+		{
+			Job->StartWorkers();
+			TelescopeJobs.Emplace(Telescope, Job.ToSharedRef());
+		}
+		else
+		{
+			UE_LOG(LogGalactitiousBake, Error, TEXT("Failed to bake %s"), *Telescope->GetPathName());
+			bFailed = true;
+		}
+	}
+
+	for (UGalaxyShapeSettings* Shape : ShapeAssets)
+	{
+		if (Shape->GasVolumeTexture == nullptr)
+		{
+			continue;
+		}
+
+		const double BakeStartTime = FPlatformTime::Seconds();
+		Shape->BakeTextures();
+		const double BakeSeconds = FPlatformTime::Seconds() - BakeStartTime;
+		UE_LOG(LogGalactitiousBake, Display, TEXT("Baked gas volume of %s in %.2f ms"), *Shape->GetPathName(), BakeSeconds * 1000.0);
+
+		if (Shape->GasVolumeTexture)
+		{
+			PackagesToSave.Add(Shape->GetOutermost());
+			PackagesToSave.Add(Shape->GasVolumeTexture->GetOutermost());
+		}
+	}
+
+	for (const TPair<UTelescopeData*, TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe>>& Pair : TelescopeJobs)
+	{
+		UTelescopeData* Telescope = Pair.Key;
+		if (!WaitForBakeJob(*Pair.Value))
+		{
+			UE_LOG(LogGalactitiousBake, Error, TEXT("Failed to bake %s"), *Telescope->GetPathName());
+			bFailed = true;
+			continue;
+		}
+		const double BakeSeconds = FPlatformTime::Seconds() - TelescopeStartTime;
+		UE_LOG(LogGalactitiousBake, Display, TEXT("Baked %s after %.2f ms"), *Telescope->GetPathName(), BakeSeconds * 1000.0);
+
+		PackagesToSave.Add(Telescope->GetOutermost());
+		PackagesToSave.Add(Telescope->AiryDiskTexture->GetOutermost());
+	}
+
+	if (bReference)
+	{
+		for (UGalaxyImpostorData* Impostor : LoadAssetsOfClass<UGalaxyImpostorData>(AssetRegistry, PackagePath))
+		{
+			bFailed |= !RenderReferenceImages(*Impostor, ReferencePasses);
+		}
+	}
+
+	DerivationResult.Wait();
+
+	for (FShapeDerivationJob& Job : ShapeJobs)
+	{
+		UPackage* Package = FinishDerivationJob(Job);
+		bFailed |= (Package == nullptr);
+		if (Package)
+		{
+			PackagesToSave.Add(Package);
+		}
+	}
+	for (FStarDerivationJob& Job : StarJobs)
+	{
+		UPackage* Package = FinishDerivationJob(Job);
+		bFailed |= (Package == nullptr);
+		if (Package)
+		{
+			PackagesToSave.Add(Package);
+		}
+	}
+
+	if (bSave)
+	{
+		for (UPackage* Package : PackagesToSave)
+		{
+			bFailed |= !SavePackage(Package);
+		}
+	}
+
+	UE_LOG(LogGalactitiousBake, Display, TEXT("Finished in %.2f s"), FPlatformTime::Seconds() - StartTime);
+	return bFailed ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "GalactitiousBakeCommandlet.generated.h"
+
+/**
+ * Bakes textures and derives sampling tables of all telescope, galaxy shape and star settings assets
+ * without an editor session, so outputs can be regenerated on build machines.
+ *
+ * With -reference, also renders CPU reference images of all impostor assets to Saved/Galactitious/Reference.
+ *
+ * Usage: UE4Editor-Cmd Galactitious.uproject -run=GalactitiousBake [-path=/Game] [-nosave] [-reference [-referencepasses=16]]
+ *        -nullrhi -unattended
+ */
+UCLASS()
+class UGalactitiousBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGalactitiousBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
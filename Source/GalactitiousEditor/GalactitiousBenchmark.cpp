@@ -0,0 +1,226 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBenchmark.h"
+
+#include "NiagaraDataInterface.h"
+#include "VectorVM.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGalactitiousBenchmark, Log, All);
+
+TSharedRef<FJsonObject> FGalactitiousBenchmarkReport::AddResult(const FString& Suite, const FString& Name)
+{
+	TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
+	Result->SetStringField(TEXT("suite"), Suite);
+	Result->SetStringField(TEXT("name"), Name);
+	Results.Add(MakeShared<FJsonValueObject>(Result));
+	return Result;
+}
+
+TSharedRef<FJsonObject> FGalactitiousBenchmarkReport::AddResult(
+	const FString& Suite, const FString& Name, const FGalactitiousBenchmarkTiming& Timing)
+{
+	TSharedRef<FJsonObject> Result = AddResult(Suite, Name);
+	Result->SetNumberField(TEXT("iterations"), Timing.NumIterations);
+	Result->SetNumberField(TEXT("ns_per_op"), Timing.NanosecondsPerOp);
+	// Allocation figures are process wide, the prefix keeps them from being read as exact per-operation costs
+	Result->SetNumberField(TEXT("approx_allocs_per_op"), Timing.AllocationsPerOp);
+	Result->SetNumberField(TEXT("approx_peak_bytes"), (double)Timing.PeakBytes);
+	return Result;
+}
+
+void FGalactitiousBenchmarkReport::AddCheck(const FString& Suite, const FString& Name, bool bPassed, const FString& Details)
+{
+	TSharedRef<FJsonObject> Check = MakeShared<FJsonObject>();
+	Check->SetStringField(TEXT("suite"), Suite);
+	Check->SetStringField(TEXT("name"), Name);
+	Check->SetBoolField(TEXT("passed"), bPassed);
+	Check->SetStringField(TEXT("details"), Details);
+	Checks.Add(MakeShared<FJsonValueObject>(Check));
+
+	if (bPassed)
+	{
+		UE_LOG(LogGalactitiousBenchmark, Display, TEXT("[%s] %s passed %s"), *Suite, *Name, *Details);
+	}
+	else
+	{
+		UE_LOG(LogGalactitiousBenchmark, Error, TEXT("[%s] %s FAILED %s"), *Suite, *Name, *Details);
+		FailedChecks.Add(FString::Printf(TEXT("[%s] %s %s"), *Suite, *Name, *Details));
+	}
+}
+
+bool FGalactitiousBenchmarkReport::WriteToFile(const FString& Filename) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+	Root->SetStringField(TEXT("cpu"), FPlatformMisc::GetCPUBrand());
+	Root->SetNumberField(TEXT("cores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	Root->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+	Root->SetArrayField(TEXT("results"), Results);
+	Root->SetArrayField(TEXT("checks"), Checks);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	if (!FJsonSerializer::Serialize(Root, Writer))
+	{
+		return false;
+	}
+	return FFileHelper::SaveStringToFile(JsonString, *Filename);
+}
+
+FAllocationCounter::FAllocationCounter()
+{
+	const int64 FirstCalls = ReadNumAllocatorCalls();
+	StartCalls = ReadNumAllocatorCalls();
+
+	// Reading the statistics allocates, counters that did not move are not maintained by the allocator
+	ReadCalls = StartCalls - FirstCalls;
+	if (FirstCalls == INDEX_NONE || ReadCalls <= 0)
+	{
+		StartCalls = INDEX_NONE;
+	}
+
+	StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+}
+
+void FAllocationCounter::Sample()
+{
+	const int64 UsedBytes = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)StartUsedPhysical;
+	PeakBytes = FMath::Max(PeakBytes, UsedBytes);
+}
+
+int64 FAllocationCounter::GetNumAllocations() const
+{
+	if (StartCalls == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+	return FMath::Max(ReadNumAllocatorCalls() - StartCalls - ReadCalls, (int64)0);
+}
+
+int64 FAllocationCounter::ReadNumAllocatorCalls()
+{
+	FGenericMemoryStats Stats;
+	GMalloc->GetAllocatorStats(Stats);
+	const SIZE_T* MallocCalls = Stats.Data.Find(TEXT("Total Malloc Calls"));
+	const SIZE_T* ReallocCalls = Stats.Data.Find(TEXT("Total Realloc Calls"));
+	return MallocCalls && ReallocCalls ? (int64)(*MallocCalls + *ReallocCalls) : INDEX_NONE;
+}
+
+FGalactitiousBenchmarkTiming MeasureBenchmark(const FGalactitiousBenchmarkSettings& Settings, TFunctionRef<void()> Operation)
+{
+	// Warm up caches and let reused buffers reach their steady state size
+	Operation();
+
+	FGalactitiousBenchmarkTiming Timing;
+	const uint64 MinCycles = (uint64)(Settings.MinSeconds / FPlatformTime::GetSecondsPerCycle64());
+	const uint64 SampleIntervalCycles = (uint64)(0.001 / FPlatformTime::GetSecondsPerCycle64());
+	uint64 Cycles = 0;
+	uint64 LastSampleCycles = 0;
+
+	FAllocationCounter AllocationCounter;
+	while (Timing.NumIterations < Settings.MaxIterations && (Timing.NumIterations < Settings.MinIterations || Cycles < MinCycles))
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Operation();
+		const uint64 EndCycles = FPlatformTime::Cycles64();
+		Cycles += EndCycles - StartCycles;
+		++Timing.NumIterations;
+
+		// Sampling is not timed, but limited for operations much faster than reading the memory statistics
+		if (EndCycles - LastSampleCycles >= SampleIntervalCycles)
+		{
+			AllocationCounter.Sample();
+			LastSampleCycles = EndCycles;
+		}
+	}
+	AllocationCounter.Sample();
+	const int64 NumAllocations = AllocationCounter.GetNumAllocations();
+
+	Timing.NanosecondsPerOp = FPlatformTime::ToSeconds64(Cycles) * 1.0e9 / Timing.NumIterations;
+	Timing.AllocationsPerOp = NumAllocations != INDEX_NONE ? (double)NumAllocations / Timing.NumIterations : -1.0;
+	Timing.PeakBytes = AllocationCounter.GetPeakBytes();
+	return Timing;
+}
+
+bool ExecuteVMExternalFunction(
+	UNiagaraDataInterface& DataInterface, FName Name, TArrayView<const void* const> Inputs, TArrayView<void* const> Outputs,
+	int32 NumInstances)
+{
+	// Data interfaces with per-instance data take a user pointer as their first input, a constant index into the user pointers
+	TArray<uint8, TAlignedHeapAllocator<16>> InstanceData;
+	InstanceData.SetNumZeroed(DataInterface.PerInstanceDataSize());
+	const bool bUserPtr = InstanceData.Num() > 0;
+	FVMExternalFunctionBindingInfo BindingInfo;
+	BindingInfo.Name = Name;
+	if (bUserPtr)
+	{
+		BindingInfo.InputParamLocations.Add(false);
+	}
+	for (int32 Input = 0; Input < Inputs.Num(); ++Input)
+	{
+		BindingInfo.InputParamLocations.Add(true);
+	}
+	BindingInfo.NumOutputs = Outputs.Num();
+
+	if (bUserPtr && !DataInterface.InitPerInstanceData(InstanceData.GetData(), nullptr))
+	{
+		return false;
+	}
+	FVMExternalFunction Function;
+	DataInterface.GetVMExternalFunction(BindingInfo, bUserPtr ? InstanceData.GetData() : nullptr, Function);
+	const bool bBound = Function.IsBound();
+	if (bBound)
+	{
+		// Operands of the call, the user pointer constant followed by a temp register per input and output
+		TArray<uint16> Code;
+		if (bUserPtr)
+		{
+			Code.Add(0);
+		}
+		for (int32 Input = 0; Input < Inputs.Num(); ++Input)
+		{
+			Code.Add(VVM_EXT_FUNC_INPUT_LOC_BIT | Input);
+		}
+		for (int32 Output = 0; Output < Outputs.Num(); ++Output)
+		{
+			Code.Add(Inputs.Num() + Output);
+		}
+
+		const int32 UserPtrIndex = 0;
+		const uint8* ConstantTable = (const uint8*)&UserPtrIndex;
+		const int32 ConstantTableSize = sizeof(UserPtrIndex);
+		void* UserPtrTable[] = {InstanceData.GetData()};
+		const FVMExternalFunction* FunctionTable[] = {&Function};
+
+		// Chunks of the size the VM executes, the registers only hold one chunk
+		const int32 ChunkSize = 128;
+		FVectorVMContext& Context = FVectorVMContext::Get();
+		Context.PrepareForExec(
+			Inputs.Num() + Outputs.Num(), 1, &ConstantTable, &ConstantTableSize, FunctionTable, UserPtrTable, TArrayView<FDataSetMeta>(),
+			FMath::Min(NumInstances, ChunkSize), false);
+		for (int32 Start = 0; Start < NumInstances; Start += ChunkSize)
+		{
+			const int32 Count = FMath::Min(NumInstances - Start, ChunkSize);
+			Context.PrepareForChunk((const uint8*)Code.GetData(), Count, Start);
+			for (int32 Input = 0; Input < Inputs.Num(); ++Input)
+			{
+				FMemory::Memcpy(Context.GetTempRegister(Input), (const uint32*)Inputs[Input] + Start, Count * sizeof(uint32));
+			}
+			Function.Execute(Context);
+			for (int32 Output = 0; Output < Outputs.Num(); ++Output)
+			{
+				FMemory::Memcpy((uint32*)Outputs[Output] + Start, Context.GetTempRegister(Inputs.Num() + Output), Count * sizeof(uint32));
+			}
+		}
+		Context.FinishExec();
+	}
+
+	if (bUserPtr)
+	{
+		DataInterface.DestroyPerInstanceData(InstanceData.GetData(), nullptr);
+	}
+	return bBound;
+}
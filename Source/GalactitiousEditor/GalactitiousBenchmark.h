@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+
+class UNiagaraDataInterface;
+
+struct FGalactitiousBenchmarkSettings
+{
+	/** Minimum measured time per benchmark, iterations are repeated until this is reached. */
+	double MinSeconds = 0.1;
+	int32 MinIterations = 3;
+	int32 MaxIterations = 1000000;
+
+	/** Largest texture resolution used by bake benchmarks. */
+	int32 MaxBakeResolution = 8192;
+
+	/** Number of samples drawn per sampler validation. */
+	int32 NumSamplerSamples = 4 * 1024 * 1024;
+};
+
+struct FGalactitiousBenchmarkTiming
+{
+	int32 NumIterations = 0;
+	double NanosecondsPerOp = 0.0;
+	/**
+	 * Approximate, includes allocations of other threads during the measurement, see FAllocationCounter.
+	 * Negative if the allocator does not count its calls.
+	 */
+	double AllocationsPerOp = 0.0;
+	/** Approximate peak growth of resident memory of the process during the measurement, sampled between calls. */
+	int64 PeakBytes = 0;
+};
+
+/** Collects benchmark results and validation checks and writes them as machine-readable JSON. */
+class FGalactitiousBenchmarkReport
+{
+public:
+	explicit FGalactitiousBenchmarkReport(const FGalactitiousBenchmarkSettings& InSettings) : Settings(InSettings) {}
+
+	const FGalactitiousBenchmarkSettings& GetSettings() const { return Settings; }
+
+	/** Add a result row, benchmark parameters and metrics are set on the returned object. */
+	TSharedRef<FJsonObject> AddResult(const FString& Suite, const FString& Name);
+	/** Add a result row with the standard timing metrics. */
+	TSharedRef<FJsonObject> AddResult(const FString& Suite, const FString& Name, const FGalactitiousBenchmarkTiming& Timing);
+
+	void AddCheck(const FString& Suite, const FString& Name, bool bPassed, const FString& Details = FString());
+	int32 GetNumFailedChecks() const { return FailedChecks.Num(); }
+	const TArray<FString>& GetFailedChecks() const { return FailedChecks; }
+
+	bool WriteToFile(const FString& Filename) const;
+
+private:
+	FGalactitiousBenchmarkSettings Settings;
+	TArray<TSharedPtr<FJsonValue>> Results;
+	TArray<TSharedPtr<FJsonValue>> Checks;
+	TArray<FString> FailedChecks;
+};
+
+/**
+ * Counts heap allocations through the allocator statistics of GMalloc. GMalloc is never replaced, so counting is safe while
+ * other threads allocate, but the statistics are process wide and include allocations of other threads.
+ * Task graph workers, the async loader and parallel operations under measurement all contribute, so the figures are approximate
+ * and reported with an approx_ prefix. Compare them across runs, not as exact costs of an operation.
+ */
+class FAllocationCounter
+{
+public:
+	FAllocationCounter();
+
+	/** Update the peak of resident memory, called between measured operations. */
+	void Sample();
+
+	/** Allocations since construction, INDEX_NONE if the allocator does not count its calls. */
+	int64 GetNumAllocations() const;
+
+	/** Peak growth of the resident memory of the process over the samples. */
+	int64 GetPeakBytes() const { return PeakBytes; }
+
+private:
+	static int64 ReadNumAllocatorCalls();
+
+	int64 StartCalls = INDEX_NONE;
+
+	/** Allocator calls made by reading the statistics. */
+	int64 ReadCalls = 0;
+
+	uint64 StartUsedPhysical = 0;
+	int64 PeakBytes = 0;
+};
+
+/** Run the operation repeatedly and measure time and allocations per call. */
+FGalactitiousBenchmarkTiming MeasureBenchmark(const FGalactitiousBenchmarkSettings& Settings, TFunctionRef<void()> Operation);
+
+/**
+ * Bind a VM function of a data interface and call it the way a CPU emitter does, with per-instance data initialized by the data
+ * interface as the first operand. Inputs and outputs point to NumInstances 32-bit values, one register each.
+ * Returns false if the data interface does not bind the function.
+ */
+bool ExecuteVMExternalFunction(
+	UNiagaraDataInterface& DataInterface, FName Name, TArrayView<const void* const> Inputs, TArrayView<void* const> Outputs,
+	int32 NumInstances);
+
+// Benchmark suites
+void RunProbabilityCurveBenchmarks(FGalactitiousBenchmarkReport& Report);
+void RunTextureBakeBenchmarks(FGalactitiousBenchmarkReport& Report);
+void RunStellarSamplerBenchmarks(FGalactitiousBenchmarkReport& Report);
+void RunGalaxyRenderBenchmarks(FGalactitiousBenchmarkReport& Report);
+void RunGalaxyRuntimeBenchmarks(FGalactitiousBenchmarkReport& Report);
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBenchmarkCommandlet.h"
+
+#include "GalactitiousBenchmark.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogGalactitiousBenchmark, Log, All);
+
+namespace
+{
+	struct FBenchmarkSuite
+	{
+		const TCHAR* Name;
+		void (*Run)(FGalactitiousBenchmarkReport& Report);
+	};
+
+	const FBenchmarkSuite BenchmarkSuites[] = {
+		{TEXT("curves"), &RunProbabilityCurveBenchmarks},
+		{TEXT("bake"), &RunTextureBakeBenchmarks},
+		{TEXT("sampler"), &RunStellarSamplerBenchmarks},
+		{TEXT("render"), &RunGalaxyRenderBenchmarks},
+		{TEXT("runtime"), &RunGalaxyRuntimeBenchmarks},
+	};
+} // namespace
+
+UGalactitiousBenchmarkCommandlet::UGalactitiousBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UGalactitiousBenchmarkCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens, Switches;
+	TMap<FString, FString> ParamsMap;
+	ParseCommandLine(*Params, Tokens, Switches, ParamsMap);
+
+	FGalactitiousBenchmarkSettings Settings;
+	if (const FString* MinTimeParam = ParamsMap.Find(TEXT("mintime")))
+	{
+		Settings.MinSeconds = FCString::Atod(**MinTimeParam);
+	}
+	if (const FString* MaxResolutionParam = ParamsMap.Find(TEXT("maxresolution")))
+	{
+		Settings.MaxBakeResolution = FCString::Atoi(**MaxResolutionParam);
+	}
+	if (const FString* SamplesParam = ParamsMap.Find(TEXT("samples")))
+	{
+		Settings.NumSamplerSamples = FCString::Atoi(**SamplesParam);
+	}
+
+	TArray<FString> SuiteNames;
+	if (const FString* SuiteParam = ParamsMap.Find(TEXT("suite")))
+	{
+		SuiteParam->ParseIntoArray(SuiteNames, TEXT(","));
+	}
+
+	const FString* OutputParam = ParamsMap.Find(TEXT("output"));
+	const FString OutputFilename =
+		OutputParam ? *OutputParam : FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), TEXT("GalactitiousBenchmark.json"));
+
+	FGalactitiousBenchmarkReport Report(Settings);
+	for (const FBenchmarkSuite& Suite : BenchmarkSuites)
+	{
+		if (SuiteNames.Num() > 0 && !SuiteNames.Contains(Suite.Name))
+		{
+			continue;
+		}
+
+		UE_LOG(LogGalactitiousBenchmark, Display, TEXT("Running benchmark suite %s"), Suite.Name);
+		const double StartTime = FPlatformTime::Seconds();
+		Suite.Run(Report);
+		UE_LOG(LogGalactitiousBenchmark, Display, TEXT("Finished %s in %.2f s"), Suite.Name, FPlatformTime::Seconds() - StartTime);
+	}
+
+	if (!Report.WriteToFile(OutputFilename))
+	{
+		UE_LOG(LogGalactitiousBenchmark, Error, TEXT("Failed to write results to %s"), *OutputFilename);
+		return 1;
+	}
+	UE_LOG(LogGalactitiousBenchmark, Display, TEXT("Results written to %s"), *OutputFilename);
+
+	if (Report.GetNumFailedChecks() > 0)
+	{
+		UE_LOG(LogGalactitiousBenchmark, Error, TEXT("%d validation checks failed"), Report.GetNumFailedChecks());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+
+#include "GalactitiousBenchmarkCommandlet.generated.h"
+
+/**
+ * Runs validation checks and benchmarks and writes the results as JSON.
+ * Returns a non-zero exit code if any validation check fails.
+ *
+ * Usage: UE4Editor-Cmd Galactitious.uproject -run=GalactitiousBenchmark [-suite=curves,bake,sampler,render,runtime] [-output=Results.json]
+ *        [-mintime=0.1] [-maxresolution=8192] [-samples=4194304] -nullrhi
+ */
+UCLASS()
+class UGalactitiousBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UGalactitiousBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
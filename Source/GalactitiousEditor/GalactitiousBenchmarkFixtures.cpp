@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBenchmarkFixtures.h"
+
+#include "Curves/CurveFloat.h"
+#include "Engine/DataTable.h"
+#include "UObject/UObjectGlobals.h"
+
+UGalaxyShapeSettings* MakeTestShapeSettings()
+{
+	UCurveFloat* DensityCurve = NewObject<UCurveFloat>(GetTransientPackage());
+	const int32 NumKeys = 33;
+	for (int32 i = 0; i < NumKeys; ++i)
+	{
+		const float Radius = (float)i / (NumKeys - 1);
+		const float Density = Radius * FMath::Exp(-Radius / 0.25f) + 0.3f * FMath::Exp(-FMath::Square(Radius / 0.1f));
+		const FKeyHandle Handle = DensityCurve->FloatCurve.AddKey(Radius, Density);
+		DensityCurve->FloatCurve.SetKeyInterpMode(Handle, RCIM_Cubic);
+	}
+	DensityCurve->FloatCurve.AutoSetTangents();
+
+	UGalaxyShapeSettings* ShapeSettings = NewObject<UGalaxyShapeSettings>(GetTransientPackage());
+	ShapeSettings->RadialDensityCurve = DensityCurve;
+	return ShapeSettings;
+}
+
+UStarSettings* MakeTestStarSettings()
+{
+	struct FClassRow
+	{
+		const TCHAR* Name;
+		FStellarClass StellarClass;
+	};
+	auto MakeClass = [](float Temperature, float Mass, float Radius, float Luminosity, float Fraction) {
+		FStellarClass StellarClass;
+		StellarClass.MinTemperature = Temperature;
+		StellarClass.MinMass = Mass;
+		StellarClass.MinRadius = Radius;
+		StellarClass.MinLuminosity = Luminosity;
+		StellarClass.Fraction = Fraction;
+		return StellarClass;
+	};
+	const FClassRow Rows[] = {
+		{TEXT("O"), MakeClass(30000.0f, 16.0f, 6.6f, 30000.0f, 0.00003f)},
+		{TEXT("B"), MakeClass(10000.0f, 2.1f, 1.8f, 25.0f, 0.0013f)},
+		{TEXT("A"), MakeClass(7500.0f, 1.4f, 1.4f, 5.0f, 0.006f)},
+		{TEXT("F"), MakeClass(6000.0f, 1.04f, 1.15f, 1.5f, 0.03f)},
+		{TEXT("G"), MakeClass(5200.0f, 0.8f, 0.96f, 0.6f, 0.076f)},
+		{TEXT("K"), MakeClass(3700.0f, 0.45f, 0.7f, 0.08f, 0.121f)},
+		{TEXT("M"), MakeClass(2400.0f, 0.08f, 0.1f, 0.0001f, 0.7645f)},
+	};
+
+	UDataTable* StellarClassesTable = NewObject<UDataTable>(GetTransientPackage());
+	StellarClassesTable->RowStruct = FStellarClass::StaticStruct();
+	for (const FClassRow& Row : Rows)
+	{
+		StellarClassesTable->AddRow(Row.Name, Row.StellarClass);
+	}
+
+	UStarSettings* StarSettings = NewObject<UStarSettings>(GetTransientPackage());
+	StarSettings->StellarClassesTable = StellarClassesTable;
+	return StarSettings;
+}
+
+TArray<float> MakeTestDensityImage(int32 Width, int32 Height)
+{
+	TArray<float> Density;
+	Density.SetNumUninitialized(Width * Height);
+	for (int32 y = 0; y < Height; ++y)
+	{
+		for (int32 x = 0; x < Width; ++x)
+		{
+			const FVector2D Position((x + 0.5f) / Width * 2.0f - 1.0f, (y + 0.5f) / Height * 2.0f - 1.0f);
+			const float Radius = Position.Size();
+			const float Angle = FMath::Atan2(Position.Y, Position.X);
+			const float Arms = 1.0f + 0.8f * FMath::Cos(2.0f * (Angle - 6.0f * Radius));
+			// Bands of empty rows and columns within the support
+			const bool bEmptyBand = FMath::Abs(Position.Y - 0.25f) < 0.04f || FMath::Abs(Position.X + 0.25f) < 0.04f;
+			Density[y * Width + x] = Radius <= 1.0f && !bEmptyBand ? FMath::Exp(-Radius / 0.3f) * Arms : 0.0f;
+		}
+	}
+	return Density;
+}
+
+UGalaxyShapeSettings* MakeTestArmShapeSettings()
+{
+	UGalaxyShapeSettings* ShapeSettings = MakeTestShapeSettings();
+	UCurveFloat* ThicknessCurve = NewObject<UCurveFloat>(GetTransientPackage());
+	ThicknessCurve->FloatCurve.AddKey(0.0f, 0.1f);
+	ThicknessCurve->FloatCurve.AddKey(1.0f, 0.02f);
+	ShapeSettings->ThicknessCurve = ThicknessCurve;
+
+	const int32 Width = 256;
+	const int32 Height = 256;
+	const TArray<float> Density = MakeTestDensityImage(Width, Height);
+	ShapeSettings->ArmDensityMapSize = FIntPoint(Width, Height);
+	ShapeSettings->ArmDensityMap.SetNumUninitialized(Density.Num());
+	for (int32 i = 0; i < Density.Num(); ++i)
+	{
+		ShapeSettings->ArmDensityMap[i] = (uint16)FMath::RoundToInt(Density[i] / (1.0f + 0.8f) * 65535.0f);
+	}
+	ShapeSettings->PositionSampling = EStarPositionSampling::ArmDensityMap;
+	return ShapeSettings;
+}
+
+bool FTestGalaxy::Generate(int32 NumParticles)
+{
+	ShapeSettings = MakeTestArmShapeSettings();
+	StarSettings = MakeTestStarSettings();
+	FGalaxyShapeSamplingData ShapeData;
+	if (!ShapeSettings->ComputeSamplingData(ShapeData) || !StarSettings->ComputeSamplingData(StarData))
+	{
+		return false;
+	}
+
+	GeneratorSettings.NumParticles = NumParticles;
+	GeneratorSettings.Sequence = ESampleSequence::Sobol;
+	return FGalaxyStarGenerator::Generate(*ShapeSettings, ShapeData, StarData, GeneratorSettings, Stars);
+}
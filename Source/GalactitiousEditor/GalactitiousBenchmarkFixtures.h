@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StarGenerator.h"
+#include "StellarSamplingData.h"
+
+// Transient settings and generated galaxies shared by the benchmark suites
+
+/** Exponential disk with a central bulge. */
+UGalaxyShapeSettings* MakeTestShapeSettings();
+
+/** Test disk with a thickness curve, sampling positions from an arm density map of MakeTestDensityImage. */
+UGalaxyShapeSettings* MakeTestArmShapeSettings();
+
+/** Main sequence Harvard classes. */
+UStarSettings* MakeTestStarSettings();
+
+/** Two-armed spiral with exponential falloff on [-1, 1]^2, zero outside the unit circle and in a cross of empty bands. */
+TArray<float> MakeTestDensityImage(int32 Width, int32 Height);
+
+/** Stars of the arm density test galaxy, generated with the Sobol sequence. */
+struct FTestGalaxy
+{
+	UGalaxyShapeSettings* ShapeSettings = nullptr;
+	UStarSettings* StarSettings = nullptr;
+	FStarSamplingData StarData;
+	FStarGeneratorSettings GeneratorSettings;
+	FStarBuffer Stars;
+
+	/** Create the settings and generate NumParticles stars. Returns false if the sampling data could not be derived. */
+	bool Generate(int32 NumParticles);
+};
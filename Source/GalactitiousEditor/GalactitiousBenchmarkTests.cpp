@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBenchmark.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	/** Run a benchmark suite with short measurements and report failed validation checks as test errors. */
+	bool RunBenchmarkSuiteTest(FAutomationTestBase& Test, void (*Run)(FGalactitiousBenchmarkReport& Report))
+	{
+		// Validation checks keep their sample counts, only timing and bake sizes are reduced
+		FGalactitiousBenchmarkSettings Settings;
+		Settings.MinSeconds = 0.0;
+		Settings.MinIterations = 1;
+		Settings.MaxBakeResolution = 2048;
+
+		FGalactitiousBenchmarkReport Report(Settings);
+		Run(Report);
+		for (const FString& FailedCheck : Report.GetFailedChecks())
+		{
+			Test.AddError(FailedCheck);
+		}
+		return Report.GetNumFailedChecks() == 0;
+	}
+} // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGalactitiousProbabilityCurveTest, "Galactitious.ProbabilityCurves",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FGalactitiousProbabilityCurveTest::RunTest(const FString& Parameters)
+{
+	return RunBenchmarkSuiteTest(*this, &RunProbabilityCurveBenchmarks);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGalactitiousTextureBakeTest, "Galactitious.TextureBake",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FGalactitiousTextureBakeTest::RunTest(const FString& Parameters)
+{
+	return RunBenchmarkSuiteTest(*this, &RunTextureBakeBenchmarks);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGalactitiousStellarSamplerTest, "Galactitious.StellarSampler",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FGalactitiousStellarSamplerTest::RunTest(const FString& Parameters)
+{
+	return RunBenchmarkSuiteTest(*this, &RunStellarSamplerBenchmarks);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGalactitiousGalaxyRenderTest, "Galactitious.GalaxyRender",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FGalactitiousGalaxyRenderTest::RunTest(const FString& Parameters)
+{
+	return RunBenchmarkSuiteTest(*this, &RunGalaxyRenderBenchmarks);
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(
+	FGalactitiousGalaxyRuntimeTest, "Galactitious.GalaxyRuntime",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+bool FGalactitiousGalaxyRuntimeTest::RunTest(const FString& Parameters)
+{
+	return RunBenchmarkSuiteTest(*this, &RunGalaxyRuntimeBenchmarks);
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBenchmark.h"
+#include "GalactitiousBenchmarkFixtures.h"
+#include "GalaxyImpostor.h"
+#include "GalaxyReferenceRenderer.h"
+#include "TextureBakerFunctionLibrary.h"
+
+#include "Math/RandomStream.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	const TCHAR* SuiteName = TEXT("GalaxyRender");
+
+	void RunImpostorSplatBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		FTestGalaxy Galaxy;
+		if (!Galaxy.Generate(Settings.NumSamplerSamples))
+		{
+			Report.AddCheck(SuiteName, TEXT("SplatImpostor"), false, TEXT("failed to generate the test galaxy"));
+			return;
+		}
+		const FStarBuffer& Stars = Galaxy.Stars;
+
+		const int32 Resolution = 512;
+		FImpostorSplatKernel Kernel;
+		Kernel.BuildGaussian(4);
+
+		for (const float Inclination : {0.0f, 60.0f})
+		{
+			TArray<FLinearColor> Image;
+			bool bSplatted = false;
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+				Settings, [&]() { bSplatted = FGalaxyImpostorBaker::SplatStars(Stars, Kernel, Inclination, Resolution, Image); });
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("SplatImpostor"), Timing);
+			Result->SetNumberField(TEXT("inclination"), Inclination);
+			Result->SetNumberField(TEXT("resolution"), Resolution);
+			Result->SetNumberField(TEXT("particles"), Stars.Num());
+			Result->SetNumberField(TEXT("particles_per_sec"), Stars.Num() / Timing.NanosecondsPerOp * 1.0e9);
+
+			// Splatting conserves the luminosity of stars projected into the image, up to kernel tails at the border
+			float Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Inclination));
+			double TotalLuminosity = 0.0;
+			double ImageLuminosity = 0.0;
+			for (int32 i = 0; i < Stars.Num(); ++i)
+			{
+				const double Luminosity = FMath::Exp(Stars.LogLuminosity[i]) * Stars.StarCount[i];
+				const float Y = Stars.PositionY[i] * Cos + Stars.PositionZ[i] * Sin;
+				TotalLuminosity += Luminosity;
+				ImageLuminosity += FMath::Abs(Stars.PositionX[i]) < 1.0f && FMath::Abs(Y) < 1.0f ? Luminosity : 0.0;
+			}
+			double ImageSum = 0.0;
+			for (const FLinearColor& Pixel : Image)
+			{
+				ImageSum += Pixel.A;
+			}
+			const double Expected = ImageLuminosity / TotalLuminosity * Resolution * Resolution;
+			const double RelativeError = FMath::Abs(ImageSum - Expected) / FMath::Max(Expected, 1.0);
+			Report.AddCheck(
+				SuiteName, FString::Printf(TEXT("SplatImpostorEnergy_%d"), FMath::RoundToInt(Inclination)),
+				bSplatted && RelativeError < 0.02, FString::Printf(TEXT("relative error %g"), RelativeError));
+
+			// Tiles merge in a fixed order, repeated bakes are bit identical
+			TArray<FLinearColor> SecondImage;
+			FGalaxyImpostorBaker::SplatStars(Stars, Kernel, Inclination, Resolution, SecondImage);
+			const bool bDeterministic = Image.Num() == SecondImage.Num() &&
+										FMemory::Memcmp(Image.GetData(), SecondImage.GetData(), Image.Num() * Image.GetTypeSize()) == 0;
+			Report.AddCheck(
+				SuiteName, FString::Printf(TEXT("SplatImpostorDeterministic_%d"), FMath::RoundToInt(Inclination)), bDeterministic,
+				FString::Printf(TEXT("%d pixels"), Image.Num()));
+		}
+
+		// Tiled splatting against direct accumulation of the luminosity channel, over a resolution that is not a multiple of
+		// the tile size. Stars scatter across tile seams and beyond the image border, where kernels are clipped.
+		{
+			const int32 TiledResolution = 3 * UTextureBakerFunctionLibrary::BakeTileSize + 11;
+			FRandomStream Random(0x51a7);
+			FStarBuffer TestStars;
+			TestStars.SetNumUninitialized(4096);
+			double TotalLuminosity = 0.0;
+			for (int32 i = 0; i < TestStars.Num(); ++i)
+			{
+				TestStars.PositionX[i] = Random.FRandRange(-1.05f, 1.05f);
+				TestStars.PositionY[i] = Random.FRandRange(-1.05f, 1.05f);
+				TestStars.PositionZ[i] = 0.0f;
+				TestStars.LogLuminosity[i] = Random.FRandRange(-2.0f, 2.0f);
+				TestStars.Temperature[i] = Random.FRandRange(3000.0f, 30000.0f);
+				TestStars.StarCount[i] = 1.0f;
+				TotalLuminosity += FMath::Exp(TestStars.LogLuminosity[i]);
+			}
+
+			TArray<double> Reference;
+			Reference.SetNumZeroed(TiledResolution * TiledResolution);
+			const int32 KernelSize = Kernel.GetSize();
+			const double PixelScale = 0.5 * TiledResolution;
+			for (int32 i = 0; i < TestStars.Num(); ++i)
+			{
+				const double Luminosity = FMath::Exp(TestStars.LogLuminosity[i]) * TiledResolution * TiledResolution / TotalLuminosity;
+				const int32 X = FMath::FloorToInt((TestStars.PositionX[i] + 1.0f) * (float)PixelScale) - Kernel.Radius;
+				const int32 Y = FMath::FloorToInt((TestStars.PositionY[i] + 1.0f) * (float)PixelScale) - Kernel.Radius;
+				for (int32 ky = 0; ky < KernelSize; ++ky)
+				{
+					for (int32 kx = 0; kx < KernelSize; ++kx)
+					{
+						if (X + kx >= 0 && X + kx < TiledResolution && Y + ky >= 0 && Y + ky < TiledResolution)
+						{
+							Reference[(Y + ky) * TiledResolution + X + kx] += Luminosity * Kernel.Weights[ky * KernelSize + kx].A;
+						}
+					}
+				}
+			}
+
+			TArray<FLinearColor> Image;
+			const bool bSplatted = FGalaxyImpostorBaker::SplatStars(TestStars, Kernel, 0.0f, TiledResolution, Image);
+			double MaxError = 0.0;
+			double MaxValue = 0.0;
+			for (int32 i = 0; bSplatted && i < Image.Num(); ++i)
+			{
+				MaxError = FMath::Max(MaxError, FMath::Abs(Image[i].A - Reference[i]));
+				MaxValue = FMath::Max(MaxValue, Reference[i]);
+			}
+			Report.AddCheck(
+				SuiteName, TEXT("SplatImpostorTiles"), bSplatted && MaxError <= 1.0e-4 * MaxValue,
+				FString::Printf(TEXT("max error %g of max value %g, resolution %d"), MaxError, MaxValue, TiledResolution));
+		}
+	}
+
+	double MeanAbsoluteDifference(const TArray<FLinearColor>& A, const TArray<FLinearColor>& B)
+	{
+		double Sum = 0.0;
+		for (int32 i = 0; i < A.Num(); ++i)
+		{
+			Sum += FMath::Abs(A[i].R - B[i].R) + FMath::Abs(A[i].G - B[i].G) + FMath::Abs(A[i].B - B[i].B);
+		}
+		return Sum / FMath::Max(A.Num(), 1);
+	}
+
+	void RunReferenceRenderBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		FTestGalaxy Galaxy;
+		if (!Galaxy.Generate(Settings.NumSamplerSamples))
+		{
+			Report.AddCheck(SuiteName, TEXT("ReferenceRender"), false, TEXT("failed to generate the test galaxy"));
+			return;
+		}
+		const UGalaxyShapeSettings& ShapeSettings = *Galaxy.ShapeSettings;
+		const FStarBuffer& Stars = Galaxy.Stars;
+
+		FGalaxyRenderSettings RenderSettings;
+		FGalaxyReferenceRenderer Renderer;
+		if (!Renderer.Initialize(ShapeSettings, Stars, RenderSettings))
+		{
+			Report.AddCheck(SuiteName, TEXT("ReferenceRender"), false, TEXT("failed to initialize the reference renderer"));
+			return;
+		}
+
+		// One 1080p pass per iteration, passes keep accumulating
+		const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() { Renderer.Render(Renderer.GetNumPasses() + 1); });
+		TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ReferenceRenderPass"), Timing);
+		Result->SetNumberField(TEXT("width"), RenderSettings.Width);
+		Result->SetNumberField(TEXT("height"), RenderSettings.Height);
+		Result->SetNumberField(TEXT("pixels_per_sec"), RenderSettings.Width * RenderSettings.Height / Timing.NanosecondsPerOp * 1.0e9);
+		Result->SetNumberField(TEXT("stolen_tiles"), Renderer.GetNumStolenTiles());
+
+		// Progressive refinement converges towards a many-pass image, independent of scheduling
+		RenderSettings.Width = 320;
+		RenderSettings.Height = 180;
+		const int32 PassCounts[] = {1, 4, 64};
+		TArray<FLinearColor> Images[UE_ARRAY_COUNT(PassCounts)];
+		for (int32 i = 0; i < UE_ARRAY_COUNT(PassCounts); ++i)
+		{
+			Renderer.Initialize(ShapeSettings, Stars, RenderSettings);
+			Renderer.Render(PassCounts[i]);
+			Renderer.GetImage(Images[i]);
+		}
+		const double SinglePassError = MeanAbsoluteDifference(Images[0], Images[2]);
+		const double RefinedError = MeanAbsoluteDifference(Images[1], Images[2]);
+		Report.AddCheck(
+			SuiteName, TEXT("ReferenceRenderConverges"), RefinedError < SinglePassError,
+			FString::Printf(TEXT("mean error 1 pass %g, 4 passes %g"), SinglePassError, RefinedError));
+
+		RenderSettings.NumWorkers = 1;
+		TArray<FLinearColor> SingleWorkerImage;
+		Renderer.Initialize(ShapeSettings, Stars, RenderSettings);
+		Renderer.Render(PassCounts[1]);
+		Renderer.GetImage(SingleWorkerImage);
+		const int32 ImageBytes = SingleWorkerImage.Num() * SingleWorkerImage.GetTypeSize();
+		const bool bDeterministic = FMemory::Memcmp(SingleWorkerImage.GetData(), Images[1].GetData(), ImageBytes) == 0;
+		Report.AddCheck(
+			SuiteName, TEXT("ReferenceRenderDeterministic"), bDeterministic, FString::Printf(TEXT("%d pixels"), SingleWorkerImage.Num()));
+	}
+} // namespace
+
+void RunGalaxyRenderBenchmarks(FGalactitiousBenchmarkReport& Report)
+{
+	// Each run renders millions of stars, a single measured iteration is enough
+	FGalactitiousBenchmarkSettings Settings = Report.GetSettings();
+	Settings.MinIterations = 1;
+
+	RunImpostorSplatBenchmarks(Report, Settings);
+	RunReferenceRenderBenchmarks(Report, Settings);
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
@@ -0,0 +1,319 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBenchmark.h"
+#include "GalactitiousBenchmarkFixtures.h"
+#include "GalaxyStarIndex.h"
+#include "GalaxyStreaming.h"
+#include "ParticleBudget.h"
+
+#include "Algo/Count.h"
+#include "Math/RandomStream.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	const TCHAR* SuiteName = TEXT("GalaxyRuntime");
+
+	/** The KD-tree indexes a galaxy of this size while loading and answers picking queries every frame. */
+	const int32 KDTreeNumStars = 10 * 1000 * 1000;
+	const double MaxKDTreeBuildSeconds = 1.0;
+	const double MaxKDTreeQueryNanoseconds = 10000.0;
+
+	void RunParticleBudgetBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		FTestGalaxy Galaxy;
+		if (!Galaxy.Generate(Settings.NumSamplerSamples))
+		{
+			Report.AddCheck(SuiteName, TEXT("ParticleBudget"), false, TEXT("failed to generate the test galaxy"));
+			return;
+		}
+		const FStarBuffer& Stars = Galaxy.Stars;
+
+		// Rescaled star counts of a particle prefix keep the total luminosity of all particles
+		double TotalLuminosity = 0.0;
+		for (int32 i = 0; i < Stars.Num(); ++i)
+		{
+			TotalLuminosity += Stars.StarCount[i] * FMath::Exp(Stars.LogLuminosity[i]);
+		}
+		double MaxRelativeError = 0.0;
+		for (const float Fraction : {0.5f, 0.25f, 0.1f})
+		{
+			const FParticleBudgetRescaling Rescaling = FParticleBudgetRescaling::Compute(
+				Stars.Num(), FMath::RoundToInt(Stars.Num() * Fraction), Galaxy.GeneratorSettings.NumGalaxyStars,
+				Galaxy.StarData.AverageLuminosity);
+			double PrefixLuminosity = 0.0;
+			for (int32 i = 0; i < Rescaling.NumActiveParticles; ++i)
+			{
+				const float Luminosity = FMath::Exp(Stars.LogLuminosity[i]);
+				PrefixLuminosity += Rescaling.GetStarCount(Luminosity) * Luminosity;
+			}
+			MaxRelativeError = FMath::Max(MaxRelativeError, FMath::Abs(PrefixLuminosity / TotalLuminosity - 1.0));
+		}
+		Report.AddCheck(
+			SuiteName, TEXT("ParticleBudgetPreservesLuminosity"), MaxRelativeError < 0.02,
+			FString::Printf(TEXT("max relative error %g"), MaxRelativeError));
+
+		// Frame time of a load with a fixed part and a part proportional to the drawn particles
+		FParticleBudgetController Controller;
+		const float DeltaTime = 1.0f / 60.0f;
+		const int32 NumFrames = 60 * 60;
+		int32 NumLateChanges = 0;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const float FrameTimeMs = 8.0f + 16.0f * Controller.GetBudgetFraction();
+			if (Controller.Update(DeltaTime, FrameTimeMs) && Frame >= NumFrames / 2)
+			{
+				++NumLateChanges;
+			}
+		}
+		const FParticleBudgetSettings& BudgetSettings = Controller.Settings;
+		const bool bConverged = FMath::Abs(Controller.GetSmoothedFrameTimeMs() / BudgetSettings.TargetFrameTimeMs - 1.0f) <=
+								BudgetSettings.Hysteresis;
+		Report.AddCheck(
+			SuiteName, TEXT("ParticleBudgetConverges"), bConverged && NumLateChanges == 0,
+			FString::Printf(
+				TEXT("budget %g, frame time %g ms, %d changes in the last 30 s"), Controller.GetBudgetFraction(),
+				Controller.GetSmoothedFrameTimeMs(), NumLateChanges));
+	}
+
+	void RunStarKDTreeBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		FTestGalaxy Galaxy;
+		if (!Galaxy.Generate(KDTreeNumStars))
+		{
+			Report.AddCheck(SuiteName, TEXT("StarKDTree"), false, TEXT("failed to generate the test galaxy"));
+			return;
+		}
+		const FStarBuffer& Stars = Galaxy.Stars;
+
+		FStarKDTree KDTree;
+		const FGalactitiousBenchmarkTiming BuildTiming = MeasureBenchmark(Settings, [&]() { KDTree.Build(Stars); });
+		TSharedRef<FJsonObject> BuildResult = Report.AddResult(SuiteName, TEXT("BuildStarKDTree"), BuildTiming);
+		BuildResult->SetNumberField(TEXT("stars"), Stars.Num());
+		BuildResult->SetNumberField(TEXT("stars_per_sec"), Stars.Num() / BuildTiming.NanosecondsPerOp * 1.0e9);
+		BuildResult->SetNumberField(TEXT("tree_bytes"), (double)KDTree.GetAllocatedSize());
+		const bool bBuiltInTime = KDTree.Num() == Stars.Num() && BuildTiming.NanosecondsPerOp < MaxKDTreeBuildSeconds * 1.0e9;
+		Report.AddCheck(
+			SuiteName, TEXT("StarKDTreeBuildTime"), bBuiltInTime,
+			FString::Printf(TEXT("%g s for %d stars"), BuildTiming.NanosecondsPerOp * 1.0e-9, Stars.Num()));
+
+		// Query points around the disk and pointer rays from outside towards it
+		const int32 NumQueries = 1024;
+		FRandomStream Random(5);
+		TArray<FVector> QueryPoints;
+		TArray<FVector> RayDirections;
+		for (int32 i = 0; i < NumQueries; ++i)
+		{
+			QueryPoints.Add(FVector(Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-1.0f, 1.0f), Random.FRandRange(-0.1f, 0.1f)));
+			RayDirections.Add((FVector(Random.FRandRange(-0.5f, 0.5f), Random.FRandRange(-0.5f, 0.5f), 0.0f) - QueryPoints[i] * 2.0f)
+								  .GetSafeNormal());
+		}
+		const float QueryRadius = 0.02f;
+		const float ConeAngle = FMath::DegreesToRadians(1.0f);
+
+		int32 Checksum = 0;
+		TArray<int32> Found;
+		const FGalactitiousBenchmarkTiming NearestTiming = MeasureBenchmark(Settings, [&]() {
+			for (const FVector& Point : QueryPoints)
+			{
+				Checksum += KDTree.FindNearest(Point);
+			}
+		});
+		const FGalactitiousBenchmarkTiming RadiusTiming = MeasureBenchmark(Settings, [&]() {
+			for (const FVector& Point : QueryPoints)
+			{
+				Found.Reset();
+				Checksum += KDTree.FindInRadius(Point, QueryRadius, Found);
+			}
+		});
+		const FGalactitiousBenchmarkTiming ConeTiming = MeasureBenchmark(Settings, [&]() {
+			for (int32 i = 0; i < NumQueries; ++i)
+			{
+				Checksum += KDTree.FindInCone(QueryPoints[i] * 2.0f, RayDirections[i], ConeAngle);
+			}
+		});
+		const TPair<const TCHAR*, const FGalactitiousBenchmarkTiming*> QueryTimings[] = {
+			{TEXT("StarKDTreeNearest"), &NearestTiming}, {TEXT("StarKDTreeRadius"), &RadiusTiming}, {TEXT("StarKDTreeCone"), &ConeTiming}};
+		for (const TPair<const TCHAR*, const FGalactitiousBenchmarkTiming*>& QueryTiming : QueryTimings)
+		{
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, QueryTiming.Key, *QueryTiming.Value);
+			Result->SetNumberField(TEXT("queries"), NumQueries);
+			Result->SetNumberField(TEXT("ns_per_query"), QueryTiming.Value->NanosecondsPerOp / NumQueries);
+			Result->SetNumberField(TEXT("checksum"), Checksum);
+		}
+
+		// Picking runs per frame, radius queries scale with the number of stars found and are not checked
+		const double NearestNanoseconds = NearestTiming.NanosecondsPerOp / NumQueries;
+		const double ConeNanoseconds = ConeTiming.NanosecondsPerOp / NumQueries;
+		Report.AddCheck(
+			SuiteName, TEXT("StarKDTreeQueryTime"),
+			NearestNanoseconds < MaxKDTreeQueryNanoseconds && ConeNanoseconds < MaxKDTreeQueryNanoseconds,
+			FString::Printf(TEXT("nearest %g ns, cone %g ns per query over %d stars"), NearestNanoseconds, ConeNanoseconds, Stars.Num()));
+
+		// Brute force reference on a subset of the queries
+		const int32 NumChecks = 32;
+		int32 NumNearestMismatches = 0;
+		int32 NumRadiusMismatches = 0;
+		int32 NumConeMismatches = 0;
+		for (int32 Query = 0; Query < NumChecks; ++Query)
+		{
+			const FVector& Point = QueryPoints[Query];
+			const FVector Origin = Point * 2.0f;
+			const FVector& Direction = RayDirections[Query];
+			float NearestDistanceSquared = MAX_flt;
+			int32 NumInRadius = 0;
+			float BestCos = FMath::Cos(ConeAngle);
+			int32 BestCone = INDEX_NONE;
+			for (int32 i = 0; i < Stars.Num(); ++i)
+			{
+				const FVector Position = Stars.GetPosition(i);
+				const float DistanceSquared = FVector::DistSquared(Position, Point);
+				NearestDistanceSquared = FMath::Min(NearestDistanceSquared, DistanceSquared);
+				NumInRadius += DistanceSquared <= QueryRadius * QueryRadius ? 1 : 0;
+
+				const FVector Offset = Position - Origin;
+				const float Along = FVector::DotProduct(Offset, Direction);
+				if (Along > 0.0f && Along / Offset.Size() > BestCos)
+				{
+					BestCos = Along / Offset.Size();
+					BestCone = i;
+				}
+			}
+
+			// Ties may pick a different star at the same distance or angle
+			const int32 Nearest = KDTree.FindNearest(Point);
+			const bool bNearestMatches =
+				Nearest != INDEX_NONE && FVector::DistSquared(Stars.GetPosition(Nearest), Point) == NearestDistanceSquared;
+			NumNearestMismatches += bNearestMatches ? 0 : 1;
+
+			Found.Reset();
+			NumRadiusMismatches += KDTree.FindInRadius(Point, QueryRadius, Found) != NumInRadius ? 1 : 0;
+
+			const int32 Cone = KDTree.FindInCone(Origin, Direction, ConeAngle);
+			const float ConeCos =
+				Cone != INDEX_NONE ? FVector::DotProduct((Stars.GetPosition(Cone) - Origin).GetSafeNormal(), Direction) : 0.0f;
+			const bool bConeMatches = Cone == BestCone || (Cone != INDEX_NONE && BestCone != INDEX_NONE && ConeCos >= BestCos - 1.0e-6f);
+			NumConeMismatches += bConeMatches ? 0 : 1;
+		}
+		const bool bMatches = NumNearestMismatches == 0 && NumRadiusMismatches == 0 && NumConeMismatches == 0;
+		Report.AddCheck(
+			SuiteName, TEXT("StarKDTreeMatchesBruteForce"), bMatches,
+			FString::Printf(
+				TEXT("%d queries, mismatches nearest %d, radius %d, cone %d"), NumChecks, NumNearestMismatches, NumRadiusMismatches,
+				NumConeMismatches));
+	}
+
+	void RunStreamingBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		FTestGalaxy Galaxy;
+		if (!Galaxy.Generate(Settings.NumSamplerSamples))
+		{
+			Report.AddCheck(SuiteName, TEXT("Streaming"), false, TEXT("failed to generate the test galaxy"));
+			return;
+		}
+		const UGalaxyShapeSettings& ShapeSettings = *Galaxy.ShapeSettings;
+		const UStarSettings& StarSettings = *Galaxy.StarSettings;
+		const FStarBuffer& Stars = Galaxy.Stars;
+
+		FGalaxyStreamingSettings StreamingSettings;
+		StreamingSettings.ChunkResolution = 16;
+		StreamingSettings.NumParticles = (int64)Stars.Num() * 16;
+		StreamingSettings.LoadRadius = 0.25f;
+		StreamingSettings.PrefetchTime = 1.0f;
+		FGalaxyStreamer Streamer;
+		if (!Streamer.Initialize(ShapeSettings, StarSettings, StreamingSettings))
+		{
+			Report.AddCheck(SuiteName, TEXT("Streaming"), false, TEXT("failed to initialize the streamer"));
+			return;
+		}
+
+		// Chunks generated separately reproduce the distribution of the whole galaxy. All chunks hold 16 times the stars of the
+		// galaxy buffer, so radii are accumulated one chunk at a time.
+		auto SumRadius = [](const FStarBuffer& Buffer) {
+			double Sum = 0.0;
+			for (int32 i = 0; i < Buffer.Num(); ++i)
+			{
+				Sum += FVector2D(Buffer.PositionX[i], Buffer.PositionY[i]).Size();
+			}
+			return Sum;
+		};
+		FStarBuffer Chunk;
+		double AllChunksRadiusSum = 0.0;
+		double ThirdChunksRadiusSum = 0.0;
+		int64 NumAllChunksStars = 0;
+		int64 NumThirdChunksStars = 0;
+		for (int32 i = 0; i < Streamer.GetNumChunks(); ++i)
+		{
+			Streamer.LoadChunk(i, Chunk);
+			const double RadiusSum = SumRadius(Chunk);
+			AllChunksRadiusSum += RadiusSum;
+			NumAllChunksStars += Chunk.Num();
+			if (i % 3 == 0)
+			{
+				ThirdChunksRadiusSum += RadiusSum;
+				NumThirdChunksStars += Chunk.Num();
+			}
+		}
+		Chunk.Empty();
+		const double ChunkMeanRadius = ThirdChunksRadiusSum / FMath::Max<int64>(NumThirdChunksStars, 1);
+		const double AllChunksMeanRadius = AllChunksRadiusSum / FMath::Max<int64>(NumAllChunksStars, 1);
+		const double FullMeanRadius = SumRadius(Stars) / FMath::Max(Stars.Num(), 1);
+		Report.AddCheck(
+			SuiteName, TEXT("StreamingChunksMatchGalaxy"), FMath::Abs(AllChunksMeanRadius / FullMeanRadius - 1.0) < 0.01,
+			FString::Printf(
+				TEXT("mean radius of all chunks %g, of every third chunk %g, of the galaxy %g"), AllChunksMeanRadius, ChunkMeanRadius,
+				FullMeanRadius));
+
+		// Fly through the disk with a budget of a fraction of the chunks and a GPU mirror, Update only does bookkeeping
+		StreamingSettings.MemoryBudgetBytes = StreamingSettings.NumParticles / 8 * sizeof(float) * 6;
+		StreamingSettings.NumMirrors = 1;
+		Streamer.Initialize(ShapeSettings, StarSettings, StreamingSettings);
+		const int32 NumSteps = 200;
+		const FVector Velocity(0.01f / 0.016f, 0.0f, 0.0f);
+		double MaxUpdateSeconds = 0.0;
+		double TotalUpdateSeconds = 0.0;
+		int64 MaxUsedBytes = 0;
+		int32 NumSlotMismatches = 0;
+		TArray<FGalaxyStreamer::FStarBufferPtr> Slots;
+		for (int32 Step = 0; Step < NumSteps; ++Step)
+		{
+			const FVector Camera(-1.0f + 2.0f * Step / NumSteps, 0.05f, 0.0f);
+			const double StartTime = FPlatformTime::Seconds();
+			Streamer.Update(Camera, Velocity);
+			const double UpdateSeconds = FPlatformTime::Seconds() - StartTime;
+			MaxUpdateSeconds = FMath::Max(MaxUpdateSeconds, UpdateSeconds);
+			TotalUpdateSeconds += UpdateSeconds;
+			MaxUsedBytes = FMath::Max(MaxUsedBytes, Streamer.GetUsedBytes());
+			Streamer.GetSlots(Slots);
+			const int32 NumUsedSlots = Algo::CountIf(Slots, [](const FGalaxyStreamer::FStarBufferPtr& Slot) { return Slot.IsValid(); });
+			NumSlotMismatches += NumUsedSlots != Streamer.GetNumResidentChunks();
+			FPlatformProcess::Sleep(0.016f);
+		}
+		TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("StreamingUpdate"));
+		Result->SetNumberField(TEXT("chunks"), Streamer.GetNumChunks());
+		Result->SetNumberField(TEXT("mean_update_us"), TotalUpdateSeconds / NumSteps * 1.0e6);
+		Result->SetNumberField(TEXT("max_update_us"), MaxUpdateSeconds * 1.0e6);
+		Result->SetNumberField(TEXT("max_used_bytes"), (double)MaxUsedBytes);
+		Result->SetNumberField(TEXT("budget_bytes"), (double)StreamingSettings.MemoryBudgetBytes);
+		const bool bWithinBudget = MaxUsedBytes <= StreamingSettings.MemoryBudgetBytes && Streamer.GetNumResidentChunks() > 0;
+		Report.AddCheck(
+			SuiteName, TEXT("StreamingWithinBudget"), bWithinBudget,
+			FString::Printf(TEXT("max %lld of %lld bytes"), MaxUsedBytes, StreamingSettings.MemoryBudgetBytes));
+		Report.AddCheck(
+			SuiteName, TEXT("StreamingSlotsMatchResidentChunks"), NumSlotMismatches == 0,
+			FString::Printf(TEXT("%d of %d updates with mismatched slots, %d slots"), NumSlotMismatches, NumSteps, Streamer.GetNumSlots()));
+	}
+} // namespace
+
+void RunGalaxyRuntimeBenchmarks(FGalactitiousBenchmarkReport& Report)
+{
+	// Fixtures generate millions of stars, a single measured iteration is enough
+	FGalactitiousBenchmarkSettings Settings = Report.GetSettings();
+	Settings.MinIterations = 1;
+
+	RunParticleBudgetBenchmarks(Report, Settings);
+	RunStarKDTreeBenchmarks(Report, Settings);
+	RunStreamingBenchmarks(Report, Settings);
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
@@ -0,0 +1,337 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GalactitiousBenchmark.h"
+#include "ProbabilityCurveFunctionLibrary.h"
+
+#include "Curves/RichCurve.h"
+
+namespace
+{
+	const TCHAR* SuiteName = TEXT("ProbabilityCurve");
+
+	const int32 KeyCounts[] = {10, 100, 1000, 10000};
+	const int32 Resolutions[] = {1, 4, 10, 32};
+	const ERichCurveInterpMode InterpModes[] = {RCIM_Constant, RCIM_Linear, RCIM_Cubic};
+
+	/** Skip inversion benchmarks producing more keys than this to bound the runtime. */
+	const int32 MaxInversionKeys = 100000;
+
+	const TCHAR* GetInterpModeName(ERichCurveInterpMode InterpMode)
+	{
+		switch (InterpMode)
+		{
+		case RCIM_Constant:
+			return TEXT("Constant");
+		case RCIM_Linear:
+			return TEXT("Linear");
+		case RCIM_Cubic:
+			return TEXT("Cubic");
+		case RCIM_None:
+			return TEXT("None");
+		}
+		return TEXT("Unknown");
+	}
+
+	FRichCurve MakeCurve(int32 NumKeys, ERichCurveInterpMode InterpMode, TFunctionRef<float(float Time)> ValueFn)
+	{
+		FRichCurve Curve;
+		for (int32 i = 0; i < NumKeys; ++i)
+		{
+			const float Time = (float)i / FMath::Max(NumKeys - 1, 1);
+			const FKeyHandle Handle = Curve.AddKey(Time, ValueFn(Time));
+			Curve.SetKeyInterpMode(Handle, InterpMode);
+		}
+		Curve.AutoSetTangents();
+		return Curve;
+	}
+
+	/** Positive density with a few bumps. */
+	FRichCurve MakeDensityCurve(int32 NumKeys, ERichCurveInterpMode InterpMode)
+	{
+		return MakeCurve(NumKeys, InterpMode, [](float Time) { return 1.0f + 0.5f * FMath::Sin(Time * 8.0f * PI); });
+	}
+
+	/** Strictly increasing curve on [0, 1], like a cumulative distribution. */
+	FRichCurve MakeMonotonicCurve(int32 NumKeys, ERichCurveInterpMode InterpMode)
+	{
+		return MakeCurve(NumKeys, InterpMode, [](float Time) { return Time + 0.1f * FMath::Sin(Time * 8.0f * PI) / (8.0f * PI); });
+	}
+
+	void SetCurveParams(const TSharedRef<FJsonObject>& Result, int32 NumKeys, ERichCurveInterpMode InterpMode)
+	{
+		Result->SetNumberField(TEXT("keys"), NumKeys);
+		Result->SetStringField(TEXT("interp"), GetInterpModeName(InterpMode));
+	}
+
+	void RunValidationChecks(FGalactitiousBenchmarkReport& Report)
+	{
+		// Integral of the uniform density on [0, 1]
+		{
+			const FRichCurve Density = MakeCurve(3, RCIM_Linear, [](float Time) { return 1.0f; });
+			FRichCurve Integrated;
+			float TotalArea = 0.0f;
+			UProbabilityCurveFunctionLibrary::IntegrateRichCurve(Density, 0.0f, Integrated, TotalArea);
+
+			const bool bPassed =
+				FMath::IsNearlyEqual(TotalArea, 1.0f, 1.0e-4f) && FMath::IsNearlyEqual(Integrated.Eval(0.5f), 0.5f, 1.0e-3f);
+			Report.AddCheck(
+				SuiteName, TEXT("IntegrateUniform"), bPassed,
+				FString::Printf(TEXT("area=%f, F(0.5)=%f"), TotalArea, Integrated.Eval(0.5f)));
+		}
+
+		// Linear density f(x) = 2x has the quantile function Q(u) = sqrt(u)
+		{
+			const FRichCurve Density = MakeCurve(2, RCIM_Linear, [](float Time) { return Time; });
+			FRichCurve NormalizedDensity, Quantile;
+			UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurve(Density, NormalizedDensity, Quantile);
+
+			float MaxError = 0.0f;
+			for (float U = 0.1f; U <= 0.9f; U += 0.05f)
+			{
+				MaxError = FMath::Max(MaxError, FMath::Abs(Quantile.Eval(U) - FMath::Sqrt(U)));
+			}
+			Report.AddCheck(SuiteName, TEXT("QuantileLinearDensity"), MaxError < 0.01f, FString::Printf(TEXT("max error=%f"), MaxError));
+		}
+
+		// Quantile of a monotonic curve inverts the cumulative distribution
+		{
+			const FRichCurve Cumulative = MakeMonotonicCurve(100, RCIM_Cubic);
+			FRichCurve Inverted;
+			UProbabilityCurveFunctionLibrary::InvertRichCurve(Cumulative, 10, Inverted);
+
+			float MaxError = 0.0f;
+			for (float X = 0.05f; X <= 0.95f; X += 0.01f)
+			{
+				MaxError = FMath::Max(MaxError, FMath::Abs(Inverted.Eval(Cumulative.Eval(X)) - X));
+			}
+			Report.AddCheck(SuiteName, TEXT("InvertRoundTrip"), MaxError < 1.0e-3f, FString::Printf(TEXT("max error=%f"), MaxError));
+		}
+
+		// Normalized curves span [0, 1]
+		{
+			const FRichCurve Density = MakeDensityCurve(100, RCIM_Linear);
+			FRichCurve Normalized;
+			UProbabilityCurveFunctionLibrary::NormalizeRichCurve(Density, Normalized);
+
+			float MinValue, MaxValue;
+			Normalized.GetValueRange(MinValue, MaxValue);
+			const bool bPassed = FMath::IsNearlyZero(MinValue, 1.0e-5f) && FMath::IsNearlyEqual(MaxValue, 1.0f, 1.0e-5f);
+			Report.AddCheck(SuiteName, TEXT("NormalizeRange"), bPassed, FString::Printf(TEXT("range=[%f, %f]"), MinValue, MaxValue));
+		}
+
+		// Conversion round trip preserves keys and interpolation modes
+		for (ERichCurveInterpMode InterpMode : InterpModes)
+		{
+			const FRichCurve Curve = MakeDensityCurve(100, InterpMode);
+			FInterpCurveFloat InterpCurve;
+			FRichCurve RoundTripCurve;
+			UProbabilityCurveFunctionLibrary::ConvertFromRichCurve(Curve, InterpCurve);
+			UProbabilityCurveFunctionLibrary::ConvertToRichCurve(InterpCurve, RoundTripCurve);
+
+			bool bPassed = RoundTripCurve.GetNumKeys() == Curve.GetNumKeys();
+			for (int32 i = 0; bPassed && i < Curve.GetNumKeys(); ++i)
+			{
+				const FRichCurveKey& Key = Curve.Keys[i];
+				const FRichCurveKey& RoundTripKey = RoundTripCurve.Keys[i];
+				bPassed = Key.Time == RoundTripKey.Time && Key.Value == RoundTripKey.Value && Key.InterpMode == RoundTripKey.InterpMode;
+			}
+			Report.AddCheck(
+				SuiteName, FString::Printf(TEXT("ConvertRoundTrip%s"), GetInterpModeName(InterpMode)), bPassed,
+				FString::Printf(TEXT("keys=%d/%d"), RoundTripCurve.GetNumKeys(), Curve.GetNumKeys()));
+		}
+
+		// Allocation-free variants produce the same keys and do not allocate in steady state
+		for (ERichCurveInterpMode InterpMode : InterpModes)
+		{
+			const FRichCurve Density = MakeDensityCurve(100, InterpMode);
+			FRichCurve NormalizedDensity, Quantile;
+			UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurve(Density, NormalizedDensity, Quantile);
+
+			FRichCurve NormalizedDensityNoAlloc, QuantileNoAlloc;
+			FQuantileCurveScratch Scratch;
+			UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurveNoAlloc(Density, NormalizedDensityNoAlloc, QuantileNoAlloc, Scratch);
+
+			bool bMatches = Quantile.Keys.Num() == QuantileNoAlloc.Keys.Num();
+			for (int32 i = 0; bMatches && i < Quantile.Keys.Num(); ++i)
+			{
+				const FRichCurveKey& Key = Quantile.Keys[i];
+				const FRichCurveKey& KeyNoAlloc = QuantileNoAlloc.Keys[i];
+				bMatches = Key.Time == KeyNoAlloc.Time && Key.Value == KeyNoAlloc.Value && Key.ArriveTangent == KeyNoAlloc.ArriveTangent &&
+						   Key.LeaveTangent == KeyNoAlloc.LeaveTangent && Key.InterpMode == KeyNoAlloc.InterpMode;
+			}
+			Report.AddCheck(
+				SuiteName, FString::Printf(TEXT("QuantileNoAllocMatches%s"), GetInterpModeName(InterpMode)), bMatches,
+				FString::Printf(TEXT("keys=%d/%d"), QuantileNoAlloc.Keys.Num(), Quantile.Keys.Num()));
+
+			// All keys live in the outputs and the scratch curves, they keep their allocations unless the call allocated
+			TArray<FRichCurveKey>* const KeyArrays[] = {
+				&NormalizedDensityNoAlloc.Keys, &QuantileNoAlloc.Keys, &Scratch.IntegratedDensityCurve.Keys,
+				&Scratch.CumulativeDensityCurve.Keys};
+			const FRichCurveKey* KeyData[UE_ARRAY_COUNT(KeyArrays)];
+			int32 KeyCapacity[UE_ARRAY_COUNT(KeyArrays)];
+			for (int32 i = 0; i < UE_ARRAY_COUNT(KeyArrays); ++i)
+			{
+				KeyData[i] = KeyArrays[i]->GetData();
+				KeyCapacity[i] = KeyArrays[i]->Max();
+			}
+			UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurveNoAlloc(Density, NormalizedDensityNoAlloc, QuantileNoAlloc, Scratch);
+			int32 NumAllocations = 0;
+			for (int32 i = 0; i < UE_ARRAY_COUNT(KeyArrays); ++i)
+			{
+				NumAllocations += KeyArrays[i]->GetData() != KeyData[i] || KeyArrays[i]->Max() != KeyCapacity[i] ? 1 : 0;
+			}
+			Report.AddCheck(
+				SuiteName, FString::Printf(TEXT("QuantileNoAllocSteadyState%s"), GetInterpModeName(InterpMode)), NumAllocations == 0,
+				FString::Printf(TEXT("reallocated key arrays=%d"), NumAllocations));
+		}
+
+		// Reused outputs are rewritten for a density without mass and their key handles follow the new keys
+		{
+			const FRichCurve Density = MakeDensityCurve(100, RCIM_Linear);
+			FRichCurve NormalizedDensity, Quantile;
+			FQuantileCurveScratch Scratch;
+			UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurveNoAlloc(Density, NormalizedDensity, Quantile, Scratch);
+			const FKeyHandle PreviousHandle = Quantile.GetKeyHandle(Quantile.GetNumKeys() - 1);
+
+			const FRichCurve ZeroDensity = MakeCurve(10, RCIM_Linear, [](float Time) { return 0.0f; });
+			UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurveNoAlloc(ZeroDensity, NormalizedDensity, Quantile, Scratch);
+
+			bool bPassed = NormalizedDensity.GetNumKeys() == ZeroDensity.GetNumKeys() && Quantile.GetNumKeys() <= 1 &&
+						   !Quantile.IsKeyHandleValid(PreviousHandle);
+			for (int32 i = 0; bPassed && i < NormalizedDensity.GetNumKeys(); ++i)
+			{
+				const FKeyHandle Handle = NormalizedDensity.GetKeyHandle(i);
+				const FRichCurveKey& Key = NormalizedDensity.Keys[i];
+				bPassed = Key.Value == 0.0f && NormalizedDensity.GetKey(Handle).Time == Key.Time;
+			}
+			Report.AddCheck(
+				SuiteName, TEXT("QuantileNoAllocZeroDensity"), bPassed,
+				FString::Printf(TEXT("density keys=%d, quantile keys=%d"), NormalizedDensity.GetNumKeys(), Quantile.GetNumKeys()));
+		}
+	}
+} // namespace
+
+void RunProbabilityCurveBenchmarks(FGalactitiousBenchmarkReport& Report)
+{
+	const FGalactitiousBenchmarkSettings& Settings = Report.GetSettings();
+
+	RunValidationChecks(Report);
+
+	for (const int32 NumKeys : KeyCounts)
+	{
+		for (const ERichCurveInterpMode InterpMode : InterpModes)
+		{
+			const FRichCurve DensityCurve = MakeDensityCurve(NumKeys, InterpMode);
+			const FRichCurve MonotonicCurve = MakeMonotonicCurve(NumKeys, InterpMode);
+
+			{
+				FRichCurve IntegratedCurve;
+				float TotalArea;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::IntegrateRichCurve(DensityCurve, 0.0f, IntegratedCurve, TotalArea);
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("IntegrateRichCurve"), Timing);
+				SetCurveParams(Result, NumKeys, InterpMode);
+				Result->SetNumberField(TEXT("output_keys"), IntegratedCurve.GetNumKeys());
+			}
+
+			{
+				FRichCurve IntegratedCurve;
+				float TotalArea;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::IntegrateRichCurveNoAlloc(DensityCurve, 0.0f, IntegratedCurve, TotalArea);
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("IntegrateRichCurveNoAlloc"), Timing);
+				SetCurveParams(Result, NumKeys, InterpMode);
+				Result->SetNumberField(TEXT("output_keys"), IntegratedCurve.GetNumKeys());
+			}
+
+			{
+				FRichCurve NormalizedCurve;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::NormalizeRichCurve(DensityCurve, NormalizedCurve);
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("NormalizeRichCurve"), Timing);
+				SetCurveParams(Result, NumKeys, InterpMode);
+				Result->SetNumberField(TEXT("output_keys"), NormalizedCurve.GetNumKeys());
+			}
+
+			FInterpCurveFloat InterpCurve;
+			{
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::ConvertFromRichCurve(DensityCurve, InterpCurve);
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ConvertFromRichCurve"), Timing);
+				SetCurveParams(Result, NumKeys, InterpMode);
+				Result->SetNumberField(TEXT("output_keys"), InterpCurve.Points.Num());
+			}
+
+			{
+				FRichCurve RichCurve;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					RichCurve.Reset();
+					UProbabilityCurveFunctionLibrary::ConvertToRichCurve(InterpCurve, RichCurve);
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ConvertToRichCurve"), Timing);
+				SetCurveParams(Result, NumKeys, InterpMode);
+				Result->SetNumberField(TEXT("output_keys"), RichCurve.GetNumKeys());
+			}
+
+			for (const int32 Resolution : Resolutions)
+			{
+				const int32 MaxSegmentKeys = (InterpMode == RCIM_Cubic ? Resolution : 1);
+				if (NumKeys * MaxSegmentKeys > MaxInversionKeys)
+				{
+					continue;
+				}
+
+				FRichCurve InvertedCurve;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::InvertRichCurve(MonotonicCurve, Resolution, InvertedCurve);
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("InvertRichCurve"), Timing);
+				SetCurveParams(Result, NumKeys, InterpMode);
+				Result->SetNumberField(TEXT("resolution"), Resolution);
+				Result->SetNumberField(TEXT("output_keys"), InvertedCurve.GetNumKeys());
+
+				const FGalactitiousBenchmarkTiming TimingNoAlloc = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::InvertRichCurveNoAlloc(MonotonicCurve, Resolution, InvertedCurve);
+				});
+				TSharedRef<FJsonObject> ResultNoAlloc = Report.AddResult(SuiteName, TEXT("InvertRichCurveNoAlloc"), TimingNoAlloc);
+				SetCurveParams(ResultNoAlloc, NumKeys, InterpMode);
+				ResultNoAlloc->SetNumberField(TEXT("resolution"), Resolution);
+				ResultNoAlloc->SetNumberField(TEXT("output_keys"), InvertedCurve.GetNumKeys());
+			}
+
+			for (const int32 Resolution : Resolutions)
+			{
+				// The integrated density is cubic with up to 3 keys per segment
+				const int32 MaxSegmentKeys = (InterpMode == RCIM_Constant ? 1 : 3 * Resolution);
+				if (NumKeys * MaxSegmentKeys > MaxInversionKeys)
+				{
+					continue;
+				}
+
+				FRichCurve NormalizedDensityCurve, QuantileCurve;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurve(
+						DensityCurve, NormalizedDensityCurve, QuantileCurve, Resolution);
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ComputeQuantileRichCurve"), Timing);
+				SetCurveParams(Result, NumKeys, InterpMode);
+				Result->SetNumberField(TEXT("resolution"), Resolution);
+				Result->SetNumberField(TEXT("output_keys"), QuantileCurve.GetNumKeys());
+
+				FQuantileCurveScratch Scratch;
+				const FGalactitiousBenchmarkTiming TimingNoAlloc = MeasureBenchmark(Settings, [&]() {
+					UProbabilityCurveFunctionLibrary::ComputeQuantileRichCurveNoAlloc(
+						DensityCurve, NormalizedDensityCurve, QuantileCurve, Scratch, Resolution);
+				});
+				TSharedRef<FJsonObject> ResultNoAlloc = Report.AddResult(SuiteName, TEXT("ComputeQuantileRichCurveNoAlloc"), TimingNoAlloc);
+				SetCurveParams(ResultNoAlloc, NumKeys, InterpMode);
+				ResultNoAlloc->SetNumberField(TEXT("resolution"), Resolution);
+				ResultNoAlloc->SetNumberField(TEXT("output_keys"), QuantileCurve.GetNumKeys());
+			}
+		}
+	}
+}
@@ -0,0 +1,1179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DensityImageSampler.h"
+#include "GalactitiousBenchmark.h"
+#include "GalactitiousBenchmarkFixtures.h"
+#include "GalaxyParameterComponent.h"
+#include "NiagaraDataInterfaceLookupTable.h"
+#include "NiagaraDataInterfaceStarBuffer.h"
+#include "QuantizedTable.h"
+#include "SampleSequence.h"
+#include "StarGenerator.h"
+#include "StellarSamplingData.h"
+
+#include "Algo/BinarySearch.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Async/ParallelFor.h"
+#include "Curves/CurveFloat.h"
+#include "HAL/FileManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+#include <cmath>
+
+namespace
+{
+	const TCHAR* SuiteName = TEXT("StellarSampler");
+
+	/** Significance level of the goodness-of-fit tests. */
+	const double Alpha = 1.0e-3;
+
+	/**
+	 * Quantile curves are piecewise approximations of the exact inverse CDF. With millions of samples the KS test resolves
+	 * that approximation error, so deviations of the empirical CDF below this are accepted regardless of the p-value.
+	 */
+	const double MaxCdfDeviation = 2.0e-3;
+
+	/** Resolution of the numerically integrated reference CDF. */
+	const int32 ReferenceCdfResolution = 8192;
+
+	const int32 SampleChunkSize = 16 * 1024;
+
+	/** Maps uniform random numbers to samples through a sampling curve. */
+	using FCurveSampleFunction = void (*)(const FRichCurve& SamplingCurve, TArrayView<const float> Uniforms, TArrayView<float> OutSamples);
+
+	void SampleCurveSerial(const FRichCurve& SamplingCurve, TArrayView<const float> Uniforms, TArrayView<float> OutSamples)
+	{
+		for (int32 i = 0; i < Uniforms.Num(); ++i)
+		{
+			OutSamples[i] = SamplingCurve.Eval(Uniforms[i]);
+		}
+	}
+
+	void SampleCurveParallel(const FRichCurve& SamplingCurve, TArrayView<const float> Uniforms, TArrayView<float> OutSamples)
+	{
+		const int32 NumChunks = FMath::DivideAndRoundUp(Uniforms.Num(), SampleChunkSize);
+		ParallelFor(NumChunks, [&SamplingCurve, Uniforms, OutSamples](int32 Chunk) {
+			const int32 Begin = Chunk * SampleChunkSize;
+			const int32 End = FMath::Min(Begin + SampleChunkSize, Uniforms.Num());
+			for (int32 i = Begin; i < End; ++i)
+			{
+				OutSamples[i] = SamplingCurve.Eval(Uniforms[i]);
+			}
+		});
+	}
+
+	struct FCurveSampler
+	{
+		const TCHAR* Name;
+		FCurveSampleFunction Sample;
+	};
+
+	/** Sampler implementations under test, every implementation is validated and timed. */
+	const FCurveSampler CurveSamplers[] = {
+		{TEXT("RichCurveEval"), &SampleCurveSerial},
+		{TEXT("RichCurveEvalParallel"), &SampleCurveParallel},
+	};
+
+	/** Maps uniform random numbers to (ln(L), temperature) pairs. */
+	using FStarSampleFunction = void (*)(
+		const FStarSamplingData& SamplingData, TArrayView<const float> Uniforms, TArrayView<float> OutLogLuminosity,
+		TArrayView<float> OutTemperature);
+
+	void SampleStarCurves(
+		const FStarSamplingData& SamplingData, TArrayView<const float> Uniforms, TArrayView<float> OutLogLuminosity,
+		TArrayView<float> OutTemperature)
+	{
+		SampleCurveSerial(SamplingData.LogLuminositySamplingCurve, Uniforms, OutLogLuminosity);
+		SampleCurveSerial(SamplingData.TemperatureSamplingCurve, Uniforms, OutTemperature);
+	}
+
+	void SampleStarCurvesParallel(
+		const FStarSamplingData& SamplingData, TArrayView<const float> Uniforms, TArrayView<float> OutLogLuminosity,
+		TArrayView<float> OutTemperature)
+	{
+		SampleCurveParallel(SamplingData.LogLuminositySamplingCurve, Uniforms, OutLogLuminosity);
+		SampleCurveParallel(SamplingData.TemperatureSamplingCurve, Uniforms, OutTemperature);
+	}
+
+	void SampleStarTable(
+		const FStarSamplingData& SamplingData, TArrayView<const float> Uniforms, TArrayView<float> OutLogLuminosity,
+		TArrayView<float> OutTemperature)
+	{
+		for (int32 i = 0; i < Uniforms.Num(); ++i)
+		{
+			const FLinearColor Attributes = SamplingData.EvalSamplingTable(Uniforms[i]);
+			OutLogLuminosity[i] = Attributes.R;
+			OutTemperature[i] = Attributes.G;
+		}
+	}
+
+	struct FStarSampler
+	{
+		const TCHAR* Name;
+		FStarSampleFunction Sample;
+	};
+
+	/** Star sampler implementations under test, every implementation is validated and timed. */
+	const FStarSampler StarSamplers[] = {
+		{TEXT("RichCurveEval"), &SampleStarCurves},
+		{TEXT("RichCurveEvalParallel"), &SampleStarCurvesParallel},
+		{TEXT("FusedTable"), &SampleStarTable},
+	};
+
+	struct FGoodnessOfFit
+	{
+		double Statistic = 0.0;
+		double PValue = 1.0;
+		int32 DegreesOfFreedom = 0;
+	};
+
+	/** Asymptotic Kolmogorov distribution Q_KS(lambda) = 2 sum((-1)^(k-1) exp(-2 k^2 lambda^2)). */
+	double KolmogorovPValue(double Lambda)
+	{
+		if (Lambda < 0.2)
+		{
+			return 1.0;
+		}
+
+		double Sum = 0.0;
+		double Sign = 1.0;
+		for (int32 k = 1; k <= 100; ++k)
+		{
+			const double Term = Sign * FMath::Exp(-2.0 * k * k * Lambda * Lambda);
+			Sum += Term;
+			if (FMath::Abs(Term) < 1.0e-12)
+			{
+				break;
+			}
+			Sign = -Sign;
+		}
+		return FMath::Clamp(2.0 * Sum, 0.0, 1.0);
+	}
+
+	/** Standard normal deviate of the chi-squared statistic (Wilson-Hilferty), accurate enough for p-values near Alpha. */
+	double ChiSquaredNormalDeviate(double Statistic, int32 DegreesOfFreedom)
+	{
+		const double K = DegreesOfFreedom;
+		const double Variance = 2.0 / (9.0 * K);
+		return (FMath::Pow(Statistic / K, 1.0 / 3.0) - (1.0 - Variance)) / FMath::Sqrt(Variance);
+	}
+
+	/** Upper tail probability of the standard normal distribution. */
+	double NormalUpperTail(double Z)
+	{
+		return 0.5 * std::erfc(Z / 1.4142135623730951);
+	}
+
+	/**
+	 * Kolmogorov-Smirnov test of samples against a reference CDF tabulated at equidistant points on [MinValue, MaxValue].
+	 * Sorts the samples in place.
+	 */
+	FGoodnessOfFit KolmogorovSmirnovTest(TArray<float>& Samples, const TArray<double>& ReferenceCdf, float MinValue, float MaxValue)
+	{
+		Samples.Sort();
+
+		const int32 NumSamples = Samples.Num();
+		const double Scale = (ReferenceCdf.Num() - 1) / (double)(MaxValue - MinValue);
+		auto EvalReferenceCdf = [&ReferenceCdf, MinValue, Scale](float Value) -> double {
+			const double X = FMath::Clamp((Value - MinValue) * Scale, 0.0, (double)(ReferenceCdf.Num() - 1));
+			const int32 Index = FMath::Min((int32)X, ReferenceCdf.Num() - 2);
+			return FMath::Lerp(ReferenceCdf[Index], ReferenceCdf[Index + 1], X - Index);
+		};
+
+		double MaxDeviation = 0.0;
+		for (int32 i = 0; i < NumSamples; ++i)
+		{
+			const double Cdf = EvalReferenceCdf(Samples[i]);
+			MaxDeviation = FMath::Max(MaxDeviation, FMath::Max(Cdf - (double)i / NumSamples, (double)(i + 1) / NumSamples - Cdf));
+		}
+
+		const double SqrtN = FMath::Sqrt((double)NumSamples);
+		FGoodnessOfFit Result;
+		Result.Statistic = MaxDeviation;
+		Result.PValue = KolmogorovPValue((SqrtN + 0.12 + 0.11 / SqrtN) * MaxDeviation);
+		return Result;
+	}
+
+	/** Pearson's chi-squared test, bins with too few expected counts are merged into their neighbour. */
+	FGoodnessOfFit ChiSquaredTest(const TArray<int64>& ObservedCounts, const TArray<double>& ExpectedProbabilities, int64 NumSamples)
+	{
+		const double MinExpectedCount = 5.0;
+
+		FGoodnessOfFit Result;
+		double Observed = 0.0;
+		double Expected = 0.0;
+		int32 NumBins = 0;
+		for (int32 i = 0; i < ObservedCounts.Num(); ++i)
+		{
+			Observed += ObservedCounts[i];
+			Expected += ExpectedProbabilities[i] * NumSamples;
+			if (Expected >= MinExpectedCount || i == ObservedCounts.Num() - 1)
+			{
+				if (Expected > 0.0)
+				{
+					Result.Statistic += FMath::Square(Observed - Expected) / Expected;
+					++NumBins;
+				}
+				Observed = 0.0;
+				Expected = 0.0;
+			}
+		}
+
+		Result.DegreesOfFreedom = FMath::Max(NumBins - 1, 1);
+		Result.PValue = NormalUpperTail(ChiSquaredNormalDeviate(Result.Statistic, Result.DegreesOfFreedom));
+		return Result;
+	}
+
+	/** CDF of a density curve by trapezoidal integration, negative densities are treated as zero. */
+	TArray<double> ComputeReferenceCdf(const FRichCurve& DensityCurve, float MinTime, float MaxTime)
+	{
+		TArray<double> Cdf;
+		Cdf.SetNumUninitialized(ReferenceCdfResolution + 1);
+
+		const double DeltaTime = (MaxTime - MinTime) / (double)ReferenceCdfResolution;
+		double Integral = 0.0;
+		double Density = FMath::Max(DensityCurve.Eval(MinTime), 0.0f);
+		Cdf[0] = 0.0;
+		for (int32 i = 1; i <= ReferenceCdfResolution; ++i)
+		{
+			const double NextDensity = FMath::Max(DensityCurve.Eval(MinTime + i * DeltaTime), 0.0f);
+			Integral += 0.5 * (Density + NextDensity) * DeltaTime;
+			Cdf[i] = Integral;
+			Density = NextDensity;
+		}
+
+		if (Integral > 0.0)
+		{
+			for (double& Value : Cdf)
+			{
+				Value /= Integral;
+			}
+		}
+		return Cdf;
+	}
+
+	TArray<float> MakeUniforms(int32 NumSamples, int32 Seed)
+	{
+		FRandomStream RandomStream(Seed);
+		TArray<float> Uniforms;
+		Uniforms.SetNumUninitialized(NumSamples);
+		for (float& U : Uniforms)
+		{
+			U = RandomStream.GetFraction();
+		}
+		return Uniforms;
+	}
+
+	/** Time the sampler on the uniforms and keep the samples of the last run. */
+	void RunSamplerTiming(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, const FCurveSampler& Sampler,
+		const FString& CaseName, const TCHAR* BenchmarkName, const FRichCurve& SamplingCurve, const TArray<float>& Uniforms,
+		TArray<float>& OutSamples)
+	{
+		OutSamples.SetNumUninitialized(Uniforms.Num());
+		const FGalactitiousBenchmarkTiming Timing =
+			MeasureBenchmark(Settings, [&]() { Sampler.Sample(SamplingCurve, Uniforms, OutSamples); });
+
+		TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, BenchmarkName, Timing);
+		Result->SetStringField(TEXT("sampler"), Sampler.Name);
+		Result->SetStringField(TEXT("case"), CaseName);
+		Result->SetNumberField(TEXT("samples"), Uniforms.Num());
+		Result->SetNumberField(TEXT("samples_per_sec"), Uniforms.Num() / Timing.NanosecondsPerOp * 1.0e9);
+	}
+
+	void AddFitResult(
+		FGalactitiousBenchmarkReport& Report, const FString& Name, const TCHAR* SamplerName, const FString& CaseName, const TCHAR* Test,
+		const FGoodnessOfFit& Fit, bool bPassed, const FString& Details)
+	{
+		TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, Name);
+		Result->SetStringField(TEXT("sampler"), SamplerName);
+		Result->SetStringField(TEXT("case"), CaseName);
+		Result->SetStringField(TEXT("test"), Test);
+		Result->SetNumberField(TEXT("statistic"), Fit.Statistic);
+		Result->SetNumberField(TEXT("p_value"), Fit.PValue);
+		if (Fit.DegreesOfFreedom > 0)
+		{
+			Result->SetNumberField(TEXT("dof"), Fit.DegreesOfFreedom);
+		}
+
+		Report.AddCheck(SuiteName, FString::Printf(TEXT("%s_%s_%s"), *Name, *CaseName, SamplerName), bPassed, Details);
+	}
+
+	void ValidateRadialSampling(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, const FString& CaseName,
+		const UGalaxyShapeSettings* ShapeSettings)
+	{
+		FGalaxyShapeSamplingData SamplingData;
+		if (!ShapeSettings->ComputeSamplingData(SamplingData))
+		{
+			Report.AddCheck(SuiteName, FString::Printf(TEXT("RadialSampling_%s"), *CaseName), false, TEXT("failed to derive sampling data"));
+			return;
+		}
+
+		const FRichCurve& DensityCurve = ShapeSettings->RadialDensityCurve->FloatCurve;
+		float MinRadius, MaxRadius;
+		DensityCurve.GetTimeRange(MinRadius, MaxRadius);
+		const TArray<double> ReferenceCdf = ComputeReferenceCdf(DensityCurve, MinRadius, MaxRadius);
+		const TArray<float> Uniforms = MakeUniforms(Settings.NumSamplerSamples, 0x5a3d);
+
+		TArray<float> Samples;
+		for (const FCurveSampler& Sampler : CurveSamplers)
+		{
+			RunSamplerTiming(Report, Settings, Sampler, CaseName, TEXT("RadialSampling"), SamplingData.RadialSamplingCurve, Uniforms, Samples);
+
+			const FGoodnessOfFit Fit = KolmogorovSmirnovTest(Samples, ReferenceCdf, MinRadius, MaxRadius);
+			const bool bPassed = Fit.PValue >= Alpha || Fit.Statistic <= MaxCdfDeviation;
+			AddFitResult(
+				Report, TEXT("RadialSampling"), Sampler.Name, CaseName, TEXT("KolmogorovSmirnov"), Fit, bPassed,
+				FString::Printf(TEXT("D=%g, p=%g, n=%d"), Fit.Statistic, Fit.PValue, Samples.Num()));
+		}
+	}
+
+	void ValidateStarSampling(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, const FString& CaseName,
+		const UStarSettings* StarSettings)
+	{
+		FStarSamplingData SamplingData;
+		if (!StarSettings->ComputeSamplingData(SamplingData))
+		{
+			Report.AddCheck(SuiteName, FString::Printf(TEXT("StarSampling_%s"), *CaseName), false, TEXT("failed to derive sampling data"));
+			return;
+		}
+
+		// Expected class probabilities follow from the source table, independent of the derived curves:
+		// P_i ~ Fraction_i * MinLuminosity_i, see UStarSettings::ComputeSamplingData.
+		TArray<FStellarClass> StellarClasses;
+		StarSettings->StellarClassesTable->ForeachRow<FStellarClass>(
+			"ValidateStarSampling", [&StellarClasses](const FName& Key, const FStellarClass& Value) { StellarClasses.Add(Value); });
+		StellarClasses.Sort(
+			[](const FStellarClass& ClassA, const FStellarClass& ClassB) { return ClassA.MinLuminosity < ClassB.MinLuminosity; });
+
+		const int32 NumClasses = StellarClasses.Num();
+		TArray<double> ExpectedProbabilities;
+		TArray<float> LogLuminosityBounds;
+		TArray<float> TemperatureBounds;
+		double TotalWeight = 0.0;
+		for (const FStellarClass& StellarClass : StellarClasses)
+		{
+			const double Weight = (double)StellarClass.Fraction * StellarClass.MinLuminosity;
+			ExpectedProbabilities.Add(Weight);
+			LogLuminosityBounds.Add(FMath::Loge(StellarClass.MinLuminosity));
+			TemperatureBounds.Add(StellarClass.MinTemperature);
+			TotalWeight += Weight;
+		}
+		for (double& Probability : ExpectedProbabilities)
+		{
+			Probability /= TotalWeight;
+		}
+		// Upper bound of the most luminous class, matches the derived curves
+		TemperatureBounds.Add(StellarClasses.Last().MinTemperature);
+
+		const TArray<float> Uniforms = MakeUniforms(Settings.NumSamplerSamples, 0x7b1f);
+
+		TArray<float> LogLuminositySamples, TemperatureSamples;
+		LogLuminositySamples.SetNumUninitialized(Uniforms.Num());
+		TemperatureSamples.SetNumUninitialized(Uniforms.Num());
+		for (const FStarSampler& Sampler : StarSamplers)
+		{
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+				Settings, [&]() { Sampler.Sample(SamplingData, Uniforms, LogLuminositySamples, TemperatureSamples); });
+			TSharedRef<FJsonObject> TimingResult = Report.AddResult(SuiteName, TEXT("StarSampling"), Timing);
+			TimingResult->SetStringField(TEXT("sampler"), Sampler.Name);
+			TimingResult->SetStringField(TEXT("case"), CaseName);
+			TimingResult->SetNumberField(TEXT("samples"), Uniforms.Num());
+			TimingResult->SetNumberField(TEXT("samples_per_sec"), Uniforms.Num() / Timing.NanosecondsPerOp * 1.0e9);
+
+			// Bin by luminosity class and check that temperatures lie within the class interval of the same draw
+			const float TemperatureTolerance = 1.0e-3f;
+			TArray<int64> ObservedCounts;
+			ObservedCounts.SetNumZeroed(NumClasses);
+			int64 NumTemperatureOutliers = 0;
+			for (int32 i = 0; i < Uniforms.Num(); ++i)
+			{
+				const int32 UpperBound = Algo::UpperBound(LogLuminosityBounds, LogLuminositySamples[i]);
+				const int32 ClassIndex = FMath::Clamp(UpperBound - 1, 0, NumClasses - 1);
+				++ObservedCounts[ClassIndex];
+
+				const float MinTemperature = FMath::Min(TemperatureBounds[ClassIndex], TemperatureBounds[ClassIndex + 1]);
+				const float MaxTemperature = FMath::Max(TemperatureBounds[ClassIndex], TemperatureBounds[ClassIndex + 1]);
+				const float Tolerance = TemperatureTolerance * MaxTemperature;
+				if (TemperatureSamples[i] < MinTemperature - Tolerance || TemperatureSamples[i] > MaxTemperature + Tolerance)
+				{
+					++NumTemperatureOutliers;
+				}
+			}
+
+			// All samplers are exact, every class must be hit with its probability up to sampling noise
+			double MaxProbabilityError = 0.0;
+			for (int32 ClassIndex = 0; ClassIndex < NumClasses; ++ClassIndex)
+			{
+				const double Error = FMath::Abs((double)ObservedCounts[ClassIndex] / Uniforms.Num() - ExpectedProbabilities[ClassIndex]);
+				MaxProbabilityError = FMath::Max(MaxProbabilityError, Error);
+			}
+
+			const FGoodnessOfFit Fit = ChiSquaredTest(ObservedCounts, ExpectedProbabilities, Uniforms.Num());
+			const bool bFitPassed = Fit.PValue >= Alpha;
+			AddFitResult(
+				Report, TEXT("LuminositySampling"), Sampler.Name, CaseName, TEXT("ChiSquared"), Fit, bFitPassed,
+				FString::Printf(
+					TEXT("chi2=%g, dof=%d, p=%g, max probability error=%g, n=%d"), Fit.Statistic, Fit.DegreesOfFreedom, Fit.PValue,
+					MaxProbabilityError, Uniforms.Num()));
+
+			Report.AddCheck(
+				SuiteName, FString::Printf(TEXT("TemperatureSampling_%s_%s"), *CaseName, Sampler.Name), NumTemperatureOutliers == 0,
+				FString::Printf(TEXT("%lld of %d temperatures outside of their luminosity class"), NumTemperatureOutliers, Uniforms.Num()));
+		}
+	}
+
+	/**
+	 * Quantile table lookup through a bilinear filtered texture with half texel offsets. Interpolates between entries of
+	 * neighbouring rows and across gaps of empty pixels, the reason the table texture is point sampled.
+	 */
+	FVector2D SampleQuantileTableBilinear(const TArray<float>& Table, int32 TableWidth, int32 ImageHeight, float U, float V)
+	{
+		const auto EvalRow = [&Table, TableWidth](int32 Row, float Quantile) {
+			const float* Values = Table.GetData() + (int64)Row * TableWidth;
+			const float X = FMath::Clamp(Quantile, 0.0f, 1.0f) * (TableWidth - 1);
+			const int32 Index = FMath::Min((int32)X, TableWidth - 2);
+			return FMath::Lerp(Values[Index], Values[Index + 1], X - Index);
+		};
+		const float Y = EvalRow(ImageHeight, U);
+		const float RowCoordinate = FMath::Clamp(Y * ImageHeight - 0.5f, 0.0f, ImageHeight - 1.0f);
+		const int32 Row = FMath::Min((int32)RowCoordinate, ImageHeight - 2);
+		const float X = FMath::Lerp(EvalRow(Row, V), EvalRow(FMath::Min(Row + 1, ImageHeight - 1), V), RowCoordinate - Row);
+		return FVector2D(X, Y);
+	}
+
+	void ValidateDensityImageSampling(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		const int32 Width = 256;
+		const int32 Height = 256;
+		const TArray<float> Density = MakeTestDensityImage(Width, Height);
+
+		FDensityImageSampler Sampler;
+		{
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() { Sampler.Build(Width, Height, Density); });
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("DensityImageSamplerBuild"), Timing);
+			Result->SetNumberField(TEXT("width"), Width);
+			Result->SetNumberField(TEXT("height"), Height);
+		}
+		if (!Sampler.IsValid())
+		{
+			Report.AddCheck(SuiteName, TEXT("DensityImageSampling"), false, TEXT("failed to build sampler"));
+			return;
+		}
+
+		TArray<float> QuantileTable;
+		Sampler.BuildQuantileTable(FGalaxyShapeSamplingData::ArmSamplingTableWidth, QuantileTable);
+
+		// Expected probabilities of 8x8 pixel blocks, coarse enough to resolve table interpolation errors above the noise
+		const int32 BlockSize = 8;
+		const int32 NumBlocksX = Width / BlockSize;
+		const int32 NumBlocksY = Height / BlockSize;
+		TArray<double> ExpectedProbabilities;
+		ExpectedProbabilities.SetNumZeroed(NumBlocksX * NumBlocksY);
+		double TotalDensity = 0.0;
+		for (int32 y = 0; y < Height; ++y)
+		{
+			for (int32 x = 0; x < Width; ++x)
+			{
+				ExpectedProbabilities[(y / BlockSize) * NumBlocksX + x / BlockSize] += Density[y * Width + x];
+				TotalDensity += Density[y * Width + x];
+			}
+		}
+		for (double& Probability : ExpectedProbabilities)
+		{
+			Probability /= TotalDensity;
+		}
+
+		const TArray<float> Uniforms = MakeUniforms(Settings.NumSamplerSamples, 0x2d17);
+		const int32 NumSamples = Uniforms.Num() / 2;
+		TArray<FVector2D> Samples;
+		Samples.SetNumUninitialized(NumSamples);
+
+		// Texture lookups of the particle shaders are quantized, only their support is checked.
+		// Bilinear lookups are recorded to show the discrepancy that point sampling of the table texture avoids.
+		enum class EImageSamplerChecks : uint8
+		{
+			FitAndSupport,
+			Support,
+			None,
+		};
+		struct FImageSampler
+		{
+			const TCHAR* Name;
+			TFunction<FVector2D(float U, float V)> Sample;
+			EImageSamplerChecks Checks;
+		};
+		const int32 TableWidth = FGalaxyShapeSamplingData::ArmSamplingTableWidth;
+		const FImageSampler ImageSamplers[] = {
+			{TEXT("BinarySearch"), [&Sampler](float U, float V) { return Sampler.Sample(U, V); }, EImageSamplerChecks::FitAndSupport},
+			{TEXT("QuantileTable"),
+			 [&QuantileTable, TableWidth, Width, Height](float U, float V) {
+				 return FDensityImageSampler::SampleQuantileTable(QuantileTable, TableWidth, Width, Height, U, V);
+			 },
+			 EImageSamplerChecks::FitAndSupport},
+			{TEXT("QuantileTableNearest"),
+			 [&QuantileTable, TableWidth, Width, Height](float U, float V) {
+				 return FDensityImageSampler::SampleQuantileTableNearest(QuantileTable, TableWidth, Width, Height, U, V);
+			 },
+			 EImageSamplerChecks::Support},
+			{TEXT("QuantileTableBilinear"),
+			 [&QuantileTable, TableWidth, Height](float U, float V) {
+				 return SampleQuantileTableBilinear(QuantileTable, TableWidth, Height, U, V);
+			 },
+			 EImageSamplerChecks::None},
+		};
+
+		for (const FImageSampler& ImageSampler : ImageSamplers)
+		{
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+				for (int32 i = 0; i < NumSamples; ++i)
+				{
+					Samples[i] = ImageSampler.Sample(Uniforms[2 * i], Uniforms[2 * i + 1]);
+				}
+			});
+			TSharedRef<FJsonObject> TimingResult = Report.AddResult(SuiteName, TEXT("DensityImageSampling"), Timing);
+			TimingResult->SetStringField(TEXT("sampler"), ImageSampler.Name);
+			TimingResult->SetNumberField(TEXT("samples"), NumSamples);
+			TimingResult->SetNumberField(TEXT("samples_per_sec"), NumSamples / Timing.NanosecondsPerOp * 1.0e9);
+
+			TArray<int64> ObservedCounts;
+			ObservedCounts.SetNumZeroed(ExpectedProbabilities.Num());
+			int64 NumOutside = 0;
+			for (const FVector2D& Sample : Samples)
+			{
+				const int32 x = FMath::Clamp((int32)(Sample.X * Width), 0, Width - 1);
+				const int32 y = FMath::Clamp((int32)(Sample.Y * Height), 0, Height - 1);
+				++ObservedCounts[(y / BlockSize) * NumBlocksX + x / BlockSize];
+				NumOutside += Density[y * Width + x] > 0.0f ? 0 : 1;
+			}
+
+			double TotalVariation = 0.0;
+			for (int32 i = 0; i < ObservedCounts.Num(); ++i)
+			{
+				TotalVariation += 0.5 * FMath::Abs((double)ObservedCounts[i] / NumSamples - ExpectedProbabilities[i]);
+			}
+
+			TimingResult->SetNumberField(TEXT("total_variation"), TotalVariation);
+			TimingResult->SetNumberField(TEXT("outside_fraction"), (double)NumOutside / NumSamples);
+
+			if (ImageSampler.Checks == EImageSamplerChecks::FitAndSupport)
+			{
+				const FGoodnessOfFit Fit = ChiSquaredTest(ObservedCounts, ExpectedProbabilities, NumSamples);
+				AddFitResult(
+					Report, TEXT("DensityImageSampling"), ImageSampler.Name, TEXT("TestSpiral"), TEXT("ChiSquared"), Fit,
+					Fit.PValue >= Alpha,
+					FString::Printf(
+						TEXT("chi2=%g, dof=%d, p=%g, total variation=%g, n=%d"), Fit.Statistic, Fit.DegreesOfFreedom, Fit.PValue,
+						TotalVariation, NumSamples));
+			}
+
+			// No sampler used for particles may select pixels without density, including the empty bands
+			if (ImageSampler.Checks != EImageSamplerChecks::None)
+			{
+				Report.AddCheck(
+					SuiteName, FString::Printf(TEXT("DensityImageSupport_%s"), ImageSampler.Name), NumOutside == 0,
+					FString::Printf(TEXT("%lld of %d samples in pixels without density"), NumOutside, NumSamples));
+			}
+		}
+	}
+
+	void RunStarGeneratorBenchmarks(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, UGalaxyShapeSettings* ShapeSettings,
+		const UStarSettings* StarSettings)
+	{
+		FStarSamplingData StarData;
+		if (!StarSettings->ComputeSamplingData(StarData))
+		{
+			Report.AddCheck(SuiteName, TEXT("StarGenerator"), false, TEXT("failed to derive star sampling data"));
+			return;
+		}
+
+		const EStarPositionSampling Modes[] = {EStarPositionSampling::Radial, EStarPositionSampling::ArmDensityMap};
+		for (const EStarPositionSampling Mode : Modes)
+		{
+			ShapeSettings->PositionSampling = Mode;
+			const TCHAR* ModeName = Mode == EStarPositionSampling::Radial ? TEXT("Radial") : TEXT("ArmDensityMap");
+
+			FGalaxyShapeSamplingData ShapeData;
+			if (!ShapeSettings->ComputeSamplingData(ShapeData))
+			{
+				Report.AddCheck(
+					SuiteName, FString::Printf(TEXT("StarGenerator_%s"), ModeName), false, TEXT("failed to derive shape sampling data"));
+				continue;
+			}
+
+			for (const ESampleSequence Sequence : {ESampleSequence::Random, ESampleSequence::Sobol, ESampleSequence::Lattice})
+			{
+				FStarGeneratorSettings GeneratorSettings;
+				GeneratorSettings.NumParticles = Settings.NumSamplerSamples;
+				GeneratorSettings.Sequence = Sequence;
+				const FString SequenceName = StaticEnum<ESampleSequence>()->GetNameStringByValue((int64)Sequence);
+				FStarBuffer Buffer;
+				bool bGenerated = false;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+					Settings,
+					[&]() { bGenerated = FGalaxyStarGenerator::Generate(*ShapeSettings, ShapeData, StarData, GeneratorSettings, Buffer); });
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("GenerateStars"), Timing);
+				Result->SetStringField(TEXT("position_sampling"), ModeName);
+				Result->SetStringField(TEXT("sequence"), SequenceName);
+				Result->SetNumberField(TEXT("particles"), GeneratorSettings.NumParticles);
+				Result->SetNumberField(TEXT("particles_per_sec"), GeneratorSettings.NumParticles / Timing.NanosecondsPerOp * 1.0e9);
+				Result->SetNumberField(TEXT("buffer_bytes"), (double)Buffer.GetAllocatedSize());
+
+				// Generation is independent of scheduling, a second run reproduces the buffer
+				FStarBuffer SecondBuffer;
+				FGalaxyStarGenerator::Generate(*ShapeSettings, ShapeData, StarData, GeneratorSettings, SecondBuffer);
+				const bool bDeterministic = Buffer.PositionX == SecondBuffer.PositionX && Buffer.PositionZ == SecondBuffer.PositionZ &&
+											Buffer.LogLuminosity == SecondBuffer.LogLuminosity;
+				Report.AddCheck(
+					SuiteName, FString::Printf(TEXT("StarGeneratorDeterministic_%s_%s"), ModeName, *SequenceName),
+					bGenerated && bDeterministic, FString::Printf(TEXT("%d particles"), Buffer.Num()));
+
+				// Loading a snapshot replaces generation when the star buffer data interface restarts
+				const FString SnapshotFile =
+					FPaths::ProjectIntermediateDir() / TEXT("Galactitious") / FString::Printf(TEXT("StarSnapshot_%s.bin"), ModeName);
+				const bool bSaved = Buffer.SaveSnapshot(SnapshotFile);
+				FStarBuffer LoadedBuffer;
+				bool bLoaded = false;
+				const FGalactitiousBenchmarkTiming LoadTiming =
+					MeasureBenchmark(Settings, [&]() { bLoaded = LoadedBuffer.LoadSnapshot(SnapshotFile); });
+				TSharedRef<FJsonObject> LoadResult = Report.AddResult(SuiteName, TEXT("LoadStarSnapshot"), LoadTiming);
+				LoadResult->SetStringField(TEXT("position_sampling"), ModeName);
+				LoadResult->SetStringField(TEXT("sequence"), SequenceName);
+				LoadResult->SetNumberField(TEXT("particles"), Buffer.Num());
+				LoadResult->SetNumberField(TEXT("file_bytes"), (double)IFileManager::Get().FileSize(*SnapshotFile));
+				IFileManager::Get().Delete(*SnapshotFile);
+
+				const bool bRoundTrip = Buffer.PositionX == LoadedBuffer.PositionX && Buffer.PositionY == LoadedBuffer.PositionY &&
+										Buffer.PositionZ == LoadedBuffer.PositionZ && Buffer.LogLuminosity == LoadedBuffer.LogLuminosity &&
+										Buffer.Temperature == LoadedBuffer.Temperature && Buffer.StarCount == LoadedBuffer.StarCount;
+				Report.AddCheck(
+					SuiteName, FString::Printf(TEXT("StarSnapshotRoundTrip_%s_%s"), ModeName, *SequenceName),
+					bSaved && bLoaded && bRoundTrip, SnapshotFile);
+
+				// Quantized tables trade a small error of the sampled attributes for a smaller cache footprint
+				GeneratorSettings.bQuantizedTables = true;
+				FStarBuffer QuantizedBuffer;
+				const FGalactitiousBenchmarkTiming QuantizedTiming = MeasureBenchmark(
+					Settings,
+					[&]() { FGalaxyStarGenerator::Generate(*ShapeSettings, ShapeData, StarData, GeneratorSettings, QuantizedBuffer); });
+				TSharedRef<FJsonObject> QuantizedResult = Report.AddResult(SuiteName, TEXT("GenerateStarsQuantized"), QuantizedTiming);
+				QuantizedResult->SetStringField(TEXT("position_sampling"), ModeName);
+				QuantizedResult->SetStringField(TEXT("sequence"), SequenceName);
+				QuantizedResult->SetNumberField(
+					TEXT("particles_per_sec"), GeneratorSettings.NumParticles / QuantizedTiming.NanosecondsPerOp * 1.0e9);
+				float MaxPositionError = 0.0f;
+				float MaxLogLuminosityError = 0.0f;
+				for (int32 i = 0; i < FMath::Min(Buffer.Num(), QuantizedBuffer.Num()); ++i)
+				{
+					MaxPositionError = FMath::Max(MaxPositionError, FVector::Dist(Buffer.GetPosition(i), QuantizedBuffer.GetPosition(i)));
+					MaxLogLuminosityError =
+						FMath::Max(MaxLogLuminosityError, FMath::Abs(Buffer.LogLuminosity[i] - QuantizedBuffer.LogLuminosity[i]));
+				}
+				Report.AddCheck(
+					SuiteName, FString::Printf(TEXT("StarGeneratorQuantized_%s_%s"), ModeName, *SequenceName),
+					QuantizedBuffer.Num() == Buffer.Num() && MaxPositionError < 1.0e-3f && MaxLogLuminosityError < 1.0e-2f,
+					FString::Printf(TEXT("max position error %g, max ln(L) error %g"), MaxPositionError, MaxLogLuminosityError));
+			}
+		}
+	}
+
+	void RunParameterBlockBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		UGalaxyShapeSettings* ShapeSettings = MakeTestShapeSettings();
+		UCurveFloat* ThicknessCurve = NewObject<UCurveFloat>(GetTransientPackage());
+		ThicknessCurve->FloatCurve.AddKey(0.0f, 0.1f);
+		ThicknessCurve->FloatCurve.AddKey(1.0f, 0.02f);
+		ShapeSettings->ThicknessCurve = ThicknessCurve;
+		const UStarSettings* StarSettings = MakeTestStarSettings();
+
+		// Per galaxy cost of an update, without the upload to a component
+		FGalaxyParameterBlock Block;
+		bool bComputed = false;
+		const FGalactitiousBenchmarkTiming Timing =
+			MeasureBenchmark(Settings, [&]() { bComputed = Block.Compute(*ShapeSettings, *StarSettings); });
+		TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ComputeParameterBlock"), Timing);
+		Result->SetNumberField(TEXT("block_bytes"), (double)Block.GetAllocatedSize());
+		if (!bComputed)
+		{
+			Report.AddCheck(SuiteName, TEXT("ParameterBlock"), false, TEXT("failed to compute the parameter block"));
+			return;
+		}
+
+		// Blocks of different settings stay independent
+		UGalaxyShapeSettings* OtherShapeSettings = DuplicateObject(ShapeSettings, GetTransientPackage());
+		OtherShapeSettings->Radius = 2.0f * ShapeSettings->Radius;
+		FGalaxyParameterBlock OtherBlock;
+		OtherBlock.Compute(*OtherShapeSettings, *StarSettings);
+		const bool bIndependent = Block.Scalars[FGalaxyParameterBlock::Radius] == ShapeSettings->Radius &&
+								  OtherBlock.Scalars[FGalaxyParameterBlock::Radius] == OtherShapeSettings->Radius &&
+								  Block.ThicknessTable == OtherBlock.ThicknessTable;
+		Report.AddCheck(SuiteName, TEXT("ParameterBlockIndependent"), bIndependent, TEXT("radius differs, tables match"));
+
+		// Curve tables replace the curve data interfaces of the collection path
+		float MaxError = 0.0f;
+		for (int32 i = 0; i < FGalaxyParameterBlock::CurveTableSize; ++i)
+		{
+			const float Alpha = (float)i / (FGalaxyParameterBlock::CurveTableSize - 1);
+			const float Time = FMath::Lerp(Block.ThicknessDomain.X, Block.ThicknessDomain.Y, Alpha);
+			MaxError = FMath::Max(MaxError, FMath::Abs(Block.ThicknessTable[i] - ThicknessCurve->FloatCurve.Eval(Time)));
+		}
+		Report.AddCheck(
+			SuiteName, TEXT("ParameterBlockThicknessTable"), MaxError < 1.0e-6f, FString::Printf(TEXT("max error %g"), MaxError));
+	}
+
+	void RunSampleSequenceBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		const ESampleSequence Sequences[] = {ESampleSequence::Random, ESampleSequence::Sobol, ESampleSequence::Lattice};
+		const UEnum* SequenceEnum = StaticEnum<ESampleSequence>();
+
+		// Per attribute 2D integrand 3u^2 * 3v^2 with unit integral, on the dimension pairs the star generator uses and the
+		// first pair past the Sobol dimensions
+		const uint32 DimensionPairs[] = {
+			FGalaxyStarGenerator::DimensionPositionU, FGalaxyStarGenerator::DimensionHeight0, FSampleSequence::NumSobolDimensions};
+		const int32 IntegrationSampleCounts[] = {256, 4096};
+		const int32 NumSeeds = 64;
+
+		TArray<float> Samples;
+		Samples.SetNumUninitialized(Settings.NumSamplerSamples);
+		double RandomError = 0.0;
+
+		for (const ESampleSequence Sequence : Sequences)
+		{
+			const FString SequenceName = SequenceEnum->GetNameStringByValue((int64)Sequence);
+
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+				Settings,
+				[&]() {
+					const int32 NumChunks = FMath::DivideAndRoundUp(Samples.Num(), SampleChunkSize);
+					ParallelFor(NumChunks, [&](int32 Chunk) {
+						const int32 Begin = Chunk * SampleChunkSize;
+						const int32 End = FMath::Min(Begin + SampleChunkSize, Samples.Num());
+						for (int32 i = Begin; i < End; ++i)
+						{
+							const uint32 Dimension = (uint32)i % FGalaxyStarGenerator::NumDimensions;
+							Samples[i] = FSampleSequence::GetSample(Sequence, 0, (uint32)i, Dimension);
+						}
+					});
+				});
+			TSharedRef<FJsonObject> TimingResult = Report.AddResult(SuiteName, TEXT("SampleSequence"), Timing);
+			TimingResult->SetStringField(TEXT("sequence"), SequenceName);
+			TimingResult->SetNumberField(TEXT("samples"), Samples.Num());
+			TimingResult->SetNumberField(TEXT("samples_per_sec"), Samples.Num() / Timing.NanosecondsPerOp * 1.0e9);
+
+			for (const int32 NumIntegrationSamples : IntegrationSampleCounts)
+			{
+				// Root mean square error over independently scrambled or shifted realizations
+				double SumSquaredError = 0.0;
+				double MaxError = 0.0;
+				for (const uint32 Dimension : DimensionPairs)
+				{
+					for (int32 Seed = 0; Seed < NumSeeds; ++Seed)
+					{
+						double Sum = 0.0;
+						for (int32 i = 0; i < NumIntegrationSamples; ++i)
+						{
+							const double U = FSampleSequence::GetSample(Sequence, (uint32)Seed, (uint32)i, Dimension);
+							const double V = FSampleSequence::GetSample(Sequence, (uint32)Seed, (uint32)i, Dimension + 1);
+							Sum += 9.0 * U * U * V * V;
+						}
+						const double Error = Sum / NumIntegrationSamples - 1.0;
+						SumSquaredError += Error * Error;
+						MaxError = FMath::Max(MaxError, FMath::Abs(Error));
+					}
+				}
+				const double RmsError = FMath::Sqrt(SumSquaredError / (NumSeeds * UE_ARRAY_COUNT(DimensionPairs)));
+
+				TSharedRef<FJsonObject> ErrorResult = Report.AddResult(SuiteName, TEXT("SampleSequenceIntegration"));
+				ErrorResult->SetStringField(TEXT("sequence"), SequenceName);
+				ErrorResult->SetNumberField(TEXT("samples"), NumIntegrationSamples);
+				ErrorResult->SetNumberField(TEXT("rms_error"), RmsError);
+				ErrorResult->SetNumberField(TEXT("max_error"), MaxError);
+
+				if (NumIntegrationSamples != IntegrationSampleCounts[UE_ARRAY_COUNT(IntegrationSampleCounts) - 1])
+				{
+					continue;
+				}
+				if (Sequence == ESampleSequence::Random)
+				{
+					RandomError = RmsError;
+				}
+				else
+				{
+					// Low-discrepancy sequences converge faster than 1/sqrt(N), a clear margin at a few thousand samples
+					Report.AddCheck(
+						SuiteName, FString::Printf(TEXT("SampleSequenceConvergence_%s"), *SequenceName), RmsError < 0.25 * RandomError,
+						FString::Printf(TEXT("rms error %g vs random %g, n=%d"), RmsError, RandomError, NumIntegrationSamples));
+				}
+			}
+		}
+	}
+
+	void RunLookupTableBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		FStarSamplingData StarData;
+		if (!MakeTestStarSettings()->ComputeSamplingData(StarData))
+		{
+			Report.AddCheck(SuiteName, TEXT("LookupTable"), false, TEXT("failed to derive star sampling data"));
+			return;
+		}
+
+		const TArrayView<const float> TableValues((const float*)StarData.SamplingTable.GetData(), StarData.SamplingTable.Num() * 4);
+		UNiagaraDataInterfaceLookupTable* LookupTable = NewObject<UNiagaraDataInterfaceLookupTable>(GetTransientPackage());
+		LookupTable->SetTable(TableValues, 4, 0.0f, 1.0f);
+
+		// Same linear lookup as the fused sampling table at the table coordinate of the quantile
+		double MaxError = 0.0;
+		const int32 NumChecks = 4096;
+		for (int32 i = 0; i <= NumChecks; ++i)
+		{
+			const float Quantile = (float)i / NumChecks;
+			const FLinearColor Expected = StarData.EvalSamplingTable(Quantile);
+			const FVector4 Actual = LookupTable->SampleVector(StarData.GetSamplingTableCoordinate(Quantile));
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				const double Reference = FMath::Max(FMath::Abs((double)Expected.Component(Channel)), 1.0);
+				MaxError = FMath::Max(MaxError, FMath::Abs((double)Actual[Channel] - Expected.Component(Channel)) / Reference);
+			}
+		}
+		Report.AddCheck(
+			SuiteName, TEXT("LookupTableMatchesSamplingTable"), MaxError < 1.0e-5,
+			FString::Printf(TEXT("max relative error %g over %d quantiles"), MaxError, NumChecks + 1));
+
+		// GPU lookups directly at the quantile match the exact lookup wherever both neighbouring entries are in one class
+		{
+			const TArray<float>& ClassQuantiles = StarData.SamplingTableQuantiles;
+			const TArray<FLinearColor>& GpuTable = StarData.QuantileSamplingTable;
+			const int32 NumIntervals = GpuTable.Num() - 1;
+			UNiagaraDataInterfaceLookupTable* GpuLookupTable = NewObject<UNiagaraDataInterfaceLookupTable>(GetTransientPackage());
+			GpuLookupTable->SetTable(TArrayView<const float>((const float*)GpuTable.GetData(), GpuTable.Num() * 4), 4, 0.0f, 1.0f);
+			double MaxGpuError = 0.0;
+			int32 NumGpuChecks = 0;
+			for (int32 i = 0; i <= NumChecks; ++i)
+			{
+				const float Quantile = (float)i / NumChecks;
+				const int32 Entry = FMath::Min((int32)(Quantile * NumIntervals), NumIntervals - 1);
+				const int32 Class0 = Algo::UpperBound(ClassQuantiles, (float)Entry / NumIntervals);
+				const int32 Class1 = Algo::LowerBound(ClassQuantiles, (float)(Entry + 1) / NumIntervals);
+				if (Class0 != Class1)
+				{
+					continue;
+				}
+				const FLinearColor Expected = StarData.EvalSamplingTable(Quantile);
+				const FVector4 Actual = GpuLookupTable->SampleVector(Quantile);
+				for (int32 Channel = 0; Channel < 4; ++Channel)
+				{
+					const double Reference = FMath::Max(FMath::Abs((double)Expected.Component(Channel)), 1.0);
+					MaxGpuError = FMath::Max(MaxGpuError, FMath::Abs((double)Actual[Channel] - Expected.Component(Channel)) / Reference);
+				}
+				++NumGpuChecks;
+			}
+			Report.AddCheck(
+				SuiteName, TEXT("QuantileSamplingTableMatchesSamplingTable"), NumGpuChecks > NumChecks / 2 && MaxGpuError < 1.0e-4,
+				FString::Printf(TEXT("max relative error %g over %d quantiles inside classes"), MaxGpuError, NumGpuChecks));
+		}
+
+		// The VM functions of CPU emitters read the per-instance snapshot, including clamping outside the domain
+		{
+			const int32 NumInstances = 1001;
+			TArray<float> X;
+			for (int32 i = 0; i < NumInstances; ++i)
+			{
+				X.Add(-0.1f + 1.2f * i / (NumInstances - 1));
+			}
+			TArray<float> Values[4];
+			for (TArray<float>& Channel : Values)
+			{
+				Channel.SetNumZeroed(NumInstances);
+			}
+			TArray<float> ScalarValues;
+			ScalarValues.SetNumZeroed(NumInstances);
+			const void* const Inputs[] = {X.GetData()};
+			void* const VectorOutputs[] = {Values[0].GetData(), Values[1].GetData(), Values[2].GetData(), Values[3].GetData()};
+			void* const ScalarOutputs[] = {ScalarValues.GetData()};
+			const bool bVectorBound = ExecuteVMExternalFunction(*LookupTable, TEXT("SampleVector"), Inputs, VectorOutputs, NumInstances);
+			const bool bScalarBound = ExecuteVMExternalFunction(*LookupTable, TEXT("Sample"), Inputs, ScalarOutputs, NumInstances);
+			double MaxVMError = 0.0;
+			for (int32 i = 0; i < NumInstances; ++i)
+			{
+				const FVector4 Expected = LookupTable->SampleVector(X[i]);
+				for (int32 Channel = 0; Channel < 4; ++Channel)
+				{
+					MaxVMError = FMath::Max(MaxVMError, (double)FMath::Abs(Values[Channel][i] - Expected[Channel]));
+				}
+				MaxVMError = FMath::Max(MaxVMError, (double)FMath::Abs(ScalarValues[i] - LookupTable->Sample(X[i])));
+			}
+			Report.AddCheck(
+				SuiteName, TEXT("LookupTableVMMatchesSample"), bVectorBound && bScalarBound && MaxVMError <= 1.0e-4,
+				FString::Printf(
+					TEXT("bound Sample %d, SampleVector %d, max error %g over %d instances"), bScalarBound, bVectorBound, MaxVMError,
+					NumInstances));
+		}
+
+		// Scalar lookups against the curve evaluation they replace
+		FRandomStream Random(1);
+		TArray<float> Quantiles;
+		Quantiles.SetNumUninitialized(64 * 1024);
+		for (float& Quantile : Quantiles)
+		{
+			Quantile = Random.GetFraction();
+		}
+		float Checksum = 0.0f;
+		const FGalactitiousBenchmarkTiming CurveTiming = MeasureBenchmark(Settings, [&]() {
+			for (const float Quantile : Quantiles)
+			{
+				Checksum += StarData.LogLuminositySamplingCurve.Eval(Quantile);
+			}
+		});
+		TSharedRef<FJsonObject> CurveResult = Report.AddResult(SuiteName, TEXT("LookupTableSample"), CurveTiming);
+		CurveResult->SetStringField(TEXT("implementation"), TEXT("RichCurve"));
+		CurveResult->SetNumberField(TEXT("lookups_per_sec"), Quantiles.Num() / CurveTiming.NanosecondsPerOp * 1.0e9);
+
+		TArray<float> LogLuminosityTable;
+		for (const FLinearColor& Entry : StarData.SamplingTable)
+		{
+			LogLuminosityTable.Add(Entry.R);
+		}
+		LookupTable->SetTable(LogLuminosityTable, 1, 0.0f, 1.0f);
+		const FGalactitiousBenchmarkTiming TableTiming = MeasureBenchmark(Settings, [&]() {
+			for (const float Quantile : Quantiles)
+			{
+				Checksum += LookupTable->Sample(Quantile);
+			}
+		});
+		TSharedRef<FJsonObject> TableResult = Report.AddResult(SuiteName, TEXT("LookupTableSample"), TableTiming);
+		TableResult->SetStringField(TEXT("implementation"), TEXT("LookupTable"));
+		TableResult->SetNumberField(TEXT("lookups_per_sec"), Quantiles.Num() / TableTiming.NanosecondsPerOp * 1.0e9);
+		TableResult->SetNumberField(TEXT("checksum"), Checksum);
+
+		// Pushing an unchanged table only compares entries, a single changed entry uploads only that entry
+		const FGalactitiousBenchmarkTiming UnchangedTiming =
+			MeasureBenchmark(Settings, [&]() { LookupTable->SetTable(LogLuminosityTable, 1, 0.0f, 1.0f); });
+		Report.AddResult(SuiteName, TEXT("LookupTableSetTable"), UnchangedTiming)->SetStringField(TEXT("update"), TEXT("Unchanged"));
+
+		int32 ChangedEntry = 0;
+		const FGalactitiousBenchmarkTiming PartialTiming = MeasureBenchmark(Settings, [&]() {
+			ChangedEntry = (ChangedEntry + 1) % LogLuminosityTable.Num();
+			LogLuminosityTable[ChangedEntry] += 1.0f;
+			LookupTable->SetTable(LogLuminosityTable, 1, 0.0f, 1.0f);
+		});
+		Report.AddResult(SuiteName, TEXT("LookupTableSetTable"), PartialTiming)->SetStringField(TEXT("update"), TEXT("SingleEntry"));
+		Report.AddCheck(
+			SuiteName, TEXT("LookupTablePartialUpdate"), LookupTable->Values == LogLuminosityTable,
+			FString::Printf(TEXT("%d entries"), LookupTable->GetNumEntries()));
+	}
+
+	void RunStarBufferChecks(FGalactitiousBenchmarkReport& Report)
+	{
+		// Slots of a capacity of 100 stars, one partially filled and one empty
+		const int32 SlotCapacity = 100;
+		const int32 SlotSizes[] = {SlotCapacity, 37, 0, SlotCapacity};
+		FRandomStream Random(11);
+		TArray<UNiagaraDataInterfaceStarBuffer::FStarBufferPtr> Slots;
+		for (const int32 SlotSize : SlotSizes)
+		{
+			TSharedRef<FStarBuffer, ESPMode::ThreadSafe> Stars = MakeShared<FStarBuffer, ESPMode::ThreadSafe>();
+			Stars->SetNumUninitialized(SlotSize);
+			for (int32 i = 0; i < SlotSize; ++i)
+			{
+				Stars->PositionX[i] = Random.FRandRange(-1.0f, 1.0f);
+				Stars->PositionY[i] = Random.FRandRange(-1.0f, 1.0f);
+				Stars->PositionZ[i] = Random.FRandRange(-0.1f, 0.1f);
+				Stars->LogLuminosity[i] = Random.FRandRange(-5.0f, 10.0f);
+				Stars->Temperature[i] = Random.FRandRange(3000.0f, 30000.0f);
+				Stars->StarCount[i] = Random.FRandRange(1.0f, 100.0f);
+			}
+			if (SlotSize > 0)
+			{
+				Slots.Add(Stars);
+			}
+			else
+			{
+				Slots.AddDefaulted();
+			}
+		}
+
+		// The VM functions of CPU emitters read the per-instance slots, out of range indices are clamped
+		UNiagaraDataInterfaceStarBuffer* StarBuffer = NewObject<UNiagaraDataInterfaceStarBuffer>(GetTransientPackage());
+		StarBuffer->SetStarSlots(Slots, SlotCapacity);
+		const int32 NumStars = StarBuffer->GetNumStars();
+		TArray<int32> Indices;
+		for (int32 Index = -2; Index < NumStars + 2; ++Index)
+		{
+			Indices.Add(Index);
+		}
+		const int32 NumInstances = Indices.Num();
+		TArray<int32> NumStarsOutput;
+		NumStarsOutput.SetNumZeroed(NumInstances);
+		TArray<float> Attributes[6];
+		for (TArray<float>& Attribute : Attributes)
+		{
+			Attribute.SetNumZeroed(NumInstances);
+		}
+		void* const NumStarsOutputs[] = {NumStarsOutput.GetData()};
+		const void* const StarInputs[] = {Indices.GetData()};
+		void* const StarOutputs[] = {Attributes[0].GetData(), Attributes[1].GetData(), Attributes[2].GetData(),
+									 Attributes[3].GetData(), Attributes[4].GetData(), Attributes[5].GetData()};
+		const bool bNumStarsBound = ExecuteVMExternalFunction(*StarBuffer, TEXT("GetNumStars"), {}, NumStarsOutputs, NumInstances);
+		const bool bStarBound = ExecuteVMExternalFunction(*StarBuffer, TEXT("GetStar"), StarInputs, StarOutputs, NumInstances);
+
+		int32 NumMismatches = 0;
+		for (int32 i = 0; i < NumInstances; ++i)
+		{
+			const int32 Index = FMath::Clamp(Indices[i], 0, NumStars - 1);
+			const FStarBuffer* Stars = Slots[Index / SlotCapacity].Get();
+			const int32 StarIndex = Index % SlotCapacity;
+			const bool bValid = Stars != nullptr && StarIndex < Stars->Num();
+			const float Expected[6] = {
+				bValid ? Stars->PositionX[StarIndex] : 0.0f,	 bValid ? Stars->PositionY[StarIndex] : 0.0f,
+				bValid ? Stars->PositionZ[StarIndex] : 0.0f,	 bValid ? Stars->LogLuminosity[StarIndex] : 0.0f,
+				bValid ? Stars->Temperature[StarIndex] : 0.0f, bValid ? Stars->StarCount[StarIndex] : 0.0f};
+			bool bMatches = NumStarsOutput[i] == NumStars;
+			for (int32 Attribute = 0; Attribute < 6; ++Attribute)
+			{
+				bMatches &= Attributes[Attribute][i] == Expected[Attribute];
+			}
+			NumMismatches += bMatches ? 0 : 1;
+		}
+		Report.AddCheck(
+			SuiteName, TEXT("StarBufferVMMatchesSlots"), bNumStarsBound && bStarBound && NumStars == 400 && NumMismatches == 0,
+			FString::Printf(
+				TEXT("bound GetNumStars %d, GetStar %d, %d stars, %d of %d instances mismatched"), bNumStarsBound, bStarBound, NumStars,
+				NumMismatches, NumInstances));
+	}
+
+	void RunQuantizedTableBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		FStarSamplingData StarData;
+		if (!MakeTestStarSettings()->ComputeSamplingData(StarData))
+		{
+			Report.AddCheck(SuiteName, TEXT("QuantizedTable"), false, TEXT("failed to derive star sampling data"));
+			return;
+		}
+
+		const TArrayView<const float> TableValues((const float*)StarData.SamplingTable.GetData(), StarData.SamplingTable.Num() * 4);
+		FRandomStream Random(1);
+		TArray<float> Quantiles;
+		Quantiles.SetNumUninitialized(64 * 1024);
+		for (float& Quantile : Quantiles)
+		{
+			Quantile = Random.GetFraction();
+		}
+
+		FLinearColor Checksum = FLinearColor::Transparent;
+		const FGalactitiousBenchmarkTiming FloatTiming = MeasureBenchmark(Settings, [&]() {
+			for (const float Quantile : Quantiles)
+			{
+				Checksum += StarData.EvalSamplingTable(Quantile);
+			}
+		});
+		TSharedRef<FJsonObject> FloatResult = Report.AddResult(SuiteName, TEXT("QuantizedTableEval"), FloatTiming);
+		FloatResult->SetStringField(TEXT("format"), TEXT("Float"));
+		FloatResult->SetNumberField(TEXT("bytes"), (double)StarData.SamplingTable.GetAllocatedSize());
+		FloatResult->SetNumberField(TEXT("lookups_per_sec"), Quantiles.Num() / FloatTiming.NanosecondsPerOp * 1.0e9);
+
+		// Errors relative to the channel range, delta encoding must not lose precision against a single block
+		double MaxErrors[2] = {0.0, 0.0};
+		for (const EQuantizedTableFormat Format : {EQuantizedTableFormat::UNorm16, EQuantizedTableFormat::Half})
+		{
+			for (const bool bDeltaEncoding : {false, true})
+			{
+				FQuantizedTable Table;
+				Table.Encode(TableValues, 4, Format, bDeltaEncoding);
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					for (const float Quantile : Quantiles)
+					{
+						Checksum += Table.Eval4(StarData.GetSamplingTableCoordinate(Quantile));
+					}
+				});
+
+				double MaxRelativeError = 0.0;
+				for (int32 Channel = 0; Channel < 4; ++Channel)
+				{
+					float MinValue = MAX_flt;
+					float MaxValue = -MAX_flt;
+					for (const FLinearColor& Entry : StarData.SamplingTable)
+					{
+						MinValue = FMath::Min(MinValue, Entry.Component(Channel));
+						MaxValue = FMath::Max(MaxValue, Entry.Component(Channel));
+					}
+					const double Range = FMath::Max(MaxValue - MinValue, 1.0e-6f);
+					MaxRelativeError = FMath::Max(MaxRelativeError, Table.GetMaxError(Channel) / Range);
+				}
+				if (Format == EQuantizedTableFormat::UNorm16)
+				{
+					MaxErrors[bDeltaEncoding ? 1 : 0] = MaxRelativeError;
+				}
+
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("QuantizedTableEval"), Timing);
+				Result->SetStringField(TEXT("format"), StaticEnum<EQuantizedTableFormat>()->GetNameStringByValue((int64)Format));
+				Result->SetBoolField(TEXT("delta_encoding"), bDeltaEncoding);
+				Result->SetNumberField(TEXT("bytes"), (double)Table.GetAllocatedSize());
+				Result->SetNumberField(TEXT("max_relative_error"), MaxRelativeError);
+				Result->SetNumberField(TEXT("lookups_per_sec"), Quantiles.Num() / Timing.NanosecondsPerOp * 1.0e9);
+			}
+		}
+		Report.AddCheck(
+			SuiteName, TEXT("QuantizedTableDeltaPrecision"), MaxErrors[1] <= MaxErrors[0] && MaxErrors[0] < 1.0e-4,
+			FString::Printf(TEXT("max relative error %g, delta encoded %g, checksum %g"), MaxErrors[0], MaxErrors[1], Checksum.R));
+	}
+
+	template <typename AssetType>
+	TArray<AssetType*> LoadProjectAssets()
+	{
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+		AssetRegistry.SearchAllAssets(true);
+
+		TArray<FAssetData> AssetDataList;
+		AssetRegistry.GetAssetsByClass(AssetType::StaticClass()->GetFName(), AssetDataList, true);
+
+		TArray<AssetType*> Assets;
+		for (const FAssetData& AssetData : AssetDataList)
+		{
+			if (AssetType* Asset = Cast<AssetType>(AssetData.GetAsset()))
+			{
+				Assets.Add(Asset);
+			}
+		}
+		return Assets;
+	}
+} // namespace
+
+void RunStellarSamplerBenchmarks(FGalactitiousBenchmarkReport& Report)
+{
+	// Each run draws millions of samples, a single measured iteration is enough
+	FGalactitiousBenchmarkSettings Settings = Report.GetSettings();
+	Settings.MinIterations = 1;
+
+	ValidateRadialSampling(Report, Settings, TEXT("TestDisk"), MakeTestShapeSettings());
+	for (const UGalaxyShapeSettings* ShapeSettings : LoadProjectAssets<UGalaxyShapeSettings>())
+	{
+		if (ShapeSettings->RadialDensityCurve != nullptr)
+		{
+			ValidateRadialSampling(Report, Settings, ShapeSettings->GetName(), ShapeSettings);
+		}
+	}
+
+	ValidateStarSampling(Report, Settings, TEXT("TestMainSequence"), MakeTestStarSettings());
+
+	ValidateDensityImageSampling(Report, Settings);
+	RunSampleSequenceBenchmarks(Report, Settings);
+	RunLookupTableBenchmarks(Report, Settings);
+	RunStarBufferChecks(Report);
+	RunQuantizedTableBenchmarks(Report, Settings);
+	RunStarGeneratorBenchmarks(Report, Settings, MakeTestArmShapeSettings(), MakeTestStarSettings());
+	RunParameterBlockBenchmarks(Report, Settings);
+	for (const UStarSettings* StarSettings : LoadProjectAssets<UStarSettings>())
+	{
+		if (StarSettings->StellarClassesTable != nullptr)
+		{
+			ValidateStarSampling(Report, Settings, StarSettings->GetName(), StarSettings);
+		}
+	}
+
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
@@ -0,0 +1,702 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FFT.h"
+#include "GalactitiousBenchmark.h"
+#include "StellarSamplingData.h"
+#include "TelescopeData.h"
+#include "TextureBakeJob.h"
+#include "TextureBakerFunctionLibrary.h"
+
+#include "RenderingThread.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Curves/CurveFloat.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	const TCHAR* SuiteName = TEXT("TextureBake");
+
+	const int32 Resolutions[] = {256, 1024, 2048, 4096, 8192};
+	const ETextureSourceFormat SourceFormats[] = {TSF_RGBA16F, TSF_G8, TSF_BGRA8};
+	/** Thread counts for the bake loop, 0 uses all worker threads. */
+	const int32 ThreadCounts[] = {1, 2, 4, 0};
+	const int32 FFTResolutions[] = {1024, 2048, 4096};
+	const FIntVector VolumeResolutions[] = {{64, 64, 64}, {128, 128, 128}, {256, 256, 64}, {256, 256, 256}};
+
+	/** Incremental bake job settings, resembling a runtime bake during gameplay. */
+	const int32 BakeJobResolution = 2048;
+	const double BakeJobBudgetSeconds = 0.002;
+
+	const TCHAR* GetSourceFormatName(ETextureSourceFormat SourceFormat)
+	{
+		switch (SourceFormat)
+		{
+		case TSF_RGBA16F:
+			return TEXT("RGBA16F");
+		case TSF_G8:
+			return TEXT("G8");
+		case TSF_BGRA8:
+			return TEXT("BGRA8");
+		default:
+			return TEXT("Unknown");
+		}
+	}
+
+	EPixelFormat GetPixelFormat(ETextureSourceFormat SourceFormat)
+	{
+		switch (SourceFormat)
+		{
+		case TSF_RGBA16F:
+			return PF_FloatRGBA;
+		case TSF_G8:
+			return PF_G8;
+		case TSF_BGRA8:
+			return PF_B8G8R8A8;
+		default:
+			return PF_Unknown;
+		}
+	}
+
+	template <typename ValueType>
+	ValueType ConvertColor(const FLinearColor& Color);
+
+	template <>
+	FVector4_16 ConvertColor<FVector4_16>(const FLinearColor& Color)
+	{
+		FVector4_16 Result;
+		Result.X = Color.R;
+		Result.Y = Color.G;
+		Result.Z = Color.B;
+		Result.W = Color.A;
+		return Result;
+	}
+
+	template <>
+	uint8 ConvertColor<uint8>(const FLinearColor& Color)
+	{
+		return (uint8)FMath::Clamp(FMath::RoundToInt(Color.R * 255.0f), 0, 255);
+	}
+
+	template <>
+	FColor ConvertColor<FColor>(const FLinearColor& Color)
+	{
+		return Color.ToFColor(false);
+	}
+
+	struct FValueFunction
+	{
+		const TCHAR* Name;
+		TFunction<FLinearColor(float X, float Y)> ColorFn;
+	};
+
+	TArray<FValueFunction> MakeValueFunctions(const UTelescopeData* Telescope, const FTelescopePSFProfile& PSFProfile)
+	{
+		FInterpCurveFloat Curve;
+		for (int32 i = 0; i < 100; ++i)
+		{
+			const float Time = i / 99.0f;
+			Curve.AddPoint(Time, 1.0f + 0.5f * FMath::Sin(Time * 8.0f * PI));
+			Curve.Points.Last().InterpMode = CIM_CurveAuto;
+		}
+		Curve.AutoSetTangents();
+		TFunction<float(float X, float Y)> CurveFn = UTextureBakerFunctionLibrary::FloatCurveEvalFunction(Curve);
+
+		TArray<FValueFunction> ValueFunctions;
+		ValueFunctions.Add({TEXT("Constant"), [](float X, float Y) { return FLinearColor(0.5f, 0.5f, 0.5f, 1.0f); }});
+		ValueFunctions.Add({TEXT("AiryDisk"), [Telescope](float X, float Y) {
+								const float I = Telescope->EvalAiryDiskIntensity(X, Y);
+								return FLinearColor(I, I, I, 1.0f);
+							}});
+		ValueFunctions.Add(
+			{TEXT("AnnularPSF"), [Telescope, &PSFProfile](float X, float Y) { return Telescope->EvalPSF(PSFProfile, X, Y); }});
+		ValueFunctions.Add({TEXT("CurveEval"), [CurveFn](float X, float Y) {
+								const float Value = CurveFn(X, Y);
+								return FLinearColor(Value, Value, Value, 1.0f);
+							}});
+		return ValueFunctions;
+	}
+
+	void SetBakeParams(
+		const TSharedRef<FJsonObject>& Result, int32 Resolution, ETextureSourceFormat SourceFormat, const TCHAR* ValueFunctionName,
+		int32 NumThreads)
+	{
+		Result->SetNumberField(TEXT("resolution"), Resolution);
+		Result->SetStringField(TEXT("format"), GetSourceFormatName(SourceFormat));
+		Result->SetStringField(TEXT("value_function"), ValueFunctionName);
+		Result->SetNumberField(TEXT("threads"), NumThreads);
+	}
+
+	void SetThroughput(const TSharedRef<FJsonObject>& Result, int32 Resolution, const FGalactitiousBenchmarkTiming& Timing)
+	{
+		const double NumPixels = (double)Resolution * Resolution;
+		Result->SetNumberField(TEXT("mpixels_per_sec"), NumPixels / Timing.NanosecondsPerOp * 1.0e3);
+	}
+
+	template <typename ValueType>
+	void RunBakeBenchmarks(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, int32 Resolution,
+		ETextureSourceFormat SourceFormat, const FValueFunction& ValueFunction)
+	{
+		const int32 BytesPerPixel = FTextureSource::GetBytesPerPixel(SourceFormat);
+		check(sizeof(ValueType) == BytesPerPixel);
+		const int32 NumWorkerThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+		const TFunction<FLinearColor(float X, float Y)>& ColorFn = ValueFunction.ColorFn;
+
+		// Bake loop into a preallocated buffer
+		{
+			TArray<uint8> Buffer;
+			Buffer.AddUninitialized(Resolution * Resolution * BytesPerPixel);
+
+			auto PixelFn = [&ColorFn](float X, float Y, uint8* OutData) {
+				const ValueType Value = ConvertColor<ValueType>(ColorFn(X, Y));
+				FMemory::Memcpy(OutData, &Value, sizeof(ValueType));
+			};
+
+			for (const int32 MaxThreads : ThreadCounts)
+			{
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+					Settings,
+					[&]() {
+						UTextureBakerFunctionLibrary::BakePixelData(
+							Resolution, Resolution, BytesPerPixel, PixelFn, Buffer.GetData(), MaxThreads);
+					});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("BakePixelData"), Timing);
+				SetBakeParams(Result, Resolution, SourceFormat, ValueFunction.Name, MaxThreads > 0 ? MaxThreads : NumWorkerThreads);
+				SetThroughput(Result, Resolution, Timing);
+				Result->SetNumberField(TEXT("buffer_bytes"), (double)Buffer.GetAllocatedSize());
+			}
+		}
+
+		// Complete transient texture bake, including texture creation and resource update
+		{
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+				Settings,
+				[&]() {
+					UTextureBakerFunctionLibrary::BakeTransientTexture<ValueType>(
+						FString(), Resolution, Resolution, GetPixelFormat(SourceFormat), SourceFormat, TMGS_NoMipmaps,
+						[&ColorFn](float X, float Y) { return ConvertColor<ValueType>(ColorFn(X, Y)); });
+				});
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("BakeTransientTexture"), Timing);
+			SetBakeParams(Result, Resolution, SourceFormat, ValueFunction.Name, NumWorkerThreads);
+			SetThroughput(Result, Resolution, Timing);
+		}
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	void RunBakeJobBenchmarks(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, const FValueFunction& ValueFunction)
+	{
+		const int32 Resolution = FMath::Min(BakeJobResolution, Settings.MaxBakeResolution);
+		const TFunction<FLinearColor(float X, float Y)>& ColorFn = ValueFunction.ColorFn;
+		auto MakeJob = [&]() {
+			return FTextureBakeJob::CreateRGBA16F(
+				Resolution, Resolution, [&ColorFn](float X0, float dX, float Y, int32 Count, FLinearColor* OutValues) {
+					for (int32 i = 0; i < Count; ++i)
+					{
+						OutValues[i] = ColorFn(X0 + i * dX, Y);
+					}
+				});
+		};
+
+		// Game thread bake within the frame budget, one tick per frame
+		{
+			const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Job = MakeJob();
+			const double StartTime = FPlatformTime::Seconds();
+			double MaxTickSeconds = 0.0;
+			int32 NumTicks = 0;
+			bool bFinished = false;
+			while (!bFinished)
+			{
+				const double TickStartTime = FPlatformTime::Seconds();
+				bFinished = Job->Tick(BakeJobBudgetSeconds);
+				MaxTickSeconds = FMath::Max(MaxTickSeconds, FPlatformTime::Seconds() - TickStartTime);
+				++NumTicks;
+			}
+			const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("BakeJobGameThread"));
+			SetBakeParams(Result, Resolution, TSF_RGBA16F, ValueFunction.Name, 1);
+			Result->SetNumberField(TEXT("budget_ms"), BakeJobBudgetSeconds * 1000.0);
+			Result->SetNumberField(TEXT("ticks"), NumTicks);
+			Result->SetNumberField(TEXT("max_tick_ms"), MaxTickSeconds * 1000.0);
+			Result->SetNumberField(TEXT("total_ms"), TotalSeconds * 1000.0);
+
+			const bool bPassed = Job->GetState() == FTextureBakeJob::EState::Completed && Job->GetTexture() != nullptr;
+			Report.AddCheck(
+				SuiteName, TEXT("BakeJobCompleted"), bPassed,
+				FString::Printf(TEXT("%d ticks, max tick %.3f ms"), NumTicks, MaxTickSeconds * 1000.0));
+		}
+
+		// Background workers, the game thread only polls for completion
+		{
+			const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Job = MakeJob();
+			const double StartTime = FPlatformTime::Seconds();
+			double MaxTickSeconds = 0.0;
+			Job->StartWorkers();
+			bool bFinished = false;
+			while (!bFinished)
+			{
+				FPlatformProcess::Sleep(0.0f);
+				const double TickStartTime = FPlatformTime::Seconds();
+				bFinished = Job->Tick(BakeJobBudgetSeconds);
+				MaxTickSeconds = FMath::Max(MaxTickSeconds, FPlatformTime::Seconds() - TickStartTime);
+			}
+			const double TotalSeconds = FPlatformTime::Seconds() - StartTime;
+
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("BakeJobWorkers"));
+			SetBakeParams(Result, Resolution, TSF_RGBA16F, ValueFunction.Name, FTaskGraphInterface::Get().GetNumWorkerThreads());
+			Result->SetNumberField(TEXT("max_tick_ms"), MaxTickSeconds * 1000.0);
+			Result->SetNumberField(TEXT("total_ms"), TotalSeconds * 1000.0);
+		}
+
+		// Cancelled jobs stop baking and leave no texture
+		{
+			const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Job = MakeJob();
+			Job->Tick(0.0);
+			Job->Cancel();
+			const bool bPassed = Job->Tick(BakeJobBudgetSeconds) && Job->GetProgress() < 1.0f && Job->GetTexture() == nullptr;
+			Report.AddCheck(SuiteName, TEXT("BakeJobCancel"), bPassed, FString::Printf(TEXT("progress=%f"), Job->GetProgress()));
+		}
+
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+
+	void RunTextureUpdateBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		// Lookup tables as regenerated by live parameter edits, a single entry changes per update
+		const FIntPoint Sizes[] = {{1024, 1}, {256, 256}, {1024, 1024}};
+		for (const FIntPoint& Size : Sizes)
+		{
+			TArray<FLinearColor> Table;
+			Table.Init(FLinearColor::Black, Size.X * Size.Y);
+			int32 NumUpdates = 0;
+			auto ChangeEntry = [&]() {
+				++NumUpdates;
+				Table[(NumUpdates * 7919) % Table.Num()].R = (float)NumUpdates;
+			};
+
+			// Full update, recreates the texture resource
+			{
+				UTexture2D* Texture = nullptr;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					ChangeEntry();
+					Texture =
+						UTextureBakerFunctionLibrary::UpdateTransientTexture(Texture, Size.X, Size.Y, PF_A32B32G32R32F, Table.GetData());
+				});
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("UpdateTransientTexture"), Timing);
+				Result->SetNumberField(TEXT("width"), Size.X);
+				Result->SetNumberField(TEXT("height"), Size.Y);
+			}
+
+			// Region update of the changed entry
+			{
+				FTextureUpdateStaging Staging;
+				UTexture2D* InitialTexture = UTextureBakerFunctionLibrary::UpdateTransientTextureRegions(
+					nullptr, Size.X, Size.Y, PF_A32B32G32R32F, Table.GetData(), Staging);
+				UTexture2D* Texture = InitialTexture;
+				const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+					ChangeEntry();
+					Texture = UTextureBakerFunctionLibrary::UpdateTransientTextureRegions(
+						Texture, Size.X, Size.Y, PF_A32B32G32R32F, Table.GetData(), Staging);
+				});
+				FlushRenderingCommands();
+				TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("UpdateTransientTextureRegions"), Timing);
+				Result->SetNumberField(TEXT("width"), Size.X);
+				Result->SetNumberField(TEXT("height"), Size.Y);
+
+				const bool bPassed = Texture == InitialTexture &&
+									 FMemory::Memcmp(Staging.PixelData.GetData(), Table.GetData(), Staging.PixelData.Num()) == 0;
+				Report.AddCheck(
+					SuiteName, FString::Printf(TEXT("UpdateRegionsReusesTexture%dx%d"), Size.X, Size.Y), bPassed,
+					FString::Printf(TEXT("%d updates"), Timing.NumIterations));
+			}
+
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+	}
+
+	UCurveFloat* MakeCurveAsset(TFunctionRef<float(float Time)> ValueFn)
+	{
+		UCurveFloat* Curve = NewObject<UCurveFloat>(GetTransientPackage());
+		for (int32 i = 0; i < 32; ++i)
+		{
+			const float Time = i / 31.0f;
+			Curve->FloatCurve.AddKey(Time, ValueFn(Time));
+		}
+		Curve->FloatCurve.AutoSetTangents();
+		return Curve;
+	}
+
+	void RunVolumeBakeBenchmarks(FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings)
+	{
+		UGalaxyShapeSettings* Shape = NewObject<UGalaxyShapeSettings>(GetTransientPackage());
+		Shape->AddToRoot();
+		Shape->RadialDensityCurve = MakeCurveAsset([](float Time) { return FMath::Exp(-4.0f * Time) * (1.0f - Time); });
+		Shape->ThicknessCurve = MakeCurveAsset([](float Time) { return 0.08f * (1.0f - 0.7f * Time); });
+		const float InvMaxRadialDensity = 1.0f / Shape->GetMaxRadialDensity();
+
+		for (const FIntVector& Resolution : VolumeResolutions)
+		{
+			if (FMath::Max3(Resolution.X, Resolution.Y, Resolution.Z) > Settings.MaxBakeResolution)
+			{
+				continue;
+			}
+
+			TArray<uint8> Buffer;
+			Buffer.AddUninitialized(Resolution.X * Resolution.Y * Resolution.Z);
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+				Settings,
+				[&]() {
+					UTextureBakerFunctionLibrary::BakeVolumePixelData(
+						Resolution.X, Resolution.Y, Resolution.Z, 1,
+						[&](float X, float Y, float Z, uint8* OutData) {
+							const FVector Position(2.0f * X - 1.0f, 2.0f * Y - 1.0f, (2.0f * Z - 1.0f) * Shape->GasVolumeHeight);
+							*OutData = (uint8)FMath::RoundToInt(Shape->EvalGasDensity(Position, InvMaxRadialDensity) * 255.0f);
+						},
+						Buffer.GetData());
+				});
+
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("BakeVolumePixelData"), Timing);
+			Result->SetNumberField(TEXT("width"), Resolution.X);
+			Result->SetNumberField(TEXT("height"), Resolution.Y);
+			Result->SetNumberField(TEXT("depth"), Resolution.Z);
+			Result->SetStringField(TEXT("value_function"), TEXT("GasDensity"));
+			const double NumVoxels = (double)Resolution.X * Resolution.Y * Resolution.Z;
+			Result->SetNumberField(TEXT("mvoxels_per_sec"), NumVoxels / Timing.NanosecondsPerOp * 1.0e3);
+		}
+
+		Shape->RemoveFromRoot();
+	}
+
+	void RunAperturePSFBenchmarks(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, UTelescopeData* Telescope)
+	{
+		for (const int32 Resolution : FFTResolutions)
+		{
+			if (Resolution > Settings.MaxBakeResolution)
+			{
+				continue;
+			}
+
+			const int32 NumValues = Resolution * Resolution;
+			FRandomStream Random(Resolution);
+			TArray<float> Real, Imag;
+			Real.SetNumUninitialized(NumValues);
+			Imag.SetNumUninitialized(NumValues);
+			for (int32 i = 0; i < NumValues; ++i)
+			{
+				Real[i] = Random.FRand();
+				Imag[i] = Random.FRand();
+			}
+			const TArray<float> SourceReal = Real;
+			const TArray<float> SourceImag = Imag;
+
+			// Forward and inverse pairs keep the values bounded over iterations
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+				Settings,
+				[&]() {
+					FFastFourierTransform::Transform2D(Real, Imag, Resolution, Resolution);
+					FFastFourierTransform::Transform2D(Real, Imag, Resolution, Resolution, /*bInverse=*/true);
+				});
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("FFT2DRoundTrip"), Timing);
+			Result->SetNumberField(TEXT("resolution"), Resolution);
+			Result->SetNumberField(TEXT("ms_per_transform"), Timing.NanosecondsPerOp * 0.5e-6);
+
+			float MaxError = 0.0f;
+			for (int32 i = 0; i < NumValues; ++i)
+			{
+				MaxError = FMath::Max(MaxError, FMath::Abs(Real[i] - SourceReal[i]));
+				MaxError = FMath::Max(MaxError, FMath::Abs(Imag[i] - SourceImag[i]));
+			}
+			Report.AddCheck(
+				SuiteName, FString::Printf(TEXT("FFT2DRoundTrip%d"), Resolution), MaxError < 1.0e-3f,
+				FString::Printf(TEXT("max error=%g after %d round trips"), MaxError, Timing.NumIterations));
+		}
+
+		const int32 SavedNumSpiderVanes = Telescope->NumSpiderVanes;
+		const int32 SavedResolution = Telescope->ApertureFFTResolution;
+		const int32 MaxFFTResolution = 1 << FMath::FloorLog2(FMath::Max(Settings.MaxBakeResolution, 256));
+		Telescope->ApertureFFTResolution = FMath::Min(Telescope->ApertureFFTResolution, MaxFFTResolution);
+
+		// Without spider vanes the aperture PSF must match the analytic annular PSF
+		{
+			Telescope->NumSpiderVanes = 0;
+			FTelescopePSFProfile Profile;
+			Telescope->ComputePSFProfile(Profile);
+			FTelescopeAperturePSF PSF;
+			const bool bComputed = Telescope->ComputeAperturePSF(PSF);
+
+			float MaxError = 0.0f;
+			const int32 NumPoints = 64;
+			for (int32 j = 0; bComputed && j < NumPoints; ++j)
+			{
+				for (int32 i = 0; i < NumPoints; ++i)
+				{
+					const float X = (float)i / (NumPoints - 1);
+					const float Y = (float)j / (NumPoints - 1);
+					const FLinearColor Analytic = Telescope->EvalPSF(Profile, X, Y);
+					const FLinearColor Aperture = Telescope->EvalAperturePSF(PSF, X, Y);
+					MaxError = FMath::Max(MaxError, FMath::Abs(Analytic.R - Aperture.R));
+					MaxError = FMath::Max(MaxError, FMath::Abs(Analytic.G - Aperture.G));
+					MaxError = FMath::Max(MaxError, FMath::Abs(Analytic.B - Aperture.B));
+				}
+			}
+			Report.AddCheck(
+				SuiteName, TEXT("AperturePSFMatchesAnalytic"), bComputed && MaxError < 0.02f,
+				FString::Printf(TEXT("max error=%f, resolution=%d"), MaxError, Telescope->ApertureFFTResolution));
+		}
+
+		// Full aperture PSF with spider vanes, rasterization and FFT
+		Telescope->NumSpiderVanes = FMath::Max(SavedNumSpiderVanes, 1);
+		{
+			FTelescopeAperturePSF PSF;
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() { Telescope->ComputeAperturePSF(PSF); });
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ComputeAperturePSF"), Timing);
+			Result->SetNumberField(TEXT("resolution"), Telescope->ApertureFFTResolution);
+			Result->SetNumberField(TEXT("spider_vanes"), Telescope->NumSpiderVanes);
+
+			// Texture bake from the FFT result, spectral integration per pixel
+			const int32 BakeResolution = FMath::Min(1024, Settings.MaxBakeResolution);
+			const int32 BytesPerPixel = sizeof(FVector4_16);
+			TArray<uint8> Buffer;
+			Buffer.AddUninitialized(BakeResolution * BakeResolution * BytesPerPixel);
+			const FGalactitiousBenchmarkTiming BakeTiming = MeasureBenchmark(
+				Settings,
+				[&]() {
+					UTextureBakerFunctionLibrary::BakePixelData(
+						BakeResolution, BakeResolution, BytesPerPixel,
+						[&](float X, float Y, uint8* OutData) {
+							const FVector4_16 Value = ConvertColor<FVector4_16>(Telescope->EvalAperturePSF(PSF, X, Y));
+							FMemory::Memcpy(OutData, &Value, sizeof(Value));
+						},
+						Buffer.GetData());
+				});
+			TSharedRef<FJsonObject> BakeResult = Report.AddResult(SuiteName, TEXT("BakeAperturePSF"), BakeTiming);
+			BakeResult->SetNumberField(TEXT("resolution"), BakeResolution);
+			BakeResult->SetNumberField(TEXT("spectral_samples"), PSF.SpectralScales.Num());
+			SetThroughput(BakeResult, BakeResolution, BakeTiming);
+		}
+
+		Telescope->NumSpiderVanes = SavedNumSpiderVanes;
+		Telescope->ApertureFFTResolution = SavedResolution;
+	}
+	void RunHalfConversionBenchmarks(
+		FGalactitiousBenchmarkReport& Report, const FGalactitiousBenchmarkSettings& Settings, const FValueFunction& ValueFunction)
+	{
+		// Random finite floats over the whole half range, including denormals, overflow and rounding ties
+		const int32 NumValues = 1 << 20;
+		FRandomStream Random(0x4A17);
+		TArray<float> Values;
+		Values.AddUninitialized(NumValues);
+		for (float& Value : Values)
+		{
+			const uint32 Bits = Random.GetUnsignedInt();
+			const uint32 FiniteBits = (Bits & 0x80000000u) | ((Bits & 0x7FFFFFFFu) % 0x48000000u);
+			FMemory::Memcpy(&Value, &FiniteBits, sizeof(float));
+		}
+		TArray<FFloat16> Halfs;
+		Halfs.AddUninitialized(NumValues);
+
+		{
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() {
+				for (int32 i = 0; i < NumValues; ++i)
+				{
+					Halfs[i] = Values[i];
+				}
+			});
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("FloatToHalfScalar"), Timing);
+			Result->SetNumberField(TEXT("count"), NumValues);
+			Result->SetNumberField(TEXT("mvalues_per_sec"), NumValues / Timing.NanosecondsPerOp * 1.0e3);
+		}
+
+		{
+			const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+				Settings, [&]() { UTextureBakerFunctionLibrary::ConvertFloatToHalf(Values.GetData(), Halfs.GetData(), NumValues); });
+			TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ConvertFloatToHalf"), Timing);
+			Result->SetNumberField(TEXT("count"), NumValues);
+			Result->SetNumberField(TEXT("mvalues_per_sec"), NumValues / Timing.NanosecondsPerOp * 1.0e3);
+		}
+
+		// The batched conversion must match the portable scalar conversion bit for bit
+		{
+			UTextureBakerFunctionLibrary::ConvertFloatToHalf(Values.GetData(), Halfs.GetData(), NumValues);
+			int32 NumMismatches = 0;
+			float FirstMismatch = 0.0f;
+			for (int32 i = 0; i < NumValues; ++i)
+			{
+				if (Halfs[i].Encoded != UTextureBakerFunctionLibrary::FloatToHalf(Values[i]) && NumMismatches++ == 0)
+				{
+					FirstMismatch = Values[i];
+				}
+			}
+			Report.AddCheck(
+				SuiteName, TEXT("ConvertFloatToHalfMatchesScalar"), NumMismatches == 0,
+				FString::Printf(TEXT("%d mismatches, first at %g"), NumMismatches, FirstMismatch));
+		}
+
+		// Against FFloat16 decoding: every finite half must round trip, values a quarter step off round to the nearer half,
+		// midpoints to the even half. Values from the midpoint above the largest half overflow to infinity, NaN stays NaN.
+		{
+			TArray<float> Inputs;
+			TArray<uint16> Expected;
+			for (const uint16 Sign : {(uint16)0, (uint16)0x8000})
+			{
+				for (uint16 Bits = 0; Bits < 0x7c00; ++Bits)
+				{
+					FFloat16 Half;
+					Half.Encoded = (uint16)(Bits | Sign);
+					const float Value = Half.GetFloat();
+					Inputs.Add(Value);
+					Expected.Add(Half.Encoded);
+					if (Bits + 1 < 0x7c00)
+					{
+						FFloat16 Next;
+						Next.Encoded = (uint16)((Bits + 1) | Sign);
+						const float Step = Next.GetFloat() - Value;
+						Inputs.Append({Value + 0.25f * Step, Value + 0.5f * Step, Value + 0.75f * Step});
+						Expected.Append({Half.Encoded, (Bits & 1) ? Next.Encoded : Half.Encoded, Next.Encoded});
+					}
+				}
+				const float SignScale = Sign ? -1.0f : 1.0f;
+				Inputs.Append({65520.0f * SignScale, 1.0e6f * SignScale});
+				Expected.Append({(uint16)(0x7c00 | Sign), (uint16)(0x7c00 | Sign)});
+			}
+			const uint32 QuietNaNBits = 0x7fc00000u;
+			float QuietNaN;
+			FMemory::Memcpy(&QuietNaN, &QuietNaNBits, sizeof(QuietNaN));
+			Inputs.Add(QuietNaN);
+
+			TArray<FFloat16> Converted;
+			Converted.AddUninitialized(Inputs.Num());
+			UTextureBakerFunctionLibrary::ConvertFloatToHalf(Inputs.GetData(), Converted.GetData(), Inputs.Num());
+			int32 NumMismatches = 0;
+			float FirstMismatch = 0.0f;
+			for (int32 i = 0; i < Expected.Num(); ++i)
+			{
+				if (Converted[i].Encoded != Expected[i] && NumMismatches++ == 0)
+				{
+					FirstMismatch = Inputs[i];
+				}
+			}
+			const uint16 ConvertedNaN = Converted.Last().Encoded;
+			const bool bNaN = (ConvertedNaN & 0x7c00) == 0x7c00 && (ConvertedNaN & 0x03ff) != 0;
+			Report.AddCheck(
+				SuiteName, TEXT("ConvertFloatToHalfMatchesFloat16"), NumMismatches == 0 && bNaN,
+				FString::Printf(
+					TEXT("%d mismatches of %d, first at %g, NaN converted to 0x%04x"), NumMismatches, Expected.Num(), FirstMismatch,
+					ConvertedNaN));
+		}
+
+		// Row bake, compare to BakePixelData of RGBA16F with per pixel conversion
+		const int32 Resolution = FMath::Min(BakeJobResolution, Settings.MaxBakeResolution);
+		const TFunction<FLinearColor(float X, float Y)>& ColorFn = ValueFunction.ColorFn;
+		TArray<FFloat16> Buffer;
+		Buffer.AddUninitialized(Resolution * Resolution * 4);
+		const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(
+			Settings,
+			[&]() {
+				UTextureBakerFunctionLibrary::BakePixelDataRGBA16F(
+					Resolution, Resolution,
+					[&ColorFn](float X0, float dX, float Y, int32 Count, FLinearColor* OutValues) {
+						for (int32 i = 0; i < Count; ++i)
+						{
+							OutValues[i] = ColorFn(X0 + i * dX, Y);
+						}
+					},
+					Buffer.GetData());
+			});
+		TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("BakePixelDataRGBA16F"), Timing);
+		SetBakeParams(Result, Resolution, TSF_RGBA16F, ValueFunction.Name, FTaskGraphInterface::Get().GetNumWorkerThreads() + 1);
+		SetThroughput(Result, Resolution, Timing);
+
+		// Bake jobs convert tile rows the same way and upload the half colors unchanged
+		const TSharedRef<FTextureBakeJob, ESPMode::ThreadSafe> Job = FTextureBakeJob::CreateRGBA16F(
+			Resolution, Resolution, [&ColorFn](float X0, float dX, float Y, int32 Count, FLinearColor* OutValues) {
+				for (int32 i = 0; i < Count; ++i)
+				{
+					OutValues[i] = ColorFn(X0 + i * dX, Y);
+				}
+			});
+		Job->StartWorkers();
+		while (!Job->Tick(BakeJobBudgetSeconds))
+		{
+			FPlatformProcess::Sleep(0.0f);
+		}
+		bool bMatches = false;
+		if (UTexture2D* Texture = Job->GetTexture())
+		{
+			FByteBulkData& BulkData = Texture->PlatformData->Mips[0].BulkData;
+			const void* MipData = BulkData.Lock(LOCK_READ_ONLY);
+			bMatches = BulkData.GetBulkDataSize() == Buffer.Num() * Buffer.GetTypeSize() &&
+					   FMemory::Memcmp(MipData, Buffer.GetData(), Buffer.Num() * Buffer.GetTypeSize()) == 0;
+			BulkData.Unlock();
+		}
+		Report.AddCheck(
+			SuiteName, TEXT("BakeJobRGBA16FMatchesPixelData"), bMatches, FString::Printf(TEXT("%dx%d"), Resolution, Resolution));
+		CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+	}
+} // namespace
+
+void RunTextureBakeBenchmarks(FGalactitiousBenchmarkReport& Report)
+{
+	// Large bakes take seconds, a single measured iteration is enough
+	FGalactitiousBenchmarkSettings Settings = Report.GetSettings();
+	Settings.MinIterations = 1;
+
+	UTelescopeData* Telescope = NewObject<UTelescopeData>(GetTransientPackage());
+	Telescope->AddToRoot();
+
+	// Spectral PSF integration that precedes polychromatic bakes
+	FTelescopePSFProfile PSFProfile;
+	{
+		const FGalactitiousBenchmarkTiming Timing = MeasureBenchmark(Settings, [&]() { Telescope->ComputePSFProfile(PSFProfile); });
+		TSharedRef<FJsonObject> Result = Report.AddResult(SuiteName, TEXT("ComputePSFProfile"), Timing);
+		Result->SetNumberField(TEXT("resolution"), UTelescopeData::PSFProfileResolution);
+	}
+
+	const TArray<FValueFunction> ValueFunctions = MakeValueFunctions(Telescope, PSFProfile);
+
+	for (const int32 Resolution : Resolutions)
+	{
+		if (Resolution > Settings.MaxBakeResolution)
+		{
+			continue;
+		}
+
+		for (const ETextureSourceFormat SourceFormat : SourceFormats)
+		{
+			for (const FValueFunction& ValueFunction : ValueFunctions)
+			{
+				switch (SourceFormat)
+				{
+				case TSF_RGBA16F:
+					RunBakeBenchmarks<FVector4_16>(Report, Settings, Resolution, SourceFormat, ValueFunction);
+					break;
+				case TSF_G8:
+					RunBakeBenchmarks<uint8>(Report, Settings, Resolution, SourceFormat, ValueFunction);
+					break;
+				case TSF_BGRA8:
+					RunBakeBenchmarks<FColor>(Report, Settings, Resolution, SourceFormat, ValueFunction);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	}
+
+	for (const FValueFunction& ValueFunction : ValueFunctions)
+	{
+		if (FCString::Strcmp(ValueFunction.Name, TEXT("AiryDisk")) == 0)
+		{
+			RunBakeJobBenchmarks(Report, Settings, ValueFunction);
+			RunHalfConversionBenchmarks(Report, Settings, ValueFunction);
+		}
+	}
+	RunTextureUpdateBenchmarks(Report, Report.GetSettings());
+	RunVolumeBakeBenchmarks(Report, Settings);
+	RunAperturePSFBenchmarks(Report, Settings, Telescope);
+
+	Telescope->RemoveFromRoot();
+}